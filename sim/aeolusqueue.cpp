@@ -1,286 +1,62 @@
-// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-        
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
 #include "aeolusqueue.h"
+#include "ndppacket.h"
 #include <math.h>
 
 #include <iostream>
 #include <sstream>
 
 AeolusQueue::AeolusQueue(linkspeed_bps bitrate, mem_b maxsize, EventList& eventlist, QueueLogger* logger)
-  : Queue(bitrate, maxsize, eventlist, logger)
+  : ClassQueue(bitrate, maxsize, eventlist, logger, CLASSIFY_CONTROL)
 {
-	_ratio_high = 10;
-	_ratio_low = 1;
-	_crt = 0;
-	_num_headers = 0;
-	_num_packets = 0;
-	_num_acks = 0;
-	_num_nacks = 0;
-	_num_pulls = 0;
-	_num_drops = 0;
-	_num_stripped = 0;
-	_num_bounced = 0;
+    _num_headers = 0;
+    _num_packets = 0;
+    _num_acks = 0;
+    _num_nacks = 0;
+    _num_pulls = 0;
 
-	drop_thresh = 6000;
+    drop_thresh = 6000;
 
- 	_queuesize_high = _queuesize_low = 0;
-  	_serv = QUEUE_INVALID;
-  	stringstream ss;
-  	ss << "compqueue(" << bitrate/1000000 << "Mb/s," << maxsize << "bytes)";
-  	_nodename = ss.str();
-}
-
-void AeolusQueue::beginService() {
-
-	// If both queues are non-empty
-	if (!_enqueued_high.empty() && !_enqueued_low.empty()) {
-		_crt++;
-
-		if (_crt >= (_ratio_high+_ratio_low))
-			_crt = 0;
-
-    	if (_crt< _ratio_high) {
-			_serv = QUEUE_HIGH;
-			eventlist().sourceIsPendingRel(*this, drainTime(_enqueued_high.back()));
-    	} else {
-			assert(_crt < _ratio_high+_ratio_low);
-			_serv = QUEUE_LOW;
-			eventlist().sourceIsPendingRel(*this, drainTime(_enqueued_low.back()));      
-    	}
+    // DRR quanta of ten headers and one data packet
+    addClass(0, 10*ACKSIZE, 0, OVERFLOW_TRIM, Q_HI);			// Q_HI
+    addClass(0, Packet::data_packet_size(), 0, OVERFLOW_TRIM_RANDOM, Q_HI); // Q_LO
 
-    	return;
-  	}
-
-  	if (!_enqueued_high.empty()) {
-    	_serv = QUEUE_HIGH;
-    	eventlist().sourceIsPendingRel(*this, drainTime(_enqueued_high.back()));
-  	} else if (!_enqueued_low.empty()){
-    	_serv = QUEUE_LOW;
-    	eventlist().sourceIsPendingRel(*this, drainTime(_enqueued_low.back()));
-  	} else {
-		assert(0);
-		_serv = QUEUE_INVALID;
-  	}
-}
-
-void AeolusQueue::completeService(){
-	Packet* pkt;
-
-	if (_serv == QUEUE_LOW) {
-		assert(!_enqueued_low.empty());
-		pkt = _enqueued_low.back();
-		_enqueued_low.pop_back();
-		_queuesize_low -= pkt->size();
-		_num_packets++;
-
-  	} else if (_serv==QUEUE_HIGH) {
-		assert(!_enqueued_high.empty());
-    	pkt = _enqueued_high.back();
-    	_enqueued_high.pop_back();
-    	_queuesize_high -= pkt->size();
-    	if (pkt->type() == NDPACK)
-    		_num_acks++;
-    	else if (pkt->type() == NDPNACK)
-			_num_nacks++;
-    	else if (pkt->type() == NDPPULL)
-			_num_pulls++;
-    	else {
-	//cout << "Hdr: type=" << pkt->type() << endl;
-			_num_headers++;
-    	}
-  	} else {
-      assert(0);
-  	}
-    
-    pkt->flow().logTraffic(*pkt,*this,TrafficLogger::PKT_DEPART);
-  	if (_logger) 
-  		_logger->logQueue(*this, QueueLogger::PKT_SERVICE, *pkt);
-  	
-  	pkt->sendOn();
-	_serv = QUEUE_INVALID;
-  
-  //cout << "E[ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ]" << endl;
-
-  	if (!_enqueued_high.empty()||!_enqueued_low.empty())
-    	beginService();
-}
-
-void AeolusQueue::doNextEvent() {
-	completeService();
+    stringstream ss;
+    ss << "compqueue(" << bitrate/1000000 << "Mb/s," << maxsize << "bytes)";
+    _nodename = ss.str();
 }
 
 void AeolusQueue::receivePacket(Packet& pkt)
 {
-    pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_ARRIVE);
-
-    // A first-RTT data packet
-    if (pkt.first_rtt() && !pkt.header_only()) {
-
-    	// Strip the first-RTT packet if the queue length > threshold
-    	if (_queuesize_low + pkt.size() > drop_thresh) {
-	    	pkt.strip_payload();
-	    	_num_stripped++;
-	    	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_TRIM);
-	    		
-	    	if (_logger) 
-	    		_logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
-
-	    	// Later, we will see whether we can enqueue the trimmed packet into the high priority
-	    	goto ENQUEUE_HIGH;
-
-	    // Enqueue the first-RTT packet into the low priority queue
-    	} else {
-			_enqueued_low.push_front(&pkt);
-	    	_queuesize_low += pkt.size();
-	    	
-	    	if (_logger) 
-	    		_logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
-
-	    	if (_serv == QUEUE_INVALID) 
-				beginService();
-	    	
-	    	return;
-    	}
+    // Strip the first-RTT packet if the queue length > threshold
+    if (pkt.first_rtt() && !pkt.header_only()
+	&& queuesize(Q_LO) + pkt.size() > drop_thresh) {
+	pkt.strip_payload();
+	_num_stripped++;
+	pkt.logTraffic(*this,TrafficLogger::PKT_TRIM);
+	if (_logger)
+	    _logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
     }
+    ClassQueue::receivePacket(pkt);
+}
 
-
-    // A non-first-RTT data packet
-    if (!pkt.first_rtt() && !pkt.header_only()) {
-		
-		// regular packet; don't drop the arriving packet
-	    // we are here because either the queue isn't full or,
-	    // it might be full and we randomly chose an enqueued packet to trim
-		if (_queuesize_low + pkt.size() <= _maxsize  || drand() < 0.5) {
-
-	    	// we're going to trim an existing packet from the queue
-	    	if (_queuesize_low + pkt.size() > _maxsize) {
-				if (_enqueued_low.empty()) {
-		    		assert(0);
-				}
-				
-				//take last packet from low prio queue, make it a header and place it in the high prio queue
-				Packet* booted_pkt = _enqueued_low.front();
-				_enqueued_low.pop_front();
-				_queuesize_low -= booted_pkt->size();
-
-				booted_pkt->strip_payload();
-				_num_stripped++;
-				booted_pkt->flow().logTraffic(*booted_pkt,*this,TrafficLogger::PKT_TRIM);
-				
-				if (_logger) 
-					_logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
-				
-				if (_queuesize_high + booted_pkt->size() > _maxsize) {
-		    		if (booted_pkt->reverse_route()  && booted_pkt->bounced() == false) {
-						//return the packet to the sender
-						if (_logger) 
-							_logger->logQueue(*this, QueueLogger::PKT_BOUNCE, *booted_pkt);
-						
-						booted_pkt->flow().logTraffic(pkt,*this,TrafficLogger::PKT_BOUNCE);
-			//XXX what to do with it now?
-#if 0
-			printf("Bounce2 at %s\n", _nodename.c_str());
-			printf("Fwd route:\n");
-			print_route(*(booted_pkt->route()));
-			printf("nexthop: %d\n", booted_pkt->nexthop());
-#endif
-						booted_pkt->bounce();
-#if 0
-			printf("\nRev route:\n");
-			print_route(*(booted_pkt->reverse_route()));
-			printf("nexthop: %d\n", booted_pkt->nexthop());
-#endif
-						_num_bounced++;
-						booted_pkt->sendOn();
-		    		} else {    
-						cout << "Dropped\n";
-						booted_pkt->flow().logTraffic(*booted_pkt,*this,TrafficLogger::PKT_DROP);
-						booted_pkt->free();
-						if (_logger) 
-							_logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
-		    		}
-				} else {
-		    		_enqueued_high.push_front(booted_pkt);
-		    		_queuesize_high += booted_pkt->size();
-				}
-	    	}
-
-	    	// Enqueue the arrival packet into low priority 
-			assert(_queuesize_low + pkt.size() <= _maxsize);
-	    
-	    	_enqueued_low.push_front(&pkt);
-	    	_queuesize_low += pkt.size();
-	    	if (_logger) 
-	    		_logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
-	    
-	    	if (_serv == QUEUE_INVALID) {
-				beginService();
-	    	}
-
-	    	return;
-
-	    // Strip packet the arriving packet - low priority queue is full
-		} else {
-	    	pkt.strip_payload();
-	    	_num_stripped++;
-	    	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_TRIM);
-	    	if (_logger) 
-	    		_logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
-		}
+void AeolusQueue::serviced(Packet& pkt, int cls) {
+    if (cls == Q_LO) {
+	_num_packets++;
+	return;
     }
-
-//	The arrival packet has been trimmed
-//	Try to enqueue it into the high priority
-ENQUEUE_HIGH:
-
-	// The packet must have been trimmed
-	assert(pkt.header_only());
-
-	// The high priority queue is full!
-	if (_queuesize_high + pkt.size() > _maxsize) {
-		//drop header
-		cout << "drop!\n";
-
-		if (pkt.reverse_route()  && pkt.bounced() == false) {
-	    	//return the packet to the sender
-	    	if (_logger) _logger->logQueue(*this, QueueLogger::PKT_BOUNCE, pkt);
-	    	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_BOUNCE);
-	    	//XXX what to do with it now?
-#if 0
-	    	printf("Bounce1 at %s\n", _nodename.c_str());
-	    	printf("Fwd route:\n");
-	    	print_route(*(pkt.route()));
-	    	printf("nexthop: %d\n", pkt.nexthop());
-#endif
-	    	pkt.bounce();
-#if 0
-	    	printf("\nRev route:\n");
-	    	print_route(*(pkt.reverse_route()));
-	    	printf("nexthop: %d\n", pkt.nexthop());
-#endif
-	    	_num_bounced++;
-	    	pkt.sendOn();
-	    	return;
-
-
-	} else {
-		if (_logger) _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
-	    	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_DROP);
-	    	cout << "B[ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ] DROP " 
-	    	 << pkt.flow().id << endl;
-	    	pkt.free();
-	    	_num_drops++;
-	    	return;
-		}
+    switch (pkt.type()) {
+    case NDPACK:
+	_num_acks++;
+	break;
+    case NDPNACK:
+	_num_nacks++;
+	break;
+    case NDPPULL:
+	_num_pulls++;
+	break;
+    default:
+	_num_headers++;
+	break;
     }
-    
-    _enqueued_high.push_front(&pkt);
-    _queuesize_high += pkt.size();
-    
-    if (_serv == QUEUE_INVALID) {
-		beginService();
-	}
-}
-
-mem_b AeolusQueue::queuesize() {
-	return _queuesize_low + _queuesize_high;
 }
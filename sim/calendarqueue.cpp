@@ -0,0 +1,206 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "calendarqueue.h"
+
+#define CQ_MIN_BUCKETS 16
+#define CQ_INITIAL_SHIFT 20  // ~1us wide buckets until we know better
+#define CQ_SAMPLE_SIZE 25    // events sampled to estimate the bucket width
+
+CalendarQueue::CalendarQueue()
+    : _width_shift(CQ_INITIAL_SHIFT), _size(0),
+      _cur_bucket(0), _cur_top(0), _last_time(0), _resizing(false)
+{
+    Bucket empty = {NULL, NULL};
+    _buckets.assign(CQ_MIN_BUCKETS, empty);
+    _mask = CQ_MIN_BUCKETS - 1;
+    set_cursor(0);
+}
+
+// Insert e after the last entry in b that is not later than it.  New
+// events almost always belong at the tail, so search backwards.
+void
+CalendarQueue::link(Bucket& b, PendingEvent* e)
+{
+    PendingEvent* p = b.tail;
+    while (p && p->when > e->when)
+	p = p->prev;
+    e->prev = p;
+    if (p) {
+	e->next = p->next;
+	p->next = e;
+    } else {
+	e->next = b.head;
+	b.head = e;
+    }
+    if (e->next)
+	e->next->prev = e;
+    else
+	b.tail = e;
+}
+
+void
+CalendarQueue::unlink(Bucket& b, PendingEvent* e)
+{
+    if (e->prev)
+	e->prev->next = e->next;
+    else
+	b.head = e->next;
+    if (e->next)
+	e->next->prev = e->prev;
+    else
+	b.tail = e->prev;
+}
+
+void
+CalendarQueue::set_cursor(simtime_picosec when)
+{
+    _cur_bucket = bucket_of(when);
+    _cur_top = ((when >> _width_shift) + 1) << _width_shift;
+}
+
+void
+CalendarQueue::insert(PendingEvent* e)
+{
+    link(_buckets[bucket_of(e->when)], e);
+    _size++;
+    // top() may have left the cursor on a later day than this
+    if (e->when < _cur_top - ((simtime_picosec)1 << _width_shift))
+	set_cursor(e->when);
+    if (!_resizing && _size > 2 * _buckets.size())
+	resize(2 * _buckets.size());
+}
+
+// Find the earliest entry and leave the cursor on its bucket.
+PendingEvent*
+CalendarQueue::find()
+{
+    assert(_size > 0);
+
+    // walk forward through this year's days from the cursor
+    size_t i = _cur_bucket;
+    simtime_picosec top = _cur_top;
+    PendingEvent* e = NULL;
+    for (size_t n = 0; n < _buckets.size(); n++) {
+	PendingEvent* head = _buckets[i].head;
+	if (head && head->when < top) {
+	    _cur_bucket = i;
+	    _cur_top = top;
+	    e = head;
+	    break;
+	}
+	i = (i + 1) & _mask;
+	top += (simtime_picosec)1 << _width_shift;
+    }
+
+    if (!e) {
+	// nothing this year - the queue is sparse, so find the
+	// earliest event directly and jump the cursor to it
+	for (i = 0; i < _buckets.size(); i++) {
+	    PendingEvent* head = _buckets[i].head;
+	    if (head && (!e || head->when < e->when))
+		e = head;
+	}
+	assert(e);
+	set_cursor(e->when);
+    }
+    return e;
+}
+
+// Unlink the earliest entry without freeing it.
+PendingEvent*
+CalendarQueue::take()
+{
+    PendingEvent* e = find();
+    unlink(_buckets[_cur_bucket], e);
+    _size--;
+    _last_time = e->when;
+    return e;
+}
+
+PendingEvent*
+CalendarQueue::pop()
+{
+    PendingEvent* e = take();
+    if (!_resizing && _buckets.size() > CQ_MIN_BUCKETS && _size < _buckets.size() / 2)
+	resize(_buckets.size() / 2);
+    return e;
+}
+
+PendingEvent*
+CalendarQueue::top()
+{
+    return find();
+}
+
+void
+CalendarQueue::remove(PendingEvent* e)
+{
+    unlink(_buckets[bucket_of(e->when)], e);
+    _size--;
+}
+
+// Rehash into nbuckets buckets.  Following Brown, a bucket should be
+// about three times the mean separation between events near the head
+// of the queue; we sample that by dequeuing the first few events and
+// then putting them back.
+void
+CalendarQueue::resize(size_t nbuckets)
+{
+    _resizing = true;
+    simtime_picosec last_time = _last_time;
+
+    vector<PendingEvent*> sample;
+    while (sample.size() < CQ_SAMPLE_SIZE && _size > 0)
+	sample.push_back(take());
+
+    unsigned shift = _width_shift;
+    if (sample.size() > 1) {
+	size_t n = sample.size();
+	simtime_picosec avg = (sample[n-1]->when - sample[0]->when) / (n - 1);
+	// ignore outliers, then recompute
+	simtime_picosec total = 0;
+	size_t count = 0;
+	for (size_t k = 1; k < n; k++) {
+	    simtime_picosec sep = sample[k]->when - sample[k-1]->when;
+	    if (sep <= 2 * avg) {
+		total += sep;
+		count++;
+	    }
+	}
+	if (count > 0)
+	    avg = total / count;
+	// if everything sampled is simultaneous, we've learned
+	// nothing about the spacing, so keep the old width
+	if (avg > 0) {
+	    simtime_picosec width = 3 * avg;
+	    shift = 0;
+	    while (((simtime_picosec)1 << (shift + 1)) <= width)
+		shift++;
+	}
+    }
+
+    vector<Bucket> old;
+    old.swap(_buckets);
+    Bucket empty = {NULL, NULL};
+    _buckets.assign(nbuckets, empty);
+    _mask = nbuckets - 1;
+    _width_shift = shift;
+
+    // the sampled events are the earliest, so they go in first to
+    // keep insertion order among events with equal times
+    for (size_t k = 0; k < sample.size(); k++) {
+	link(_buckets[bucket_of(sample[k]->when)], sample[k]);
+	_size++;
+    }
+    for (size_t i = 0; i < old.size(); i++) {
+	PendingEvent* e = old[i].head;
+	while (e) {
+	    PendingEvent* next = e->next;
+	    link(_buckets[bucket_of(e->when)], e);
+	    e = next;
+	}
+    }
+
+    _last_time = last_time;
+    set_cursor(_last_time);
+    _resizing = false;
+}
@@ -0,0 +1,76 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef CALENDARQUEUE_H
+#define CALENDARQUEUE_H
+
+/*
+ * A calendar queue (R. Brown, CACM 1988) holding the pending event
+ * set of an EventList.  Events are hashed by time into a ring of
+ * buckets, each one "day" wide; each bucket is a time-sorted doubly
+ * linked list.  Insert and dequeue are O(1) amortized as long as the
+ * bucket width tracks the mean event separation, which we re-estimate
+ * whenever the queue grows or shrinks by a factor of two.
+ *
+ * Events with identical times are dequeued in the order they were
+ * inserted, exactly as the multimap in EventList does, so a run is
+ * bit-for-bit identical whichever backend is used.
+ */
+
+#include <vector>
+#include "config.h"
+
+class EventSource;
+
+// One scheduled event.  These are owned and recycled by EventList;
+// the calendar queue threads them onto its buckets via prev/next.
+struct PendingEvent {
+    simtime_picosec when;
+    EventSource* src;
+    PendingEvent* prev;
+    PendingEvent* next;
+    PendingEvent* src_next; // next event pending for the same source
+};
+
+class CalendarQueue {
+ public:
+    CalendarQueue();
+
+    void insert(PendingEvent* e);
+    // remove and return the earliest event; queue must not be empty
+    PendingEvent* pop();
+    // the earliest event, left in place; queue must not be empty
+    PendingEvent* top();
+    void remove(PendingEvent* e);
+    inline bool empty() const {return _size == 0;}
+    inline size_t size() const {return _size;}
+
+ private:
+    struct Bucket {
+	PendingEvent* head;
+	PendingEvent* tail;
+    };
+
+    inline size_t bucket_of(simtime_picosec when) const {
+	return (size_t)(when >> _width_shift) & _mask;
+    }
+    void link(Bucket& b, PendingEvent* e);
+    void unlink(Bucket& b, PendingEvent* e);
+    PendingEvent* find();
+    PendingEvent* take();
+    void resize(size_t nbuckets);
+    void set_cursor(simtime_picosec when);
+
+    vector<Bucket> _buckets;
+    size_t _mask;           // _buckets.size()-1; size is a power of two
+    unsigned _width_shift;  // a bucket is 2^_width_shift picoseconds wide
+    size_t _size;
+
+    // dequeue cursor: the bucket we're currently reading from, the
+    // end of its current "day", and the time of the last dequeue
+    size_t _cur_bucket;
+    simtime_picosec _cur_top;
+    simtime_picosec _last_time;
+
+    bool _resizing;
+};
+
+#endif
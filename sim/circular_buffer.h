@@ -0,0 +1,101 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef CIRCULAR_BUFFER_H
+#define CIRCULAR_BUFFER_H
+
+/*
+ * A double-ended ring buffer with the subset of the list<> interface
+ * that the queues and pipes use.  Storage doubles when it fills and is
+ * never given back, so once a queue has seen its peak occupancy,
+ * enqueue and dequeue never touch the heap - unlike list<>, which
+ * mallocs a node for every packet at every hop.
+ *
+ * As with the lists it replaces, the queues push new packets on the
+ * front and serve them from the back.
+ */
+
+#include "config.h"
+
+template<class T>
+class CircularBuffer {
+ public:
+    CircularBuffer(size_t capacity = 8) : _head(0), _count(0) {
+	size_t c = 1;
+	while (c < capacity)
+	    c <<= 1;
+	_buf = new T[c];
+	_mask = c - 1;
+    }
+    ~CircularBuffer() { delete[] _buf; }
+
+    inline bool empty() const {return _count == 0;}
+    inline size_t size() const {return _count;}
+    inline size_t capacity() const {return _mask + 1;}
+
+    inline T& front() {assert(_count > 0); return _buf[_head];}
+    inline T& back() {assert(_count > 0); return _buf[(_head + _count - 1) & _mask];}
+    inline const T& front() const {assert(_count > 0); return _buf[_head];}
+    inline const T& back() const {assert(_count > 0); return _buf[(_head + _count - 1) & _mask];}
+
+    inline void push_front(const T& v) {
+	if (_count == capacity())
+	    grow();
+	_head = (_head - 1) & _mask;
+	_buf[_head] = v;
+	_count++;
+    }
+    inline void push_back(const T& v) {
+	if (_count == capacity())
+	    grow();
+	_buf[(_head + _count) & _mask] = v;
+	_count++;
+    }
+    inline void pop_front() {
+	assert(_count > 0);
+	_head = (_head + 1) & _mask;
+	_count--;
+    }
+    inline void pop_back() {
+	assert(_count > 0);
+	_count--;
+    }
+
+    // the i'th element from the front
+    inline T& operator[](size_t i) {assert(i < _count); return _buf[(_head + i) & _mask];}
+    // remove the i'th element from the front, closing the gap from
+    // whichever end is nearer
+    void erase(size_t i) {
+	assert(i < _count);
+	if (i < _count / 2) {
+	    for (size_t j = i; j > 0; j--)
+		_buf[(_head + j) & _mask] = _buf[(_head + j - 1) & _mask];
+	    _head = (_head + 1) & _mask;
+	} else {
+	    for (size_t j = i; j + 1 < _count; j++)
+		_buf[(_head + j) & _mask] = _buf[(_head + j + 1) & _mask];
+	}
+	_count--;
+    }
+
+ private:
+    // not copyable - queues and pipes are never copied
+    CircularBuffer(const CircularBuffer&);
+    CircularBuffer& operator=(const CircularBuffer&);
+
+    void grow() {
+	size_t cap = capacity();
+	T* buf = new T[cap * 2];
+	for (size_t i = 0; i < _count; i++)
+	    buf[i] = _buf[(_head + i) & _mask];
+	delete[] _buf;
+	_buf = buf;
+	_head = 0;
+	_mask = cap * 2 - 1;
+    }
+
+    T* _buf;
+    size_t _mask;
+    size_t _head;
+    size_t _count;
+};
+
+#endif
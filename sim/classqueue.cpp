@@ -0,0 +1,309 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "classqueue.h"
+#include "ndppacket.h"
+
+#include <iostream>
+#include <sstream>
+
+// WFQ virtual time advances by size*WFQ_SCALE/weight per packet
+#define WFQ_SCALE 65536
+
+ClassQueue::ClassQueue(linkspeed_bps bitrate, mem_b maxsize, EventList& eventlist,
+		       QueueLogger* logger, classifier_t classifier,
+		       discipline_t discipline)
+    : Queue(bitrate, maxsize, eventlist, logger),
+      _classifier(classifier), _discipline(discipline)
+{
+    _classes = 0;
+    _busy_levels = 0;
+    _serv = -1;
+    _default_class = 0;
+    _num_stripped = 0;
+    _num_bounced = 0;
+    for (int l = 0; l < CLASS_QUEUE_MAX; l++) {
+	_level[l].nmembers = 0;
+	_level[l].backlogged = 0;
+	_level[l].vtime = 0;
+    }
+
+    stringstream ss;
+    ss << "classqueue(" << bitrate/1000000 << "Mb/s," << maxsize << "bytes)";
+    _nodename = ss.str();
+}
+
+int
+ClassQueue::addClass(int level, uint32_t weight, mem_b limit,
+		     overflow_t overflow, int trim_to) {
+    assert(_classes < CLASS_QUEUE_MAX);
+    assert(level >= 0 && level < CLASS_QUEUE_MAX);
+    assert(weight > 0);
+    assert(trim_to < CLASS_QUEUE_MAX);
+    assert(trim_to >= 0 || (overflow != OVERFLOW_TRIM && overflow != OVERFLOW_TRIM_RANDOM));
+    int cls = _classes++;
+    traffic_class& c = _class[cls];
+    c.queued = 0;
+    c.limit = limit;
+    c.level = level;
+    c.weight = weight;
+    c.overflow = overflow;
+    c.trim_to = trim_to;
+    c.deficit = 0;
+    c.last_finish = 0;
+    class_level& l = _level[level];
+    l.members[l.nmembers++] = cls;
+    return cls;
+}
+
+void
+ClassQueue::setFlowClass(uint32_t flow_id, int cls) {
+    assert(cls >= 0 && cls < CLASS_QUEUE_MAX);
+    _flow_class[flow_id] = cls;
+}
+
+void
+ClassQueue::setDefaultClass(int cls) {
+    assert(cls >= 0 && cls < CLASS_QUEUE_MAX);
+    _default_class = cls;
+}
+
+int
+ClassQueue::classify(Packet& pkt) {
+    bool control = pkt.header_only();
+    switch (pkt.type()) {
+    case TCPACK:
+    case NDPACK:
+    case NDPNACK:
+    case NDPPULL:
+    case NDPLITEACK:
+    case NDPLITERTS:
+    case NDPLITEPULL:
+	control = true;
+	break;
+    default:
+	break;
+    }
+
+    switch (_classifier) {
+    case CLASSIFY_CONTROL:
+	return control ? 0 : 1;
+    case CLASSIFY_RETRANSMIT:
+	if (control)
+	    return 0;
+	if (pkt.type() == NDP && ((NdpPacket*)&pkt)->retransmitted())
+	    return 1;
+	return 2;
+    case CLASSIFY_FIRST_RTT:
+	if (control)
+	    return 0;
+	return pkt.first_rtt() ? 2 : 1;
+    case CLASSIFY_FLOW: {
+	std::map<uint32_t, int>::const_iterator i = _flow_class.find(pkt.flow_id());
+	return i == _flow_class.end() ? _default_class : i->second;
+    }
+    }
+    abort();
+}
+
+bool
+ClassQueue::fits(int cls, mem_b size) const {
+    const traffic_class& c = _class[cls];
+    if (_buffer)
+	return _buffer->fits(_buffer_port, cls, size);
+    return c.queued + size <= (c.limit ? c.limit : _maxsize);
+}
+
+void
+ClassQueue::enqueue(Packet& pkt, int cls) {
+    traffic_class& c = _class[cls];
+    class_level& l = _level[c.level];
+    if (c.pkts.empty()) {
+	if (_discipline == DRR)
+	    l.active.push_back(cls);
+	if (l.backlogged++ == 0)
+	    _busy_levels |= 1u << c.level;
+    }
+    if (_discipline == WFQ) {
+	uint64_t start = c.last_finish > l.vtime ? c.last_finish : l.vtime;
+	c.last_finish = start + (uint64_t)pkt.size() * WFQ_SCALE / c.weight;
+	c.finish.push_front(c.last_finish);
+    }
+    c.pkts.push_front(&pkt);
+    c.queued += pkt.size();
+    _queuesize += pkt.size();
+    bufferTake(pkt.size(), cls);
+    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
+}
+
+Packet*
+ClassQueue::unqueueNewest(int cls) {
+    traffic_class& c = _class[cls];
+    if (c.pkts.size() < 2)
+	return NULL;
+    Packet* pkt = c.pkts.front();
+    c.pkts.pop_front();
+    if (_discipline == WFQ) {
+	c.finish.pop_front();
+	c.last_finish = c.finish.front();
+    }
+    c.queued -= pkt->size();
+    _queuesize -= pkt->size();
+    bufferGive(pkt->size(), cls);
+    return pkt;
+}
+
+void
+ClassQueue::drop(Packet& pkt) {
+    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
+    pkt.logTraffic(*this, TrafficLogger::PKT_DROP);
+    pkt.free();
+    _num_drops++;
+    bufferDropped();
+}
+
+void
+ClassQueue::bounceOrDrop(Packet& pkt) {
+    if (pkt.reverse_route() && pkt.bounced() == false) {
+	// return the packet to the sender
+	if (_logger) _logger->logQueue(*this, QueueLogger::PKT_BOUNCE, pkt);
+	pkt.logTraffic(*this, TrafficLogger::PKT_BOUNCE);
+	pkt.bounce();
+	_num_bounced++;
+	pkt.sendOn();
+    } else {
+	drop(pkt);
+    }
+}
+
+void
+ClassQueue::trim(Packet& pkt, int cls) {
+    int to = _class[cls].trim_to;
+    assert(to < _classes);
+    if (to == cls) {
+	bounceOrDrop(pkt);
+	return;
+    }
+    if (!pkt.header_only()) {
+	pkt.strip_payload();
+	_num_stripped++;
+	pkt.logTraffic(*this, TrafficLogger::PKT_TRIM);
+	if (_logger) _logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
+    }
+    if (fits(to, pkt.size()))
+	enqueue(pkt, to);
+    else
+	bounceOrDrop(pkt);
+}
+
+void
+ClassQueue::receivePacket(Packet& pkt)
+{
+    pkt.logTraffic(*this, TrafficLogger::PKT_ARRIVE);
+    int cls = classify(pkt);
+    assert(cls >= 0 && cls < _classes);
+    traffic_class& c = _class[cls];
+
+    if (fits(cls, pkt.size())) {
+	enqueue(pkt, cls);
+    } else {
+	Packet* booted = NULL;
+	if ((c.overflow == OVERFLOW_DROP_RANDOM || c.overflow == OVERFLOW_TRIM_RANDOM)
+	    && _rng.uniform() < 0.5)
+	    booted = unqueueNewest(cls);
+
+	if (booted) {
+	    if (c.overflow == OVERFLOW_DROP_RANDOM)
+		drop(*booted);
+	    else
+		trim(*booted, cls);
+	}
+	if (booted && fits(cls, pkt.size()))
+	    enqueue(pkt, cls);
+	else if (c.overflow == OVERFLOW_TRIM || c.overflow == OVERFLOW_TRIM_RANDOM)
+	    trim(pkt, cls);
+	else
+	    drop(pkt);
+    }
+
+    if (_serv < 0 && _queuesize > 0)
+	beginService();
+}
+
+int
+ClassQueue::nextClass() {
+    assert(_busy_levels);
+    class_level& l = _level[__builtin_ctz(_busy_levels)];
+
+    if (_discipline == DRR) {
+	// the class at the head of the round keeps its turn until its
+	// deficit won't cover its next packet
+	for (;;) {
+	    int cls = l.active.front();
+	    traffic_class& c = _class[cls];
+	    if (c.deficit >= c.pkts.back()->size())
+		return cls;
+	    c.deficit += c.weight;
+	    l.active.pop_front();
+	    l.active.push_back(cls);
+	}
+    }
+
+    int best = -1;
+    for (int i = 0; i < l.nmembers; i++) {
+	int cls = l.members[i];
+	if (_class[cls].pkts.empty())
+	    continue;
+	if (best < 0 || _class[cls].finish.back() < _class[best].finish.back())
+	    best = cls;
+    }
+    assert(best >= 0);
+    return best;
+}
+
+void
+ClassQueue::beginService() {
+    _serv = nextClass();
+    eventlist().sourceIsPendingRel(*this, drainTime(_class[_serv].pkts.back()));
+}
+
+void
+ClassQueue::completeService() {
+    assert(_serv >= 0);
+    int cls = _serv;
+    traffic_class& c = _class[cls];
+    class_level& l = _level[c.level];
+
+    Packet* pkt = c.pkts.back();
+    c.pkts.pop_back();
+    c.queued -= pkt->size();
+    _queuesize -= pkt->size();
+    bufferGive(pkt->size(), cls);
+    if (_discipline == WFQ) {
+	l.vtime = c.finish.back();
+	c.finish.pop_back();
+    } else {
+	c.deficit -= pkt->size();
+    }
+    if (c.pkts.empty()) {
+	if (_discipline == DRR) {
+	    assert(l.active.front() == cls);
+	    l.active.pop_front();
+	    c.deficit = 0;
+	}
+	if (--l.backlogged == 0)
+	    _busy_levels &= ~(1u << c.level);
+    }
+
+    serviced(*pkt, cls);
+    pkt->logTraffic(*this, TrafficLogger::PKT_DEPART);
+    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_SERVICE, *pkt);
+    pkt->sendOn();
+
+    _serv = -1;
+    if (_queuesize > 0)
+	beginService();
+}
+
+void
+ClassQueue::doNextEvent() {
+    completeService();
+}
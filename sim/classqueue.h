@@ -0,0 +1,129 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef CLASS_QUEUE_H
+#define CLASS_QUEUE_H
+
+/*
+ * A queue with up to CLASS_QUEUE_MAX traffic classes, each with its
+ * own byte limit and overflow policy, and a scheduler between them.
+ *
+ * Arriving packets are put in a class by classify(): by packet type
+ * (control and headers vs data), additionally by NDP's retransmitted
+ * flag or by first_rtt, or by a per-flow tag.  Subclasses can override
+ * it for anything else.
+ *
+ * Each class sits at a priority level; lower levels are served
+ * strictly first.  Classes sharing a level split it by weight, either
+ * by deficit round robin (the weight is a quantum in bytes) or by WFQ
+ * (self-clocked: a packet's virtual finish time is its class's last
+ * one, or the level's virtual time if later, plus size/weight, and the
+ * level's virtual time is that of the last packet served).  A class
+ * per level gives strict priority.  Choosing the next packet is O(1)
+ * for strict priority and DRR, and O(classes in the level) for WFQ.
+ *
+ * A packet that doesn't fit its class is dropped, or trimmed to a
+ * header and moved to another class (bounced back to its sender if
+ * that's full too).  The _RANDOM policies instead pick, half the time,
+ * the packet that last joined the class to drop or trim, as
+ * CompositeQueue does.
+ *
+ * With a shared buffer (Queue::setSwitchBuffer), class n draws on the
+ * buffer's class n in place of its limit.
+ */
+
+#include <map>
+#include "queue.h"
+#include "config.h"
+#include "eventlist.h"
+#include "network.h"
+#include "loggertypes.h"
+
+#define CLASS_QUEUE_MAX 8
+
+class ClassQueue : public Queue {
+ public:
+    typedef enum {DRR, WFQ} discipline_t;
+    // CLASSIFY_CONTROL:    0 control packets and headers, 1 data
+    // CLASSIFY_RETRANSMIT: 0 control and headers, 1 retransmitted data, 2 other data
+    // CLASSIFY_FIRST_RTT:  0 control and headers, 1 data, 2 first-RTT data
+    // CLASSIFY_FLOW:       the flow's tag from setFlowClass()
+    typedef enum {CLASSIFY_CONTROL, CLASSIFY_RETRANSMIT, CLASSIFY_FIRST_RTT, CLASSIFY_FLOW} classifier_t;
+    typedef enum {OVERFLOW_DROP, OVERFLOW_DROP_RANDOM, OVERFLOW_TRIM, OVERFLOW_TRIM_RANDOM} overflow_t;
+
+    ClassQueue(linkspeed_bps bitrate, mem_b maxsize, EventList &eventlist,
+	       QueueLogger* logger, classifier_t classifier = CLASSIFY_CONTROL,
+	       discipline_t discipline = DRR);
+
+    // Add the next class and return its number.  weight is a DRR
+    // quantum in bytes or a WFQ weight; a limit of 0 means _maxsize.
+    // OVERFLOW_TRIM* move trimmed packets to class trim_to; a class
+    // that trims to itself bounces what doesn't fit, untrimmed.
+    int addClass(int level, uint32_t weight, mem_b limit = 0,
+		 overflow_t overflow = OVERFLOW_DROP, int trim_to = -1);
+    int classes() const {return _classes;}
+
+    // for CLASSIFY_FLOW; untagged flows go in the default class
+    void setFlowClass(uint32_t flow_id, int cls);
+    void setDefaultClass(int cls);
+
+    virtual void receivePacket(Packet& pkt);
+    virtual void doNextEvent();
+    virtual mem_b queuesize() {return _queuesize;}
+    mem_b queuesize(int cls) const {return _class[cls].queued;}
+    int num_stripped() const {return _num_stripped;}
+    int num_bounced() const {return _num_bounced;}
+
+ protected:
+    // which class pkt belongs in
+    virtual int classify(Packet& pkt);
+    // pkt is leaving class cls
+    virtual void serviced(Packet& pkt, int cls) {}
+
+    void beginService();
+    void completeService();
+
+    int _num_stripped;
+    int _num_bounced;
+
+ private:
+    struct traffic_class {
+	CircularBuffer<Packet*> pkts;
+	CircularBuffer<uint64_t> finish; // WFQ virtual finish times, as pkts
+	mem_b queued;
+	mem_b limit;
+	int level;
+	uint32_t weight;
+	overflow_t overflow;
+	int trim_to;
+	mem_b deficit;        // DRR
+	uint64_t last_finish; // WFQ
+    };
+    struct class_level {
+	CircularBuffer<int> active; // DRR: backlogged classes, in round order
+	int members[CLASS_QUEUE_MAX];
+	int nmembers;
+	int backlogged;
+	uint64_t vtime;             // WFQ
+    };
+
+    bool fits(int cls, mem_b size) const;
+    void enqueue(Packet& pkt, int cls);
+    // take the packet that last joined cls; never its last packet,
+    // which may be in service
+    Packet* unqueueNewest(int cls);
+    void trim(Packet& pkt, int cls);
+    void bounceOrDrop(Packet& pkt);
+    void drop(Packet& pkt);
+    int nextClass();
+
+    classifier_t _classifier;
+    discipline_t _discipline;
+    traffic_class _class[CLASS_QUEUE_MAX];
+    class_level _level[CLASS_QUEUE_MAX];
+    int _classes;
+    uint32_t _busy_levels; // bit n set if level n has packets
+    int _serv;             // class in service, or -1
+    std::map<uint32_t, int> _flow_class;
+    int _default_class;
+};
+
+#endif
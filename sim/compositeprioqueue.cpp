@@ -78,7 +78,7 @@ CompositePrioQueue::completeService(){
       assert(0);
   }
     
-  pkt->flow().logTraffic(*pkt,*this,TrafficLogger::PKT_DEPART);
+  pkt->logTraffic(*this,TrafficLogger::PKT_DEPART);
   if (_logger) _logger->logQueue(*this, QueueLogger::PKT_SERVICE, *pkt);
   pkt->sendOn();
 
@@ -98,10 +98,10 @@ CompositePrioQueue::doNextEvent() {
 void
 CompositePrioQueue::receivePacket(Packet& pkt)
 {
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_ARRIVE);
+    pkt.logTraffic(*this,TrafficLogger::PKT_ARRIVE);
     if (!pkt.header_only()){
 	if (_queuesize_low+pkt.size() <= _maxsize
-	    || ((pkt.path_len() == _enqueued_low.front()->path_len()) && drand()<0.5)
+	    || ((pkt.path_len() == _enqueued_low.front()->path_len()) && _rng.uniform()<0.5)
 	    || ((pkt.path_len() < _max_path_len_queued)) ) {
 	    //regular packet; don't drop the arriving packet
 
@@ -150,7 +150,7 @@ CompositePrioQueue::receivePacket(Packet& pkt)
 	    cout << "B [ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ] STRIP" << endl;
 	    pkt.strip_payload();
 	    _stripped++;
-	    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_TRIM);
+	    pkt.logTraffic(*this,TrafficLogger::PKT_TRIM);
 	    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
 	}
     }
@@ -159,7 +159,7 @@ CompositePrioQueue::receivePacket(Packet& pkt)
     if (_queuesize_high+pkt.size() > _maxsize){
 	//drop header
 	if (_logger) _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
-	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_DROP);
+	pkt.logTraffic(*this,TrafficLogger::PKT_DROP);
 	cout << "D[ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ] DROP " 
 	     << pkt.flow().id << endl;
 	pkt.free();
@@ -304,13 +304,13 @@ CompositePrioQueue::trim_low_priority_packet(uint32_t prio) {
 	    if (_queuesize_high+booted_pkt->size() > _maxsize){
 		// there's no space in the header queue either
 		_dropped++;
-		booted_pkt->flow().logTraffic(*booted_pkt,*this,TrafficLogger::PKT_DROP);
+		booted_pkt->logTraffic(*this,TrafficLogger::PKT_DROP);
 		booted_pkt->free();
 		if (_logger) 
 		    _logger->logQueue(*this, QueueLogger::PKT_DROP, *booted_pkt);
 	    } else {
 		_stripped++;
-		booted_pkt->flow().logTraffic(*booted_pkt,*this,TrafficLogger::PKT_TRIM);
+		booted_pkt->logTraffic(*this,TrafficLogger::PKT_TRIM);
 		_enqueued_high.push_front(booted_pkt);
 		_queuesize_high += booted_pkt->size();
 		if (_logger) 
@@ -20,6 +20,10 @@ CompositeQueue::CompositeQueue(linkspeed_bps bitrate, mem_b maxsize, EventList&
   _num_drops = 0;
   _num_stripped = 0;
   _num_bounced = 0;
+  _num_trimmed_arrival = _num_trimmed_tail = _num_trimmed_largest = _num_trimmed_early = 0;
+  _trim_threshold = 0;
+  _header_maxsize = 0;
+  _trim_victim = TRIM_RANDOM;
 
   _queuesize_high = _queuesize_low = 0;
   _serv = QUEUE_INVALID;
@@ -65,15 +69,14 @@ CompositeQueue::completeService(){
 
   if (_serv==QUEUE_LOW){
     assert(!_enqueued_low.empty());
-    pkt = _enqueued_low.back();
-    _enqueued_low.pop_back();
-    _queuesize_low -= pkt->size();
+    pkt = dequeueLow(_enqueued_low.size() - 1);
     _num_packets++;
   } else if (_serv==QUEUE_HIGH) {
     assert(!_enqueued_high.empty());
     pkt = _enqueued_high.back();
     _enqueued_high.pop_back();
     _queuesize_high -= pkt->size();
+    bufferGive(pkt->size(), 1);
     if (pkt->type() == NDPACK)
 	_num_acks++;
     else if (pkt->type() == NDPNACK)
@@ -88,7 +91,7 @@ CompositeQueue::completeService(){
       assert(0);
   }
     
-  pkt->flow().logTraffic(*pkt,*this,TrafficLogger::PKT_DEPART);
+  pkt->logTraffic(*this,TrafficLogger::PKT_DEPART);
   if (_logger) _logger->logQueue(*this, QueueLogger::PKT_SERVICE, *pkt);
   pkt->sendOn();
 
@@ -108,35 +111,31 @@ CompositeQueue::doNextEvent() {
 void
 CompositeQueue::receivePacket(Packet& pkt)
 {
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_ARRIVE);
+    pkt.logTraffic(*this,TrafficLogger::PKT_ARRIVE);
     if (!pkt.header_only()){
-	if (_queuesize_low+pkt.size() <= _maxsize  || drand()<0.5) {
-	    //regular packet; don't drop the arriving packet
-
-	    // we are here because either the queue isn't full or,
-	    // it might be full and we randomly chose an
-	    // enqueued packet to trim
-	    
-	    if (_queuesize_low+pkt.size()>_maxsize){
-		// we're going to drop an existing packet from the queue
-		if (_enqueued_low.empty()){
-		    //cout << "QUeuesize " << _queuesize_low << " packetsize " << pkt.size() << " maxsize " << _maxsize << endl;
-		    assert(0);
-		}
-		//take last packet from low prio queue, make it a header and place it in the high prio queue
-		
-		Packet* booted_pkt = _enqueued_low.front();
-		_enqueued_low.pop_front();
-		_queuesize_low -= booted_pkt->size();
+	// full packets are class 0 of a shared buffer, headers class 1
+	if (!lowFits(pkt.size())) {
+	    // over the trim threshold, or full: trim the arrival or
+	    // something queued
+	    if (bufferFits(_queuesize_low, pkt.size()))
+		_num_trimmed_early++;
+	    int victim = trimVictim(pkt);
+	    if (victim >= 0) {
+		//take a packet from low prio queue, make it a header and place it in the high prio queue
+		if (_trim_victim == TRIM_LARGEST_FLOW)
+		    _num_trimmed_largest++;
+		else
+		    _num_trimmed_tail++;
+		Packet* booted_pkt = dequeueLow(victim);
 
 		//cout << "A [ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ] STRIP" << endl;
 		//cout << "booted_pkt->size(): " << booted_pkt->size();
 		booted_pkt->strip_payload();
 		_num_stripped++;
-		booted_pkt->flow().logTraffic(*booted_pkt,*this,TrafficLogger::PKT_TRIM);
+		booted_pkt->logTraffic(*this,TrafficLogger::PKT_TRIM);
 		if (_logger) _logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
 		
-		if (_queuesize_high+booted_pkt->size() > _maxsize){
+		if (!highFits(booted_pkt->size())){
 		    if (booted_pkt->reverse_route()  && booted_pkt->bounced() == false) {
 			//return the packet to the sender
 			if (_logger) _logger->logQueue(*this, QueueLogger::PKT_BOUNCE, *booted_pkt);
@@ -158,21 +157,24 @@ CompositeQueue::receivePacket(Packet& pkt)
 			booted_pkt->sendOn();
 		    } else {    
 			cout << "Dropped\n";
-			booted_pkt->flow().logTraffic(*booted_pkt,*this,TrafficLogger::PKT_DROP);
+			booted_pkt->logTraffic(*this,TrafficLogger::PKT_DROP);
 			booted_pkt->free();
+			bufferDropped();
 			if (_logger) _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
 		    }
 		}  
 		else {
 		    _enqueued_high.push_front(booted_pkt);
 		    _queuesize_high += booted_pkt->size();
+		    bufferTake(booted_pkt->size(), 1);
 		}
 	    }
-	    
-	    assert(_queuesize_low+pkt.size()<= _maxsize);
-	    
-	    _enqueued_low.push_front(&pkt);
-	    _queuesize_low += pkt.size();
+	}
+
+	// Trimming one packet needn't make room: a smaller one may have
+	// been trimmed, or other ports may hold the rest of a shared buffer.
+	if (lowFits(pkt.size())) {
+	    enqueueLow(pkt);
 	    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
 	    
 	    if (_serv==QUEUE_INVALID) {
@@ -182,24 +184,24 @@ CompositeQueue::receivePacket(Packet& pkt)
 	    //cout << "BL[ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ]" << endl;
 	    
 	    return;
-	} else {
-	    //strip packet the arriving packet - low priority queue is full
-	    //cout << "B [ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ] STRIP" << endl;
-	    pkt.strip_payload();
-	    _num_stripped++;
-	    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_TRIM);
-	    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
 	}
+	//strip packet the arriving packet - low priority queue is full
+	//cout << "B [ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ] STRIP" << endl;
+	pkt.strip_payload();
+	_num_stripped++;
+	_num_trimmed_arrival++;
+	pkt.logTraffic(*this,TrafficLogger::PKT_TRIM);
+	if (_logger) _logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
     }
     assert(pkt.header_only());
     
-    if (_queuesize_high+pkt.size() > _maxsize){
+    if (!highFits(pkt.size())){
 	//drop header
 	cout << "drop!\n";
 	if (pkt.reverse_route()  && pkt.bounced() == false) {
 	    //return the packet to the sender
 	    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_BOUNCE, pkt);
-	    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_BOUNCE);
+	    pkt.logTraffic(*this,TrafficLogger::PKT_BOUNCE);
 	    //XXX what to do with it now?
 #if 0
 	    printf("Bounce1 at %s\n", _nodename.c_str());
@@ -218,11 +220,12 @@ CompositeQueue::receivePacket(Packet& pkt)
 	    return;
 	} else {
 	    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
-	    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_DROP);
+	    pkt.logTraffic(*this,TrafficLogger::PKT_DROP);
 	    cout << "B[ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ] DROP " 
 	    	 << pkt.flow().id << endl;
 	    pkt.free();
 	    _num_drops++;
+	    bufferDropped();
 	    return;
 	}
     }
@@ -233,6 +236,7 @@ CompositeQueue::receivePacket(Packet& pkt)
     
     _enqueued_high.push_front(&pkt);
     _queuesize_high += pkt.size();
+    bufferTake(pkt.size(), 1);
     
     //cout << "BH[ " << _enqueued_low.size() << " " << _enqueued_high.size() << " ]" << endl;
     
@@ -241,7 +245,100 @@ CompositeQueue::receivePacket(Packet& pkt)
     }
 }
 
+bool
+CompositeQueue::lowFits(mem_b size) const {
+    if (_trim_threshold && _queuesize_low + size > _trim_threshold)
+	return false;
+    return bufferFits(_queuesize_low, size);
+}
+
+bool
+CompositeQueue::highFits(mem_b size) const {
+    if (!_header_maxsize)
+	return bufferFits(_queuesize_high, size, 1);
+    if (_queuesize_high + size > _header_maxsize)
+	return false;
+    return !_buffer || bufferFits(_queuesize_high, size, 1);
+}
+
+void
+CompositeQueue::setTrimVictim(trim_victim_t victim) {
+    // per-flow counts are only kept for TRIM_LARGEST_FLOW
+    assert(_enqueued_low.empty());
+    _trim_victim = victim;
+}
+
+int
+CompositeQueue::trimVictim(Packet& pkt) {
+    if (_enqueued_low.empty())
+	return -1;
+    // the packet at the back may be on the wire
+    size_t n = _enqueued_low.size() - (_serv == QUEUE_LOW ? 1 : 0);
+
+    switch (_trim_victim) {
+    case TRIM_ARRIVAL:
+	return -1;
+    case TRIM_TAIL:
+	return n ? 0 : -1;
+    case TRIM_RANDOM:
+	return (_rng.uniform() < 0.5 && n) ? 0 : -1;
+    case TRIM_LARGEST_FLOW:
+	break;
+    }
+
+    // the arrival's own flow wins ties
+    uint32_t largest = pkt.flow_id();
+    map<uint32_t, mem_b>::const_iterator i = _flow_bytes.find(largest);
+    mem_b most = (i == _flow_bytes.end() ? 0 : i->second) + pkt.size();
+    for (i = _flow_bytes.begin(); i != _flow_bytes.end(); ++i) {
+	if (i->second > most) {
+	    most = i->second;
+	    largest = i->first;
+	}
+    }
+    if (largest == pkt.flow_id())
+	return -1;
+    for (size_t j = 0; j < n; j++)
+	if (_enqueued_low[j]->flow_id() == largest)
+	    return j;
+    return -1;
+}
+
+void
+CompositeQueue::enqueueLow(Packet& pkt) {
+    _enqueued_low.push_front(&pkt);
+    _queuesize_low += pkt.size();
+    bufferTake(pkt.size(), 0);
+    if (_trim_victim == TRIM_LARGEST_FLOW)
+	_flow_bytes[pkt.flow_id()] += pkt.size();
+}
+
+Packet*
+CompositeQueue::dequeueLow(int i) {
+    Packet* pkt = _enqueued_low[i];
+    _enqueued_low.erase(i);
+    _queuesize_low -= pkt->size();
+    bufferGive(pkt->size(), 0);
+    if (_trim_victim == TRIM_LARGEST_FLOW) {
+	map<uint32_t, mem_b>::iterator f = _flow_bytes.find(pkt->flow_id());
+	assert(f != _flow_bytes.end());
+	f->second -= pkt->size();
+	if (f->second == 0)
+	    _flow_bytes.erase(f);
+    }
+    return pkt;
+}
+
 mem_b 
 CompositeQueue::queuesize() {
     return _queuesize_low + _queuesize_high;
 }
+
+void
+CompositeQueue::setMaxsize(mem_b maxsize) {
+    Queue::setMaxsize(maxsize);
+    // the size is part of our node name, ahead of anything setName added
+    stringstream ss;
+    ss << "compqueue(" << _bitrate/1000000 << "Mb/s," << maxsize << "bytes)";
+    _nodename = ss.str() + _nodename.substr(_nodename.find(')') + 1);
+}
@@ -4,6 +4,12 @@
 
 /*
  * A composite queue that transforms packets into headers when there is no space and services headers with priority. 
+ *
+ * By default data is trimmed only once the data queue is full, and the
+ * victim is either the arrival or the last packet queued, at random.
+ * For shallow buffers trimming can start at a lower threshold, the
+ * victim policy can be fixed, and headers can be given their own
+ * capacity.
  */
 
 #define QUEUE_INVALID 0
@@ -11,7 +17,7 @@
 #define QUEUE_HIGH 2
 
 
-#include <list>
+#include <map>
 #include "queue.h"
 #include "config.h"
 #include "eventlist.h"
@@ -20,6 +26,11 @@
 
 class CompositeQueue : public Queue {
  public:
+    // which data packet to trim when there's no room: the arriving
+    // one, the last one queued, one of those at random, or the last
+    // one queued of the flow with the most data queued
+    typedef enum {TRIM_ARRIVAL, TRIM_TAIL, TRIM_RANDOM, TRIM_LARGEST_FLOW} trim_victim_t;
+
     CompositeQueue(linkspeed_bps bitrate, mem_b maxsize, 
 		   EventList &eventlist, QueueLogger* logger);
     virtual void receivePacket(Packet& pkt);
@@ -34,11 +45,18 @@ class CompositeQueue : public Queue {
     int num_nacks() const { return _num_nacks;}
     int num_pulls() const { return _num_pulls;}
     virtual mem_b queuesize();
-    virtual void setName(const string& name) {
-	Logged::setName(name); 
-	_nodename += name;
-    }
-    virtual const string& nodename() { return _nodename; }
+    virtual void setMaxsize(mem_b maxsize);
+
+    // trim data once this many bytes are queued; 0 means at _maxsize
+    void setTrimThreshold(mem_b threshold) {_trim_threshold = threshold;}
+    void setTrimVictim(trim_victim_t victim);
+    // room for headers, acks and pulls; 0 means _maxsize
+    void setHeaderCapacity(mem_b size) {_header_maxsize = size;}
+    // trims broken down by victim, and those made below _maxsize
+    int num_trimmed_arrival() const { return _num_trimmed_arrival;}
+    int num_trimmed_tail() const { return _num_trimmed_tail;}
+    int num_trimmed_largest() const { return _num_trimmed_largest;}
+    int num_trimmed_early() const { return _num_trimmed_early;}
 
     int _num_packets;
     int _num_headers; // only includes data packets stripped to headers, not acks or nacks
@@ -47,6 +65,7 @@ class CompositeQueue : public Queue {
     int _num_pulls;
     int _num_stripped; // count of packets we stripped
     int _num_bounced;  // count of packets we bounced
+    int _num_trimmed_arrival, _num_trimmed_tail, _num_trimmed_largest, _num_trimmed_early;
 
  protected:
     // Mechanism
@@ -56,8 +75,22 @@ class CompositeQueue : public Queue {
     int _serv;
     int _ratio_high, _ratio_low, _crt;
 
-    list<Packet*> _enqueued_low;
-    list<Packet*> _enqueued_high;
+    CircularBuffer<Packet*> _enqueued_low;
+    CircularBuffer<Packet*> _enqueued_high;
+
+    mem_b _trim_threshold;
+    mem_b _header_maxsize;
+    trim_victim_t _trim_victim;
+    map<uint32_t, mem_b> _flow_bytes; // data queued per flow, for TRIM_LARGEST_FLOW
+
+ private:
+    bool lowFits(mem_b size) const;
+    bool highFits(mem_b size) const;
+    // the position in _enqueued_low of the packet to trim to make
+    // room for pkt, or -1 to trim pkt itself
+    int trimVictim(Packet& pkt);
+    void enqueueLow(Packet& pkt);
+    Packet* dequeueLow(int i);
 };
 
 #endif
@@ -2,9 +2,22 @@
 #include <math.h>
 #include "config.h"
 #include "tcppacket.h"
+#include "simcontext.h"
+
+static __thread unsigned int* thread_random_state = NULL;
+
+void setThreadRandomState(unsigned int* state) {
+    thread_random_state = state;
+}
+
+long simrandom() {
+    if (thread_random_state)
+	return rand_r(thread_random_state);
+    return SimContext::current().random();
+}
 
 double drand() {
-    int r=rand();
+    int r=thread_random_state ? rand_r(thread_random_state) : SimContext::current().rand();
     int m=RAND_MAX;
     double d = (double)r/(double)m;
     return d;
@@ -10,6 +10,13 @@
 #include <string>
 
 double drand();
+// Model code should call this rather than random().  It draws from
+// the current SimContext's stream (random() unless seeded), unless
+// the parallel engine has given the calling thread the random state
+// of the partition it is running (see pdes.h), so that results don't
+// depend on how partitions are spread over threads.
+long simrandom();
+void setThreadRandomState(unsigned int* state);
 
 
 #ifdef _WIN32
@@ -46,18 +46,18 @@ CutPayloadQueue::receivePacket(Packet& pkt)
 {
     bool queueWasEmpty = _enqueued.size()==0;
 
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_ARRIVE);
+    pkt.logTraffic(*this,TrafficLogger::PKT_ARRIVE);
     if (_queuesize+pkt.size() > _threshold) {
 	//strip packet the arriving packet
 	pkt.strip_payload();
 	_num_stripped++;
-	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_TRIM);
+	pkt.logTraffic(*this,TrafficLogger::PKT_TRIM);
 	if (_logger) _logger->logQueue(*this, QueueLogger::PKT_TRIM, pkt);
     }
 
     if (_queuesize+pkt.size() > _maxsize) {
 	if (_logger) _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
-	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_DROP);
+	pkt.logTraffic(*this,TrafficLogger::PKT_DROP);
 	pkt.free();
 	_num_drops++;
 	return;
@@ -27,11 +27,6 @@ class CutPayloadQueue : public Queue {
     int num_nacks() const { return _num_nacks;}
     int num_pulls() const { return _num_pulls;}
 
-    virtual void setName(const string& name) {
-	Logged::setName(name); 
-	_nodename += name;
-    }
-    virtual const string& nodename() { return _nodename; }
 
  protected:
     // Mechanism
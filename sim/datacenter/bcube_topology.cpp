@@ -180,7 +180,7 @@ void BCubeTopology::init_network(){
 	    queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	    logfile->addLogger(*queueLogger);
 	    prio_queues_srv(i,k) = alloc_src_queue(queueLogger);
-	    prio_queues_srv(i,k)->setName("PRIO_SRV_" + ntoa(i) + "(" + ntoa(k) + ")");
+	    prio_queues_srv(i,k)->setName("PRIO_SRV_%d(%d)", i, k);
 	}
     }
 
@@ -202,11 +202,11 @@ void BCubeTopology::init_network(){
 	    logfile->addLogger(*queueLogger);
       
 	    queues_srv_switch(i,j,k) = alloc_queue(queueLogger);
-	    queues_srv_switch(i,j,k)->setName("SRV_" + ntoa(i) + "(level_" + ntoa(k)+"))_SW_" +ntoa(j));
+	    queues_srv_switch(i,j,k)->setName("SRV_%d(level_%d))_SW_%d", i, k, j);
 	    logfile->writeName(*(queues_srv_switch(i,j,k)));
       
 	    pipes_srv_switch(i,j,k) = new Pipe(timeFromUs(RTT), *eventlist);
-	    pipes_srv_switch(i,j,k)->setName("Pipe-SRV_" + ntoa(i) + "(level_" + ntoa(k)+")-SW_" +ntoa(j));
+	    pipes_srv_switch(i,j,k)->setName("Pipe-SRV_%d(level_%d)-SW_%d", i, k, j);
 	    logfile->writeName(*(pipes_srv_switch(i,j,k)));
 
 	    queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
@@ -214,11 +214,11 @@ void BCubeTopology::init_network(){
 	    logfile->addLogger(*queueLogger);
       
 	    queues_switch_srv(j,i,k) = alloc_queue(queueLogger);
-	    queues_switch_srv(j,i,k)->setName("SW_" + ntoa(j) + "(level_" + ntoa(k)+")-SRV_" +ntoa(i));
+	    queues_switch_srv(j,i,k)->setName("SW_%d(level_%d)-SRV_%d", j, k, i);
 	    logfile->writeName(*(queues_switch_srv(j,i,k)));
       
 	    pipes_switch_srv(j,i,k) = new Pipe(timeFromUs(RTT), *eventlist);
-	    pipes_switch_srv(j,i,k)->setName("Pipe-SW_" + ntoa(j) + "(level_" + ntoa(k)+")-SRV_" +ntoa(i));
+	    pipes_switch_srv(j,i,k)->setName("Pipe-SW_%d(level_%d)-SRV_%d", j, k, i);
 	    logfile->writeName(*(pipes_switch_srv(j,i,k)));
 	}
     }
@@ -75,7 +75,7 @@ void CamCubeTopology::init_network(){
 	    queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	    logfile->addLogger(*queueLogger);
 	    prio_queues[i][k] = alloc_src_queue(queueLogger);
-	    prio_queues[i][k]->setName("PRIO_SRV_" + ntoa(i) + "(" + ntoa(k) + ")");
+	    prio_queues[i][k]->setName("PRIO_SRV_%d(%d)", i, k);
 	}
     }
 
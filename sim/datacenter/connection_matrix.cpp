@@ -2,7 +2,8 @@
 #include <string.h>
 #include <iostream>
 
-ConnectionMatrix::ConnectionMatrix(int n)
+ConnectionMatrix::ConnectionMatrix(int n, uint64_t stream)
+  : _rng(SimContext::current().rng(stream))
 {
   N = n;
 }
@@ -36,7 +37,7 @@ void ConnectionMatrix::setPermutation(int conn, int rack_size){
 
   for (int src = 0; src < N; src++) {
     do {
-      pos = rand()%perm_tmp.size();
+      pos = _rng.below(perm_tmp.size());
     } while(src==perm_tmp[pos]&&perm_tmp.size()>1);
 
     dest = perm_tmp[pos];
@@ -52,10 +53,10 @@ void ConnectionMatrix::setPermutation(int conn, int rack_size){
 	perm_tmp.push_back(q);
       }
 
-    pos = rand()%perm_tmp.size();
+    pos = _rng.below(perm_tmp.size());
 
     if (rack_count<N){
-      //int pos2 = rand()%perm_tmp.size();
+      //int pos2 = _rng.below(perm_tmp.size());
 
       //if (rack_load[perm_tmp[pos]/rack_size]>rack_load[perm_tmp[pos2]/rack_size])
       //pos = pos2;
@@ -90,7 +91,7 @@ void ConnectionMatrix::setPermutation(){
   for (int src = 0; src < N; src++) {
     vector<int>* destinations = new vector<int>();
       
-    int r = rand()%(N-src);
+    int r = _rng.below(N-src);
     for (dest = 0;dest<N;dest++){
       if (r==0&&!is_dest[dest])
 	break;
@@ -142,8 +143,8 @@ void ConnectionMatrix::setLocalTraffic(Topology* top){
 
 void ConnectionMatrix::setRandom(int cnx){
   for (int conn = 0;conn<cnx; conn++) {
-    int src = rand()%N;
-    int dest = rand()%N;
+    int src = _rng.below(N);
+    int dest = _rng.below(N);
 
     if (src==0||dest==N-1){
       conn--;
@@ -164,20 +165,20 @@ void ConnectionMatrix::setVL2(){
 
     //need to draw a number from VL2 distribution
     int crt = -1;
-    double coin = drand();
+    double coin = _rng.uniform();
     if (coin<0.3)
       crt = 1;
     else if (coin<0.35)
-      crt = 1+rand()%10;
+      crt = 1+_rng.below(10);
     else if (coin<0.85)
       crt = 10;
     else if (coin<0.95)
-      crt = 10+rand()%70;
+      crt = 10+_rng.below(70);
     else 
       crt = 80;
 
     for (int i = 0;i<crt;i++){
-      int dest = rand()%N;
+      int dest = _rng.below(N);
       if (src==dest){
 	i--;
 	continue;
@@ -210,7 +211,7 @@ vector<connection*>* ConnectionMatrix::getAllConnections(){
 
 void ConnectionMatrix::setStaggeredRandom(Topology* top,int conns,double local){
   for (int conn = 0;conn<conns; conn++) {
-    int src = rand()%N;
+    int src = _rng.below(N);
 
     if (connections.find(src)==connections.end()){
       connections[src] = new vector<int>();
@@ -219,11 +220,11 @@ void ConnectionMatrix::setStaggeredRandom(Topology* top,int conns,double local){
     vector<int>* neighbours = top->get_neighbours(src);
 
     int dest;
-    if (drand()<local){
-      dest = neighbours->at(rand()%neighbours->size());
+    if (_rng.uniform()<local){
+      dest = neighbours->at(_rng.below(neighbours->size()));
     }
     else {
-      dest = rand()%N;
+      dest = _rng.below(N);
     }
     connections[src]->push_back(dest);
   }
@@ -239,12 +240,12 @@ void ConnectionMatrix::setStaggeredPermutation(Topology* top,double local){
     connections[src] = new vector<int>();
     vector<int>* neighbours = top->get_neighbours(src);
 
-    double v = drand();
+    double v = _rng.uniform();
     if (v<local){
       i = 0;
       do {
 	found = 0;
-	dest = neighbours->at(rand()%neighbours->size());
+	dest = neighbours->at(_rng.below(neighbours->size()));
 	if (is_dest[dest])
 	  found = 1;
       }
@@ -252,7 +253,7 @@ void ConnectionMatrix::setStaggeredPermutation(Topology* top,double local){
     }
     
     if (v>=local || (v<local&&found)){
-      dest = rand()%N;
+      dest = _rng.below(N);
       while (is_dest[dest])
 	dest = (dest+1)%N;
     }
@@ -272,7 +273,7 @@ void ConnectionMatrix::setManytoMany(int c){
 
   for (i=0;i<(unsigned int)c;i++){
     do {
-      t = rand()%N;
+      t = _rng.below(N);
       f = 0;
       for (j=0;j<hosts.size();j++)
 	if (hosts[j]==t){
@@ -304,7 +305,7 @@ void ConnectionMatrix::setHotspot(int hosts_per_hotspot, int count){
   int first, src;
   for (int k=0;k<count;k++){
     do {
-      first = rand()%N;
+      first = _rng.below(N);
     }
     while (is_dest[first]);
     
@@ -315,7 +316,7 @@ void ConnectionMatrix::setHotspot(int hosts_per_hotspot, int count){
 	if (hosts_per_hotspot==N)
 	  src = i;
 	else
-	  src = rand()%N;
+	  src = _rng.below(N);
       }
       while(is_done[src]);
       is_done[src]=1;
@@ -371,14 +372,14 @@ void ConnectionMatrix::setHotspot(int hosts){
     is_done[i] = 0;
   }
 
-  int first = rand()%N;
+  int first = _rng.below(N);
   is_done[first] = 1;
   is_dest[first] = 1;
 
   for (int i=0;i<hosts-1;i++){
     int src;
     do{
-      src = rand()%N;
+      src = _rng.below(N);
     }
     while(is_done[src]);
     is_done[src]=1;
@@ -393,7 +394,7 @@ void ConnectionMatrix::setHotspot(int hosts){
 
     vector<int>* destinations = new vector<int>();
       
-    int r = rand()%(N-src);
+    int r = _rng.below(N-src);
     for (dest = 0;dest<N;dest++){
       if (r==0&&!is_dest[dest])
 	break;
@@ -6,6 +6,7 @@
 #include "topology.h"
 #include "randomqueue.h"
 #include "eventlist.h"
+#include "rng.h"
 #include <list>
 #include <map>
 
@@ -15,7 +16,8 @@ struct connection{
 
 class ConnectionMatrix{
  public:
-  ConnectionMatrix(int );
+  // draws on the given random stream; see SimContext::rng
+  ConnectionMatrix(int n, uint64_t stream = RNG_STREAM_CONNECTIONS);
   void addConnection(int src, int dest);
   void setPermutation(int conn);
   void setPermutation(int conn, int rack_size);
@@ -35,6 +37,8 @@ class ConnectionMatrix{
 
   map<int,vector<int>*> connections;
   int N;
+ private:
+  Rng _rng; // on its own stream, so it doesn't disturb anything else
 };
 
 #endif
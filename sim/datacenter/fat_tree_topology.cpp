@@ -15,6 +15,7 @@
 #include "queue_lossless_input.h"
 #include "queue_lossless_output.h"
 #include "ecnqueue.h"
+#include "pdes.h"
 
 extern uint32_t RTT;
 
@@ -28,6 +29,7 @@ FatTreeTopology::FatTreeTopology(int no_of_nodes, mem_b queuesize, Logfile* lg,
     _queuesize = queuesize;
     logfile = lg;
     eventlist = ev;
+    engine = NULL;
     ff = fit;
     qt = q;
     failed_links = 0;
@@ -44,6 +46,7 @@ FatTreeTopology::FatTreeTopology(int no_of_nodes, mem_b queuesize, Logfile* lg,
     qt = q;
 
     eventlist = ev;
+    engine = NULL;
     ff = fit;
 
     failed_links = fail;
@@ -53,6 +56,27 @@ FatTreeTopology::FatTreeTopology(int no_of_nodes, mem_b queuesize, Logfile* lg,
     init_network();
 }
 
+FatTreeTopology::FatTreeTopology(int no_of_nodes, mem_b queuesize, Logfile* lg, 
+				 ParallelEngine* e,FirstFit * fit, queue_type q){
+    _queuesize = queuesize;
+    logfile = lg;
+    qt = q;
+
+    // PFC pause frames go straight from queue to queue, not through
+    // pipes, so lossless operation can't be split across partitions
+    assert(qt!=LOSSLESS && qt!=LOSSLESS_INPUT && qt!=LOSSLESS_INPUT_ECN);
+
+    engine = e;
+    eventlist = &engine->global();
+    ff = fit;
+
+    failed_links = 0;
+  
+    set_params(no_of_nodes);
+
+    init_network();
+}
+
 void FatTreeTopology::set_params(int no_of_nodes) {
     cout << "Set params " << no_of_nodes << endl;
     _no_of_nodes = 0;
@@ -92,34 +116,224 @@ void FatTreeTopology::set_params(int no_of_nodes) {
     queues_ns_nlp.resize(NSRV, vector<Queue*>(NK));
 }
 
-Queue* FatTreeTopology::alloc_src_queue(QueueLogger* queueLogger){
-    return  new PriorityQueue(speedFromMbps((uint64_t)HOST_NIC), memFromPkt(FEEDER_BUFFER), *eventlist, queueLogger);
+int FatTreeTopology::pod_partition(int pod) const {
+    if (!engine)
+	return 0;
+    return pod % engine->partitions();
+}
+
+EventList& FatTreeTopology::partition_eventlist(int partition){
+    if (!engine)
+	return *eventlist;
+    return engine->partition(partition);
+}
+
+Pipe* FatTreeTopology::alloc_pipe(int from_partition, int to_partition){
+    if (!engine)
+	return new Pipe(timeFromUs(RTT), *eventlist);
+    return engine->makePipe(timeFromUs(RTT), from_partition, to_partition);
+}
+
+Queue* FatTreeTopology::alloc_src_queue(QueueLogger* queueLogger, EventList& ev){
+    return  new PriorityQueue(speedFromMbps((uint64_t)HOST_NIC), memFromPkt(FEEDER_BUFFER), ev, queueLogger);
 }
 
-Queue* FatTreeTopology::alloc_queue(QueueLogger* queueLogger, mem_b queuesize){
-    return alloc_queue(queueLogger, HOST_NIC, queuesize);
+Queue* FatTreeTopology::alloc_queue(QueueLogger* queueLogger, mem_b queuesize, EventList& ev){
+    return alloc_queue(queueLogger, HOST_NIC, queuesize, ev);
 }
 
-Queue* FatTreeTopology::alloc_queue(QueueLogger* queueLogger, uint64_t speed, mem_b queuesize){
+Queue* FatTreeTopology::alloc_queue(QueueLogger* queueLogger, uint64_t speed, mem_b queuesize, EventList& ev){
     if (qt==RANDOM)
-	return new RandomQueue(speedFromMbps(speed), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
+	return new RandomQueue(speedFromMbps(speed), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), ev, queueLogger, memFromPkt(RANDOM_BUFFER));
     else if (qt==COMPOSITE)
-	return new CompositeQueue(speedFromMbps(speed), queuesize, *eventlist, queueLogger);
+	return new CompositeQueue(speedFromMbps(speed), queuesize, ev, queueLogger);
     else if (qt==AEOLUS)
-  return new AeolusQueue(speedFromMbps(speed), queuesize, *eventlist, queueLogger);
+  return new AeolusQueue(speedFromMbps(speed), queuesize, ev, queueLogger);
     else if (qt==CTRL_PRIO)
-	return new CtrlPrioQueue(speedFromMbps(speed), queuesize, *eventlist, queueLogger);
+	return new CtrlPrioQueue(speedFromMbps(speed), queuesize, ev, queueLogger);
     else if (qt==ECN)
-	return new ECNQueue(speedFromMbps(speed), memFromPkt(2*SWITCH_BUFFER), *eventlist, queueLogger, memFromPkt(15));
+	return new ECNQueue(speedFromMbps(speed), memFromPkt(2*SWITCH_BUFFER), ev, queueLogger, memFromPkt(15));
     else if (qt==LOSSLESS)
-	return new LosslessQueue(speedFromMbps(speed), memFromPkt(50), *eventlist, queueLogger, NULL);
+	return new LosslessQueue(speedFromMbps(speed), memFromPkt(50), ev, queueLogger, NULL);
     else if (qt==LOSSLESS_INPUT)
-	return new LosslessOutputQueue(speedFromMbps(speed), memFromPkt(200), *eventlist, queueLogger);    
+	return new LosslessOutputQueue(speedFromMbps(speed), memFromPkt(200), ev, queueLogger);    
     else if (qt==LOSSLESS_INPUT_ECN)
-	return new LosslessOutputQueue(speedFromMbps(speed), memFromPkt(10000), *eventlist, queueLogger,1,memFromPkt(16));
+	return new LosslessOutputQueue(speedFromMbps(speed), memFromPkt(10000), ev, queueLogger,1,memFromPkt(16));
     assert(0);
 }
 
+void FatTreeTopology::set_queue_size(mem_b queuesize){
+  _queuesize = queuesize;
+  for (int j = 0; j < NK; j++) {
+    for (int k = 0; k < NSRV; k++)
+      if (queues_nlp_ns[j][k])
+	queues_nlp_ns[j][k]->setMaxsize(queuesize);
+    for (int k = 0; k < NK; k++) {
+      if (queues_nup_nlp[j][k])
+	queues_nup_nlp[j][k]->setMaxsize(queuesize);
+      if (queues_nlp_nup[j][k])
+	queues_nlp_nup[j][k]->setMaxsize(queuesize);
+    }
+    for (int k = 0; k < NC; k++)
+      if (queues_nup_nc[j][k])
+	queues_nup_nc[j][k]->setMaxsize(queuesize);
+  }
+  for (int j = 0; j < NC; j++)
+    for (int k = 0; k < NK; k++)
+      if (queues_nc_nup[j][k])
+	queues_nc_nup[j][k]->setMaxsize(queuesize);
+}
+
+void FatTreeTopology::switch_queues(vector<Queue*>& queues){
+  for (int j = 0; j < NK; j++) {
+    for (int k = 0; k < NSRV; k++)
+      queues.push_back(queues_nlp_ns[j][k]);
+    for (int k = 0; k < NK; k++) {
+      queues.push_back(queues_nup_nlp[j][k]);
+      queues.push_back(queues_nlp_nup[j][k]);
+    }
+    for (int k = 0; k < NC; k++)
+      queues.push_back(queues_nup_nc[j][k]);
+  }
+  for (int j = 0; j < NC; j++)
+    for (int k = 0; k < NK; k++)
+      queues.push_back(queues_nc_nup[j][k]);
+}
+
+void FatTreeTopology::set_ecn_marking(const EcnMarker& marker){
+  assert(qt==ECN || qt==LOSSLESS_INPUT_ECN);
+  vector<Queue*> queues;
+  switch_queues(queues);
+  for (size_t i = 0; i < queues.size(); i++) {
+    if (!queues[i])
+      continue;
+    if (qt==ECN)
+      ((ECNQueue*)queues[i])->setMarker(marker);
+    else
+      ((LosslessOutputQueue*)queues[i])->setMarker(marker);
+  }
+}
+
+uint64_t FatTreeTopology::ecn_marks(){
+  assert(qt==ECN || qt==LOSSLESS_INPUT_ECN);
+  vector<Queue*> queues;
+  switch_queues(queues);
+  uint64_t marks = 0;
+  for (size_t i = 0; i < queues.size(); i++) {
+    if (!queues[i])
+      continue;
+    if (qt==ECN)
+      marks += ((ECNQueue*)queues[i])->num_marked();
+    else
+      marks += ((LosslessOutputQueue*)queues[i])->num_marked();
+  }
+  return marks;
+}
+
+void FatTreeTopology::set_trimming(mem_b threshold, CompositeQueue::trim_victim_t victim, mem_b header_size){
+  assert(qt==COMPOSITE);
+  vector<Queue*> queues;
+  switch_queues(queues);
+
+  for (size_t i = 0; i < queues.size(); i++) {
+    if (!queues[i])
+      continue;
+    CompositeQueue* q = (CompositeQueue*)queues[i];
+    q->setTrimThreshold(threshold);
+    q->setTrimVictim(victim);
+    q->setHeaderCapacity(header_size);
+  }
+}
+
+void FatTreeTopology::report_pfc(std::ostream& out){
+  assert(qt==LOSSLESS || qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN);
+  vector<Queue*> queues;
+  switch_queues(queues);
+
+  vector<PfcSender*> senders;
+  for (size_t i = 0; i < queues.size(); i++) {
+    if (!queues[i])
+      continue;
+    PfcSender* s;
+    if (qt==LOSSLESS)
+      s = ((LosslessQueue*)queues[i])->pfc();
+    else
+      s = ((LosslessOutputQueue*)queues[i])->pfc();
+    // queues only know PFC once they've been paused
+    if (s)
+      senders.push_back(s);
+  }
+  for (int k = 0; k < NSRV; k++)
+    for (int j = 0; j < NK; j++)
+      if (queues_ns_nlp[k][j] && ((PriorityQueue*)queues_ns_nlp[k][j])->pfc())
+	senders.push_back(((PriorityQueue*)queues_ns_nlp[k][j])->pfc());
+
+  for (int c = 0; c < PFC_CLASSES; c++) {
+    uint64_t pauses = 0, blocked = 0, deadlocks = 0;
+    simtime_picosec blocked_time = 0;
+    for (size_t i = 0; i < senders.size(); i++) {
+      pauses += senders[i]->pauses(c);
+      blocked += senders[i]->holBlocked(c);
+      blocked_time += senders[i]->blockedTime(c);
+      deadlocks += senders[i]->deadlocks(c);
+    }
+    if (!pauses)
+      continue;
+    out << "PFC class " << c << " pauses " << pauses << " hol_blocked " << blocked
+	<< " blocked_us " << timeAsUs(blocked_time) << " deadlocks " << deadlocks << endl;
+  }
+}
+
+void FatTreeTopology::share_buffers(mem_b pool, double alpha){
+  assert(qt==RANDOM || qt==ECN || qt==COMPOSITE || qt==AEOLUS || qt==LOSSLESS);
+
+  // lossless runs have their switches already; otherwise group each
+  // switch's output queues
+  if (qt!=LOSSLESS) {
+    for (int j=0;j<NK;j++){
+      switches_lp[j] = new Switch("Switch_LowerPod_"+ntoa(j));
+      switches_up[j] = new Switch("Switch_UpperPod_"+ntoa(j));
+      if (j<NC)
+	switches_c[j] = new Switch("Switch_Core_"+ntoa(j));
+    }
+    for (int j=0;j<NK;j++){
+      for (int k=0;k<NSRV;k++)
+	if (queues_nlp_ns[j][k])
+	  switches_lp[j]->addPort(queues_nlp_ns[j][k]);
+      for (int k=0;k<NK;k++){
+	if (queues_nlp_nup[j][k])
+	  switches_lp[j]->addPort(queues_nlp_nup[j][k]);
+	if (queues_nup_nlp[j][k])
+	  switches_up[j]->addPort(queues_nup_nlp[j][k]);
+      }
+      for (int k=0;k<NC;k++)
+	if (queues_nup_nc[j][k])
+	  switches_up[j]->addPort(queues_nup_nc[j][k]);
+    }
+    for (int j=0;j<NC;j++)
+      for (int k=0;k<NK;k++)
+	if (queues_nc_nup[j][k])
+	  switches_c[j]->addPort(queues_nc_nup[j][k]);
+  }
+
+  vector<Switch*> switches(switches_lp);
+  switches.insert(switches.end(), switches_up.begin(), switches_up.end());
+  switches.insert(switches.end(), switches_c.begin(), switches_c.end());
+
+  SwitchBufferLoggerSampling* bufferLogger = new SwitchBufferLoggerSampling(timeFromMs(1000), *eventlist);
+  logfile->addLogger(*bufferLogger);
+  for (size_t i=0;i<switches.size();i++){
+    SwitchBuffer* buffer = new SwitchBuffer(pool, alpha);
+    buffer->setName("Buffer_" + switches[i]->_name);
+    logfile->writeName(*buffer);
+    switches[i]->setBuffer(buffer);
+    bufferLogger->monitorBuffer(buffer);
+    // headroom for PFC, in place of the thresholds it set up
+    if (qt==LOSSLESS)
+      switches[i]->configureLossless(timeFromUs(RTT));
+  }
+}
+
 void FatTreeTopology::init_network(){
   QueueLoggerSampling* queueLogger;
 
@@ -165,19 +379,19 @@ void FatTreeTopology::init_network(){
 	  //queueLogger = NULL;
 	  logfile->addLogger(*queueLogger);
 	  
-	  queues_nlp_ns[j][k] = alloc_queue(queueLogger, _queuesize);
-	  queues_nlp_ns[j][k]->setName("LS" + ntoa(j) + "->DST" +ntoa(k));
+	  queues_nlp_ns[j][k] = alloc_queue(queueLogger, _queuesize, partition_eventlist(switch_partition(j)));
+	  queues_nlp_ns[j][k]->setName("LS%d->DST%d", j, k);
 	  logfile->writeName(*(queues_nlp_ns[j][k]));
 
-	  pipes_nlp_ns[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	  pipes_nlp_ns[j][k]->setName("Pipe-LS" + ntoa(j)  + "->DST" + ntoa(k));
+	  pipes_nlp_ns[j][k] = alloc_pipe(switch_partition(j), host_partition(k));
+	  pipes_nlp_ns[j][k]->setName("Pipe-LS%d->DST%d", j, k);
 	  logfile->writeName(*(pipes_nlp_ns[j][k]));
 	  
 	  // Uplink
 	  queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	  logfile->addLogger(*queueLogger);
-	  queues_ns_nlp[k][j] = alloc_src_queue(queueLogger);
-	  queues_ns_nlp[k][j]->setName("SRC" + ntoa(k) + "->LS" +ntoa(j));
+	  queues_ns_nlp[k][j] = alloc_src_queue(queueLogger, partition_eventlist(host_partition(k)));
+	  queues_ns_nlp[k][j]->setName("SRC%d->LS%d", k, j);
 	  logfile->writeName(*(queues_ns_nlp[k][j]));
 
 	  if (qt==LOSSLESS){
@@ -185,11 +399,12 @@ void FatTreeTopology::init_network(){
 	      ((LosslessQueue*)queues_nlp_ns[j][k])->setRemoteEndpoint(queues_ns_nlp[k][j]);
 	  }else if (qt==LOSSLESS_INPUT || qt == LOSSLESS_INPUT_ECN){
 	      //no virtual queue needed at server
-	      new LosslessInputQueue(*eventlist,queues_ns_nlp[k][j]);
+	      LosslessInputQueue* iq = new LosslessInputQueue(*eventlist,queues_ns_nlp[k][j]);
+	      iq->configurePfc(timeFromUs(RTT));
 	  }
 	  
-	  pipes_ns_nlp[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	  pipes_ns_nlp[k][j]->setName("Pipe-SRC" + ntoa(k) + "->LS" + ntoa(j));
+	  pipes_ns_nlp[k][j] = alloc_pipe(host_partition(k), switch_partition(j));
+	  pipes_ns_nlp[k][j]->setName("Pipe-SRC%d->LS%d", k, j);
 	  logfile->writeName(*(pipes_ns_nlp[k][j]));
 	  
 	  if (ff){
@@ -214,19 +429,19 @@ void FatTreeTopology::init_network(){
 	// Downlink
 	queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	logfile->addLogger(*queueLogger);
-	queues_nup_nlp[k][j] = alloc_queue(queueLogger, _queuesize);
-	queues_nup_nlp[k][j]->setName("US" + ntoa(k) + "->LS_" + ntoa(j));
+	queues_nup_nlp[k][j] = alloc_queue(queueLogger, _queuesize, partition_eventlist(switch_partition(k)));
+	queues_nup_nlp[k][j]->setName("US%d->LS_%d", k, j);
 	logfile->writeName(*(queues_nup_nlp[k][j]));
 	
-	pipes_nup_nlp[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	pipes_nup_nlp[k][j]->setName("Pipe-US" + ntoa(k) + "->LS" + ntoa(j));
+	pipes_nup_nlp[k][j] = alloc_pipe(switch_partition(k), switch_partition(j));
+	pipes_nup_nlp[k][j]->setName("Pipe-US%d->LS%d", k, j);
 	logfile->writeName(*(pipes_nup_nlp[k][j]));
 	
 	// Uplink
 	queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	logfile->addLogger(*queueLogger);
-	queues_nlp_nup[j][k] = alloc_queue(queueLogger, _queuesize);
-	queues_nlp_nup[j][k]->setName("LS" + ntoa(j) + "->US" + ntoa(k));
+	queues_nlp_nup[j][k] = alloc_queue(queueLogger, _queuesize, partition_eventlist(switch_partition(j)));
+	queues_nlp_nup[j][k]->setName("LS%d->US%d", j, k);
 	logfile->writeName(*(queues_nlp_nup[j][k]));
 
 	if (qt==LOSSLESS){
@@ -235,12 +450,14 @@ void FatTreeTopology::init_network(){
 	    switches_up[k]->addPort(queues_nup_nlp[k][j]);
 	    ((LosslessQueue*)queues_nup_nlp[k][j])->setRemoteEndpoint(queues_nlp_nup[j][k]);
 	}else if (qt==LOSSLESS_INPUT || qt == LOSSLESS_INPUT_ECN){	    
-	    new LosslessInputQueue(*eventlist, queues_nlp_nup[j][k]);
-	    new LosslessInputQueue(*eventlist, queues_nup_nlp[k][j]);
+	    LosslessInputQueue* iq = new LosslessInputQueue(*eventlist, queues_nlp_nup[j][k]);
+	    iq->configurePfc(timeFromUs(RTT));
+	    iq = new LosslessInputQueue(*eventlist, queues_nup_nlp[k][j]);
+	    iq->configurePfc(timeFromUs(RTT));
 	}
 	
-	pipes_nlp_nup[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	pipes_nlp_nup[j][k]->setName("Pipe-LS" + ntoa(j) + "->US" + ntoa(k));
+	pipes_nlp_nup[j][k] = alloc_pipe(switch_partition(j), switch_partition(k));
+	pipes_nlp_nup[j][k]->setName("Pipe-LS%d->US%d", j, k);
 	logfile->writeName(*(pipes_nlp_nup[j][k]));
 	
 	if (ff){
@@ -266,12 +483,12 @@ void FatTreeTopology::init_network(){
 	queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	logfile->addLogger(*queueLogger);
 
-	queues_nup_nc[j][k] = alloc_queue(queueLogger, _queuesize);
-	queues_nup_nc[j][k]->setName("US" + ntoa(j) + "->CS" + ntoa(k));
+	queues_nup_nc[j][k] = alloc_queue(queueLogger, _queuesize, partition_eventlist(switch_partition(j)));
+	queues_nup_nc[j][k]->setName("US%d->CS%d", j, k);
 	logfile->writeName(*(queues_nup_nc[j][k]));
 	
-	pipes_nup_nc[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	pipes_nup_nc[j][k]->setName("Pipe-US" + ntoa(j) + "->CS" + ntoa(k));
+	pipes_nup_nc[j][k] = alloc_pipe(switch_partition(j), core_partition(k));
+	pipes_nup_nc[j][k]->setName("Pipe-US%d->CS%d", j, k);
 	logfile->writeName(*(pipes_nup_nc[j][k]));
 	
 	// Uplink
@@ -280,13 +497,13 @@ void FatTreeTopology::init_network(){
 	logfile->addLogger(*queueLogger);
 	
 	if ((l+j*K/2)<failed_links){
-	    queues_nc_nup[k][j] = alloc_queue(queueLogger,HOST_NIC/10, _queuesize);
+	    queues_nc_nup[k][j] = alloc_queue(queueLogger,HOST_NIC/10, _queuesize, partition_eventlist(core_partition(k)));
 	  cout << "Adding link failure for j" << ntoa(j) << " l " << ntoa(l) << endl;
 	}
  	else
-	    queues_nc_nup[k][j] = alloc_queue(queueLogger, _queuesize);
+	    queues_nc_nup[k][j] = alloc_queue(queueLogger, _queuesize, partition_eventlist(core_partition(k)));
 	
-	queues_nc_nup[k][j]->setName("CS" + ntoa(k) + "->US" + ntoa(j));
+	queues_nc_nup[k][j]->setName("CS%d->US%d", k, j);
 
 
 	if (qt==LOSSLESS){
@@ -296,14 +513,16 @@ void FatTreeTopology::init_network(){
 	    ((LosslessQueue*)queues_nc_nup[k][j])->setRemoteEndpoint(queues_nup_nc[j][k]);
 	}
 	else if (qt == LOSSLESS_INPUT || qt == LOSSLESS_INPUT_ECN){
-	    new LosslessInputQueue(*eventlist, queues_nup_nc[j][k]);
-	    new LosslessInputQueue(*eventlist, queues_nc_nup[k][j]);
+	    LosslessInputQueue* iq = new LosslessInputQueue(*eventlist, queues_nup_nc[j][k]);
+	    iq->configurePfc(timeFromUs(RTT));
+	    iq = new LosslessInputQueue(*eventlist, queues_nc_nup[k][j]);
+	    iq->configurePfc(timeFromUs(RTT));
 	}
 
 	logfile->writeName(*(queues_nc_nup[k][j]));
 	
-	pipes_nc_nup[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	pipes_nc_nup[k][j]->setName("Pipe-CS" + ntoa(k) + "->US" + ntoa(j));
+	pipes_nc_nup[k][j] = alloc_pipe(core_partition(k), switch_partition(j));
+	pipes_nc_nup[k][j]->setName("Pipe-CS%d->US%d", k, j);
 	logfile->writeName(*(pipes_nc_nup[k][j]));
 	
 	if (ff){
@@ -323,10 +542,10 @@ void FatTreeTopology::init_network(){
     //init thresholds for lossless operation
     if (qt==LOSSLESS)
 	for (int j=0;j<NK;j++){
-	    switches_lp[j]->configureLossless();
-	    switches_up[j]->configureLossless();
+	    switches_lp[j]->configureLossless(timeFromUs(RTT));
+	    switches_up[j]->configureLossless(timeFromUs(RTT));
 	    if (j<NC)
-		switches_c[j]->configureLossless();
+		switches_c[j]->configureLossless(timeFromUs(RTT));
 	}
 }
 
@@ -348,211 +567,109 @@ void check_non_null(Route* rt){
   }
 }
 
-vector<const Route*>* FatTreeTopology::get_paths(int src, int dest){
-  vector<const Route*>* paths = new vector<const Route*>();
+// Paths are computed hop by hop as packets follow them rather than
+// stored.  Between pods, path n goes through core switch n, and so
+// through the (2n/K)'th upper switch of each pod; within a pod, path n
+// goes through the pod's n'th upper switch; and hosts on the same edge
+// switch have just the one path.  Either way the path back from dest
+// to src through the same switches has the same number.
+int FatTreeTopology::no_of_paths(int src, int dest) const {
+  if (HOST_POD_SWITCH(src)==HOST_POD_SWITCH(dest))
+    return 1;
+  if (HOST_POD(src)==HOST_POD(dest))
+    return K/2;
+  return K*K/4;
+}
 
-  route_t *routeout, *routeback;
-  //QueueLoggerSimple *simplequeuelogger = new QueueLoggerSimple();
-  //QueueLoggerSimple *simplequeuelogger = 0;
-  //logfile->addLogger(*simplequeuelogger);
-  //Queue* pqueue = new Queue(speedFromMbps((uint64_t)HOST_NIC), memFromPkt(FEEDER_BUFFER), *eventlist, simplequeuelogger);
-  //pqueue->setName("PQueue_" + ntoa(src) + "_" + ntoa(dest));
-  //logfile->writeName(*pqueue);
-  if (HOST_POD_SWITCH(src)==HOST_POD_SWITCH(dest)){
-  
-    // forward path
-    routeout = new Route();
-    //routeout->push_back(pqueue);
-    routeout->push_back(queues_ns_nlp[src][HOST_POD_SWITCH(src)]);
-    routeout->push_back(pipes_ns_nlp[src][HOST_POD_SWITCH(src)]);
+// Each link on a path is its queue and pipe, and with lossless input
+// queues the queue at the far end; the last link, to the host, has no
+// far end queue.
+size_t FatTreeTopology::path_hops(int src, int dest, int path) const {
+  int links = HOST_POD_SWITCH(src)==HOST_POD_SWITCH(dest) ? 2 : HOST_POD(src)==HOST_POD(dest) ? 4 : 6;
+  return links*hops_per_link() - (hops_per_link()-2);
+}
 
-    if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	routeout->push_back(queues_ns_nlp[src][HOST_POD_SWITCH(src)]->getRemoteEndpoint());
+PacketSink* FatTreeTopology::path_hop(int src, int dest, int path, size_t i) const {
+  int link, hop;
+  if (hops_per_link()==2){
+    link = i >> 1;
+    hop = i & 1;
+  } else {
+    link = i / 3;
+    hop = i % 3;
+  }
 
-    routeout->push_back(queues_nlp_ns[HOST_POD_SWITCH(dest)][dest]);
-    routeout->push_back(pipes_nlp_ns[HOST_POD_SWITCH(dest)][dest]);
+  Queue* q;
+  Pipe* p;
+  int sw_src = HOST_POD_SWITCH(src);
+  if (link==0){
+    q = queues_ns_nlp[src][sw_src];
+    p = pipes_ns_nlp[src][sw_src];
+  } else {
+    int sw_dest = HOST_POD_SWITCH(dest);
+    int pod_src = HOST_POD(src), pod_dest = HOST_POD(dest);
+    int last = sw_src==sw_dest ? 1 : pod_src==pod_dest ? 3 : 5;
+    if (link==last){
+      q = queues_nlp_ns[sw_dest][dest];
+      p = pipes_nlp_ns[sw_dest][dest];
+    } else if (last==3){
+      int upper = MIN_POD_ID(pod_src) + path;
+      if (link==1){
+	q = queues_nlp_nup[sw_src][upper];
+	p = pipes_nlp_nup[sw_src][upper];
+      } else {
+	q = queues_nup_nlp[upper][sw_dest];
+	p = pipes_nup_nlp[upper][sw_dest];
+      }
+    } else {
+      int core = path;
+      int upper = MIN_POD_ID(pod_src) + 2 * core / K;
+      int upper2 = MIN_POD_ID(pod_dest) + 2 * core / K;
+      switch (link){
+      case 1:
+	q = queues_nlp_nup[sw_src][upper];
+	p = pipes_nlp_nup[sw_src][upper];
+	break;
+      case 2:
+	q = queues_nup_nc[upper][core];
+	p = pipes_nup_nc[upper][core];
+	break;
+      case 3:
+	q = queues_nc_nup[core][upper2];
+	p = pipes_nc_nup[core][upper2];
+	break;
+      default:
+	q = queues_nup_nlp[upper2][sw_dest];
+	p = pipes_nup_nlp[upper2][sw_dest];
+	break;
+      }
+    }
+  }
 
-    // reverse path for RTS packets
-    routeback = new Route();
-    routeback->push_back(queues_ns_nlp[dest][HOST_POD_SWITCH(dest)]);
-    routeback->push_back(pipes_ns_nlp[dest][HOST_POD_SWITCH(dest)]);
+  if (hop==0)
+    return q;
+  if (hop==1)
+    return p;
+  return q->getRemoteEndpoint();
+}
 
-    if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	routeback->push_back(queues_ns_nlp[dest][HOST_POD_SWITCH(dest)]->getRemoteEndpoint());
+vector<const Route*>* FatTreeTopology::get_paths(int src, int dest){
+  vector<const Route*>* paths = new vector<const Route*>();
 
-    routeback->push_back(queues_nlp_ns[HOST_POD_SWITCH(src)][src]);
-    routeback->push_back(pipes_nlp_ns[HOST_POD_SWITCH(src)][src]);
+  int n = no_of_paths(src, dest);
+  for (int path = 0; path < n; path++){
+    route_t* routeout = new Route(this, src, dest, path);
+    // reverse path for RTS packets
+    route_t* routeback = new Route(this, dest, src, path);
 
     routeout->set_reverse(routeback);
     routeback->set_reverse(routeout);
 
     //print_route(*routeout);
     paths->push_back(routeout);
-
     check_non_null(routeout);
-    return paths;
-  }
-  else if (HOST_POD(src)==HOST_POD(dest)){
-    //don't go up the hierarchy, stay in the pod only.
-
-    int pod = HOST_POD(src);
-    //there are K/2 paths between the source and the destination
-    for (int upper = MIN_POD_ID(pod);upper <= MAX_POD_ID(pod); upper++){
-      //upper is nup
-      
-      routeout = new Route();
-      //routeout->push_back(pqueue);
-      
-      routeout->push_back(queues_ns_nlp[src][HOST_POD_SWITCH(src)]);
-      routeout->push_back(pipes_ns_nlp[src][HOST_POD_SWITCH(src)]);
-
-      if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	  routeout->push_back(queues_ns_nlp[src][HOST_POD_SWITCH(src)]->getRemoteEndpoint());
-
-      routeout->push_back(queues_nlp_nup[HOST_POD_SWITCH(src)][upper]);
-      routeout->push_back(pipes_nlp_nup[HOST_POD_SWITCH(src)][upper]);
-
-      if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	  routeout->push_back(queues_nlp_nup[HOST_POD_SWITCH(src)][upper]->getRemoteEndpoint());
-
-      routeout->push_back(queues_nup_nlp[upper][HOST_POD_SWITCH(dest)]);
-      routeout->push_back(pipes_nup_nlp[upper][HOST_POD_SWITCH(dest)]);
-
-      if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	  routeout->push_back(queues_nup_nlp[upper][HOST_POD_SWITCH(dest)]->getRemoteEndpoint());
-
-      routeout->push_back(queues_nlp_ns[HOST_POD_SWITCH(dest)][dest]);
-      routeout->push_back(pipes_nlp_ns[HOST_POD_SWITCH(dest)][dest]);
-
-      // reverse path for RTS packets
-      routeback = new Route();
-      
-      routeback->push_back(queues_ns_nlp[dest][HOST_POD_SWITCH(dest)]);
-      routeback->push_back(pipes_ns_nlp[dest][HOST_POD_SWITCH(dest)]);
-
-      if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	  routeback->push_back(queues_ns_nlp[dest][HOST_POD_SWITCH(dest)]->getRemoteEndpoint());
-
-      routeback->push_back(queues_nlp_nup[HOST_POD_SWITCH(dest)][upper]);
-      routeback->push_back(pipes_nlp_nup[HOST_POD_SWITCH(dest)][upper]);
-
-      if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	  routeback->push_back(queues_nlp_nup[HOST_POD_SWITCH(dest)][upper]->getRemoteEndpoint());
-
-      routeback->push_back(queues_nup_nlp[upper][HOST_POD_SWITCH(src)]);
-      routeback->push_back(pipes_nup_nlp[upper][HOST_POD_SWITCH(src)]);
-
-      if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	  routeback->push_back(queues_nup_nlp[upper][HOST_POD_SWITCH(src)]->getRemoteEndpoint());
-      
-      routeback->push_back(queues_nlp_ns[HOST_POD_SWITCH(src)][src]);
-      routeback->push_back(pipes_nlp_ns[HOST_POD_SWITCH(src)][src]);
-
-      routeout->set_reverse(routeback);
-      routeback->set_reverse(routeout);
-      
-      //print_route(*routeout);
-      paths->push_back(routeout);
-      check_non_null(routeout);
-    }
-    return paths;
-  }
-  else {
-    int pod = HOST_POD(src);
-
-    for (int upper = MIN_POD_ID(pod);upper <= MAX_POD_ID(pod); upper++)
-      for (int core = (upper%(K/2)) * K / 2; core < ((upper % (K/2)) + 1)*K/2; core++){
-	//upper is nup
-	
-	routeout = new Route();
-	//routeout->push_back(pqueue);
-	
-	routeout->push_back(queues_ns_nlp[src][HOST_POD_SWITCH(src)]);
-	routeout->push_back(pipes_ns_nlp[src][HOST_POD_SWITCH(src)]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeout->push_back(queues_ns_nlp[src][HOST_POD_SWITCH(src)]->getRemoteEndpoint());
-	
-	routeout->push_back(queues_nlp_nup[HOST_POD_SWITCH(src)][upper]);
-	routeout->push_back(pipes_nlp_nup[HOST_POD_SWITCH(src)][upper]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeout->push_back(queues_nlp_nup[HOST_POD_SWITCH(src)][upper]->getRemoteEndpoint());
-	
-	routeout->push_back(queues_nup_nc[upper][core]);
-	routeout->push_back(pipes_nup_nc[upper][core]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeout->push_back(queues_nup_nc[upper][core]->getRemoteEndpoint());
-	
-	//now take the only link down to the destination server!
-	
-	int upper2 = HOST_POD(dest)*K/2 + 2 * core / K;
-	//printf("K %d HOST_POD(%d) %d core %d upper2 %d\n",K,dest,HOST_POD(dest),core, upper2);
-	
-	routeout->push_back(queues_nc_nup[core][upper2]);
-	routeout->push_back(pipes_nc_nup[core][upper2]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeout->push_back(queues_nc_nup[core][upper2]->getRemoteEndpoint());	
-
-	routeout->push_back(queues_nup_nlp[upper2][HOST_POD_SWITCH(dest)]);
-	routeout->push_back(pipes_nup_nlp[upper2][HOST_POD_SWITCH(dest)]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeout->push_back(queues_nup_nlp[upper2][HOST_POD_SWITCH(dest)]->getRemoteEndpoint());
-	
-	routeout->push_back(queues_nlp_ns[HOST_POD_SWITCH(dest)][dest]);
-	routeout->push_back(pipes_nlp_ns[HOST_POD_SWITCH(dest)][dest]);
-
-	// reverse path for RTS packets
-	routeback = new Route();
-	
-	routeback->push_back(queues_ns_nlp[dest][HOST_POD_SWITCH(dest)]);
-	routeback->push_back(pipes_ns_nlp[dest][HOST_POD_SWITCH(dest)]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeback->push_back(queues_ns_nlp[dest][HOST_POD_SWITCH(dest)]->getRemoteEndpoint());
-	
-	routeback->push_back(queues_nlp_nup[HOST_POD_SWITCH(dest)][upper2]);
-	routeback->push_back(pipes_nlp_nup[HOST_POD_SWITCH(dest)][upper2]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeback->push_back(queues_nlp_nup[HOST_POD_SWITCH(dest)][upper2]->getRemoteEndpoint());
-	
-	routeback->push_back(queues_nup_nc[upper2][core]);
-	routeback->push_back(pipes_nup_nc[upper2][core]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeback->push_back(queues_nup_nc[upper2][core]->getRemoteEndpoint());
-	
-	//now take the only link back down to the src server!
-	
-	routeback->push_back(queues_nc_nup[core][upper]);
-	routeback->push_back(pipes_nc_nup[core][upper]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeback->push_back(queues_nc_nup[core][upper]->getRemoteEndpoint());
-	
-	routeback->push_back(queues_nup_nlp[upper][HOST_POD_SWITCH(src)]);
-	routeback->push_back(pipes_nup_nlp[upper][HOST_POD_SWITCH(src)]);
-
-	if (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN)
-	    routeback->push_back(queues_nup_nlp[upper][HOST_POD_SWITCH(src)]->getRemoteEndpoint());
-	
-	routeback->push_back(queues_nlp_ns[HOST_POD_SWITCH(src)][src]);
-	routeback->push_back(pipes_nlp_ns[HOST_POD_SWITCH(src)][src]);
-
-
-	routeout->set_reverse(routeback);
-	routeback->set_reverse(routeout);
-	
-	//print_route(*routeout);
-	paths->push_back(routeout);
-	check_non_null(routeout);
-      }
-    return paths;
   }
+  return paths;
 }
 
 void FatTreeTopology::count_queue(Queue* queue){
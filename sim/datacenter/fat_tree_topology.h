@@ -11,6 +11,8 @@
 #include "logfile.h"
 #include "eventlist.h"
 #include "switch.h"
+#include "compositequeue.h"
+#include "ecn_marker.h"
 #include <ostream>
 
 //#define N K*K*K/4
@@ -27,7 +29,9 @@
 typedef enum {RANDOM, ECN, COMPOSITE, AEOLUS, CTRL_PRIO, LOSSLESS, LOSSLESS_INPUT, LOSSLESS_INPUT_ECN} queue_type;
 #endif
 
-class FatTreeTopology: public Topology{
+class ParallelEngine;
+
+class FatTreeTopology: public Topology, public PathAlgorithm{
  public:
 /*	
   Pipe * pipes_nc_nup[NC][NK];
@@ -65,20 +69,58 @@ class FatTreeTopology: public Topology{
   FirstFit* ff;
   Logfile* logfile;
   EventList* eventlist;
+  ParallelEngine* engine;
   int failed_links;
   queue_type qt;
 
   FatTreeTopology(int no_of_nodes, mem_b queuesize, Logfile* log,EventList* ev,FirstFit* f, queue_type q);
   FatTreeTopology(int no_of_nodes, mem_b queuesize, Logfile* log,EventList* ev,FirstFit* f, queue_type q, int fail);
+  // Build the network across the partitions of a parallel engine,
+  // one pod per partition (wrapping round if there are more pods than
+  // partitions) and the core switches dealt out round-robin.  Loggers
+  // go on the engine's global eventlist.
+  FatTreeTopology(int no_of_nodes, mem_b queuesize, Logfile* log,ParallelEngine* e,FirstFit* f, queue_type q);
 
   void init_network();
   virtual vector<const Route*>* get_paths(int src, int dest);
+  int no_of_paths(int src, int dest) const;
+  size_t path_hops(int src, int dest, int path) const;
+  PacketSink* path_hop(int src, int dest, int path, size_t i) const;
+  // resize every switch queue, e.g. to reuse one topology for runs
+  // with different buffer sizes; host NIC queues are left alone
+  void set_queue_size(mem_b queuesize);
+  // Give each switch one buffer of pool bytes, shared by its ports
+  // with dynamic threshold alpha (see switch_buffer.h), in place of
+  // each queue's own.  Call before any traffic; RANDOM, ECN, COMPOSITE
+  // and LOSSLESS queues only.  Lossless switches get PFC headroom.
+  void share_buffers(mem_b pool, double alpha);
+  // Trim at threshold bytes rather than when full, choosing victims
+  // by policy, and give headers header_size bytes of their own (0
+  // leaves either at the queue size).  COMPOSITE queues only.
+  void set_trimming(mem_b threshold, CompositeQueue::trim_victim_t victim, mem_b header_size);
+  // Per PFC class: pauses received, pauses that held up waiting
+  // packets and for how long, and watchdog deadlocks, summed over the
+  // hosts and every switch port.  Lossless queue types only.
+  void report_pfc(std::ostream& out);
+  // Mark as marker does at every switch queue (see ecn_marker.h), and
+  // count the marks they've made.  ECN and LOSSLESS_INPUT_ECN only.
+  void set_ecn_marking(const EcnMarker& marker);
+  uint64_t ecn_marks();
+
+  // the partition, and so the eventlist, each node runs in
+  int host_partition(int host) const {return pod_partition(HOST_POD(host));}
+  int switch_partition(int sw) const {return pod_partition(2*sw/K);}
+  int core_partition(int core) const {return pod_partition(core%K);}
+  EventList& partition_eventlist(int partition);
 
-  Queue* alloc_src_queue(QueueLogger* q);
-  Queue* alloc_queue(QueueLogger* q, mem_b queuesize);
-  Queue* alloc_queue(QueueLogger* q, uint64_t speed, mem_b queuesize);
+  Queue* alloc_src_queue(QueueLogger* q, EventList& ev);
+  Queue* alloc_queue(QueueLogger* q, mem_b queuesize, EventList& ev);
+  Queue* alloc_queue(QueueLogger* q, uint64_t speed, mem_b queuesize, EventList& ev);
+  Pipe* alloc_pipe(int from_partition, int to_partition);
 
   void count_queue(Queue*);
+  // every switch queue, or NULL where there's no link
+  void switch_queues(vector<Queue*>& queues);
   void print_path(std::ofstream& paths,int src,const Route* route);
   vector<int>* get_neighbours(int src) { return NULL;};
   int no_of_nodes() const {return _no_of_nodes;}
@@ -89,6 +131,8 @@ class FatTreeTopology: public Topology{
   int find_core_switch(Queue* queue);
   int find_destination(Queue* queue);
   void set_params(int no_of_nodes);
+  int pod_partition(int pod) const;
+  int hops_per_link() const {return (qt==LOSSLESS_INPUT || qt==LOSSLESS_INPUT_ECN) ? 3 : 2;}
   int K, NK, NC, NSRV;
   int _no_of_nodes;
   mem_b _queuesize;
@@ -1,10 +1,10 @@
 #include "firstfit.h"
 #include <iostream>
 
-FirstFit::FirstFit(simtime_picosec scanPeriod, EventList& eventlist, vector<const Route*>*** n) : EventSource(eventlist,"FirstFit"), _scanPeriod(scanPeriod) /*, _init(0)*/
+FirstFit::FirstFit(simtime_picosec scanPeriod, EventList& eventlist) : EventSource(eventlist,"FirstFit"), _scanPeriod(scanPeriod) /*, _init(0)*/
 {
   eventlist.sourceIsPendingRel(*this, _scanPeriod);
-  net_paths = n;
+  path_cache = NULL;
 
   threshold = (int)(timeAsSec(_scanPeriod) * HOST_NIC * 100);
 
@@ -76,8 +76,9 @@ void FirstFit::run(){
       int best_route = -1, best_cost = 10000000;
       int crt_cost;
 
-      for (unsigned int p = 0;p<net_paths[f->src][f->dest]->size();p++){
-	const Route* crt_route = net_paths[f->src][f->dest]->at(p);
+      vector<const Route*>* paths = (*path_cache)[f->src][f->dest];
+      for (unsigned int p = 0;p<paths->size();p++){
+	const Route* crt_route = paths->at(p);
 	crt_cost = 0;
 
 	for (unsigned int i=1;i<crt_route->size()-1;i+=2)
@@ -95,7 +96,7 @@ void FirstFit::run(){
       //printf("Switching flow %d %d to path %d\n",f->src,f->dest,best_route);
       cout << "S";
 
-      Route* new_route = new Route(*(net_paths[f->src][f->dest]->at(best_route)));
+      Route* new_route = new Route(*(paths->at(best_route)));
       new_route->push_back(tcp->_sink);
 
       tcp->replace_route(new_route);
@@ -5,6 +5,7 @@
 #include "tcp.h"
 #include "randomqueue.h"
 #include "eventlist.h"
+#include "topology.h"
 #include <list>
 #include <map>
 
@@ -26,13 +27,13 @@ struct flow_entry {
 
 class FirstFit: public EventSource{
  public:
-  FirstFit(simtime_picosec scanPeriod, EventList& eventlist,vector<const Route*>*** np = NULL);
+  FirstFit(simtime_picosec scanPeriod, EventList& eventlist);
   void doNextEvent();
 
   void run();
   void add_flow(int src,int dest,TcpSrc* flow);
   void add_queue(Queue* queue);
-  vector<const Route*>*** net_paths;
+  PathCache* path_cache; // where to find each flow's paths
 
  private:
   map<TcpSrc*,flow_entry*> flow_counters;
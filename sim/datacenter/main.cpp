@@ -79,6 +79,8 @@ int main(int argc, char **argv) {
     int no_of_conns = 0, no_of_nodes = DEFAULT_NODES;
     stringstream filename(ios_base::out);
 
+    int seed = time(NULL);
+
     int i = 1;
     filename << "logout.dat";
 
@@ -91,6 +93,9 @@ int main(int argc, char **argv) {
 	else if (!strcmp(argv[i],"-sub")){
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-conns")){
 	    no_of_conns = atoi(argv[i+1]);
 	    cout << "no_of_conns "<<no_of_conns << endl;
@@ -121,7 +126,8 @@ int main(int argc, char **argv) {
 
 	i++;
     }
-    srand(time(NULL));
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     cout << "Using subflow count " << subflow_count <<endl;
     cout << "conns " << no_of_conns << endl;
@@ -207,20 +213,15 @@ int main(int argc, char **argv) {
     no_of_nodes = top->no_of_nodes();
     cout << "actual nodes " << no_of_nodes << endl;
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
     
     vector<int>* destinations;
 
@@ -253,18 +254,17 @@ int main(int argc, char **argv) {
 	for (unsigned int dst_id = 0;dst_id<destinations->size();dst_id++){
 	    connID++;
 	    dest = destinations->at(dst_id);
-	    if (!net_paths[src][dest])
-		net_paths[src][dest] = top->get_paths(src,dest);
+	    net_paths.get(top, src, dest);
 
 	    /*bool cbr = 1;
 	      if (cbr){
 	      cbrSrc = new CbrSrc(eventlist,speedFromPktps(7999),timeFromMs(0),timeFromMs(0));
 	      cbrSnk = new CbrSink();
 	      
-	      cbrSrc->setName("cbr_" + ntoa(src) + "_" + ntoa(dest)+"_"+ntoa(dst_id));
+	      cbrSrc->setName("cbr_%d_%d_%d", src, dest, dst_id);
 	      logfile.writeName(*cbrSrc);
 	      
-	      cbrSnk->setName("cbr_sink_" + ntoa(src) + "_" + ntoa(dest)+"_"+ntoa(dst_id));
+	      cbrSnk->setName("cbr_sink_%d_%d_%d", src, dest, dst_id);
 	      logfile.writeName(*cbrSnk);
 	      
 	      // tell it the route
@@ -423,7 +423,7 @@ int main(int argc, char **argv) {
 			mtcp->addSubflow(tcpSrc);
 	      
 			if (inter == 0) {
-			    mtcp->setName("multipath" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+			    mtcp->setName("multipath%d_%d(%d)", src, dest, connection);
 			    logfile.writeName(*mtcp);
 			}
 	      
@@ -90,6 +90,11 @@ int main(int argc, char **argv) {
 	flowsize=Packet::data_packet_size()*50;
     stringstream filename(ios_base::out);
 
+    int seed = 13;
+
+    EcnMarker marker(memFromPkt(16)); // as the topology's lossless ECN queues
+    bool marking = false;
+    int nargs;
     int i = 1;
     filename << "logout.dat";
 
@@ -98,6 +103,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")) {
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -120,12 +128,18 @@ int main(int argc, char **argv) {
 	} else if (!strcmp(argv[i],"-q")){
 	    queuesize = memFromPkt(atoi(argv[i+1]));
 	    i++;
+	} else if ((nargs = marker.parseOption(argc, argv, i)) != 0) {
+	    if (nargs < 0)
+		exit_error(argv[0]);
+	    marking = true;
+	    i += nargs;
 	} else
 	    exit_error(argv[0]);
 	
 	i++;
     }
-    srand(13);
+    srand(seed);
+    SimContext::current().setSeed(seed);
 
     cout << "Using subflow count " << subflow_count <<endl;
 
@@ -178,6 +192,8 @@ int main(int argc, char **argv) {
 #ifdef FAT_TREE
     FatTreeTopology* top = new FatTreeTopology(no_of_nodes, queuesize, &logfile, 
 					       &eventlist,ff,LOSSLESS_INPUT_ECN,0);
+    if (marking)
+	top->set_ecn_marking(marker);
 #endif
 
 #ifdef OV_FAT_TREE
@@ -201,21 +217,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #ifdef USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -256,16 +267,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		subflows_chosen.clear();
@@ -288,10 +295,10 @@ int main(int argc, char **argv) {
 		tcpSrc->set_flowsize(flowsize);
 		tcpSrc->_rto = timeFromMs(10);
 
-		tcpSrc->setName("tcp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		tcpSrc->setName("tcp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*tcpSrc);
 	  
-		tcpSnk->setName("tcp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		tcpSnk->setName("tcp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*tcpSnk);
 	  
 		tcpRtxScanner.registerTcp(*tcpSrc);
@@ -373,7 +380,7 @@ int main(int argc, char **argv) {
 		routeout = new Route(*(net_paths[src][dest]->at(choice)));
 		routeout->push_back(tcpSnk);
 	  
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
+		routein = new Route(*(net_paths[dest][src]->at(choice)));
 		routein->push_back(tcpSrc);
 
 		extrastarttime = 80;
@@ -413,17 +420,17 @@ int main(int argc, char **argv) {
     TcpSink* longSnk = new TcpSink();
     tcpSrc->set_ssthresh(10*Packet::data_packet_size());
     tcpSrc->_rto = timeFromMs(10);
-    longSrc->setName("long_" + ntoa(long_src_no) + "_" + ntoa(long_dest_no));
+    longSrc->setName("long_%d_%d", long_src_no, long_dest_no);
     logfile.writeName(*longSrc);
-    longSnk->setName("long_sink_" + ntoa(long_src_no) + "_" + ntoa(long_dest_no));
+    longSnk->setName("long_sink_%d_%d", long_src_no, long_dest_no);
     logfile.writeName(*longSnk);
     tcpRtxScanner.registerTcp(*longSrc);
 
-    vector<const Route*>* srcpaths = top->get_paths(long_src_no, long_dest_no);
+    vector<const Route*>* srcpaths = net_paths.get(top, long_src_no, long_dest_no);
     routeout = new Route(*(srcpaths->at(0)));
     routeout->push_back(longSnk);
 
-    vector<const Route*>* dstpaths = top->get_paths(long_dest_no, long_src_no);
+    vector<const Route*>* dstpaths = net_paths.get(top, long_dest_no, long_src_no);
     routein = new Route(*(dstpaths->at(0)));
     routein->push_back(longSrc);
 
@@ -447,6 +454,10 @@ int main(int argc, char **argv) {
     }
 
     cout << "Done" << endl;
+#ifdef FAT_TREE
+    if (marking)
+	cout << "ECN marks " << top->ecn_marks() << endl;
+#endif
     /*list <const Route*>::iterator rt_i;
     int counts[10]; int hop;
     for (int i = 0; i < 10; i++)
@@ -82,6 +82,11 @@ int main(int argc, char **argv) {
     stringstream filename(ios_base::out);
     RouteStrategy route_strategy = NOT_SET;
 
+    int seed = 13;
+
+    EcnMarker marker(memFromPkt(15)); // as the topology's ECN queues
+    bool marking = false;
+    int nargs;
     int i = 1;
     filename << "logout.dat";
 
@@ -90,6 +95,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")){
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -116,12 +124,18 @@ int main(int argc, char **argv) {
 		route_strategy = SINGLE_PATH;
 	    }
 	    i++;
+	} else if ((nargs = marker.parseOption(argc, argv, i)) != 0) {
+	    if (nargs < 0)
+		exit_error(argv[0]);
+	    marking = true;
+	    i += nargs;
 	} else {
 	    exit_error(argv[0]);
 	}
 	i++;
     }
-    srand(13);
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     if (route_strategy == NOT_SET) {
 	fprintf(stderr, "Route Strategy not set.  Use the -strat param.  \nValid values are perm, rand, pull, rg and single\n");
@@ -179,6 +193,8 @@ int main(int argc, char **argv) {
 
 #ifdef OV_FAT_TREE
     OversubscribedFatTreeTopology* top = new OversubscribedFatTreeTopology(&logfile, &eventlist,ff,ECN);
+    if (marking)
+	top->set_ecn_marking(marker);
 #endif
 
 #ifdef MH_FAT_TREE
@@ -200,21 +216,16 @@ int main(int argc, char **argv) {
     no_of_nodes = top->no_of_nodes();
     cout << "actual nodes " << no_of_nodes << endl;
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
 
-    for (int i=0; i<no_of_nodes; i++){
+    for (int i=0; i<no_of_nodes; i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0; j<no_of_nodes; j++)
-	    net_paths[i][j] = NULL;
-    }
 
 #if USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -253,16 +264,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		subflows_chosen.clear();
@@ -278,10 +285,10 @@ int main(int argc, char **argv) {
 		ndp_srcs.push_back(ndpSrc);
 		ndpSnk = new TcpSink();
 	  
-		ndpSrc->setName("dctcp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		ndpSrc->setName("dctcp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("dctcp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("dctcp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
 		ndpRtxScanner.registerTcp(*ndpSrc);
@@ -363,9 +370,7 @@ int main(int argc, char **argv) {
 		routeout = new Route(*(net_paths[src][dest]->at(choice)));
 		routeout->push_back(ndpSnk);
 	  
-		routein = new Route();
-
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
+		routein = new Route(*(net_paths[dest][src]->at(choice)));
 		routein->push_back(ndpSrc);
 
 		extrastarttime = 0 * drand();
@@ -401,6 +406,10 @@ int main(int argc, char **argv) {
     }
 
     cout << "Done" << endl;
+#ifdef OV_FAT_TREE
+    if (marking)
+	cout << "ECN marks " << top->ecn_marks() << endl;
+#endif
     list <const Route*>::iterator rt_i;
     /*
     int stripped[10],bounced[10],counts[10]; int hop;
@@ -77,8 +77,14 @@ int main(int argc, char **argv) {
     Clock c(timeFromSec(5 / 100.), eventlist);
     int no_of_conns = DEFAULT_NODES, no_of_nodes = DEFAULT_NODES, ssthresh = 15;
     mem_b queuesize = memFromPkt(DEFAULT_QUEUE_SIZE);
+    mem_b shared_buffer = 0; // per switch; 0 for a buffer per queue
+    double alpha = 1;
+    EcnMarker marker(memFromPkt(15)); // as the topology's ECN queues
+    bool marking = false;
+    int nargs;
     stringstream filename(ios_base::out);
     int failed_links = 0;
+    int seed = time(NULL);
     int i = 1;
     filename << "logout.dat";
 
@@ -88,6 +94,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")){
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -107,6 +116,19 @@ int main(int argc, char **argv) {
 	    queuesize = memFromPkt(atoi(argv[i+1]));
 	    cout << "queuesize "<<queuesize << endl;
 	    i++;
+	} else if (!strcmp(argv[i],"-sharedbuf")){
+	    shared_buffer = memFromPkt(atoi(argv[i+1]));
+	    i++;
+	} else if (!strcmp(argv[i],"-alpha")){
+	    alpha = atof(argv[i+1]);
+	    i++;
+	} else if ((nargs = marker.parseOption(argc, argv, i)) != 0) {
+	    if (nargs < 0)
+		exit_error(argv[0], argv[i]);
+	    marking = true;
+	    i += nargs;
+	} else if (!strcmp(argv[i],"-sharedpipes")){
+	    Pipe::setSharedDelayLines(true);
 	} else if (!strcmp(argv[i],"-fail")){
 	    failed_links = atoi(argv[i+1]);
 	    cout << "failed_links "<<failed_links << endl;
@@ -115,7 +137,8 @@ int main(int argc, char **argv) {
 	    exit_error(argv[0], argv[i]);
 	i++;
     }
-    srand(time(NULL));
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     cout << "Using subflow count " << subflow_count <<endl;
       
@@ -164,6 +187,10 @@ int main(int argc, char **argv) {
 #ifdef FAT_TREE
     FatTreeTopology* top = new FatTreeTopology(no_of_nodes, queuesize, &logfile, 
 					       &eventlist,ff,ECN,failed_links);
+    if (shared_buffer)
+	top->share_buffers(shared_buffer, alpha);
+    if (marking)
+	top->set_ecn_marking(marker);
 #endif
 
 #ifdef OV_FAT_TREE
@@ -187,21 +214,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #if USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -239,16 +261,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		cnt_con ++;
@@ -263,10 +281,10 @@ int main(int argc, char **argv) {
 		    //}
 		tcpSrc->set_ssthresh(ssthresh*Packet::data_packet_size());
 		
-		tcpSrc->setName("dctcp_" + ntoa(src) + "_" + ntoa(dest));
+		tcpSrc->setName("dctcp_%d_%d", src, dest);
 		logfile.writeName(*tcpSrc);
 		
-		tcpSnk->setName("dctcp_sink_" + ntoa(src) + "_" + ntoa(dest));
+		tcpSnk->setName("dctcp_sink_%d_%d", src, dest);
 		logfile.writeName(*tcpSnk);
 		
 		tcpRtxScanner.registerTcp(*tcpSrc);
@@ -334,7 +352,7 @@ int main(int argc, char **argv) {
 		    routeout = new Route(*(net_paths[src][dest]->at(choice)));
 		    routeout->push_back(tcpSnk);
 		    
-		    routein = new Route(*(top->get_paths(dest,src)->at(choice)));
+		    routein = new Route(*(net_paths[dest][src]->at(choice)));
 		    routein->push_back(tcpSrc);
 		    
 		    extrastarttime = 0 * drand();
@@ -373,6 +391,10 @@ int main(int argc, char **argv) {
     }
 
     cout << "Done" << endl;
+#ifdef FAT_TREE
+    if (marking)
+	cout << "ECN marks " << top->ecn_marks() << endl;
+#endif
 }
 
 string ntoa(double n) {
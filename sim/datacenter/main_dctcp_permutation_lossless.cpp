@@ -23,6 +23,7 @@
 //#include "vl2_topology.h"
 
 #include "fat_tree_topology.h"
+#include "pfc.h"
 //#include "oversubscribed_fat_tree_topology.h"
 //#include "multihomed_fat_tree_topology.h"
 //#include "star_topology.h"
@@ -80,6 +81,13 @@ int main(int argc, char **argv) {
     mem_b queuesize = memFromPkt(DEFAULT_QUEUE_SIZE);
     stringstream filename(ios_base::out);
 
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    int seed = start.tv_usec;
+
+    EcnMarker marker(memFromPkt(16)); // as the topology's lossless ECN queues
+    bool marking = false;
+    int nargs;
     int i = 1;
     filename << "logout.dat";
 
@@ -88,6 +96,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")){
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -103,16 +114,23 @@ int main(int argc, char **argv) {
 	} else if (!strcmp(argv[i],"-q")){
 	    queuesize = memFromPkt(atoi(argv[i+1]));
 	    i++;
+	} else if (!strcmp(argv[i],"-pfcctrl")){
+	    // give acks, nacks, pulls and headers their own PFC class
+	    PfcClass::setControl(atoi(argv[i+1]));
+	    i++;
+	} else if ((nargs = marker.parseOption(argc, argv, i)) != 0) {
+	    if (nargs < 0)
+		exit_error(argv[0]);
+	    marking = true;
+	    i += nargs;
 	} else {
 	    exit_error(argv[0]);
 	}
 	i++;
     }
     
-    struct timeval start;
-    gettimeofday(&start, NULL);
-
-    srand(start.tv_usec);
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     cout << "Using subflow count " << subflow_count <<endl;
 
@@ -164,6 +182,8 @@ int main(int argc, char **argv) {
 #ifdef FAT_TREE
     FatTreeTopology* top = new FatTreeTopology(no_of_nodes, queuesize, 
 					       &logfile, &eventlist,ff,LOSSLESS_INPUT_ECN,0);
+    if (marking)
+	top->set_ecn_marking(marker);
 #endif
 
 #ifdef OV_FAT_TREE
@@ -190,21 +210,16 @@ int main(int argc, char **argv) {
     no_of_nodes = top->no_of_nodes();
     cout << "actual nodes " << no_of_nodes << endl;
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0; i<no_of_nodes; i++){
+    for (int i=0; i<no_of_nodes; i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0; j<no_of_nodes; j++)
-	    net_paths[i][j] = NULL;
-    }
 
 #if USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -243,16 +258,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    cout << "Connection from " << src << " to " << dest << endl;
 
@@ -274,10 +285,10 @@ int main(int argc, char **argv) {
 		ndp_srcs.push_back(ndpSrc);
 		ndpSnk = new TcpSink();//eventlist, 1 /*pull at line rate*/);
 	  
-		ndpSrc->setName("dctcp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		ndpSrc->setName("dctcp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("dctcp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("dctcp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
 		tcpRtxScanner.registerTcp(*ndpSrc);
@@ -356,12 +367,12 @@ int main(int argc, char **argv) {
 						}*/
 #endif
 	  
-		routeout = new Route(*top->get_paths(src,dest)->at(choice));//*(net_paths[src][dest]->at(choice)));
+		routeout = new Route(*(net_paths[src][dest]->at(choice)));
 		routeout->push_back(ndpSnk);
 		
 		//routein = new Route();
 
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
+		routein = new Route(*(net_paths[dest][src]->at(choice)));
 		routein->push_back(ndpSrc);
 
 		extrastarttime = 0 * drand();
@@ -400,6 +411,11 @@ int main(int argc, char **argv) {
     }
 
     cout << "Done" << endl;
+#ifdef FAT_TREE
+    if (marking)
+	cout << "ECN marks " << top->ecn_marks() << endl;
+#endif
+    top->report_pfc(cout);
 }
 
 string ntoa(double n) {
@@ -71,7 +71,7 @@ void print_path(std::ofstream &paths, const Route* rt){
 }
 
 int main(int argc, char **argv) {
-    Packet::set_packet_size(1500);
+    Packet::set_packet_size(9000); // it's a datacentre, use jumbograms
     eventlist.setEndtime(timeFromSec(0.201));
     Clock c(timeFromSec(5 / 100.), eventlist);
     int algo = COUPLED_EPSILON;
@@ -79,6 +79,9 @@ int main(int argc, char **argv) {
     int no_of_conns = 0, no_of_nodes = DEFAULT_NODES, cwnd = 15,seed = 1;
     stringstream filename(ios_base::out);
 
+    EcnMarker marker(memFromPkt(16)); // as the topology's lossless ECN queues
+    bool marking = false;
+    int nargs;
     int i = 1;
     filename << "logout.dat";
 
@@ -122,12 +125,18 @@ int main(int argc, char **argv) {
 		i++;
 	    }
 	    printf("Using epsilon %f\n", epsilon);
+	} else if ((nargs = marker.parseOption(argc, argv, i)) != 0) {
+	    if (nargs < 0)
+		exit_error(argv[0]);
+	    marking = true;
+	    i += nargs;
 	} else
 	    exit_error(argv[0]);
 
 	i++;
     }
     srand(seed);
+    SimContext::current().setSeed(seed);
       
     cout << "Using subflow count " << subflow_count <<endl;
       
@@ -160,7 +169,6 @@ int main(int argc, char **argv) {
     logfile.addLogger(sinkLogger);
     TcpTrafficLogger traffic_logger = TcpTrafficLogger();
     logfile.addLogger(traffic_logger);
-    TcpPacket::set_packet_size(9000); // it's a datacentre, use jumbograms
     TcpSrc* ndpSrc;
     TcpSink* ndpSnk;
 
@@ -180,6 +188,8 @@ int main(int argc, char **argv) {
 #ifdef FAT_TREE
     FatTreeTopology* top = new FatTreeTopology(no_of_nodes, memFromPkt(8), &logfile, 
 					       &eventlist,ff,LOSSLESS_INPUT_ECN,0);
+    if (marking)
+	top->set_ecn_marking(marker);
 #endif
 
 #ifdef OV_FAT_TREE
@@ -203,21 +213,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #ifdef USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -256,16 +261,12 @@ int main(int argc, char **argv) {
 	    dest = destinations->at(dst_id);
 
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		cnt_con ++;
@@ -282,10 +283,10 @@ int main(int argc, char **argv) {
 		ndpSrc->set_ssthresh(cwnd*Packet::data_packet_size());
 
 		
-		ndpSrc->setName("dctcp_" + ntoa(src) + "_" + ntoa(dest));
+		ndpSrc->setName("dctcp_%d_%d", src, dest);
 		logfile.writeName(*ndpSrc);
 		
-		ndpSnk->setName("dctcp_sink_" + ntoa(src) + "_" + ntoa(dest));
+		ndpSnk->setName("dctcp_sink_%d_%d", src, dest);
 		logfile.writeName(*ndpSnk);
 		
 		ndpRtxScanner.registerTcp(*ndpSrc);
@@ -361,7 +362,7 @@ int main(int argc, char **argv) {
 		    routeout = new Route(*(net_paths[src][dest]->at(choice)));
 		    routeout->push_back(ndpSnk);
 		    
-		    routein = new Route(*(top->get_paths(dest,src)->at(choice)));
+		    routein = new Route(*(net_paths[dest][src]->at(choice)));
 		    routein->push_back(ndpSrc);
 		    
 		    extrastarttime = 0 * drand();
@@ -402,6 +403,10 @@ int main(int argc, char **argv) {
     }
 
     cout << "Done" << endl;
+#ifdef FAT_TREE
+    if (marking)
+	cout << "ECN marks " << top->ecn_marks() << endl;
+#endif
 
     /*    list <const Route*>::iterator rt_i;
     int counts[10]; int hop;
@@ -81,6 +81,8 @@ int main(int argc, char **argv) {
     int no_of_conns = 0, cwnd = 15, no_of_nodes = DEFAULT_NODES;
     stringstream filename(ios_base::out);
 
+    int seed = 13;
+
     int i = 1;
     filename << "logout.dat";
 
@@ -89,6 +91,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")){
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -126,7 +131,8 @@ int main(int argc, char **argv) {
 
 	i++;
     }
-    srand(13);
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     cout << "Using subflow count " << subflow_count <<endl;
 
@@ -201,21 +207,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #if USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -254,16 +255,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		subflows_chosen.clear();
@@ -287,10 +284,10 @@ int main(int argc, char **argv) {
 		}
 	  
 		ndpSrc->setCwnd(cwnd*Packet::data_packet_size());
-		ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		ndpSrc->setName("ndp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
 		ndpRtxScanner.registerNdp(*ndpSrc);
@@ -370,12 +367,10 @@ int main(int argc, char **argv) {
 #endif
 	  
 		routeout = new Route(*(net_paths[src][dest]->at(choice)));
-		routeout->push_back(ndpSnk);
+		routeout->add_endpoints(ndpSrc, ndpSnk);
 	  
-		routein = new Route();
-
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
-		routein->push_back(ndpSrc);
+		routein = new Route(*(net_paths[dest][src]->at(choice)));
+		routein->add_endpoints(ndpSnk, ndpSrc);
 
 		extrastarttime = 0 * drand();
 	  
@@ -78,6 +78,7 @@ int main(int argc, char **argv) {
     int param = 0, cwnd = 15;
     stringstream filename(ios_base::out);
 
+    int seed = time(NULL);
     int i = 1;
     filename << "logout.dat";
 
@@ -87,6 +88,10 @@ int main(int argc, char **argv) {
 	    filename << argv[i+1];
 	    i++;
 	}
+	else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
+	}
 	else
 	    if (!strcmp(argv[i],"-sub")){
 		subflow_count = atoi(argv[i+1]);
@@ -126,7 +131,8 @@ int main(int argc, char **argv) {
 
 	i++;
     }
-    srand(time(NULL));
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     cout << "Using subflow count " << subflow_count <<endl;
 
@@ -206,21 +212,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[N];
+    PathCache net_paths;
 
     int* is_dest = new int[N];
     
-    for (int i=0;i<N;i++){
+    for (int i=0;i<N;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[N];
-	for (int j = 0;j<N;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #ifdef USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -262,8 +263,7 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		int min_length = 1000;
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back(paths->at(i));
@@ -271,10 +271,7 @@ int main(int argc, char **argv) {
 			min_length = (*paths)[i]->size();
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		subflows_chosen.clear();
@@ -295,10 +292,10 @@ int main(int argc, char **argv) {
 		ndpSnk = new NdpSink(eventlist,  2 /*pull at sum on both incoming line rates*/);
 		ndp_sinks.push_back(ndpSnk);
 	  
-		ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		ndpSrc->setName("ndp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
 		ndpRtxScanner.registerNdp(*ndpSrc);
@@ -381,12 +378,10 @@ int main(int argc, char **argv) {
 #endif
 	  
 		routeout = new Route(*(net_paths[src][dest]->at(choice)));
-		routeout->push_back(ndpSnk);
+		routeout->add_endpoints(ndpSrc, ndpSnk);
 	  
-		routein = new Route();
-
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
-		routein->push_back(ndpSrc);
+		routein = new Route(*(net_paths[dest][src]->at(choice)));
+		routein->add_endpoints(ndpSnk, ndpSrc);
 
 		extrastarttime = 0 * drand();
 	  
@@ -78,6 +78,8 @@ int main(int argc, char **argv) {
     stringstream filename(ios_base::out);
     RouteStrategy route_strategy = NOT_SET;
     
+    int seed = 13;
+    
     int i = 1;
     filename << "logout.dat";
 
@@ -86,6 +88,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-conns")) {
 	    no_of_conns = atoi(argv[i+1]);
 	    cout << "no_of_conns "<<no_of_conns << endl;
@@ -121,7 +126,8 @@ int main(int argc, char **argv) {
 
 	i++;
     }
-    srand(13);
+    srand(seed);
+    SimContext::current().setSeed(seed);
     if (route_strategy == NOT_SET) {
 	fprintf(stderr, "Route Strategy not set.  Use the -strat param.  \nValid values are perm, rand, pull, rg and single\n");
 	exit(1);
@@ -200,21 +206,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #ifdef USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -256,16 +257,12 @@ int main(int argc, char **argv) {
 	    dest = destinations->at(dst_id);
 	    extra_dst = dest; //destination for our extra source (only care about the final value of this)
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		cnt_con ++;
@@ -278,10 +275,10 @@ int main(int argc, char **argv) {
 		pacer = new NdpPullPacer(eventlist,  1 /*pull at line rate*/);   
 		ndpSnk = new NdpSink(pacer);
 	  
-		ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		ndpSrc->setName("ndp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
 		ndpRtxScanner.registerNdp(*ndpSrc);
@@ -339,7 +336,7 @@ int main(int argc, char **argv) {
 		routeout = new Route(*(net_paths[src][dest]->at(choice)));
 		routeout->add_endpoints(ndpSrc, ndpSnk);
 
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
+		routein = new Route(*(net_paths[dest][src]->at(choice)));
 		routein->add_endpoints(ndpSnk, ndpSrc);
 
 		extrastarttime = 0 * drand();
@@ -381,19 +378,19 @@ int main(int argc, char **argv) {
     //flow shares the same pacer as the last node created above
     ndpSnk = new NdpSink(pacer);
 	  
-    ndpSrc->setName("ndp_" + ntoa(extra_src) + "_" + ntoa(extra_dst));
+    ndpSrc->setName("ndp_%d_%d", extra_src, extra_dst);
     logfile.writeName(*ndpSrc);
 	  
-    ndpSnk->setName("ndp_sink_" + ntoa(extra_src) + "_" + ntoa(extra_dst));
+    ndpSnk->setName("ndp_sink_%d_%d", extra_src, extra_dst);
     logfile.writeName(*ndpSnk);
 	  
     ndpRtxScanner.registerNdp(*ndpSrc);
     
-    vector<const Route*>* srcpaths = top->get_paths(extra_src, extra_dst);
+    vector<const Route*>* srcpaths = net_paths.get(top, extra_src, extra_dst);
     routeout = new Route(*(srcpaths->at(0)));
     routeout->add_endpoints(ndpSrc, ndpSnk);
 
-    vector<const Route*>* dstpaths = top->get_paths(extra_dst, extra_src);
+    vector<const Route*>* dstpaths = net_paths.get(top, extra_dst, extra_src);
     routein = new Route(*(dstpaths->at(0)));
     routein->add_endpoints(ndpSnk, ndpSrc);
 
@@ -81,6 +81,9 @@ int main(int argc, char **argv) {
     stringstream filename(ios_base::out);
     RouteStrategy route_strategy = NOT_SET;
 
+    int seed = 13;
+    bool pool_stats = false;
+
     int i = 1;
     filename << "logout.dat";
 
@@ -89,6 +92,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")){
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -104,6 +110,11 @@ int main(int argc, char **argv) {
 	    cwnd = atoi(argv[i+1]);
 	    cout << "cwnd "<< cwnd << endl;
 	    i++;
+	} else if (!strcmp(argv[i],"-poolstats")){
+	    pool_stats = true;
+	} else if (!strcmp(argv[i],"-poolhigh")){
+	    PacketPools::setHighWater(atoi(argv[i+1]));
+	    i++;
 	} else if (!strcmp(argv[i],"-q")){
 	    queuesize = memFromPkt(atoi(argv[i+1]));
 	    i++;
@@ -123,7 +134,8 @@ int main(int argc, char **argv) {
 
 	i++;
     }
-    srand(13);
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     if (route_strategy == NOT_SET) {
 	fprintf(stderr, "Route Strategy not set.  Use the -strat param.  \nValid values are perm, rand, pull, rg and single\n");
@@ -206,21 +218,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #if USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -263,16 +270,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		subflows_chosen.clear();
@@ -291,10 +294,10 @@ int main(int argc, char **argv) {
 		ndpSrc->setCwnd(cwnd*Packet::data_packet_size());
 		ndpSnk = new NdpSink(pacer);
 	  
-		ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		ndpSrc->setName("ndp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
 		ndpRtxScanner.registerNdp(*ndpSrc);
@@ -373,13 +376,11 @@ int main(int argc, char **argv) {
 						}*/
 #endif
 	  
-		routeout = new Route(*(net_paths[src][dest]->at(choice)));
-		routeout->push_back(ndpSnk);
-	  
-		routein = new Route();
+		routeout = net_paths[src][dest]->at(choice)->extend();
+		routeout->add_endpoints(ndpSrc, ndpSnk);
 
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
-		routein->push_back(ndpSrc);
+		routein = net_paths[dest][src]->at(choice)->extend();
+		routein->add_endpoints(ndpSnk, ndpSrc);
 
 		extrastarttime = 0 * drand();
 	  
@@ -431,6 +432,8 @@ int main(int argc, char **argv) {
     }
 
     cout << "Done" << endl;
+    if (pool_stats)
+	PacketPools::report(cout);
     list <const Route*>::iterator rt_i;
     int counts[10]; int hop;
     for (int i = 0; i < 10; i++)
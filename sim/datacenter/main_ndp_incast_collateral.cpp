@@ -81,6 +81,8 @@ int main(int argc, char **argv) {
     stringstream filename(ios_base::out);
     RouteStrategy route_strategy = NOT_SET;
 
+    int seed = 13;
+
     int i = 1;
     filename << "logout.dat";
 
@@ -89,6 +91,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")) {
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -127,7 +132,8 @@ int main(int argc, char **argv) {
 	
 	i++;
     }
-    srand(13);
+    srand(seed);
+    SimContext::current().setSeed(seed);
 
     if (route_strategy == NOT_SET) {
 	fprintf(stderr, "Route Strategy not set.  Use the -strat param.  \nValid values are perm, rand, pull, rg and single\n");
@@ -210,21 +216,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #ifdef USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -267,16 +268,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		subflows_chosen.clear();
@@ -296,10 +293,10 @@ int main(int argc, char **argv) {
 		ndpSrc->set_flowsize(flowsize);
 		ndpSnk = new NdpSink(pacer);
 	  
-		ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		ndpSrc->setName("ndp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
 		ndpRtxScanner.registerNdp(*ndpSrc);
@@ -381,7 +378,7 @@ int main(int argc, char **argv) {
 		routeout = new Route(*(net_paths[src][dest]->at(choice)));
 		routeout->add_endpoints(ndpSrc, ndpSnk);
 	  
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
+		routein = new Route(*(net_paths[dest][src]->at(choice)));
 		routein->add_endpoints(ndpSnk, ndpSrc);
 
 		extrastarttime = 80;
@@ -431,17 +428,17 @@ int main(int argc, char **argv) {
     //longSrc->set_flowsize(flowsize);
     NdpPullPacer* longpacer = new NdpPullPacer(eventlist,  1 /*pull at line rate*/);   
     NdpSink* longSnk = new NdpSink(longpacer);
-    longSrc->setName("long_" + ntoa(long_src_no) + "_" + ntoa(long_dest_no));
+    longSrc->setName("long_%d_%d", long_src_no, long_dest_no);
     logfile.writeName(*longSrc);
-    longSnk->setName("long_sink_" + ntoa(long_src_no) + "_" + ntoa(long_dest_no));
+    longSnk->setName("long_sink_%d_%d", long_src_no, long_dest_no);
     logfile.writeName(*longSnk);
     ndpRtxScanner.registerNdp(*longSrc);
 
-    vector<const Route*>* srcpaths = top->get_paths(long_src_no, long_dest_no);
+    vector<const Route*>* srcpaths = net_paths.get(top, long_src_no, long_dest_no);
     routeout = new Route(*(srcpaths->at(0)));
     routeout->push_back(longSnk);
 
-    vector<const Route*>* dstpaths = top->get_paths(long_dest_no, long_src_no);
+    vector<const Route*>* dstpaths = net_paths.get(top, long_dest_no, long_src_no);
     routein = new Route(*(dstpaths->at(0)));
     routein->push_back(longSrc);
 
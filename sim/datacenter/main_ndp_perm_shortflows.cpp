@@ -81,6 +81,7 @@ int main(int argc, char **argv) {
     stringstream filename(ios_base::out);
     RouteStrategy route_strategy = NOT_SET;
     int seed = time(NULL);
+    double short_flow_rate = 0; // arrivals a second, none by default
 
     int i = 1;
     filename << "logout.dat";
@@ -105,6 +106,10 @@ int main(int argc, char **argv) {
 	} else if (!strcmp(argv[i],"-q")){
 	    queuesize = memFromPkt(atoi(argv[i+1]));
 	    i++;
+	} else if (!strcmp(argv[i],"-shortflows")){
+	    short_flow_rate = atof(argv[i+1]);
+	    cout << "short flows a second "<< short_flow_rate << endl;
+	    i++;
 	} 
 	else if (!strcmp(argv[i],"-seed")){
 	    seed = atoi(argv[i+1]);
@@ -128,6 +133,7 @@ int main(int argc, char **argv) {
 	i++;
     }
     srand(seed);
+    SimContext::current().setSeed(seed);
       
     if (route_strategy == NOT_SET) {
 	fprintf(stderr, "Route Strategy not set.  Use the -strat param.  \nValid values are perm, rand, pull, rg and single\n");
@@ -211,21 +217,16 @@ int main(int argc, char **argv) {
     no_of_nodes = top->no_of_nodes();
     cout << "actual nodes " << no_of_nodes << endl;
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0; i<no_of_nodes; i++){
+    for (int i=0; i<no_of_nodes; i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0; j<no_of_nodes; j++)
-	    net_paths[i][j] = NULL;
-    }
 
 #if USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -274,16 +275,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		subflows_chosen.clear();
@@ -302,18 +299,18 @@ int main(int argc, char **argv) {
 
 		    //pacers[dest]->set_preferred_flow(ndpSrc->flow_id());
 		    
-		    ndpSrc->setName("ndp_transfer_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		    ndpSrc->setName("ndp_transfer_%d_%d(%d)", src, dest, connection);
 		} else {
 		    ndpSrc = new NdpSrc(NULL, NULL, eventlist);
 		    ndpSnk = new NdpSink(pacers[dest]);
-		    ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		    ndpSrc->setName("ndp_%d_%d(%d)", src, dest, connection);
 		}
 		ndpSrc->setCwnd(cwnd*Packet::data_packet_size());
 		ndp_srcs.push_back(ndpSrc);
 	  
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
 		ndpRtxScanner.registerNdp(*ndpSrc);
@@ -393,12 +390,10 @@ int main(int argc, char **argv) {
 #endif
 	  
 		routeout = new Route(*(net_paths[src][dest]->at(choice)));
-		routeout->push_back(ndpSnk);
+		routeout->add_endpoints(ndpSrc, ndpSnk);
 	  
-		routein = new Route();
-
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
-		routein->push_back(ndpSrc);
+		routein = new Route(*(net_paths[dest][src]->at(choice)));
+		routein->add_endpoints(ndpSnk, ndpSrc);
 
 		extrastarttime = 0 * drand();
 	  
@@ -437,7 +432,12 @@ int main(int argc, char **argv) {
 	    }
 	}
     }
-    //    ShortFlows* sf = new ShortFlows(2560, eventlist, net_paths,conns,lg, &ndpRtxScanner);
+
+    ShortFlows* sf = NULL;
+    if (short_flow_rate > 0)
+	sf = new ShortFlows(short_flow_rate, 0, eventlist, net_paths, top, conns, lg,
+			    &ndpRtxScanner, pacers, route_strategy,
+			    cwnd*Packet::data_packet_size());
 
     cout << "Mean number of subflows " << ntoa((double)tot_subs/cnt_con)<<endl;
     cout << "Loaded " << connID << " connections in total\n";
@@ -460,6 +460,9 @@ int main(int argc, char **argv) {
     }
 
     cout << "Done" << endl;
+    if (sf)
+	cout << "Short flows: " << sf->flows_made() << " made, at most "
+	     << sf->peak_active() << " running at once" << endl;
     list <const Route*>::iterator rt_i;
     int counts[10]; int hop;
     for (rt_i = routes.begin(); rt_i != routes.end(); rt_i++) {
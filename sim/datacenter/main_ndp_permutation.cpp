@@ -16,9 +16,11 @@
 #include "clock.h"
 #include "ndp.h"
 #include "compositequeue.h"
+#include "aeolusqueue.h"
 #include "firstfit.h"
 #include "topology.h"
 #include "connection_matrix.h"
+#include "pdes.h"
 //#include "vl2_topology.h"
 
 #include "fat_tree_topology.h"
@@ -77,8 +79,18 @@ int main(int argc, char **argv) {
     Clock c(timeFromSec(5 / 100.), eventlist);
     int no_of_conns = DEFAULT_NODES, cwnd = 15, no_of_nodes = DEFAULT_NODES;
     mem_b queuesize = memFromPkt(DEFAULT_QUEUE_SIZE);
+    mem_b shared_buffer = 0; // per switch; 0 for a buffer per queue
+    double alpha = 1;
+    mem_b trim_threshold = 0, header_queue = 0; // 0 for the queue size
+    CompositeQueue::trim_victim_t trim_victim = CompositeQueue::TRIM_RANDOM;
+    bool trim_stats = false;
+    queue_type qt = COMPOSITE;
     stringstream filename(ios_base::out);
     RouteStrategy route_strategy = NOT_SET;
+    int partitions = 0, threads = 1;
+
+    int seed = 13;
+    bool pool_stats = false;
 
     int i = 1;
     filename << "logout.dat";
@@ -88,6 +100,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")){
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -100,9 +115,51 @@ int main(int argc, char **argv) {
 	} else if (!strcmp(argv[i],"-cwnd")){
 	    cwnd = atoi(argv[i+1]);
 	    i++;
+	} else if (!strcmp(argv[i],"-poolstats")){
+	    pool_stats = true;
+	} else if (!strcmp(argv[i],"-poolhigh")){
+	    PacketPools::setHighWater(atoi(argv[i+1]));
+	    i++;
 	} else if (!strcmp(argv[i],"-q")){
 	    queuesize = memFromPkt(atoi(argv[i+1]));
 	    i++;
+	} else if (!strcmp(argv[i],"-sharedbuf")){
+	    shared_buffer = memFromPkt(atoi(argv[i+1]));
+	    i++;
+	} else if (!strcmp(argv[i],"-alpha")){
+	    alpha = atof(argv[i+1]);
+	    i++;
+	} else if (!strcmp(argv[i],"-trimthresh")){
+	    trim_threshold = memFromPkt(atoi(argv[i+1]));
+	    trim_stats = true;
+	    i++;
+	} else if (!strcmp(argv[i],"-hdrq")){
+	    header_queue = memFromPkt(atoi(argv[i+1]));
+	    trim_stats = true;
+	    i++;
+	} else if (!strcmp(argv[i],"-aeolus")){
+	    qt = AEOLUS;
+	} else if (!strcmp(argv[i],"-trimvictim")){
+	    if (!strcmp(argv[i+1],"arrival"))
+		trim_victim = CompositeQueue::TRIM_ARRIVAL;
+	    else if (!strcmp(argv[i+1],"tail"))
+		trim_victim = CompositeQueue::TRIM_TAIL;
+	    else if (!strcmp(argv[i+1],"random"))
+		trim_victim = CompositeQueue::TRIM_RANDOM;
+	    else if (!strcmp(argv[i+1],"largest"))
+		trim_victim = CompositeQueue::TRIM_LARGEST_FLOW;
+	    else
+		exit_error(argv[0]);
+	    trim_stats = true;
+	    i++;
+	} else if (!strcmp(argv[i],"-sharedpipes")){
+	    Pipe::setSharedDelayLines(true);
+	} else if (!strcmp(argv[i],"-pdes")){
+	    partitions = atoi(argv[i+1]);
+	    i++;
+	} else if (!strcmp(argv[i],"-threads")){
+	    threads = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-strat")){
 	    if (!strcmp(argv[i+1], "perm")) {
 		route_strategy = SCATTER_PERMUTE;
@@ -119,7 +176,8 @@ int main(int argc, char **argv) {
 	}
 	i++;
     }
-    srand(13);
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     if (route_strategy == NOT_SET) {
 	fprintf(stderr, "Route Strategy not set.  Use the -strat param.  \nValid values are perm, rand, pull, rg and single\n");
@@ -166,6 +224,19 @@ int main(int argc, char **argv) {
     double extrastarttime;
 
     NdpRtxTimerScanner ndpRtxScanner(timeFromMs(10), eventlist);
+
+    // Parallel run: the pods are spread over the engine's partitions,
+    // and the loggers and clock stay on the global eventlist.  RTO
+    // scanning sends packets, so each partition scans its own sources.
+    ParallelEngine* engine = NULL;
+    vector<NdpRtxTimerScanner*> partition_rtx_scanners;
+    if (partitions > 0) {
+	engine = new ParallelEngine(eventlist, partitions);
+	engine->seedRandom(seed);
+	for (int p = 0; p < partitions; p++)
+	    partition_rtx_scanners.push_back(new NdpRtxTimerScanner(timeFromMs(10), engine->partition(p)));
+	cout << "PDES with " << partitions << " partitions on " << threads << " threads" << endl;
+    }
    
     int dest;
 
@@ -176,8 +247,16 @@ int main(int argc, char **argv) {
 #endif
 
 #ifdef FAT_TREE
-    FatTreeTopology* top = new FatTreeTopology(no_of_nodes, queuesize, 
-					       &logfile, &eventlist,ff,COMPOSITE,0);
+    FatTreeTopology* top;
+    if (engine)
+	top = new FatTreeTopology(no_of_nodes, queuesize, &logfile, engine, ff, qt);
+    else
+	top = new FatTreeTopology(no_of_nodes, queuesize, 
+				  &logfile, &eventlist,ff,qt,0);
+    if (shared_buffer)
+	top->share_buffers(shared_buffer, alpha);
+    if (trim_stats)
+	top->set_trimming(trim_threshold, trim_victim, header_queue);
 #endif
 
 #ifdef OV_FAT_TREE
@@ -203,21 +282,16 @@ int main(int argc, char **argv) {
     no_of_nodes = top->no_of_nodes();
     cout << "actual nodes " << no_of_nodes << endl;
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0; i<no_of_nodes; i++){
+    for (int i=0; i<no_of_nodes; i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0; j<no_of_nodes; j++)
-	    net_paths[i][j] = NULL;
-    }
 
 #if USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -259,16 +333,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    for (int connection=0;connection<1;connection++){
 		subflows_chosen.clear();
@@ -280,18 +350,21 @@ int main(int argc, char **argv) {
 	  
 		it_sub = crt_subflow_count > net_paths[src][dest]->size()?net_paths[src][dest]->size():crt_subflow_count;
 	  
-		ndpSrc = new NdpSrc(NULL, NULL, eventlist);
+		ndpSrc = new NdpSrc(NULL, NULL, top->partition_eventlist(top->host_partition(src)));
 		ndpSrc->setCwnd(cwnd*Packet::data_packet_size());
 		ndp_srcs.push_back(ndpSrc);
-		ndpSnk = new NdpSink(eventlist, 1 /*pull at line rate*/);
+		ndpSnk = new NdpSink(top->partition_eventlist(top->host_partition(dest)), 1 /*pull at line rate*/);
 	  
-		ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		ndpSrc->setName("ndp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
-		ndpRtxScanner.registerNdp(*ndpSrc);
+		if (engine)
+		    partition_rtx_scanners[top->host_partition(src)]->registerNdp(*ndpSrc);
+		else
+		    ndpRtxScanner.registerNdp(*ndpSrc);
 	  
 		int choice = 0;
 	  
@@ -367,13 +440,11 @@ int main(int argc, char **argv) {
 						}*/
 #endif
 	  
-		routeout = new Route(*(net_paths[src][dest]->at(choice)));
-		routeout->push_back(ndpSnk);
-	  
-		routein = new Route();
+		routeout = net_paths[src][dest]->at(choice)->extend();
+		routeout->add_endpoints(ndpSrc, ndpSnk);
 
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
-		routein->push_back(ndpSrc);
+		routein = net_paths[dest][src]->at(choice)->extend();
+		routein->add_endpoints(ndpSnk, ndpSrc);
 
 		extrastarttime = 0 * drand();
 	  
@@ -430,10 +501,17 @@ int main(int argc, char **argv) {
     //(*(ndp_srcs.begin()))->log_me();
 
     // GO!
-    while (eventlist.doNextEvent()) {
+    if (engine) {
+	cout << "Lookahead " << timeAsUs(engine->lookahead()) << "us" << endl;
+	engine->run(threads);
+    } else {
+	while (eventlist.doNextEvent()) {
+	}
     }
 
     cout << "Done" << endl;
+    if (pool_stats)
+	PacketPools::report(cout);
     list <const Route*>::iterator rt_i;
     int counts[10]; int hop;
     for (rt_i = routes.begin(); rt_i != routes.end(); rt_i++) {
@@ -443,12 +521,19 @@ int main(int argc, char **argv) {
 	for (int i = 0; i < r->size(); i++) {
 	    PacketSink *ps = r->at(i); 
 	    CompositeQueue *q = dynamic_cast<CompositeQueue*>(ps);
-	    if (q == 0) {
+	    AeolusQueue *aq = dynamic_cast<AeolusQueue*>(ps);
+	    if (aq) {
+		cout << aq->nodename() << " id=" << aq->id << " " << aq->num_packets() << "pkts " 
+		     << aq->num_headers() << "hdrs " << aq->num_acks() << "acks " << aq->num_nacks() << "nacks " << aq->num_stripped() << "stripped" << endl;
+	    } else if (q == 0) {
 		cout << ps->nodename() << endl;
 	    } else {
 		cout << q->nodename() << " id=" << q->id << " " << q->num_packets() << "pkts " 
-		     << q->num_headers() << "hdrs " << q->num_acks() << "acks " << q->num_nacks() << "nacks " << q->num_stripped() << "stripped"
-		     << endl;
+		     << q->num_headers() << "hdrs " << q->num_acks() << "acks " << q->num_nacks() << "nacks " << q->num_stripped() << "stripped";
+		if (trim_stats)
+		    cout << " (" << q->num_trimmed_arrival() << " arrival " << q->num_trimmed_tail() << " tail "
+			 << q->num_trimmed_largest() << " largest " << q->num_trimmed_early() << " early)";
+		cout << endl;
 	    }
 	} 
 	cout << endl;
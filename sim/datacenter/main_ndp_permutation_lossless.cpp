@@ -23,6 +23,7 @@
 //#include "vl2_topology.h"
 
 #include "fat_tree_topology.h"
+#include "pfc.h"
 //#include "oversubscribed_fat_tree_topology.h"
 //#include "multihomed_fat_tree_topology.h"
 //#include "star_topology.h"
@@ -81,6 +82,10 @@ int main(int argc, char **argv) {
     stringstream filename(ios_base::out);
     RouteStrategy route_strategy = NOT_SET;
 
+    struct timeval start;
+    gettimeofday(&start, NULL);
+    int seed = start.tv_usec;
+
     int i = 1;
     filename << "logout.dat";
 
@@ -89,6 +94,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")){
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -104,6 +112,10 @@ int main(int argc, char **argv) {
 	} else if (!strcmp(argv[i],"-q")){
 	    queuesize = memFromPkt(atoi(argv[i+1]));
 	    i++;
+	} else if (!strcmp(argv[i],"-pfcctrl")){
+	    // give acks, nacks, pulls and headers their own PFC class
+	    PfcClass::setControl(atoi(argv[i+1]));
+	    i++;
 	} else if (!strcmp(argv[i],"-strat")){
 	    if (!strcmp(argv[i+1], "perm")) {
 		route_strategy = SCATTER_PERMUTE;
@@ -121,10 +133,8 @@ int main(int argc, char **argv) {
 	i++;
     }
     
-    struct timeval start;
-    gettimeofday(&start, NULL);
-
-    srand(start.tv_usec);
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     if (route_strategy == NOT_SET) {
 	fprintf(stderr, "Route Strategy not set.  Use the -strat param.  \nValid values are perm, rand, pull, rg and single\n");
@@ -209,21 +219,16 @@ int main(int argc, char **argv) {
     no_of_nodes = top->no_of_nodes();
     cout << "actual nodes " << no_of_nodes << endl;
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0; i<no_of_nodes; i++){
+    for (int i=0; i<no_of_nodes; i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0; j<no_of_nodes; j++)
-	    net_paths[i][j] = NULL;
-    }
 
 #if USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -271,16 +276,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    cout << "Connection from " << src << " to " << dest << endl;
 
@@ -302,10 +303,10 @@ int main(int argc, char **argv) {
 		ndp_srcs.push_back(ndpSrc);
 		ndpSnk = new NdpSink(pacers[dest]);//eventlist, 1 /*pull at line rate*/);
 	  
-		ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+		ndpSrc->setName("ndp_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSrc);
 	  
-		ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
+		ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, connection);
 		logfile.writeName(*ndpSnk);
 	  
 		ndpRtxScanner.registerNdp(*ndpSrc);
@@ -384,13 +385,13 @@ int main(int argc, char **argv) {
 						}*/
 #endif
 	  
-		routeout = new Route(*top->get_paths(src,dest)->at(choice));//*(net_paths[src][dest]->at(choice)));
-		routeout->push_back(ndpSnk);
+		routeout = new Route(*(net_paths[src][dest]->at(choice)));
+		routeout->add_endpoints(ndpSrc, ndpSnk);
 		
 		//routein = new Route();
 
-		routein = new Route(*top->get_paths(dest,src)->at(choice));
-		routein->push_back(ndpSrc);
+		routein = new Route(*(net_paths[dest][src]->at(choice)));
+		routein->add_endpoints(ndpSnk, ndpSrc);
 
 		extrastarttime = 0 * drand();
 	  
@@ -483,6 +484,7 @@ int main(int argc, char **argv) {
     }
     for (int i = 0; i < 10; i++)
 	cout << "Hop " << i << " Count " << counts[i] << endl;
+    top->report_pfc(cout);
     list <NdpSrc*>::iterator src_i;
     for (src_i = ndp_srcs.begin(); src_i != ndp_srcs.end(); src_i++) {
 	cout << "Src, sent: " << (*src_i)->_packets_sent << "[new: " << (*src_i)->_new_packets_sent << " rtx: " << (*src_i)->_rtx_packets_sent << "] nacks: " << (*src_i)->_nacks_received << " pulls: " << (*src_i)->_pulls_received << " paths: " << (*src_i)->_paths.size() << endl;
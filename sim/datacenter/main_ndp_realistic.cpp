@@ -9,6 +9,8 @@
 #include <iostream>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "network.h"
 #include "randomqueue.h"
 #include "subflow_control.h"
@@ -63,6 +65,218 @@ void print_path(std::ofstream &paths, const Route* rt)
     paths << endl;
 }
 
+typedef vector<pair<uint64_t, double> > flow_trace_t;
+
+// Read up to count (size, start time) lines from a flow trace, or the
+// whole file if count is negative.
+void read_trace(const char* file_name, int count, flow_trace_t& flow_trace)
+{
+	ifstream trace_file(file_name);
+	if (!trace_file) {
+		cerr << "Can't open trace file " << file_name << endl;
+		exit(1);
+	}
+
+	string line;
+	uint64_t flow_size;
+	double start_time;
+	for (int i = 0; count < 0 || i < count; i++) {
+		if (!getline(trace_file, line))
+			break;
+		if (count < 0 && line.empty())
+			continue;
+		istringstream iss(line);
+		iss >> flow_size >> start_time;
+		flow_trace.push_back(make_pair(flow_size, start_time));
+	}
+	trace_file.close();
+}
+
+// Set up an NDP flow for each connection in conns, taking sizes and
+// start times from flow_trace in order.  connID numbers flows across
+// calls.
+void add_flows(ConnectionMatrix* conns, const flow_trace_t& flow_trace,
+	       FatTreeTopology* top, PathCache& net_paths,
+	       vector<NdpPullPacer*>& pacers, Logfile& logfile,
+	       NdpRtxTimerScanner& ndpRtxScanner, NdpTrafficLogger& traffic_logger,
+	       RouteStrategy route_strategy, int cwnd,
+	       int& connID, int& tot_subs, int& cnt_con)
+{
+	// outgoing (src->dst) and incoming (dst->src) routes
+    Route* routeout, *routein;
+    int base = connID;
+    map<int,vector<int>*>::iterator it;
+
+    // for each connection group (a single src to multiple destinations)
+	for (it = conns->connections.begin(); it != conns->connections.end(); it++) {
+		int src = (*it).first;	// a single source
+		vector<int>* destinations = (vector<int>*)(*it).second;	// several connections in this group
+
+		vector<int> subflows_chosen;
+
+		// for each destination 
+		for (unsigned int dst_id = 0; dst_id < destinations->size(); dst_id++) {
+			connID++;
+	    	int dest = destinations->at(dst_id);
+	    	cout << connID << " (" << src << "->" << dest << ") ";
+
+	    	// set paths from source to destination
+	    	net_paths.get(top, src, dest);
+
+	    	// set paths from destination to source 
+	    	net_paths.get(top, dest, src);
+
+	    	// for each subflow? I guess
+	    	// Now we only have a single subflow
+	    	for (int connection = 0; connection < 1; connection++) {
+				subflows_chosen.clear();
+
+				int it_sub;
+				int crt_subflow_count = subflow_count;
+
+				tot_subs += crt_subflow_count;	// update total # of subflows
+				cnt_con++;	// total # of connections
+
+				// it_sub = min(crt_subflow_count, net_paths[src][dest]->size())
+				it_sub = crt_subflow_count > net_paths[src][dest]->size() ? net_paths[src][dest]->size() : crt_subflow_count;
+
+				// NDP sender
+				NdpSrc* ndpSrc = new NdpSrc(NULL, NULL, eventlist);
+				ndpSrc->setCwnd(cwnd * Packet::data_packet_size());
+				ndpSrc->set_flowsize(flow_trace[connID - base - 1].first);
+
+				// NDP receiver. 
+				// We don't specify the pull rate here as multiple pullers may co-exist in the same
+				NdpSink* ndpSnk = new NdpSink(pacers[dest]);
+
+				ndpSrc->setName("ndp_%d_%d(%d)", src, dest, connection);
+				logfile.writeName(*ndpSrc);
+				ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, connection);
+				logfile.writeName(*ndpSnk);
+
+				ndpRtxScanner.registerNdp(*ndpSrc);
+
+				// Choose a path randomly
+				int choice = rand() % net_paths[src][dest]->size();
+				subflows_chosen.push_back(choice);
+
+				routeout = net_paths[src][dest]->at(choice)->extend();
+				routeout->add_endpoints(ndpSrc, ndpSnk);
+				routein = net_paths[dest][src]->at(choice)->extend();
+				routein->add_endpoints(ndpSnk, ndpSrc);
+
+	  			ndpSrc->connect(*routeout, *routein, *ndpSnk, timeFromSec(flow_trace[connID - base - 1].second));
+
+	  			// I don't understand this part
+	  			switch(route_strategy) {
+					case SCATTER_PERMUTE:
+					case SCATTER_RANDOM:
+					case PULL_BASED: {
+		    			ndpSrc->set_paths(net_paths[src][dest]);
+		    			ndpSnk->set_paths(net_paths[dest][src]);
+
+		    			vector<const Route*>* rts = net_paths[src][dest];
+		    			const Route* rt = rts->at(0);
+		    			PacketSink* first_queue = rt->at(0);
+		    			if (ndpSrc->_log_me) {
+							cout << "First hop: " << first_queue->nodename() << endl;
+							QueueLoggerSimple queue_logger = QueueLoggerSimple();
+							logfile.addLogger(queue_logger);
+							((Queue*)first_queue)->setLogger(&queue_logger);
+		    
+							ndpSrc->set_traffic_logger(&traffic_logger);
+		    			}
+		    			break;
+					}
+					default:
+		    			break;
+				}
+
+				//sinkLogger.monitorSink(ndpSnk);
+	    	}
+		}
+	}
+}
+
+// Fork a child per tail trace, at most jobs at a time.  Each child is
+// an exact copy of the simulation at the checkpoint; it adds its tail's
+// flows and runs on, logging to <log>_<n> and <log>_<n>.out, where the
+// log starts with everything recorded before the checkpoint.  The
+// parent's own log stops at the checkpoint.
+//
+// The checkpoint lives only in this process's memory: nothing is
+// written that a later run could restore, so every invocation runs the
+// warm-up again before it forks.  Give all the tails you want to try
+// to one invocation to pay for the warm-up once.
+int run_continuations(const vector<char*>& tail_file_names, double checkpoint_time, int jobs,
+		      const string& log_name, FatTreeTopology* top, PathCache& net_paths,
+		      vector<NdpPullPacer*>& pacers, Logfile& logfile,
+		      NdpRtxTimerScanner& ndpRtxScanner, NdpTrafficLogger& traffic_logger,
+		      RouteStrategy route_strategy, int cwnd, int connID, int tot_subs, int cnt_con)
+{
+	unsigned int next = 0, running = 0, failed = 0;
+	while (next < tail_file_names.size() || running > 0) {
+		if (next < tail_file_names.size() && (int)running < jobs) {
+			// nothing buffered may be written twice
+			cout.flush();
+			fflush(NULL);
+			pid_t pid = fork();
+			if (pid < 0) {
+				perror("fork");
+				exit(1);
+			}
+			if (pid == 0) {
+				string name = log_name + "_" + itoa(next);
+				if (!freopen((name + ".out").c_str(), "w", stdout)) {
+					cerr << "Failed to open " << name << ".out" << endl;
+					exit(1);
+				}
+				logfile.reopen(name);
+
+				flow_trace_t tail;
+				read_trace(tail_file_names[next], -1, tail);
+				for (unsigned int f = 0; f < tail.size(); f++) {
+					if (tail[f].second < checkpoint_time) {
+						cerr << tail_file_names[next] << ": flow starts before the checkpoint" << endl;
+						exit(1);
+					}
+				}
+				random_shuffle(tail.begin(), tail.end());
+
+				// the same pairs for every tail, but not the warm-up's
+				ConnectionMatrix* conns = new ConnectionMatrix(top->no_of_nodes(), RNG_STREAM_CONNECTIONS + 1);
+				conns->setRandom(tail.size());
+				cout << "Continuing from " << checkpoint_time << "s with " << tail.size()
+				     << " connections from " << tail_file_names[next] << endl;
+				add_flows(conns, tail, top, net_paths, pacers, logfile, ndpRtxScanner, traffic_logger,
+					  route_strategy, cwnd, connID, tot_subs, cnt_con);
+				cout << "Loaded " << connID << " connections in total" << endl;
+
+				while (eventlist.doNextEvent()) {
+				}
+				// returning lets the logfile be written out as usual
+				return 0;
+			}
+			next++;
+			running++;
+			continue;
+		}
+
+		int status;
+		pid_t pid = wait(&status);
+		if (pid < 0) {
+			perror("wait");
+			exit(1);
+		}
+		running--;
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			failed++;
+	}
+	if (failed)
+		cerr << failed << " continuations failed" << endl;
+	return failed ? 1 : 0;
+}
+
 int main(int argc, char **argv) 
 {
 	char *trace_file_name = NULL;
@@ -83,13 +297,23 @@ int main(int argc, char **argv)
 
 	bool enable_aeolus = false;
 
+	// Run to checkpoint_time, then fork a continuation for each tail
+	// trace, which adds that trace's flows and runs to the end.
+	double checkpoint_time = 0;
+	vector<char*> tail_file_names;
+	int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+
     // Parse arguments and overide default values
+    int seed = 13;
     int i = 1;
     while (i < argc) {
 		if (!strcmp(argv[i], "-o")) {	// output file
 	    	filename.str(std::string());
 	    	filename << argv[i + 1];
 	    	i++;
+		} else if (!strcmp(argv[i],"-seed")){
+		    seed = atoi(argv[i+1]);
+		    i++;
 		} else if (!strcmp(argv[i], "-sub")) {	// # of subflows
 	    	subflow_count = atoi(argv[i + 1]);
 	    	i++;
@@ -121,6 +345,15 @@ int main(int argc, char **argv)
 	    	i++;
 	    } else if (!strcmp(argv[i],"-aeolus")) { // enable Aeolus
 	    	enable_aeolus = true;
+	    } else if (!strcmp(argv[i], "-checkpoint")) {	// fork continuations at this time (s)
+	    	checkpoint_time = atof(argv[i + 1]);
+	    	i++;
+	    } else if (!strcmp(argv[i], "-tail")) {	// flow trace for one continuation
+	    	tail_file_names.push_back(argv[i + 1]);
+	    	i++;
+	    } else if (!strcmp(argv[i], "-jobs")) {	// continuations run at once
+	    	jobs = atoi(argv[i + 1]);
+	    	i++;
 		} else {
 
 		}
@@ -139,8 +372,16 @@ int main(int argc, char **argv)
     	return 0;
     }
 
+    if (!tail_file_names.empty() && checkpoint_time <= 0) {
+    	cerr << "Tail traces need a checkpoint time" << endl;
+    	return 1;
+    }
+    if (jobs < 1)
+    	jobs = 1;
+
     // Set seed for random number generator
-    srand(13);
+    srand(seed);
+    SimContext::current().setSeed(seed);
 
     if (enable_aeolus)
     	cout << "Transport: Aeolus" << endl;
@@ -197,35 +438,15 @@ int main(int argc, char **argv)
 	no_of_nodes = top->no_of_nodes();
 	cout << "actual nodes " << no_of_nodes << endl;
 
-	// outgoing (src->dst) and incoming (dst->src) routes
-    Route* routeout, *routein;
-
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
     int* is_dest = new int[no_of_nodes];
     
-    for (int i = 0; i < no_of_nodes; i++){
+    for (int i = 0; i < no_of_nodes; i++)
 		is_dest[i] = 0;
-		net_paths[i] = new vector<const Route*>*[no_of_nodes];
-		for (int j = 0; j < no_of_nodes; j++) {
-	    	net_paths[i][j] = NULL;
-		}
-    }
 
     // Read flow trace
-    vector<pair<uint64_t, double> > flow_trace;
-	ifstream trace_file(trace_file_name);
-
-	string line;
-	uint64_t flow_size;
-	double start_time;
-	for (i = 0; i < no_of_conns; i++) {
-		getline(trace_file, line);
-		istringstream iss(line);
-		iss >> flow_size >> start_time;
-		flow_trace.push_back(make_pair(flow_size, start_time));
-	}
-	trace_file.close();
+    flow_trace_t flow_trace;
+    read_trace(trace_file_name, no_of_conns, flow_trace);
 
 	// Shuffle flow IDs
 	random_shuffle(flow_trace.begin(), flow_trace.end());
@@ -240,12 +461,7 @@ int main(int argc, char **argv)
     NdpSrc::setRouteStrategy(route_strategy);
     NdpSink::setRouteStrategy(route_strategy);
 
-    // used just to print out stats data at the end
-    list <const Route*> routes;
-    list <NdpSrc*> ndp_srcs;
-
     int connID = 0;
-    map<int,vector<int>*>::iterator it;
 
     vector<NdpPullPacer*> pacers;
     // for each host, we set up a NDP pacer
@@ -254,107 +470,8 @@ int main(int argc, char **argv)
     	pacers.push_back(pacer);
     }
 
-    // for each connection group (a single src to multiple destinations)
-	for (it = conns->connections.begin(); it != conns->connections.end(); it++) {
-		int src = (*it).first;	// a single source
-		vector<int>* destinations = (vector<int>*)(*it).second;	// several connections in this group
-
-		vector<int> subflows_chosen;
-
-		// for each destination 
-		for (unsigned int dst_id = 0; dst_id < destinations->size(); dst_id++) {
-			connID++;
-	    	int dest = destinations->at(dst_id);
-	    	cout << connID << " (" << src << "->" << dest << ") ";
-
-	    	// set paths from source to destination
-	    	if (!net_paths[src][dest]) {
-				vector<const Route*>* paths = top->get_paths(src, dest);
-				net_paths[src][dest] = paths;
-				// cout << src << "->" << dest << " " << paths->size() << " paths" << endl;
-
-				for (unsigned int i = 0; i < paths->size(); i++) {
-		    		routes.push_back((*paths)[i]);
-				}
-	    	}
-
-	    	// set paths from destination to source 
-	    	if (!net_paths[dest][src]) {
-				vector<const Route*>* paths = top->get_paths(dest, src);
-				net_paths[dest][src] = paths;
-	    	}
-
-	    	// for each subflow? I guess
-	    	// Now we only have a single subflow
-	    	for (int connection = 0; connection < 1; connection++) {
-				subflows_chosen.clear();
-
-				int it_sub;
-				int crt_subflow_count = subflow_count;
-
-				tot_subs += crt_subflow_count;	// update total # of subflows
-				cnt_con++;	// total # of connections
-
-				// it_sub = min(crt_subflow_count, net_paths[src][dest]->size())
-				it_sub = crt_subflow_count > net_paths[src][dest]->size() ? net_paths[src][dest]->size() : crt_subflow_count;
-
-				// NDP sender
-				NdpSrc* ndpSrc = new NdpSrc(NULL, NULL, eventlist);
-				ndpSrc->setCwnd(cwnd * Packet::data_packet_size());
-				ndpSrc->set_flowsize(flow_trace[connID - 1].first);
-				ndp_srcs.push_back(ndpSrc);
-
-				// NDP receiver. 
-				// We don't specify the pull rate here as multiple pullers may co-exist in the same
-				NdpSink* ndpSnk = new NdpSink(pacers[dest]);
-
-				ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
-				logfile.writeName(*ndpSrc);
-				ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(connection)+")");
-				logfile.writeName(*ndpSnk);
-
-				ndpRtxScanner.registerNdp(*ndpSrc);
-
-				// Choose a path randomly
-				int choice = rand() % net_paths[src][dest]->size();
-				subflows_chosen.push_back(choice);
-
-				routeout = new Route(*(net_paths[src][dest]->at(choice)));
-				routeout->push_back(ndpSnk);
-	  			routein = new Route(*top->get_paths(dest,src)->at(choice));
-				routein->push_back(ndpSrc);
-
-	  			ndpSrc->connect(*routeout, *routein, *ndpSnk, timeFromSec(flow_trace[connID - 1].second));
-
-	  			// I don't understand this part
-	  			switch(route_strategy) {
-					case SCATTER_PERMUTE:
-					case SCATTER_RANDOM:
-					case PULL_BASED: {
-		    			ndpSrc->set_paths(net_paths[src][dest]);
-		    			ndpSnk->set_paths(net_paths[dest][src]);
-
-		    			vector<const Route*>* rts = net_paths[src][dest];
-		    			const Route* rt = rts->at(0);
-		    			PacketSink* first_queue = rt->at(0);
-		    			if (ndpSrc->_log_me) {
-							cout << "First hop: " << first_queue->nodename() << endl;
-							QueueLoggerSimple queue_logger = QueueLoggerSimple();
-							logfile.addLogger(queue_logger);
-							((Queue*)first_queue)->setLogger(&queue_logger);
-		    
-							ndpSrc->set_traffic_logger(&traffic_logger);
-		    			}
-		    			break;
-					}
-					default:
-		    			break;
-				}
-
-				//sinkLogger.monitorSink(ndpSnk);
-	    	}
-		}
-	}
+    add_flows(conns, flow_trace, top, net_paths, pacers, logfile, ndpRtxScanner, traffic_logger,
+	      route_strategy, cwnd, connID, tot_subs, cnt_con);
 
     cout << "Mean number of subflows " << ntoa((double)tot_subs/cnt_con)<<endl;
     cout << "Loaded " << connID << " connections in total" << endl;
@@ -369,6 +486,16 @@ int main(int argc, char **argv)
     double rtt = timeAsSec(timeFromUs(RTT));
     logfile.write("# rtt =" + ntoa(rtt));
 
+    if (!tail_file_names.empty()) {
+    	// Run the common warm-up once
+    	eventlist.runUntil(timeFromSec(checkpoint_time));
+    	cout << "Checkpoint at " << checkpoint_time << "s, "
+    	     << tail_file_names.size() << " continuations" << endl;
+    	return run_continuations(tail_file_names, checkpoint_time, jobs, filename.str(),
+    				 top, net_paths, pacers, logfile, ndpRtxScanner, traffic_logger,
+    				 route_strategy, cwnd, connID, tot_subs, cnt_con);
+    }
+
     // GO!
     while (eventlist.doNextEvent()) {
     	
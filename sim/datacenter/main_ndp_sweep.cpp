@@ -0,0 +1,401 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "config.h"
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "network.h"
+#include "randomqueue.h"
+#include "pipe.h"
+#include "eventlist.h"
+#include "logfile.h"
+#include "loggers.h"
+#include "clock.h"
+#include "ndp.h"
+#include "compositequeue.h"
+#include "firstfit.h"
+#include "topology.h"
+#include "connection_matrix.h"
+#include "fat_tree_topology.h"
+#include <list>
+#include <set>
+
+/*
+ * Run an NDP permutation experiment at a list of parameter points,
+ * building the fat tree and its routes only once.  Each point runs in
+ * a forked child, so it gets its own copy of the eventlist, the
+ * loggers and every other global, starting from exactly the state a
+ * standalone htsim_ndp_permutation run would be in after building the
+ * topology; its log and stdout go to <prefix>_<point> and
+ * <prefix>_<point>.out, and should match what htsim_ndp_permutation
+ * writes for the same parameters.
+ *
+ * The points file has one point per line, made of any of -q, -cwnd
+ * and -conns; anything not given takes the value from the command
+ * line.  Lines starting with # are ignored.
+ */
+
+#include "main.h"
+
+uint32_t RTT = 1; // this is per link delay in us; identical RTT microseconds = 0.02 ms
+#define DEFAULT_NODES 128
+#define DEFAULT_QUEUE_SIZE 8
+
+FirstFit* ff = NULL;
+
+string ntoa(double n);
+string itoa(uint64_t n);
+
+EventList eventlist;
+
+Logfile* lg;
+
+struct sweep_point {
+    int queue_pkts;
+    int cwnd;
+    int conns;
+};
+
+void exit_error(char* progr) {
+    cout << "Usage " << progr << " -strat perm|rand|pull|single -points FILE [-o prefix] [-nodes N] [-jobs N] [-q N] [-cwnd N] [-conns N]" << endl;
+    exit(1);
+}
+
+void read_points(const char* file, const sweep_point& defaults, vector<sweep_point>& points) {
+    ifstream in(file);
+    if (!in) {
+	cerr << "Can't open points file " << file << endl;
+	exit(1);
+    }
+    string line;
+    while (getline(in, line)) {
+	stringstream ss(line);
+	string flag;
+	if (!(ss >> flag) || flag[0] == '#')
+	    continue;
+	sweep_point p = defaults;
+	do {
+	    int val;
+	    if (!(ss >> val)) {
+		cerr << "Missing value for " << flag << " in points file" << endl;
+		exit(1);
+	    }
+	    if (flag == "-q")
+		p.queue_pkts = val;
+	    else if (flag == "-cwnd")
+		p.cwnd = val;
+	    else if (flag == "-conns")
+		p.conns = val;
+	    else {
+		cerr << "Unknown parameter " << flag << " in points file" << endl;
+		exit(1);
+	    }
+	} while (ss >> flag);
+	points.push_back(p);
+    }
+}
+
+// Set up and run one point, in the same order as htsim_ndp_permutation
+// so that random draws and log ids come out the same.  Returns a line
+// for the results table.
+string run_point(int index, const sweep_point& pt, int seed, RouteStrategy route_strategy,
+		 FatTreeTopology* top, PathCache& net_paths, Logfile& logfile,
+		 NdpSinkLoggerSampling& sinkLogger, NdpRtxTimerScanner& ndpRtxScanner) {
+    int no_of_nodes = top->no_of_nodes();
+    top->set_queue_size(memFromPkt(pt.queue_pkts));
+
+    srand(seed);
+    cout << "conns " << pt.conns << endl;
+    cout << "cwnd " << pt.cwnd << endl;
+    cout << "queue " << pt.queue_pkts << " pkts" << endl;
+
+    ConnectionMatrix* conns = new ConnectionMatrix(no_of_nodes);
+    conns->setPermutation(pt.conns);
+
+    list<NdpSrc*> ndp_srcs;
+    list<NdpSink*> ndp_sinks;
+    set<CompositeQueue*> queues;
+    map<int,vector<int>*>::iterator it;
+    for (it = conns->connections.begin(); it != conns->connections.end(); it++) {
+	int src = (*it).first;
+	vector<int>* destinations = (*it).second;
+
+	for (unsigned int dst_id = 0; dst_id < destinations->size(); dst_id++) {
+	    int dest = destinations->at(dst_id);
+
+	    NdpSrc* ndpSrc = new NdpSrc(NULL, NULL, eventlist);
+	    ndpSrc->setCwnd(pt.cwnd*Packet::data_packet_size());
+	    ndp_srcs.push_back(ndpSrc);
+	    NdpSink* ndpSnk = new NdpSink(eventlist, 1 /*pull at line rate*/);
+	    ndp_sinks.push_back(ndpSnk);
+
+	    ndpSrc->setName("ndp_%d_%d(0)", src, dest);
+	    logfile.writeName(*ndpSrc);
+	    ndpSnk->setName("ndp_sink_%d_%d(0)", src, dest);
+	    logfile.writeName(*ndpSnk);
+	    ndpRtxScanner.registerNdp(*ndpSrc);
+
+	    int choice = rand()%net_paths[src][dest]->size();
+
+	    Route* routeout = net_paths[src][dest]->at(choice)->extend();
+	    routeout->add_endpoints(ndpSrc, ndpSnk);
+	    Route* routein = net_paths[dest][src]->at(choice)->extend();
+	    routein->add_endpoints(ndpSnk, ndpSrc);
+
+	    double extrastarttime = 0 * drand();
+	    ndpSrc->connect(*routeout, *routein, *ndpSnk, timeFromMs(extrastarttime));
+
+	    if (route_strategy == SCATTER_PERMUTE || route_strategy == SCATTER_RANDOM
+		|| route_strategy == PULL_BASED) {
+		ndpSrc->set_paths(net_paths[src][dest]);
+		ndpSnk->set_paths(net_paths[dest][src]);
+	    }
+	    sinkLogger.monitorSink(ndpSnk);
+
+	    for (unsigned int p = 0; p < net_paths[src][dest]->size(); p++) {
+		const Route* r = net_paths[src][dest]->at(p);
+		for (unsigned int h = 0; h < r->size(); h++) {
+		    CompositeQueue* q = dynamic_cast<CompositeQueue*>(r->at(h));
+		    if (q)
+			queues.insert(q);
+		}
+	    }
+	}
+    }
+    cout << "Loaded " << ndp_srcs.size() << " connections in total\n";
+
+    int pktsize = Packet::data_packet_size();
+    logfile.write("# pktsize=" + ntoa(pktsize) + " bytes");
+    logfile.write("# subflows=" + ntoa(1));
+    logfile.write("# hostnicrate = " + ntoa(HOST_NIC) + " pkt/sec");
+    logfile.write("# corelinkrate = " + ntoa(HOST_NIC*CORE_TO_HOST) + " pkt/sec");
+    double rtt = timeAsSec(timeFromUs(RTT));
+    logfile.write("# rtt =" + ntoa(rtt));
+
+    while (eventlist.doNextEvent()) {
+    }
+    cout << "Done" << endl;
+
+    double duration = timeAsSec(eventlist.now());
+    double total = 0, lowest = -1;
+    for (list<NdpSink*>::iterator i = ndp_sinks.begin(); i != ndp_sinks.end(); i++) {
+	double mbps = (*i)->cumulative_ack() * 8.0 / duration / 1000000;
+	total += mbps;
+	if (lowest < 0 || mbps < lowest)
+	    lowest = mbps;
+    }
+    uint64_t rtx = 0;
+    for (list<NdpSrc*>::iterator i = ndp_srcs.begin(); i != ndp_srcs.end(); i++) {
+	cout << "Src, sent: " << (*i)->_packets_sent << "[new: " << (*i)->_new_packets_sent << " rtx: " << (*i)->_rtx_packets_sent << "] nacks: " << (*i)->_nacks_received << " pulls: " << (*i)->_pulls_received << " paths: " << (*i)->_paths.size() << endl;
+	rtx += (*i)->_rtx_packets_sent;
+    }
+    uint64_t stripped = 0;
+    for (set<CompositeQueue*>::iterator i = queues.begin(); i != queues.end(); i++)
+	stripped += (*i)->num_stripped();
+
+    stringstream row;
+    row << index << "\t" << pt.queue_pkts << "\t" << pt.cwnd << "\t" << pt.conns << "\t"
+	<< ndp_sinks.size() << "\t" << (ndp_sinks.empty() ? 0 : total / ndp_sinks.size()) << "\t"
+	<< (lowest < 0 ? 0 : lowest) << "\t" << rtx << "\t" << stripped;
+    return row.str();
+}
+
+int main(int argc, char **argv) {
+    Packet::set_packet_size(9000);
+    eventlist.setEndtime(timeFromSec(0.201));
+    Clock c(timeFromSec(5 / 100.), eventlist);
+    sweep_point defaults = {DEFAULT_QUEUE_SIZE, 15, DEFAULT_NODES};
+    int no_of_nodes = DEFAULT_NODES;
+    int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* points_file = NULL;
+    string prefix = "sweep";
+    int seed = 13;
+    RouteStrategy route_strategy = NOT_SET;
+
+    int i = 1;
+    while (i<argc) {
+	if (!strcmp(argv[i],"-o")){
+	    prefix = argv[i+1];
+	    i++;
+	} else if (!strcmp(argv[i],"-conns")){
+	    defaults.conns = atoi(argv[i+1]);
+	    i++;
+	} else if (!strcmp(argv[i],"-nodes")){
+	    no_of_nodes = atoi(argv[i+1]);
+	    i++;
+	} else if (!strcmp(argv[i],"-cwnd")){
+	    defaults.cwnd = atoi(argv[i+1]);
+	    i++;
+	} else if (!strcmp(argv[i],"-q")){
+	    defaults.queue_pkts = atoi(argv[i+1]);
+	    i++;
+	} else if (!strcmp(argv[i],"-jobs")){
+	    jobs = atoi(argv[i+1]);
+	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
+	} else if (!strcmp(argv[i],"-points")){
+	    points_file = argv[i+1];
+	    i++;
+	} else if (!strcmp(argv[i],"-strat")){
+	    if (!strcmp(argv[i+1], "perm")) {
+		route_strategy = SCATTER_PERMUTE;
+	    } else if (!strcmp(argv[i+1], "rand")) {
+		route_strategy = SCATTER_RANDOM;
+	    } else if (!strcmp(argv[i+1], "pull")) {
+		route_strategy = PULL_BASED;
+	    } else if (!strcmp(argv[i+1], "single")) {
+		route_strategy = SINGLE_PATH;
+	    }
+	    i++;
+	} else {
+	    exit_error(argv[0]);
+	}
+	i++;
+    }
+    if (jobs < 1)
+	jobs = 1;
+
+    if (route_strategy == NOT_SET) {
+	fprintf(stderr, "Route Strategy not set.  Use the -strat param.  \nValid values are perm, rand, pull, rg and single\n");
+	exit(1);
+    }
+    if (!points_file)
+	exit_error(argv[0]);
+
+    vector<sweep_point> points;
+    read_points(points_file, defaults, points);
+    cout << "Sweeping " << points.size() << " points on " << jobs << " jobs" << endl;
+
+    SimContext::current().setSeed(seed);
+
+    // Everything up to here is shared by all the points; it's built
+    // in the same order as in htsim_ndp_permutation.
+    Logfile logfile(prefix, eventlist);
+    lg = &logfile;
+    logfile.setStartTime(timeFromSec(0));
+    NdpSinkLoggerSampling sinkLogger = NdpSinkLoggerSampling(timeFromMs(10), eventlist);
+    logfile.addLogger(sinkLogger);
+    NdpTrafficLogger traffic_logger = NdpTrafficLogger();
+    logfile.addLogger(traffic_logger);
+    NdpRtxTimerScanner ndpRtxScanner(timeFromMs(10), eventlist);
+
+    // the topology is built with the default buffer; each point sets
+    // its own
+    FatTreeTopology* top = new FatTreeTopology(no_of_nodes, memFromPkt(DEFAULT_QUEUE_SIZE),
+					       &logfile, &eventlist, ff, COMPOSITE, 0);
+    no_of_nodes = top->no_of_nodes();
+    cout << "actual nodes " << no_of_nodes << endl;
+
+    NdpSrc::setMinRTO(50000); //increase RTO to avoid spurious retransmits
+    NdpSrc::setRouteStrategy(route_strategy);
+    NdpSink::setRouteStrategy(route_strategy);
+
+    // Find the routes for every pair any point will use.
+    PathCache net_paths;
+    for (unsigned int p = 0; p < points.size(); p++) {
+	srand(seed);
+	ConnectionMatrix conns(no_of_nodes);
+	conns.setPermutation(points[p].conns);
+	map<int,vector<int>*>::iterator it;
+	for (it = conns.connections.begin(); it != conns.connections.end(); it++) {
+	    int src = (*it).first;
+	    vector<int>* destinations = (*it).second;
+	    for (unsigned int d = 0; d < destinations->size(); d++) {
+		int dest = destinations->at(d);
+		net_paths.get(top, src, dest);
+		net_paths.get(top, dest, src);
+	    }
+	}
+    }
+
+    // Fork a child per point, at most 'jobs' at a time.  Each child
+    // sends back its row of the results table through a pipe.
+    vector<pid_t> pids(points.size(), 0);
+    vector<int> fds(points.size(), -1);
+    vector<string> rows(points.size());
+    unsigned int next = 0, running = 0, failed = 0;
+    while (next < points.size() || running > 0) {
+	if (next < points.size() && (int)running < jobs) {
+	    int fd[2];
+	    if (pipe(fd) < 0) {
+		perror("pipe");
+		exit(1);
+	    }
+	    cout.flush();
+	    fflush(stdout);
+	    pid_t pid = fork();
+	    if (pid < 0) {
+		perror("fork");
+		exit(1);
+	    }
+	    if (pid == 0) {
+		close(fd[0]);
+		string name = prefix + "_" + itoa(next);
+		if (!freopen((name + ".out").c_str(), "w", stdout)) {
+		    cerr << "Failed to open " << name << ".out" << endl;
+		    exit(1);
+		}
+		logfile.reopen(name);
+		string row = run_point(next, points[next], seed, route_strategy, top, net_paths, logfile, sinkLogger, ndpRtxScanner) + "\n";
+		if (write(fd[1], row.c_str(), row.size()) != (ssize_t)row.size())
+		    exit(1);
+		close(fd[1]);
+		// returning lets the logfile be written out as usual
+		return 0;
+	    }
+	    close(fd[1]);
+	    pids[next] = pid;
+	    fds[next] = fd[0];
+	    next++;
+	    running++;
+	    continue;
+	}
+
+	// a row is far smaller than a pipe's buffer, so the child
+	// never blocks writing it and we can just wait for it to finish
+	int status;
+	pid_t pid = wait(&status);
+	if (pid < 0) {
+	    perror("wait");
+	    exit(1);
+	}
+	running--;
+	for (unsigned int p = 0; p < points.size(); p++) {
+	    if (pids[p] != pid)
+		continue;
+	    char buf[512];
+	    ssize_t n = read(fds[p], buf, sizeof(buf) - 1);
+	    close(fds[p]);
+	    if (n > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+		buf[n] = '\0';
+		rows[p] = buf;
+	    } else {
+		cerr << "Point " << p << " failed" << endl;
+		rows[p] = itoa(p) + "\tFAILED\n";
+		failed++;
+	    }
+	}
+    }
+
+    cout << "# point\tq\tcwnd\tconns\tflows\tmean_mbps\tmin_mbps\trtx\tstripped" << endl;
+    for (unsigned int p = 0; p < points.size(); p++)
+	cout << rows[p];
+    return failed ? 1 : 0;
+}
+
+string ntoa(double n) {
+    stringstream s;
+    s << n;
+    return s.str();
+}
+
+string itoa(uint64_t n) {
+    stringstream s;
+    s << n;
+    return s.str();
+}
@@ -77,6 +77,7 @@ int main(int argc, char **argv) {
     int algo = UNCOUPLED;
     double epsilon = 1;
     int no_of_conns = 0, no_of_nodes = DEFAULT_NODES, cwnd = 15;
+    double short_flow_rate = 0; // arrivals a second, none by default
     stringstream filename(ios_base::out);
     int seed = time(NULL);
 
@@ -108,6 +109,10 @@ int main(int argc, char **argv) {
 	    cwnd = atoi(argv[i+1]);
 	    cout << "cwnd "<< cwnd << endl;
 	    i++;
+	} else if (!strcmp(argv[i],"-shortflows")){
+	    short_flow_rate = atof(argv[i+1]);
+	    cout << "short flows a second "<< short_flow_rate << endl;
+	    i++;
 	} else if (!strcmp(argv[i], "UNCOUPLED"))
 	    algo = UNCOUPLED;
 	else if (!strcmp(argv[i], "COUPLED_INC"))
@@ -131,6 +136,7 @@ int main(int argc, char **argv) {
 	i++;
     }
     srand(seed);
+    SimContext::current().setSeed(seed);
       
     cout << "Using subflow count " << subflow_count <<endl;
       
@@ -206,21 +212,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #ifdef USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -259,16 +260,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    MultipathTcpSrc* mtcp;
 
@@ -304,10 +301,10 @@ int main(int argc, char **argv) {
 			ndpSnk = new TcpSink();
 			}
 		    
-		    ndpSrc->setName("ndp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(inter)+")");
+		    ndpSrc->setName("ndp_%d_%d(%d)", src, dest, inter);
 		    logfile.writeName(*ndpSrc);
 		    
-		    ndpSnk->setName("ndp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(inter)+")");
+		    ndpSnk->setName("ndp_sink_%d_%d(%d)", src, dest, inter);
 		    logfile.writeName(*ndpSnk);
 		    
 		    ndpRtxScanner.registerTcp(*ndpSrc);
@@ -408,7 +405,7 @@ int main(int argc, char **argv) {
 		    routeout = new Route(*(net_paths[src][dest]->at(choice)));
 		    routeout->push_back(ndpSnk);
 		    
-		    routein = new Route(*top->get_paths(dest,src)->at(choice));
+		    routein = new Route(*(net_paths[dest][src]->at(choice)));
 		    routein->push_back(ndpSrc);
 		    
 		    extrastarttime = 0 * drand();
@@ -417,7 +414,7 @@ int main(int argc, char **argv) {
 			mtcp->addSubflow(ndpSrc);
 		    
 			if (inter == 0) {
-			    mtcp->setName("multipath" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+			    mtcp->setName("multipath%d_%d(%d)", src, dest, connection);
 			    logfile.writeName(*mtcp);
 			}
 		    }
@@ -440,7 +437,10 @@ int main(int argc, char **argv) {
 	    }
 	}
     }
-    //    ShortFlows* sf = new ShortFlows(2560, eventlist, net_paths,conns,lg, &ndpRtxScanner);
+    ShortFlows* sf = NULL;
+    if (short_flow_rate > 0)
+	sf = new ShortFlows(short_flow_rate, timeFromMs(1000), eventlist, net_paths, top,
+			    conns, lg, &ndpRtxScanner);
 
     cout << "Mean number of subflows " << ntoa((double)tot_subs/cnt_con)<<endl;
 
@@ -459,6 +459,9 @@ int main(int argc, char **argv) {
     }
 
     cout << "Done" << endl;
+    if (sf)
+	cout << "Short flows: " << sf->flows_made() << " made, at most "
+	     << sf->peak_active() << " running at once" << endl;
 
     /*    list <const Route*>::iterator rt_i;
     int counts[10]; int hop;
@@ -80,6 +80,7 @@ int main(int argc, char **argv) {
     mem_b queuesize = memFromPkt(DEFAULT_QUEUE_SIZE);
     stringstream filename(ios_base::out);
     int failed_links = 0;
+    int seed = time(NULL);
     int i = 1;
     filename << "logout.dat";
 
@@ -88,6 +89,9 @@ int main(int argc, char **argv) {
 	    filename.str(std::string());
 	    filename << argv[i+1];
 	    i++;
+	} else if (!strcmp(argv[i],"-seed")){
+	    seed = atoi(argv[i+1]);
+	    i++;
 	} else if (!strcmp(argv[i],"-sub")){
 	    subflow_count = atoi(argv[i+1]);
 	    i++;
@@ -133,7 +137,8 @@ int main(int argc, char **argv) {
 
 	i++;
     }
-    srand(time(NULL));
+    srand(seed);
+    SimContext::current().setSeed(seed);
       
     cout << "Using subflow count " << subflow_count <<endl;
       
@@ -208,21 +213,16 @@ int main(int argc, char **argv) {
     VL2Topology* top = new VL2Topology(&logfile,&eventlist,ff);
 #endif
 
-    vector<const Route*>*** net_paths;
-    net_paths = new vector<const Route*>**[no_of_nodes];
+    PathCache net_paths;
 
     int* is_dest = new int[no_of_nodes];
     
-    for (int i=0;i<no_of_nodes;i++){
+    for (int i=0;i<no_of_nodes;i++)
 	is_dest[i] = 0;
-	net_paths[i] = new vector<const Route*>*[no_of_nodes];
-	for (int j = 0;j<no_of_nodes;j++)
-	    net_paths[i][j] = NULL;
-    }
     
 #if USE_FIRST_FIT
     if (ff)
-	ff->net_paths = net_paths;
+	ff->path_cache = &net_paths;
 #endif
     
     vector<int>* destinations;
@@ -260,16 +260,12 @@ int main(int argc, char **argv) {
 	    connID++;
 	    dest = destinations->at(dst_id);
 	    if (!net_paths[src][dest]) {
-		vector<const Route*>* paths = top->get_paths(src,dest);
-		net_paths[src][dest] = paths;
+		vector<const Route*>* paths = net_paths.get(top, src, dest);
 		for (unsigned int i = 0; i < paths->size(); i++) {
 		    routes.push_back((*paths)[i]);
 		}
 	    }
-	    if (!net_paths[dest][src]) {
-		vector<const Route*>* paths = top->get_paths(dest,src);
-		net_paths[dest][src] = paths;
-	    }
+	    net_paths.get(top, dest, src);
 
 	    MultipathTcpSrc* mtcp;
 
@@ -306,10 +302,10 @@ int main(int argc, char **argv) {
 			tcpSnk = new TcpSink();
 		    }
 		    
-		    tcpSrc->setName("tcp_" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(inter)+")");
+		    tcpSrc->setName("tcp_%d_%d(%d)", src, dest, inter);
 		    logfile.writeName(*tcpSrc);
 		    
-		    tcpSnk->setName("tcp_sink_" + ntoa(src) + "_" + ntoa(dest)+ "("+ntoa(inter)+")");
+		    tcpSnk->setName("tcp_sink_%d_%d(%d)", src, dest, inter);
 		    logfile.writeName(*tcpSnk);
 		    
 		    tcpRtxScanner.registerTcp(*tcpSrc);
@@ -410,7 +406,7 @@ int main(int argc, char **argv) {
 		    routeout = new Route(*(net_paths[src][dest]->at(choice)));
 		    routeout->push_back(tcpSnk);
 		    
-		    routein = new Route(*top->get_paths(dest,src)->at(choice));
+		    routein = new Route(*(net_paths[dest][src]->at(choice)));
 		    routein->push_back(tcpSrc);
 		    
 		    extrastarttime = 0 * drand();
@@ -419,7 +415,7 @@ int main(int argc, char **argv) {
 			mtcp->addSubflow(tcpSrc);
 		    
 			if (inter == 0) {
-			    mtcp->setName("multipath" + ntoa(src) + "_" + ntoa(dest)+"("+ntoa(connection)+")");
+			    mtcp->setName("multipath%d_%d(%d)", src, dest, connection);
 			    logfile.writeName(*mtcp);
 			}
 		    }
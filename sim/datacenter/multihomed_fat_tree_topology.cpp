@@ -58,22 +58,22 @@ void MultihomedFatTreeTopology::init_network(){
 	  logfile->addLogger(*queueLogger);
 
 	  queues_nlp_ns[j][k] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	  queues_nlp_ns[j][k]->setName("LS_" + ntoa(j) + "-" + "DST_" +ntoa(k));
+	  queues_nlp_ns[j][k]->setName("LS_%d-DST_%d", j, k);
 	  logfile->writeName(*(queues_nlp_ns[j][k]));
 	  
 	  pipes_nlp_ns[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	  pipes_nlp_ns[j][k]->setName("Pipe-nt-ns-" + ntoa(j) + "-" + ntoa(k));
+	  pipes_nlp_ns[j][k]->setName("Pipe-nt-ns-%d-%d", j, k);
 	  logfile->writeName(*(pipes_nlp_ns[j][k]));
 	  
 	  // Uplink
 	  queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	  logfile->addLogger(*queueLogger);
 	  queues_ns_nlp[k][j] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	  queues_ns_nlp[k][j]->setName("SRC_" + ntoa(k) + "-" + "LS_"+ntoa(j));
+	  queues_ns_nlp[k][j]->setName("SRC_%d-LS_%d", k, j);
 	  logfile->writeName(*(queues_ns_nlp[k][j]));
 	  
 	  pipes_ns_nlp[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	  pipes_ns_nlp[k][j]->setName("Pipe-ns-nt-" + ntoa(k) + "-" + ntoa(j));
+	  pipes_ns_nlp[k][j]->setName("Pipe-ns-nt-%d-%d", k, j);
 	  logfile->writeName(*(pipes_ns_nlp[k][j]));
 	  
 	  if (ff){
@@ -101,22 +101,22 @@ void MultihomedFatTreeTopology::init_network(){
 	queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	logfile->addLogger(*queueLogger);
 	queues_nup_nlp[k][j] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	queues_nup_nlp[k][j]->setName("US_" + ntoa(k) + "-" + "LS_"+ntoa(j));
+	queues_nup_nlp[k][j]->setName("US_%d-LS_%d", k, j);
 	logfile->writeName(*(queues_nup_nlp[k][j]));
 	
 	pipes_nup_nlp[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	pipes_nup_nlp[k][j]->setName("Pipe-na-nt-" + ntoa(k) + "-" + ntoa(j));
+	pipes_nup_nlp[k][j]->setName("Pipe-na-nt-%d-%d", k, j);
 	logfile->writeName(*(pipes_nup_nlp[k][j]));
 	
 	// Uplink
 	queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	logfile->addLogger(*queueLogger);
 	queues_nlp_nup[j][k] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	queues_nlp_nup[j][k]->setName("LS_" + ntoa(j) + "-" + "US_"+ntoa(k));
+	queues_nlp_nup[j][k]->setName("LS_%d-US_%d", j, k);
 	logfile->writeName(*(queues_nlp_nup[j][k]));
 	
 	pipes_nlp_nup[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	pipes_nlp_nup[j][k]->setName("Pipe-nt-na-" + ntoa(j) + "-" + ntoa(k));
+	pipes_nlp_nup[j][k]->setName("Pipe-nt-na-%d-%d", j, k);
 	logfile->writeName(*(pipes_nlp_nup[j][k]));
 	
 	if (ff){
@@ -143,11 +143,11 @@ void MultihomedFatTreeTopology::init_network(){
 	logfile->addLogger(*queueLogger);
 
 	queues_nup_nc[j][k] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	queues_nup_nc[j][k]->setName("US_" + ntoa(j) + "-" + "CS_"+ ntoa(k));
+	queues_nup_nc[j][k]->setName("US_%d-CS_%d", j, k);
 	logfile->writeName(*(queues_nup_nc[j][k]));
 	
 	pipes_nup_nc[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	pipes_nup_nc[j][k]->setName("Pipe-nup-nc-" + ntoa(j) + "-" + ntoa(k));
+	pipes_nup_nc[j][k]->setName("Pipe-nup-nc-%d-%d", j, k);
 	logfile->writeName(*(pipes_nup_nc[j][k]));
 	
 	// Uplink
@@ -159,13 +159,13 @@ void MultihomedFatTreeTopology::init_network(){
 	//queues_nc_nup[k][j] = new RandomQueue(speedFromPktps(HOST_NIC/10), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
 	//else
 	  queues_nc_nup[k][j] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	queues_nc_nup[k][j]->setName("CS_" + ntoa(k) + "-" + "US_"+ntoa(j));
+	queues_nc_nup[k][j]->setName("CS_%d-US_%d", k, j);
 
 
 	logfile->writeName(*(queues_nc_nup[k][j]));
 	
 	pipes_nc_nup[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	pipes_nc_nup[k][j]->setName("Pipe-nc-nup-" + ntoa(k) + "-" + ntoa(j));
+	pipes_nc_nup[k][j]->setName("Pipe-nc-nup-%d-%d", k, j);
 	logfile->writeName(*(pipes_nc_nup[k][j]));
 	
 	if (ff){
@@ -192,7 +192,7 @@ vector<const Route*>* MultihomedFatTreeTopology::get_paths(int src, int dest){
 
   if (HOST_POD_SWITCH1(src)==HOST_POD_SWITCH1(dest)){
     Queue* pqueue = new Queue(speedFromPktps(2*HOST_NIC), memFromPkt(FEEDER_BUFFER), *eventlist, NULL);
-    pqueue->setName("PQueue_" + ntoa(src) + "_" + ntoa(dest));
+    pqueue->setName("PQueue_%d_%d", src, dest);
     //logfile->writeName(*pqueue);
   
     routeout = new Route();
@@ -212,7 +212,7 @@ vector<const Route*>* MultihomedFatTreeTopology::get_paths(int src, int dest){
 
     routeout = new Route();
     pqueue = new Queue(speedFromPktps(2*HOST_NIC), memFromPkt(FEEDER_BUFFER), *eventlist, NULL);
-    pqueue->setName("PQueue_" + ntoa(src) + "_2_" + ntoa(dest));
+    pqueue->setName("PQueue_%d_2_%d", src, dest);
     routeout->push_back(pqueue);
 
     routeout->push_back(queues_ns_nlp[src][HOST_POD_SWITCH2(src)]);
@@ -234,7 +234,7 @@ vector<const Route*>* MultihomedFatTreeTopology::get_paths(int src, int dest){
     for (int upper = MIN_POD_ID(pod);upper <= MAX_POD_ID(pod); upper++){
       //upper is nup
       Queue* pqueue = new Queue(speedFromPktps(HOST_NIC), memFromPkt(FEEDER_BUFFER), *eventlist, NULL);
-      pqueue->setName("PQueue_" + ntoa(src) + "_" + ntoa(dest));
+      pqueue->setName("PQueue_%d_%d", src, dest);
       //logfile->writeName(*pqueue);
       
       routeout = new Route();
@@ -276,7 +276,7 @@ vector<const Route*>* MultihomedFatTreeTopology::get_paths(int src, int dest){
       for (int core = (upper%(K/2)) * K / 2; core < ((upper % (K/2)) + 1)*K/2; core++){
 	//upper is nup
 	Queue* pqueue = new Queue(speedFromPktps(HOST_NIC), memFromPkt(FEEDER_BUFFER), *eventlist, NULL);
-	pqueue->setName("PQueue_" + ntoa(src) + "_" + ntoa(dest));
+	pqueue->setName("PQueue_%d_%d", src, dest);
 	//logfile->writeName(*pqueue);
 	
 	routeout = new Route();
@@ -47,6 +47,42 @@ Queue* OversubscribedFatTreeTopology::alloc_queue(QueueLogger* queueLogger, uint
     assert(0);
 }
 
+void OversubscribedFatTreeTopology::switch_queues(vector<Queue*>& queues){
+    for (int j = 0; j < NK; j++) {
+	for (int k = 0; k < NSRV; k++)
+	    queues.push_back(queues_nlp_ns[j][k]);
+	for (int k = 0; k < NK; k++) {
+	    queues.push_back(queues_nup_nlp[j][k]);
+	    queues.push_back(queues_nlp_nup[j][k]);
+	}
+	for (int k = 0; k < NC; k++)
+	    queues.push_back(queues_nup_nc[j][k]);
+    }
+    for (int j = 0; j < NC; j++)
+	for (int k = 0; k < NK; k++)
+	    queues.push_back(queues_nc_nup[j][k]);
+}
+
+void OversubscribedFatTreeTopology::set_ecn_marking(const EcnMarker& marker){
+    assert(qt==ECN);
+    vector<Queue*> queues;
+    switch_queues(queues);
+    for (size_t i = 0; i < queues.size(); i++)
+	if (queues[i])
+	    ((ECNQueue*)queues[i])->setMarker(marker);
+}
+
+uint64_t OversubscribedFatTreeTopology::ecn_marks(){
+    assert(qt==ECN);
+    vector<Queue*> queues;
+    switch_queues(queues);
+    uint64_t marks = 0;
+    for (size_t i = 0; i < queues.size(); i++)
+	if (queues[i])
+	    marks += ((ECNQueue*)queues[i])->num_marked();
+    return marks;
+}
+
 void OversubscribedFatTreeTopology::init_network(){
     QueueLoggerSampling* queueLogger;
 
@@ -84,22 +120,22 @@ void OversubscribedFatTreeTopology::init_network(){
 	    logfile->addLogger(*queueLogger);
 
 	    queues_nlp_ns[j][k] = alloc_queue(queueLogger);
-	    queues_nlp_ns[j][k]->setName("LS_" + ntoa(j) + "-" + "DST_" +ntoa(k));
+	    queues_nlp_ns[j][k]->setName("LS_%d-DST_%d", j, k);
 	    logfile->writeName(*(queues_nlp_ns[j][k]));
 	  
 	    pipes_nlp_ns[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	    pipes_nlp_ns[j][k]->setName("Pipe-nt-ns-" + ntoa(j) + "-" + ntoa(k));
+	    pipes_nlp_ns[j][k]->setName("Pipe-nt-ns-%d-%d", j, k);
 	    logfile->writeName(*(pipes_nlp_ns[j][k]));
 	  
 	    // Uplink
 	    queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	    logfile->addLogger(*queueLogger);
 	    queues_ns_nlp[k][j] = alloc_src_queue(queueLogger);
-	    queues_ns_nlp[k][j]->setName("SRC_" + ntoa(k) + "-" + "LS_"+ntoa(j));
+	    queues_ns_nlp[k][j]->setName("SRC_%d-LS_%d", k, j);
 	    logfile->writeName(*(queues_ns_nlp[k][j]));
 	  
 	    pipes_ns_nlp[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	    pipes_ns_nlp[k][j]->setName("Pipe-ns-nt-" + ntoa(k) + "-" + ntoa(j));
+	    pipes_ns_nlp[k][j]->setName("Pipe-ns-nt-%d-%d", k, j);
 	    logfile->writeName(*(pipes_ns_nlp[k][j]));
 	  
 	    if (ff){
@@ -126,11 +162,11 @@ void OversubscribedFatTreeTopology::init_network(){
 	    logfile->addLogger(*queueLogger);
 	    queues_nup_nlp[k][j] = alloc_queue(queueLogger);
 	    
-	    queues_nup_nlp[k][j]->setName("US_" + ntoa(k) + "-" + "LS_"+ntoa(j));
+	    queues_nup_nlp[k][j]->setName("US_%d-LS_%d", k, j);
 	    logfile->writeName(*(queues_nup_nlp[k][j]));
 	
 	    pipes_nup_nlp[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	    pipes_nup_nlp[k][j]->setName("Pipe-na-nt-" + ntoa(k) + "-" + ntoa(j));
+	    pipes_nup_nlp[k][j]->setName("Pipe-na-nt-%d-%d", k, j);
 	    logfile->writeName(*(pipes_nup_nlp[k][j]));
 	
 	    // Uplink
@@ -138,11 +174,11 @@ void OversubscribedFatTreeTopology::init_network(){
 	    logfile->addLogger(*queueLogger);
 	    queues_nlp_nup[j][k] = alloc_queue(queueLogger);
 
-	    queues_nlp_nup[j][k]->setName("LS_" + ntoa(j) + "-" + "US_"+ntoa(k));
+	    queues_nlp_nup[j][k]->setName("LS_%d-US_%d", j, k);
 	    logfile->writeName(*(queues_nlp_nup[j][k]));
 	
 	    pipes_nlp_nup[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	    pipes_nlp_nup[j][k]->setName("Pipe-nt-na-" + ntoa(j) + "-" + ntoa(k));
+	    pipes_nlp_nup[j][k]->setName("Pipe-nt-na-%d-%d", j, k);
 	    logfile->writeName(*(pipes_nlp_nup[j][k]));
 	
 	    if (ff){
@@ -169,11 +205,11 @@ void OversubscribedFatTreeTopology::init_network(){
 	    logfile->addLogger(*queueLogger);
 
 	    queues_nup_nc[j][k] = alloc_queue(queueLogger);
-	    queues_nup_nc[j][k]->setName("US_" + ntoa(j) + "-" + "CS_"+ ntoa(k));
+	    queues_nup_nc[j][k]->setName("US_%d-CS_%d", j, k);
 	    logfile->writeName(*(queues_nup_nc[j][k]));
 	
 	    pipes_nup_nc[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	    pipes_nup_nc[j][k]->setName("Pipe-nup-nc-" + ntoa(j) + "-" + ntoa(k));
+	    pipes_nup_nc[j][k]->setName("Pipe-nup-nc-%d-%d", j, k);
 	    logfile->writeName(*(pipes_nup_nc[j][k]));
 	
 	    // Uplink
@@ -185,13 +221,13 @@ void OversubscribedFatTreeTopology::init_network(){
 	    //queues_nc_nup[k][j] = alloc_queue(queueLogger,HOST_NIC/10);
 	    //else
 	    queues_nc_nup[k][j] = alloc_queue(queueLogger);
-	    queues_nc_nup[k][j]->setName("CS_" + ntoa(k) + "-" + "US_"+ntoa(j));
+	    queues_nc_nup[k][j]->setName("CS_%d-US_%d", k, j);
 
 
 	    logfile->writeName(*(queues_nc_nup[k][j]));
 	
 	    pipes_nc_nup[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	    pipes_nc_nup[k][j]->setName("Pipe-nc-nup-" + ntoa(k) + "-" + ntoa(j));
+	    pipes_nc_nup[k][j]->setName("Pipe-nc-nup-%d-%d", k, j);
 	    logfile->writeName(*(pipes_nc_nup[k][j]));
 	
 	    if (ff){
@@ -11,6 +11,7 @@
 #include "topology.h"
 #include "logfile.h"
 #include "eventlist.h"
+#include "ecn_marker.h"
 #include <ostream>
 
 #define K 8
@@ -60,6 +61,11 @@ class OversubscribedFatTreeTopology: public Topology{
     Queue* alloc_queue(QueueLogger* q);
     Queue* alloc_queue(QueueLogger* q,uint64_t speed);
 
+    // Mark as marker does at every switch queue (see ecn_marker.h), and
+    // count the marks they've made.  ECN queues only.
+    void set_ecn_marking(const EcnMarker& marker);
+    uint64_t ecn_marks();
+
     void count_queue(Queue*);
     void print_path(std::ofstream& paths,int src,const Route* route);
     vector<int>* get_neighbours(int src);
@@ -70,6 +76,8 @@ class OversubscribedFatTreeTopology: public Topology{
     int find_up_switch(Queue* queue);
     int find_core_switch(Queue* queue);
     int find_destination(Queue* queue);
+    // every switch queue, or NULL where there's no link
+    void switch_queues(vector<Queue*>& queues);
     int _no_of_nodes;
 };
 
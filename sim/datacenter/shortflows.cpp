@@ -4,49 +4,143 @@
 string ntoa(double n);
 string itoa(uint64_t n);
 
-ShortFlows::ShortFlows(double lambda, EventList& eventlist, vector<const Route*>*** n,
-		       ConnectionMatrix* conns,Logfile* logfile,TcpRtxTimerScanner * rtx)
-  : EventSource(eventlist,"ShortFlows")
+const simtime_picosec ShortFlows::DRAIN = timeFromMs(10);
+
+ShortFlow::ShortFlow(ShortFlows* pool)
+  : tcp_src(NULL), tcp_snk(NULL), ndp_src(NULL), ndp_snk(NULL),
+    routeout(NULL), routein(NULL), finished(0), _pool(pool)
+{
+}
+
+void ShortFlow::flowStopped() {
+    _pool->flowFinished(this);
+}
+
+ShortFlows::ShortFlows(double lambda, simtime_picosec start, EventList& eventlist,
+		       PathCache& net_paths, Topology* top, ConnectionMatrix* conns,
+		       Logfile* logfile, TcpRtxTimerScanner* rtx)
+  : EventSource(eventlist,"ShortFlows"), tcpRtxScanner(rtx), ndpRtxScanner(NULL),
+    _pacers(NULL), _route_strategy(NOT_SET), _cwnd(0)
 {
-  eventlist.sourceIsPendingRel(*this, timeFromMs(1000));
-  net_paths = n;
+  init(lambda, start, net_paths, top, conns, logfile);
+}
+
+ShortFlows::ShortFlows(double lambda, simtime_picosec start, EventList& eventlist,
+		       PathCache& net_paths, Topology* top, ConnectionMatrix* conns,
+		       Logfile* logfile, NdpRtxTimerScanner* rtx,
+		       vector<NdpPullPacer*>& pacers, RouteStrategy route_strategy,
+		       uint32_t cwnd)
+  : EventSource(eventlist,"ShortFlows"), tcpRtxScanner(NULL), ndpRtxScanner(rtx),
+    _pacers(&pacers), _route_strategy(route_strategy), _cwnd(cwnd)
+{
+  init(lambda, start, net_paths, top, conns, logfile);
+}
+
+void ShortFlows::init(double lambda, simtime_picosec start, PathCache& net_paths,
+		      Topology* top, ConnectionMatrix* conns, Logfile* logfile) {
+  _made = _active = _peak_active = 0;
+  _net_paths = &net_paths;
+  _top = top;
   _traffic_matrix = conns->getAllConnections();
   this->logfile = logfile;
   this->_lambda = lambda;
 
-  tcpRtxScanner = rtx;
+  eventlist().sourceIsPending(*this, start);
 }
 
-ShortFlow* ShortFlows::createConnection(int src, int dst, simtime_picosec starttime){
-    ShortFlow* f = new ShortFlow();
-    f->src = new TcpSrcTransfer(NULL,NULL,eventlist(),70000,net_paths[src][dst]);
-    f->snk = new TcpSinkTransfer();
-
-    int pos = connections[src][dst].size();
-
-    f->src->setName("sf_" + ntoa(src) + "_" + ntoa(dst)+"("+ntoa(pos)+")");
-    logfile->writeName(*(f->src));
-	      
-    f->snk->setName("sf_sink_" + ntoa(src) + "_" + ntoa(dst)+ "("+ntoa(pos)+")");
-    logfile->writeName(*(f->snk));
-    
-    tcpRtxScanner->registerTcp(*(f->src));
-
-    int choice = rand()%net_paths[src][dst]->size();
-
-    Route* routeout = new Route(*(net_paths[src][dst]->at(choice)));
-    routeout->push_back(f->snk);
-    
-    Route* routein = new Route();
-    routein->push_back(f->src);
-    
-    f->src->connect(*routeout, *routein, *(f->snk), starttime);
+// the flow that's been finished longest, if it's drained, or else a new one
+ShortFlow* ShortFlows::newFlow() {
+  if (!_idle.empty() && _idle.front()->finished + DRAIN <= eventlist().now()) {
+    ShortFlow* f = _idle.front();
+    _idle.pop_front();
     return f;
+  }
+  _made++;
+  return new ShortFlow(this);
+}
+
+void ShortFlows::startTcp(ShortFlow* f, int src, int dst) {
+  vector<const Route*>* paths = _net_paths->get(_top, src, dst);
+
+  if (!f->tcp_src) {
+    f->tcp_src = new TcpSrcTransfer(NULL,NULL,eventlist(),70000,paths,f);
+    f->tcp_snk = new TcpSinkTransfer();
+
+    f->tcp_src->setName("sf_%d", (int)_made);
+    logfile->writeName(*(f->tcp_src));
+
+    f->tcp_snk->setName("sf_sink_%d", (int)_made);
+    logfile->writeName(*(f->tcp_snk));
+
+    tcpRtxScanner->registerTcp(*(f->tcp_src));
+
+    // the sink acks straight back, wherever the pair are
+    f->routein = new Route();
+    f->routein->push_back(f->tcp_src);
+  } else {
+    f->tcp_src->reset(70000, false);
+    f->tcp_src->change_paths(paths);
+    delete f->routeout;
+  }
+
+  int choice = rand()%paths->size();
+
+  f->routeout = paths->at(choice)->extend();
+  f->routeout->push_back(f->tcp_snk);
+
+  f->tcp_src->connect(*(f->routeout), *(f->routein), *(f->tcp_snk), eventlist().now());
+}
+
+void ShortFlows::startNdp(ShortFlow* f, int src, int dst) {
+  vector<const Route*>* paths = _net_paths->get(_top, src, dst);
+  vector<const Route*>* back = _net_paths->get(_top, dst, src);
+
+  if (!f->ndp_src) {
+    f->ndp_src = new NdpSrcTransfer(NULL, NULL, eventlist(), f);
+    f->ndp_src->setCwnd(_cwnd);
+    f->ndp_snk = new NdpSinkTransfer((*_pacers)[dst]);
+
+    f->ndp_src->setName("sf_%d", (int)_made);
+    logfile->writeName(*(f->ndp_src));
+
+    f->ndp_snk->setName("sf_sink_%d", (int)_made);
+    logfile->writeName(*(f->ndp_snk));
+
+    ndpRtxScanner->registerNdp(*(f->ndp_src));
+  } else {
+    f->ndp_src->reset(f->ndp_src->generateFlowSize(), false);
+    f->ndp_src->clear_paths();
+    f->ndp_snk->clear_paths();
+    f->ndp_snk->set_pacer((*_pacers)[dst]);
+    delete f->routeout;
+    delete f->routein;
+  }
+
+  int choice = rand()%paths->size();
+
+  f->routeout = paths->at(choice)->extend();
+  f->routeout->add_endpoints(f->ndp_src, f->ndp_snk);
+
+  f->routein = back->at(choice)->extend();
+  f->routein->add_endpoints(f->ndp_snk, f->ndp_src);
+
+  f->ndp_src->connect(*(f->routeout), *(f->routein), *(f->ndp_snk), eventlist().now());
+
+  if (_route_strategy != SINGLE_PATH) {
+    f->ndp_src->set_paths(paths);
+    f->ndp_snk->set_paths(back);
+  }
+}
+
+void ShortFlows::flowFinished(ShortFlow* f) {
+  f->finished = eventlist().now();
+  _idle.push_back(f);
+  _active--;
 }
 
 void ShortFlows::doNextEvent() {
   run();
-  
+
   simtime_picosec nextArrival = (simtime_picosec)(exponential(_lambda)*timeFromSec(1));
   eventlist().sourceIsPendingRel(*this, nextArrival);
 }
@@ -54,22 +148,14 @@ void ShortFlows::doNextEvent() {
 void ShortFlows::run(){
   //randomly choose connection to activate.
   int pos = rand()%_traffic_matrix->size();
-
-  //look for inactive connection
   connection* c = _traffic_matrix->at(pos);
-  
-  ShortFlow* f = NULL;
-  for (unsigned int i=0;i<connections[c->src][c->dst].size();i++){
-    f = connections[c->src][c->dst][i];
-    if (!f->src->_is_active)
-      break;
-  }
 
-  if (!f||f->src->_is_active){
-    f = createConnection(c->src,c->dst,eventlist().now());
-    connections[c->src][c->dst].push_back(f);
-  }
-  else {
-    f->src->reset(70000, true);
-  }
+  ShortFlow* f = newFlow();
+  if (ndpRtxScanner)
+    startNdp(f, c->src, c->dst);
+  else
+    startTcp(f, c->src, c->dst);
+
+  if (++_active > _peak_active)
+    _peak_active = _active;
 }
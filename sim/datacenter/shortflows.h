@@ -7,39 +7,88 @@
 #include "logfile.h"
 #include "eventlist.h"
 #include "tcp_transfer.h"
-#include <list>
-#include <map>
+#include "ndp_transfer.h"
+#include "topology.h"
+#include <deque>
 #include "connection_matrix.h"
 extern int N;
 
-struct ShortFlow{
-  TcpSrcTransfer* src;
-  TcpSinkTransfer* snk; 
+class ShortFlows;
+
+// A source/sink pair, TCP or NDP.  The source tells us when its
+// transfer is done (we're its _flow_stopped), and the pair goes back
+// to ShortFlows to carry a later arrival, between whichever hosts.
+class ShortFlow: public FlowStopped {
+ public:
+  ShortFlow(ShortFlows* pool);
+  void flowStopped();
+
+  TcpSrcTransfer* tcp_src;
+  TcpSinkTransfer* tcp_snk;
+  NdpSrcTransfer* ndp_src;
+  NdpSinkTransfer* ndp_snk;
+  // what connect() was last given, freed when we move hosts
+  Route* routeout;
+  Route* routein;
+  simtime_picosec finished;
+ private:
+  ShortFlows* _pool;
 };
 
+// Starts a flow between a random pair from the connection matrix at
+// each Poisson arrival, lambda of them a second from start on.
+// Finished flows wait on one free list, oldest first, and are
+// restarted between the next arrival's hosts, so memory follows how
+// many flows run at once rather than how many have run.
 class ShortFlows: public EventSource{
  public:
-  ShortFlows(double l, EventList& eventlist, vector<const Route*>*** np, ConnectionMatrix* c,
-	     Logfile* logfile,TcpRtxTimerScanner* r);
+  // TCP flows
+  ShortFlows(double lambda, simtime_picosec start, EventList& eventlist,
+	     PathCache& net_paths, Topology* top, ConnectionMatrix* c,
+	     Logfile* logfile, TcpRtxTimerScanner* r);
+  // NDP flows; the sink at host i is paced by pacers[i]
+  ShortFlows(double lambda, simtime_picosec start, EventList& eventlist,
+	     PathCache& net_paths, Topology* top, ConnectionMatrix* c,
+	     Logfile* logfile, NdpRtxTimerScanner* r,
+	     vector<NdpPullPacer*>& pacers, RouteStrategy route_strategy,
+	     uint32_t cwnd);
   void doNextEvent();
 
   void run();
 
+  void flowFinished(ShortFlow* f);
+
+  // flows made so far, and the most running at once: with finished
+  // flows recycled the first never gets far past the second
+  uint64_t flows_made() const {return _made;}
+  uint64_t peak_active() const {return _peak_active;}
+
+  // A finished flow isn't restarted until this long after, by when any
+  // of its packets still in the network, or pulls still queued at its
+  // pacer, will have arrived and gone, and its routes are free.
+  static const simtime_picosec DRAIN;
 
-  ShortFlow* createConnection(int src, int dst, simtime_picosec starttime);
-  vector<const Route*>*** net_paths;
  private:
-  vector<ShortFlow*> connections[1024][1024];
+  void init(double lambda, simtime_picosec start, PathCache& net_paths,
+	    Topology* top, ConnectionMatrix* conns, Logfile* logfile);
+  ShortFlow* newFlow();
+  void startTcp(ShortFlow* f, int src, int dst);
+  void startNdp(ShortFlow* f, int src, int dst);
+
+  PathCache* _net_paths;
+  Topology* _top;
   vector<connection*>* _traffic_matrix;
   Logfile* logfile;
 
-  //create connections periodically
-  //change path
-  //start
-  //log finish time when it's done
-  
-  double _lambda;  
+  double _lambda;
   TcpRtxTimerScanner* tcpRtxScanner;
+  NdpRtxTimerScanner* ndpRtxScanner;
+  vector<NdpPullPacer*>* _pacers;
+  RouteStrategy _route_strategy;
+  uint32_t _cwnd;
+
+  deque<ShortFlow*> _idle;  // finished, in the order they finished
+  uint64_t _made, _active, _peak_active;
 };
 
 #endif
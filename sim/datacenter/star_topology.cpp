@@ -38,22 +38,22 @@ void StarTopology::init_network(){
     logfile->addLogger(*queueLogger);
 
     queue_in_ns[j] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-    queue_in_ns[j]->setName("IN_" + ntoa(j));
+    queue_in_ns[j]->setName("IN_%d", j);
     logfile->writeName(*(queue_in_ns[j]));
 	  
     pipe_in_ns[j] = new Pipe(timeFromUs(RTT), *eventlist);
-    pipe_in_ns[j]->setName("Pipe-in-" + ntoa(j));
+    pipe_in_ns[j]->setName("Pipe-in-%d", j);
     logfile->writeName(*(pipe_in_ns[j]));
 
     queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
     //queueLogger = NULL;
     logfile->addLogger(*queueLogger);
     queue_out_ns[j] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-    queue_out_ns[j]->setName("OUT_" + ntoa(j));
+    queue_out_ns[j]->setName("OUT_%d", j);
     logfile->writeName(*(queue_out_ns[j]));
 	  
     pipe_out_ns[j] = new Pipe(timeFromUs(RTT), *eventlist);
-    pipe_out_ns[j]->setName("Pipe-out-" + ntoa(j));
+    pipe_out_ns[j]->setName("Pipe-out-%d", j);
     logfile->writeName(*(pipe_out_ns[j]));
 	  
     if (ff){
@@ -71,7 +71,7 @@ vector<const Route*>* StarTopology::get_paths(int src, int dest){
   Route* routeout;
 
     Queue* pqueue = new Queue(speedFromPktps(HOST_NIC), memFromPkt(FEEDER_BUFFER), *eventlist, NULL);
-    pqueue->setName("PQueue_" + ntoa(src) + "_" + ntoa(dest));
+    pqueue->setName("PQueue_%d_%d", src, dest);
     //logfile->writeName(*pqueue);
   
     routeout = new Route();
@@ -68,10 +68,10 @@ void SubflowControl::run(){
       TcpSrc* tcpSrc = new TcpSrc(NULL, NULL, eventlist());
       TcpSink* tcpSnk = new TcpSink();
 	      
-      tcpSrc->setName("mtcp_" + ntoa(f->src) + "_" + ntoa(f->subflows->size()) + "_" + ntoa(f->dest));
+      tcpSrc->setName("mtcp_%d_%d_%d", f->src, f->subflows->size(), f->dest);
       logfile->writeName(*tcpSrc);
 	      
-      tcpSnk->setName("mtcp_sink_" + ntoa(f->src) + "_" + ntoa(f->subflows->size()) + "_" + ntoa(f->dest));
+      tcpSnk->setName("mtcp_sink_%d_%d_%d", f->src, f->subflows->size(), f->dest);
       logfile->writeName(*tcpSnk);
       
       _rtx->registerTcp(*tcpSrc);
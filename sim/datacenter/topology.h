@@ -1,6 +1,7 @@
 #ifndef TOPOLOGY
 #define TOPOLOGY
 #include "network.h"
+#include <map>
 
 class Topology {
  public:
@@ -9,4 +10,41 @@ class Topology {
   virtual int no_of_nodes() const { abort();};
 };
 
+// The paths between pairs of hosts, as net_paths[src][dest], got from
+// the topology as each pair is first needed.  Only the pairs in use
+// take any memory, where a table of every pair grows with the square
+// of the number of hosts, and their routes are interned, so a path
+// that's also another pair's way back is only kept once.
+class PathCache {
+ public:
+  // the paths from src to dest, asking top for them the first time
+  vector<const Route*>* get(Topology* top, int src, int dest) {
+    vector<const Route*>*& paths = (*this)[src][dest];
+    if (!paths) {
+      paths = top->get_paths(src, dest);
+      _routes.intern(*paths);
+    }
+    return paths;
+  }
+
+  class Row {
+  public:
+    Row(PathCache& cache, int src) : _cache(cache), _src(src) {}
+    // NULL until got or set
+    vector<const Route*>*& operator[](int dest) {
+      return _cache._paths[((uint64_t)_src << 32) | (uint32_t)dest];
+    }
+  private:
+    PathCache& _cache;
+    int _src;
+  };
+
+  Row operator[](int src) {return Row(*this, src);}
+  size_t size() const {return _paths.size();}
+
+ private:
+  map<uint64_t, vector<const Route*>*> _paths;
+  RouteTable _routes;
+};
+
 #endif
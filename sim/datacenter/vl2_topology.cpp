@@ -57,22 +57,22 @@ void VL2Topology::init_network(){
             queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
             logfile->addLogger(*queueLogger);
             queues_nt_ns[j][k] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-            queues_nt_ns[j][k]->setName("Queue-nt-ns-" + ntoa(j) + "-" + ntoa(k));
+            queues_nt_ns[j][k]->setName("Queue-nt-ns-%d-%d", j, k);
             logfile->writeName(*(queues_nt_ns[j][k]));
 
             pipes_nt_ns[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-            pipes_nt_ns[j][k]->setName("Pipe-nt-ns-" + ntoa(j) + "-" + ntoa(k));
+            pipes_nt_ns[j][k]->setName("Pipe-nt-ns-%d-%d", j, k);
             logfile->writeName(*(pipes_nt_ns[j][k]));
 
             // Uplink
             queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
             logfile->addLogger(*queueLogger);
             queues_ns_nt[k][j] = new RandomQueue(speedFromPktps(HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-            queues_ns_nt[k][j]->setName("Queue-ns-nt-" + ntoa(k) + "-" + ntoa(j));
+            queues_ns_nt[k][j]->setName("Queue-ns-nt-%d-%d", k, j);
             logfile->writeName(*(queues_ns_nt[k][j]));
 
             pipes_ns_nt[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-            pipes_ns_nt[k][j]->setName("Pipe-ns-nt-" + ntoa(k) + "-" + ntoa(j));
+            pipes_ns_nt[k][j]->setName("Pipe-ns-nt-%d-%d", k, j);
             logfile->writeName(*(pipes_ns_nt[k][j]));
 
 #if PRINT_TOPOLOGY    
@@ -101,23 +101,23 @@ void VL2Topology::init_network(){
 	  queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	  logfile->addLogger(*queueLogger);
 	  queues_na_nt[k][j] = new RandomQueue(speedFromPktps(CORE_TO_HOST*HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	  queues_na_nt[k][j]->setName("Queue-na-nt-" + ntoa(k) + "-" + ntoa(j));
+	  queues_na_nt[k][j]->setName("Queue-na-nt-%d-%d", k, j);
 	  logfile->writeName(*(queues_na_nt[k][j]));
 	  
 
 	  pipes_na_nt[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	  pipes_na_nt[k][j]->setName("Pipe-na-nt-" + ntoa(k) + "-" + ntoa(j));
+	  pipes_na_nt[k][j]->setName("Pipe-na-nt-%d-%d", k, j);
 	  logfile->writeName(*(pipes_na_nt[k][j]));
 	  
 	  // Uplink
 	  queueLogger = new QueueLoggerSampling(timeFromMs(1000), *eventlist);
 	  logfile->addLogger(*queueLogger);
 	  queues_nt_na[j][k] = new RandomQueue(speedFromPktps(CORE_TO_HOST*HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	  queues_nt_na[j][k]->setName("Queue-nt-na-" + ntoa(j) + "-" + ntoa(k));
+	  queues_nt_na[j][k]->setName("Queue-nt-na-%d-%d", j, k);
 	  logfile->writeName(*(queues_nt_na[j][k]));
 	  
 	  pipes_nt_na[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	  pipes_nt_na[j][k]->setName("Pipe-nt-na-" + ntoa(j) + "-" + ntoa(k));
+	  pipes_nt_na[j][k]->setName("Pipe-nt-na-%d-%d", j, k);
 	  logfile->writeName(*(pipes_nt_na[j][k]));
 
 #if PRINT_TOPOLOGY    
@@ -140,7 +140,7 @@ void VL2Topology::init_network(){
 	  logfile->addLogger(*queueLogger);
 
 	  queues_ni_na[j][k] = new RandomQueue(speedFromPktps(CORE_TO_HOST*HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	  queues_ni_na[j][k]->setName("Queue-ni-na-" + ntoa(j) + "-" + ntoa(k));
+	  queues_ni_na[j][k]->setName("Queue-ni-na-%d-%d", j, k);
 
 	  //	  if (j==0)
 	  //queues_ni_na[j][k]->set_packet_loss_rate(0);
@@ -148,7 +148,7 @@ void VL2Topology::init_network(){
 	  logfile->writeName(*(queues_ni_na[j][k]));
 	  
 	  pipes_ni_na[j][k] = new Pipe(timeFromUs(RTT), *eventlist);
-	  pipes_ni_na[j][k]->setName("Pipe-ni-na-" + ntoa(j) + "-" + ntoa(k));
+	  pipes_ni_na[j][k]->setName("Pipe-ni-na-%d-%d", j, k);
 	  logfile->writeName(*(pipes_ni_na[j][k]));
 	  
 	  // Uplink
@@ -157,11 +157,11 @@ void VL2Topology::init_network(){
 	  logfile->addLogger(*queueLogger);
 
 	  queues_na_ni[k][j] = new RandomQueue(speedFromPktps(CORE_TO_HOST*HOST_NIC), memFromPkt(SWITCH_BUFFER + RANDOM_BUFFER), *eventlist, queueLogger, memFromPkt(RANDOM_BUFFER));
-	  queues_na_ni[k][j]->setName("Queue-na-ni-" + ntoa(k) + "-" + ntoa(j));
+	  queues_na_ni[k][j]->setName("Queue-na-ni-%d-%d", k, j);
 	  logfile->writeName(*(queues_na_ni[k][j]));
 
 	  pipes_na_ni[k][j] = new Pipe(timeFromUs(RTT), *eventlist);
-	  pipes_na_ni[k][j]->setName("Pipe-na-ni-" + ntoa(k) + "-" + ntoa(j));
+	  pipes_na_ni[k][j]->setName("Pipe-na-ni-%d-%d", k, j);
 	  logfile->writeName(*(pipes_na_ni[k][j]));
 
 #if PRINT_TOPOLOGY    
@@ -183,7 +183,7 @@ vector<const Route*>* VL2Topology::get_paths(int src, int dest){
 
   if (HOST_TOR(src)==HOST_TOR(dest)){
     Queue* pqueue = new Queue(speedFromPktps(CORE_TO_HOST*HOST_NIC), memFromPkt(FEEDER_BUFFER), *eventlist, NULL);
-    pqueue->setName("PQueue_" + ntoa(src) + "_" + ntoa(dest));
+    pqueue->setName("PQueue_%d_%d", src, dest);
     logfile->writeName(*pqueue);
   
     routeout = new Route();
@@ -204,7 +204,7 @@ vector<const Route*>* VL2Topology::get_paths(int src, int dest){
     routeout = new Route();
 
     Queue* pqueue = new Queue(speedFromPktps(CORE_TO_HOST*HOST_NIC), memFromPkt(FEEDER_BUFFER), *eventlist, NULL);
-    pqueue->setName("PQueue_" + ntoa(src) + "_" + ntoa(dest));
+    pqueue->setName("PQueue_%d_%d", src, dest);
     logfile->writeName(*pqueue);
   
     routeout->push_back(pqueue);
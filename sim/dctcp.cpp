@@ -77,7 +77,7 @@ DCTCPSrc::receivePacket(Packet& pkt)
 }
 
 void 
-DCTCPSrc::rtx_timer_hook(simtime_picosec now,simtime_picosec period){
-    TcpSrc::rtx_timer_hook(now,period);
+DCTCPSrc::rtx_timer_hook(simtime_picosec now){
+    TcpSrc::rtx_timer_hook(now);
 };
 
@@ -16,7 +16,7 @@ class DCTCPSrc : public TcpSrc {
     // Mechanism
     virtual void deflate_window();
     virtual void receivePacket(Packet& pkt);
-    virtual void rtx_timer_hook(simtime_picosec now,simtime_picosec period);
+    virtual void rtx_timer_hook(simtime_picosec now);
 
  private:
     uint32_t _past_cwnd;
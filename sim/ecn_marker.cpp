@@ -0,0 +1,223 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "ecn_marker.h"
+#include "network.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// after this many missed PIE updates the controller has long settled:
+// an idle queue's probability has decayed to nothing
+#define PIE_MAX_CATCHUP 64
+
+EcnMarker::EcnMarker(mem_b threshold)
+    : _policy(MARK_STEP), _point(MARK_ON_DEQUEUE), _marks(0),
+      _queuesize(0), _ewma_weight(0), _avg(0),
+      _K(threshold), _red_min(0), _red_max(0), _red_pmax(0),
+      _target(0), _interval(0), _first_above(0), _mark_next(0),
+      _marking(false), _count(0), _last_count(0),
+      _bitrate(0), _tupdate(0), _next_update(0),
+      _alpha(0), _beta(0), _p(0), _qdelay_old(0),
+      _mtu(Packet::data_packet_size())
+{
+}
+
+void
+EcnMarker::setStep(mem_b threshold) {
+    _policy = MARK_STEP;
+    _K = threshold;
+}
+
+void
+EcnMarker::setRed(mem_b min, mem_b max, double pmax) {
+    assert(min < max && pmax > 0 && pmax <= 1);
+    _policy = MARK_RED;
+    _red_min = min;
+    _red_max = max;
+    _red_pmax = pmax;
+}
+
+void
+EcnMarker::setCodel(simtime_picosec target, simtime_picosec interval) {
+    assert(target > 0 && interval > 0);
+    _policy = MARK_CODEL;
+    _target = target;
+    _interval = interval;
+}
+
+void
+EcnMarker::setPie(simtime_picosec target, simtime_picosec tupdate,
+		  double alpha, double beta) {
+    assert(target > 0 && tupdate > 0);
+    _policy = MARK_PIE;
+    _target = target;
+    _tupdate = tupdate;
+    double scale = 0.015 / timeAsSec(target);
+    _alpha = alpha * scale;
+    _beta = beta * scale;
+}
+
+void
+EcnMarker::setEwma(double weight) {
+    assert(weight >= 0 && weight <= 1);
+    _ewma_weight = weight;
+}
+
+int
+EcnMarker::parseOption(int argc, char** argv, int i) {
+    if (!strcmp(argv[i], "-mark")) {
+	if (i+1 >= argc)
+	    return -1;
+	const char* policy = argv[i+1];
+	int nargs = !strcmp(policy, "red") ? 3 : !strcmp(policy, "step") ? 1 : 2;
+	if (i+1+nargs >= argc)
+	    return -1;
+	char** a = argv + i + 2;
+	if (!strcmp(policy, "step"))
+	    setStep(memFromPkt(atof(a[0])));
+	else if (!strcmp(policy, "red"))
+	    setRed(memFromPkt(atof(a[0])), memFromPkt(atof(a[1])), atof(a[2]));
+	else if (!strcmp(policy, "codel"))
+	    setCodel(timeFromUs(atof(a[0])), timeFromUs(atof(a[1])));
+	else if (!strcmp(policy, "pie"))
+	    setPie(timeFromUs(atof(a[0])), timeFromUs(atof(a[1])));
+	else
+	    return -1;
+	return 1 + nargs;
+    }
+    if (!strcmp(argv[i], "-markat")) {
+	if (i+1 >= argc)
+	    return -1;
+	if (!strcmp(argv[i+1], "enq"))
+	    setMarkPoint(MARK_ON_ENQUEUE);
+	else if (!strcmp(argv[i+1], "deq"))
+	    setMarkPoint(MARK_ON_DEQUEUE);
+	else
+	    return -1;
+	return 1;
+    }
+    if (!strcmp(argv[i], "-ewma")) {
+	if (i+1 >= argc)
+	    return -1;
+	setEwma(atof(argv[i+1]));
+	return 1;
+    }
+    return 0;
+}
+
+void
+EcnMarker::sample(mem_b queuesize, simtime_picosec now) {
+    if (_policy == MARK_PIE)
+	pieUpdate(now);
+    _queuesize = queuesize;
+    if (_ewma_weight > 0)
+	_avg += _ewma_weight * (queuesize - _avg);
+}
+
+bool
+EcnMarker::mark(mem_b queuesize, simtime_picosec sojourn, simtime_picosec now, Rng& rng) {
+    double occupancy = _ewma_weight > 0 ? _avg : queuesize;
+    bool marked = false;
+
+    switch (_policy) {
+    case MARK_STEP:
+	marked = occupancy > _K;
+	break;
+    case MARK_RED:
+	if (occupancy >= _red_max)
+	    marked = true;
+	else if (occupancy > _red_min)
+	    marked = rng.uniform() < _red_pmax * (occupancy - _red_min) / (_red_max - _red_min);
+	break;
+    case MARK_CODEL:
+	marked = codelMark(queuesize, sojourn, now);
+	break;
+    case MARK_PIE:
+	pieUpdate(now);
+	marked = _p > 0 && rng.uniform() < _p;
+	break;
+    }
+
+    if (marked)
+	_marks++;
+    return marked;
+}
+
+bool
+EcnMarker::codelMark(mem_b queuesize, simtime_picosec sojourn, simtime_picosec now) {
+    // has the sojourn time been above target for at least an interval?
+    bool above = false;
+    if (sojourn < _target || queuesize <= _mtu) {
+	_first_above = 0;
+    } else if (_first_above == 0) {
+	_first_above = now + _interval;
+    } else if (now >= _first_above) {
+	above = true;
+    }
+
+    if (_marking) {
+	if (!above) {
+	    _marking = false;
+	    return false;
+	}
+	if (now < _mark_next)
+	    return false;
+	_count++;
+	_mark_next += (simtime_picosec)(_interval / sqrt((double)_count));
+	return true;
+    }
+    if (!above)
+	return false;
+
+    // start marking again, at the rate we left off if that was recent
+    _marking = true;
+    uint32_t delta = _count - _last_count;
+    if (delta > 1 && now < _mark_next + 16 * _interval)
+	_count = delta;
+    else
+	_count = 1;
+    _last_count = _count;
+    _mark_next = now + (simtime_picosec)(_interval / sqrt((double)_count));
+    return true;
+}
+
+void
+EcnMarker::pieUpdate(simtime_picosec now) {
+    if (_next_update == 0)
+	_next_update = now + _tupdate;
+    // the queue hasn't changed since the last update we made, so each
+    // update we missed saw the same delay
+    double target = timeAsSec(_target);
+    double qdelay = _bitrate ? (double)_queuesize * 8 / _bitrate : 0;
+    for (int i = 0; now >= _next_update; i++) {
+	if (i == PIE_MAX_CATCHUP) {
+	    if (qdelay == 0)
+		_p = 0;
+	    _next_update = now + _tupdate;
+	    break;
+	}
+	// small probabilities move in smaller steps (RFC 8033 5.2)
+	double a = _alpha, b = _beta;
+	if (_p < 0.000001) {
+	    a /= 2048; b /= 2048;
+	} else if (_p < 0.00001) {
+	    a /= 512; b /= 512;
+	} else if (_p < 0.0001) {
+	    a /= 128; b /= 128;
+	} else if (_p < 0.001) {
+	    a /= 32; b /= 32;
+	} else if (_p < 0.01) {
+	    a /= 8; b /= 8;
+	} else if (_p < 0.1) {
+	    a /= 2; b /= 2;
+	}
+	_p += a * (qdelay - target) + b * (qdelay - _qdelay_old);
+	if (_p < 0)
+	    _p = 0;
+	else if (_p > 1)
+	    _p = 1;
+	if (qdelay == 0 && _qdelay_old == 0)
+	    _p *= 0.98;
+	_qdelay_old = qdelay;
+	_next_update += _tupdate;
+    }
+}
@@ -0,0 +1,114 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef ECN_MARKER_H
+#define ECN_MARKER_H
+
+/*
+ * Decides which packets an ECN queue marks CE.
+ *
+ * MARK_STEP marks when occupancy exceeds a threshold, as DCTCP expects.
+ * MARK_RED marks with a probability rising linearly from 0 at min
+ * bytes to pmax at max, and marks everything above max.
+ * MARK_CODEL marks by sojourn time (RFC 8289, marking where CoDel would
+ * drop): once packets have been queued longer than target for a whole
+ * interval, it marks one, then more often, interval/sqrt(count) apart,
+ * until the sojourn time falls below target again.
+ * MARK_PIE marks with a probability that a PI controller (RFC 8033)
+ * moves every tupdate, by how far the queueing delay is from target
+ * and how fast it's growing; the delay is occupancy over the link
+ * rate.  alpha and beta are RFC 8033's gains for a 15ms target, and are
+ * scaled by 15ms/target so the controller reacts as quickly to the
+ * microsecond delays of a datacenter.
+ *
+ * STEP and RED see either the occupancy at the time or, given an EWMA
+ * weight, its average over the queue's enqueues and dequeues.
+ *
+ * A queue marks at one point, on enqueue or on dequeue.  On enqueue the
+ * occupancy is that the packet joins, and the sojourn time is that of
+ * the packet at the head; on dequeue they're the occupancy the packet
+ * leaves, itself included, and its own sojourn time.
+ *
+ * Everything is O(1) per packet.  PIE's periodic updates are made
+ * when the queue next changes, for the intervals that have passed.
+ */
+
+#include "config.h"
+#include "rng.h"
+
+class EcnMarker {
+ public:
+    typedef enum {MARK_STEP, MARK_RED, MARK_CODEL, MARK_PIE} policy_t;
+    typedef enum {MARK_ON_DEQUEUE, MARK_ON_ENQUEUE} mark_point_t;
+
+    // step marking at threshold on dequeue, by instantaneous occupancy
+    EcnMarker(mem_b threshold = 0);
+
+    void setStep(mem_b threshold);
+    void setRed(mem_b min, mem_b max, double pmax);
+    void setCodel(simtime_picosec target, simtime_picosec interval);
+    void setPie(simtime_picosec target, simtime_picosec tupdate,
+		double alpha = 0.125, double beta = 1.25);
+    void setMarkPoint(mark_point_t point) {_point = point;}
+    // 0 means instantaneous occupancy
+    void setEwma(double weight);
+    // the rate the queue drains at, for PIE's delay
+    void setRate(linkspeed_bps bitrate) {_bitrate = bitrate;}
+
+    // A driver's marking option at argv[i]:
+    //   -mark step <K pkts> | red <min pkts> <max pkts> <pmax>
+    //       | codel <target us> <interval us> | pie <target us> <tupdate us>
+    //   -markat enq|deq
+    //   -ewma <weight>
+    // Returns how many arguments after argv[i] it took, 0 if argv[i]
+    // isn't one of these, or -1 if they're malformed.
+    int parseOption(int argc, char** argv, int i);
+
+    policy_t policy() const {return _policy;}
+    mark_point_t markPoint() const {return _point;}
+
+    // the queue now holds queuesize bytes; call on every enqueue and dequeue
+    void sample(mem_b queuesize, simtime_picosec now);
+    // whether to mark a packet at the marking point
+    bool mark(mem_b queuesize, simtime_picosec sojourn, simtime_picosec now, Rng& rng);
+    uint64_t marks() const {return _marks;}
+
+ private:
+    bool codelMark(mem_b queuesize, simtime_picosec sojourn, simtime_picosec now);
+    void pieUpdate(simtime_picosec now);
+
+    policy_t _policy;
+    mark_point_t _point;
+    uint64_t _marks;
+
+    // occupancy
+    mem_b _queuesize;
+    double _ewma_weight;
+    double _avg;
+
+    // STEP and RED
+    mem_b _K;
+    mem_b _red_min;
+    mem_b _red_max;
+    double _red_pmax;
+
+    // CoDel
+    simtime_picosec _target;
+    simtime_picosec _interval;
+    simtime_picosec _first_above;
+    simtime_picosec _mark_next;
+    bool _marking;
+    uint32_t _count;
+    uint32_t _last_count;
+
+    // PIE (_target is shared)
+    linkspeed_bps _bitrate;
+    simtime_picosec _tupdate;
+    simtime_picosec _next_update;
+    double _alpha;
+    double _beta;
+    double _p;
+    double _qdelay_old; // seconds
+
+    mem_b _mtu; // CoDel doesn't mark a queue holding less than a packet
+};
+
+#endif
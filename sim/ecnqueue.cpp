@@ -8,11 +8,26 @@
 ECNQueue::ECNQueue(linkspeed_bps bitrate, mem_b maxsize, 
 			 EventList& eventlist, QueueLogger* logger, mem_b  K)
     : Queue(bitrate,maxsize,eventlist,logger), 
-      _K(K)
+      _marker(K)
 {
+    _marker.setRate(bitrate);
     _state_send = LosslessQueue::READY;
 }
 
+void
+ECNQueue::setMarker(const EcnMarker& marker)
+{
+    _marker = marker;
+    _marker.setRate(_bitrate);
+}
+
+void
+ECNQueue::markPacket(Packet& pkt)
+{
+    pkt.set_flags(pkt.flags() | ECN_CE);
+    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_MARK, pkt);
+}
+
 
 void
 ECNQueue::receivePacket(Packet & pkt)
@@ -47,25 +62,34 @@ ECNQueue::receivePacket(Packet & pkt)
     }
 
 
-    if (_queuesize+pkt.size() > _maxsize) {
+    if (!bufferFits(_queuesize, pkt.size())) {
 	/* if the packet doesn't fit in the queue, drop it */
 	if (_logger) 
 	    _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
-	pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_DROP);
+	pkt.logTraffic(*this, TrafficLogger::PKT_DROP);
 	pkt.free();
 	_num_drops++;
+	bufferDropped();
 	return;
     }
-    pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_ARRIVE);
+    pkt.logTraffic(*this, TrafficLogger::PKT_ARRIVE);
+
+    simtime_picosec now = eventlist().now();
 
     //mark on enqueue
-    //    if (_queuesize > _K)
-    //  pkt.set_flags(pkt.flags() | ECN_CE);
+    if (_marker.markPoint() == EcnMarker::MARK_ON_ENQUEUE) {
+	simtime_picosec sojourn = _enqueued.empty() ? 0 : now - _enqueue_times.back();
+	if (_marker.mark(_queuesize, sojourn, now, _rng))
+	    markPacket(pkt);
+    }
 
     /* enqueue the packet */
     bool queueWasEmpty = _enqueued.empty();
     _enqueued.push_front(&pkt);
+    _enqueue_times.push_front(now);
     _queuesize += pkt.size();
+    bufferTake(pkt.size());
+    _marker.sample(_queuesize, now);
     if (_logger) _logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
 
     if (queueWasEmpty && _state_send==LosslessQueue::READY) {
@@ -83,16 +107,22 @@ ECNQueue::completeService()
     assert(!_enqueued.empty());
     Packet* pkt = _enqueued.back();
     _enqueued.pop_back();
+    simtime_picosec now = eventlist().now();
+    simtime_picosec sojourn = now - _enqueue_times.back();
+    _enqueue_times.pop_back();
 
     if (_state_send==LosslessQueue::PAUSE_RECEIVED)
 	_state_send = LosslessQueue::PAUSED;
     
     //mark on deque
-    if (_queuesize > _K)
-	  pkt->set_flags(pkt->flags() | ECN_CE);
+    if (_marker.markPoint() == EcnMarker::MARK_ON_DEQUEUE
+	&& _marker.mark(_queuesize, sojourn, now, _rng))
+	markPacket(*pkt);
 
     _queuesize -= pkt->size();
-    pkt->flow().logTraffic(*pkt, *this, TrafficLogger::PKT_DEPART);
+    bufferGive(pkt->size());
+    _marker.sample(_queuesize, now);
+    pkt->logTraffic(*this, TrafficLogger::PKT_DEPART);
     if (_logger) _logger->logQueue(*this, QueueLogger::PKT_SERVICE, *pkt);
 
     /* tell the packet to move on to the next pipe */
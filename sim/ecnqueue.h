@@ -4,6 +4,9 @@
 #include "queue.h"
 /*
  * A simple ECN queue that marks on dequeue as soon as the packet occupancy exceeds the set threshold. 
+ *
+ * Other marking policies, and marking on enqueue, are set through its
+ * EcnMarker; see ecn_marker.h.
  */
 
 #include <list>
@@ -11,6 +14,7 @@
 #include "eventlist.h"
 #include "network.h"
 #include "loggertypes.h"
+#include "ecn_marker.h"
 
 class ECNQueue : public Queue {
  public:
@@ -18,8 +22,16 @@ class ECNQueue : public Queue {
 		QueueLogger* logger, mem_b drop);
     void receivePacket(Packet & pkt);
     void completeService();
+
+    // mark as marker does, from a fresh start
+    void setMarker(const EcnMarker& marker);
+    const EcnMarker& marker() const {return _marker;}
+    uint64_t num_marked() const {return _marker.marks();}
  private:
-    mem_b _K;
+    void markPacket(Packet& pkt);
+
+    EcnMarker _marker;
+    CircularBuffer<simtime_picosec> _enqueue_times; // as _enqueued
     int _state_send;
 };
 
@@ -13,15 +13,24 @@
 
 #define PAUSESIZE 64
 
+// A PFC frame (802.1Qbb) names the priority classes it applies to and
+// a pause time for them in quanta; 0 lets them send again.  The
+// original PAUSE is a frame naming all eight.
+
 class EthPausePacket : public Packet {
  public:
-    //do not implement PFC; one priority class alone
-
     inline static EthPausePacket* newpkt(unsigned int sleep){
 	EthPausePacket* p = _packetdb.allocPacket();
 	p->_type = ETH_PAUSE;
 	p->_sleepTime = sleep;
 	p->_size = PAUSESIZE;
+	p->_classes = 0xff;
+	return p;
+    }
+    // pause, or resume, just class cls
+    inline static EthPausePacket* newpkt(int cls, unsigned int quanta){
+	EthPausePacket* p = newpkt(quanta);
+	p->_classes = 1 << cls;
 	return p;
     }
   
@@ -29,9 +38,11 @@ class EthPausePacket : public Packet {
     virtual ~EthPausePacket(){}
 
     inline unsigned int sleepTime() const {return _sleepTime;}
+    inline bool names(int cls) const {return _classes & (1 << cls);}
 
  protected:
-    unsigned int _sleepTime;
+    unsigned int _sleepTime; // in quanta, for every class named
+    uint8_t _classes;
     static PacketDB<EthPausePacket> _packetdb;
 };
 
@@ -1,12 +1,53 @@
 // -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-        
 
 #include "eventlist.h"
+#include "eventprofile.h"
 //#include <iostream>
 
-EventList::EventList()
+#define EVENT_BLOCK_SIZE 1024
+
+EventList::EventList(scheduler_type scheduler)
     : _endtime(0),
-      _lasteventtime(0)
+      _lasteventtime(0),
+      _scheduler(scheduler),
+      _profile(NULL),
+      _freelist(NULL)
 {
+#ifdef EVENT_PROFILE
+    _profile = EventProfile::create();
+#endif
+}
+
+EventList::~EventList()
+{
+    for (size_t i = 0; i < _blocks.size(); i++)
+	delete[] _blocks[i];
+    map<simtime_picosec, EventSource*>::iterator i;
+    for (i = _delay_lines.begin(); i != _delay_lines.end(); i++)
+	delete i->second;
+}
+
+PendingEvent*
+EventList::alloc_event()
+{
+    if (!_freelist) {
+	PendingEvent* block = new PendingEvent[EVENT_BLOCK_SIZE];
+	_blocks.push_back(block);
+	for (int i = 0; i < EVENT_BLOCK_SIZE; i++) {
+	    block[i].next = _freelist;
+	    _freelist = &block[i];
+	}
+    }
+    PendingEvent* ev = _freelist;
+    _freelist = ev->next;
+    return ev;
+}
+
+void
+EventList::free_event(PendingEvent* ev)
+{
+    ev->next = _freelist;
+    _freelist = ev;
 }
 
 void
@@ -18,45 +59,112 @@ EventList::setEndtime(simtime_picosec endtime)
 bool
 EventList::doNextEvent() 
 {
-    if (_pendingsources.empty())
-	return false;
-    simtime_picosec nexteventtime = _pendingsources.begin()->first;
-    EventSource* nextsource = _pendingsources.begin()->second;
-    _pendingsources.erase(_pendingsources.begin());
+    PendingEvent* ev;
+    if (_scheduler == CALENDAR) {
+	if (_calendar.empty())
+	    return false;
+	ev = _calendar.pop();
+    } else {
+	if (_pendingsources.empty())
+	    return false;
+	ev = _pendingsources.begin()->second;
+	_pendingsources.erase(_pendingsources.begin());
+    }
+    simtime_picosec nexteventtime = ev->when;
+    EventSource* nextsource = ev->src;
+    // events are dispatched in the same order they're kept on each
+    // source, so this one is always at the head of the source's list
+    assert(nextsource->_pending == ev);
+    nextsource->_pending = ev->src_next;
+    free_event(ev);
+
     assert(nexteventtime >= _lasteventtime);
     _lasteventtime = nexteventtime; // set this before calling doNextEvent, so that this::now() is accurate
+#ifdef EVENT_PROFILE
+    size_t profiled = _profile->source(*nextsource);
+    uint64_t start_ns = EventProfile::now_ns();
     nextsource->doNextEvent();
+    _profile->record(profiled, start_ns, *this);
+#else
+    nextsource->doNextEvent();
+#endif
     return true;
 }
 
+bool
+EventList::empty() const
+{
+    if (_scheduler == CALENDAR)
+	return _calendar.empty();
+    return _pendingsources.empty();
+}
+
+size_t
+EventList::pending() const
+{
+    if (_scheduler == CALENDAR)
+	return _calendar.size();
+    return _pendingsources.size();
+}
+
+simtime_picosec
+EventList::nextEventTime()
+{
+    if (_scheduler == CALENDAR)
+	return _calendar.top()->when;
+    return _pendingsources.begin()->first;
+}
+
+void
+EventList::runUntil(simtime_picosec until)
+{
+    while (!empty() && nextEventTime() < until)
+	doNextEvent();
+}
 
 void 
 EventList::sourceIsPending(EventSource &src, simtime_picosec when) 
 {
-    /*
-    pendingsources_t::iterator i = _pendingsources.begin();
-    while (i != _pendingsources.end()) {
-	if (i->second == &src)
-	    abort();
-	i++;
-    }
-    */
-    
     assert(when>=now());
-    if (_endtime==0 || when<_endtime)
-	_pendingsources.insert(make_pair(when,&src));
+    if (_endtime!=0 && when>=_endtime)
+	return;
+
+    PendingEvent* ev = alloc_event();
+    ev->when = when;
+    ev->src = &src;
+
+    // keep the source's own list in dispatch order.  A source rarely
+    // has more than one or two events pending.
+    PendingEvent** pp = &src._pending;
+    while (*pp && (*pp)->when <= when)
+	pp = &(*pp)->src_next;
+    ev->src_next = *pp;
+    *pp = ev;
+
+    if (_scheduler == CALENDAR)
+	_calendar.insert(ev);
+    else
+	_pendingsources.insert(make_pair(when,ev));
 }
 
 void 
 EventList::cancelPendingSource(EventSource &src) {
-    pendingsources_t::iterator i = _pendingsources.begin();
-    while (i != _pendingsources.end()) {
-	if (i->second == &src) {
-	    _pendingsources.erase(i);
-	    return;
+    PendingEvent* ev = src._pending;
+    if (!ev)
+	return;
+    src._pending = ev->src_next;
+
+    if (_scheduler == CALENDAR) {
+	_calendar.remove(ev);
+    } else {
+	pendingsources_t::iterator i = _pendingsources.lower_bound(ev->when);
+	while (i->second != ev) {
+	    i++;
+	    assert(i != _pendingsources.end() && i->first == ev->when);
 	}
-	i++;
+	_pendingsources.erase(i);
     }
+    free_event(ev);
 }
 
 void 
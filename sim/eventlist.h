@@ -5,35 +5,78 @@
 #include <sys/time.h>
 #include "config.h"
 #include "loggertypes.h"
+#include "calendarqueue.h"
 
 class EventList;
+class EventProfile;
 
 class EventSource : public Logged {
+	friend class EventList;
 	public:
-		EventSource(EventList& eventlist, const string& name) : Logged(name), _eventlist(eventlist) {};
+		EventSource(EventList& eventlist, const string& name) : Logged(name), _eventlist(eventlist), _pending(NULL) {};
+		// name is a literal, as for Logged
+		EventSource(EventList& eventlist, const char* name) : Logged(name), _eventlist(eventlist), _pending(NULL) {};
 		virtual ~EventSource() {};
 		virtual void doNextEvent() = 0;
 		inline EventList& eventlist() const {return _eventlist;}
+		inline bool isPending() const {return _pending != NULL;}
 	protected:
 		EventList& _eventlist;
+	private:
+		// this source's pending events, earliest first, so that
+		// cancelling doesn't need to search the whole event list
+		PendingEvent* _pending;
 	};
 
 class EventList {
 public:
-    EventList();
+    // How the pending event set is stored.  MULTIMAP is the original
+    // red-black tree; CALENDAR is an O(1) amortized calendar queue.
+    // Both dispatch events in (time, insertion order), so the choice
+    // never changes simulation results.
+    typedef enum {MULTIMAP, CALENDAR} scheduler_type;
+
+    EventList(scheduler_type scheduler = CALENDAR);
+    ~EventList();
     void setEndtime(simtime_picosec endtime); // end simulation at endtime (rather than forever)
     bool doNextEvent(); // returns true if it did anything, false if there's nothing to do
+    // run every pending event due before 'until'.  Used by the
+    // parallel engine to advance one partition by one window.
+    void runUntil(simtime_picosec until);
+    bool empty() const;
+    size_t pending() const; // how many events are pending
+    simtime_picosec nextEventTime(); // the list must not be empty
     void sourceIsPending(EventSource &src, simtime_picosec when);
     void sourceIsPendingRel(EventSource &src, simtime_picosec timefromnow)
 			{ sourceIsPending(src, now()+timefromnow); }
+    // cancel the earliest pending event for src.  O(1) with the
+    // calendar queue, O(log n) with the multimap.
     void cancelPendingSource(EventSource &src);
     void reschedulePendingSource(EventSource &src, simtime_picosec when);
     inline simtime_picosec now() const {return _lasteventtime;}
+    inline simtime_picosec endtime() const {return _endtime;}
+    inline scheduler_type scheduler() const {return _scheduler;}
+    // the shared delay line for pipes of this delay (see pipe.h), or
+    // NULL if there isn't one yet.  Lines belong to their eventlist
+    // and are deleted with it.
+    EventSource*& delayLine(simtime_picosec delay) {return _delay_lines[delay];}
 private:
     simtime_picosec _endtime;
     simtime_picosec _lasteventtime;
-    typedef multimap <simtime_picosec, EventSource*> pendingsources_t;
+    typedef multimap <simtime_picosec, PendingEvent*> pendingsources_t;
     pendingsources_t _pendingsources;
+    CalendarQueue _calendar;
+    scheduler_type _scheduler;
+    EventProfile* _profile; // NULL unless built with EVENT_PROFILE
+
+    // PendingEvents are carved out of large blocks and recycled
+    // through a free list, so scheduling an event never calls malloc
+    PendingEvent* alloc_event();
+    void free_event(PendingEvent* ev);
+    PendingEvent* _freelist;
+    vector<PendingEvent*> _blocks;
+
+    map<simtime_picosec, EventSource*> _delay_lines;
 };
 
 #endif
@@ -0,0 +1,237 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "eventprofile.h"
+#include "eventlist.h"
+#include <mutex>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <cxxabi.h>
+
+#define PROFILE_TOP_SOURCES 20
+
+// Made on first use and never freed, so it's still there when the
+// report runs at exit whatever order static objects go away in.
+static struct profile_registry {
+    std::mutex lock;
+    vector<EventProfile*> profiles;
+    string output;
+} *registry = NULL;
+static std::once_flag registry_once;
+
+static profile_registry&
+get_registry()
+{
+    std::call_once(registry_once, [] {
+	    registry = new profile_registry();
+	    registry->output = "eventprofile.json";
+	});
+    return *registry;
+}
+
+EventProfile::EventProfile()
+    : _start_ns(0), _last_ns(0), _events(0)
+{
+}
+
+EventProfile*
+EventProfile::create()
+{
+    profile_registry& r = get_registry();
+    EventProfile* profile = new EventProfile();
+    std::lock_guard<std::mutex> guard(r.lock);
+    if (r.profiles.empty())
+	atexit(report);
+    r.profiles.push_back(profile);
+    return profile;
+}
+
+void
+EventProfile::setOutput(const string& filename)
+{
+    profile_registry& r = get_registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.output = filename;
+}
+
+size_t
+EventProfile::source(EventSource& src)
+{
+    const std::type_info* type = &typeid(src);
+    unordered_map<EventSource*, size_t>::iterator i = _index.find(&src);
+    if (i != _index.end() && _sources[i->second].type == type)
+	return i->second;
+
+    source_t s;
+    s.type = type;
+    s.name = src.str();
+    s.events = 0;
+    s.ns = 0;
+    _sources.push_back(s);
+    _index[&src] = _sources.size() - 1;
+    return _sources.size() - 1;
+}
+
+void
+EventProfile::record(size_t source, uint64_t start_ns, const EventList& eventlist)
+{
+    _last_ns = now_ns();
+    if (_events == 0)
+	_start_ns = start_ns;
+    source_t& s = _sources[source];
+    s.events++;
+    s.ns += _last_ns - start_ns;
+    if (++_events % PROFILE_SAMPLE_EVENTS == 0) {
+	sample_t sample = {eventlist.now(), _last_ns - _start_ns, _events, eventlist.pending()};
+	_samples.push_back(sample);
+    }
+}
+
+static string
+demangle(const std::type_info* type)
+{
+    int status;
+    char* name = abi::__cxa_demangle(type->name(), NULL, NULL, &status);
+    if (status != 0)
+	return type->name();
+    string s(name);
+    free(name);
+    return s;
+}
+
+static string
+json_string(const string& s)
+{
+    string out = "\"";
+    for (size_t i = 0; i < s.size(); i++) {
+	char c = s[i];
+	if (c == '"' || c == '\\') {
+	    out += '\\';
+	    out += c;
+	} else if ((unsigned char)c < 0x20) {
+	    char buf[8];
+	    snprintf(buf, sizeof(buf), "\\u%04x", c);
+	    out += buf;
+	} else {
+	    out += c;
+	}
+    }
+    return out + "\"";
+}
+
+struct profile_row {
+    string type;
+    string name;
+    uint64_t events;
+    uint64_t ns;
+};
+
+static bool
+more_expensive(const profile_row& a, const profile_row& b)
+{
+    if (a.ns != b.ns)
+	return a.ns > b.ns;
+    return a.events > b.events;
+}
+
+static void
+print_rows(const vector<profile_row>& rows, size_t count, bool names,
+	   uint64_t events, uint64_t ns)
+{
+    cerr << left << setw(names ? 40 : 28) << (names ? "source" : "type")
+	 << right << setw(14) << "events" << setw(8) << "%ev"
+	 << setw(14) << "ms" << setw(8) << "%time" << setw(12) << "ns/event" << endl;
+    for (size_t i = 0; i < rows.size() && i < count; i++) {
+	const profile_row& r = rows[i];
+	string label = names ? r.name + " (" + r.type + ")" : r.type;
+	cerr << left << setw(names ? 40 : 28) << label << right
+	     << setw(14) << r.events
+	     << setw(8) << fixed << setprecision(1) << (events ? 100.0 * r.events / events : 0)
+	     << setw(14) << setprecision(3) << r.ns / 1e6
+	     << setw(8) << setprecision(1) << (ns ? 100.0 * r.ns / ns : 0)
+	     << setw(12) << setprecision(1) << (r.events ? (double)r.ns / r.events : 0)
+	     << endl;
+    }
+}
+
+void
+EventProfile::report()
+{
+    profile_registry& r = get_registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+
+    // totals by type and by source, across every eventlist
+    map<const std::type_info*, profile_row> by_type;
+    vector<profile_row> by_source;
+    uint64_t events = 0, ns = 0, first_ns = 0, last_ns = 0;
+    for (size_t p = 0; p < r.profiles.size(); p++) {
+	EventProfile* profile = r.profiles[p];
+	if (profile->_events == 0)
+	    continue;
+	if (first_ns == 0 || profile->_start_ns < first_ns)
+	    first_ns = profile->_start_ns;
+	last_ns = max(last_ns, profile->_last_ns);
+	for (size_t i = 0; i < profile->_sources.size(); i++) {
+	    const source_t& s = profile->_sources[i];
+	    profile_row& t = by_type[s.type];
+	    if (t.type.empty())
+		t.type = demangle(s.type);
+	    t.events += s.events;
+	    t.ns += s.ns;
+	    profile_row row = {t.type, s.name, s.events, s.ns};
+	    by_source.push_back(row);
+	    events += s.events;
+	    ns += s.ns;
+	}
+    }
+    vector<profile_row> types;
+    for (map<const std::type_info*, profile_row>::iterator i = by_type.begin(); i != by_type.end(); i++)
+	types.push_back(i->second);
+    sort(types.begin(), types.end(), more_expensive);
+    sort(by_source.begin(), by_source.end(), more_expensive);
+
+    uint64_t wall_ns = last_ns - first_ns;
+    double rate = wall_ns ? events / (wall_ns / 1e9) : 0;
+    cerr << "Event profile: " << events << " events in " << fixed << setprecision(3)
+	 << wall_ns / 1e9 << "s (" << setprecision(0) << rate << " events/s), "
+	 << setprecision(3) << ns / 1e9 << "s in handlers" << endl;
+    print_rows(types, types.size(), false, events, ns);
+    cerr << endl;
+    print_rows(by_source, PROFILE_TOP_SOURCES, true, events, ns);
+
+    ofstream out(r.output.c_str());
+    if (!out) {
+	cerr << "Can't write event profile to " << r.output << endl;
+	return;
+    }
+    out << "{\n  \"events\": " << events << ",\n  \"wall_ns\": " << wall_ns
+	<< ",\n  \"handler_ns\": " << ns << ",\n  \"events_per_sec\": " << setprecision(0) << rate
+	<< ",\n  \"types\": [";
+    for (size_t i = 0; i < types.size(); i++)
+	out << (i ? "," : "") << "\n    {\"type\": " << json_string(types[i].type)
+	    << ", \"events\": " << types[i].events << ", \"ns\": " << types[i].ns << "}";
+    out << "\n  ],\n  \"sources\": [";
+    for (size_t i = 0; i < by_source.size(); i++)
+	out << (i ? "," : "") << "\n    {\"name\": " << json_string(by_source[i].name)
+	    << ", \"type\": " << json_string(by_source[i].type)
+	    << ", \"events\": " << by_source[i].events << ", \"ns\": " << by_source[i].ns << "}";
+    // one series per eventlist: [simulated ps, wall ns, events, pending]
+    out << "\n  ],\n  \"eventlists\": [";
+    bool first = true;
+    for (size_t p = 0; p < r.profiles.size(); p++) {
+	EventProfile* profile = r.profiles[p];
+	if (profile->_events == 0)
+	    continue;
+	out << (first ? "" : ",") << "\n    {\"events\": " << profile->_events
+	    << ", \"wall_ns\": " << profile->_last_ns - profile->_start_ns << ", \"samples\": [";
+	first = false;
+	for (size_t i = 0; i < profile->_samples.size(); i++) {
+	    const sample_t& s = profile->_samples[i];
+	    out << (i ? ", " : "") << "[" << s.when << ", " << s.wall_ns << ", "
+		<< s.events << ", " << s.pending << "]";
+	}
+	out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,76 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef EVENTPROFILE_H
+#define EVENTPROFILE_H
+
+/*
+ * Where the event loop's time goes.  Built with -DEVENT_PROFILE (make
+ * PROFILE=1), every EventList counts the events it dispatches and the
+ * wall-clock time each takes, per EventSource, and every
+ * PROFILE_SAMPLE_EVENTS events notes the simulated time and the size
+ * of its pending set.  At exit the totals across all eventlists are
+ * printed to stderr by dynamic source type, most expensive first,
+ * along with the most expensive sources, and everything is written as
+ * JSON to the file named by EventProfile::setOutput
+ * (eventprofile.json unless told otherwise).
+ *
+ * Without EVENT_PROFILE none of this is compiled in.  Each eventlist
+ * has its own profile and is only ever run by one thread at a time,
+ * so the parallel engine's partitions need no locking.
+ */
+
+#include <vector>
+#include <unordered_map>
+#include <typeinfo>
+#include <time.h>
+#include "config.h"
+
+#define PROFILE_SAMPLE_EVENTS 65536
+
+class EventList;
+class EventSource;
+
+class EventProfile {
+ public:
+    // profiles live until the program exits, when they're reported
+    static EventProfile* create();
+    static void setOutput(const string& filename);
+
+    static inline uint64_t now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    // call before dispatching src's event, as the event may free src
+    size_t source(EventSource& src);
+    // call after, with source()'s result and the time it started
+    void record(size_t source, uint64_t start_ns, const EventList& eventlist);
+
+    struct source_t {
+	const std::type_info* type;
+	string name;
+	uint64_t events;
+	uint64_t ns;
+    };
+    struct sample_t {
+	simtime_picosec when;
+	uint64_t wall_ns;  // since this eventlist's first event
+	uint64_t events;
+	size_t pending;
+    };
+
+ private:
+    EventProfile();
+    static void report();
+
+    uint64_t _start_ns;
+    uint64_t _last_ns;
+    uint64_t _events;
+    // keyed by address, so a source that's freed and replaced by one
+    // of another type at the same address is told apart by its type
+    unordered_map<EventSource*, size_t> _index;
+    vector<source_t> _sources;
+    vector<sample_t> _samples;
+};
+
+#endif
@@ -67,22 +67,35 @@ FifoPullQueue<PullPkt>::flush_flow(int32_t flow_id) {
 }
 
 template<class PullPkt>
-FairPullQueue<PullPkt>::FairPullQueue() {
-    _current_queue = _queue_map.begin();
-}
+const int32_t FairPullQueue<PullPkt>::NO_FLOW;
+template<class PullPkt>
+const uint32_t FairPullQueue<PullPkt>::NO_QUEUE;
 
+template<class PullPkt>
+FairPullQueue<PullPkt>::FairPullQueue()
+    : _index(16, pair<int32_t, uint32_t>(NO_FLOW, NO_QUEUE)), _indexed(0)
+{
+}
 
 template<class PullPkt>
 void
 FairPullQueue<PullPkt>::enqueue(PullPkt& pkt) {
-    list <PullPkt*>* pull_queue;
-    if (queue_exists(pkt)) {
-	pull_queue = find_queue(pkt);
-    }  else {
-	pull_queue = create_queue(pkt);
+    uint32_t q = find_queue(pkt.flow_id());
+    if (q == NO_QUEUE)
+	q = create_queue(pkt.flow_id());
+    flow_queue& fq = _queues[q];
+    pkt.set_next_pull(NULL);
+    if (fq.head) {
+	fq.tail->set_next_pull(&pkt);
+    } else {
+	fq.head = &pkt;
+	if (!fq.in_ring) {
+	    fq.in_ring = true;
+	    fq.deficit = fq.weight;
+	    _ring.push_back(q);
+	}
     }
-    //we add packets to the front,remove them from the back
-    pull_queue->push_front(&pkt);
+    fq.tail = &pkt;
     this->_pull_count++;
 }
 
@@ -92,67 +105,132 @@ FairPullQueue<PullPkt>::dequeue() {
     if (this->_pull_count == 0)
 	return 0;
     while (1) {
-	if (_current_queue == _queue_map.end())
-	    _current_queue = _queue_map.begin();
-	list <PullPkt*>* pull_queue = _current_queue->second;
-	_current_queue++;
-	if (!pull_queue->empty()) {
-	    //we add packets to the front,remove them from the back
-	    PullPkt* packet = pull_queue->back();
-	    pull_queue->pop_back();
-	    this->_pull_count--;
-	    return packet;
+	// there are pulls queued, so some queue in the ring has them
+	uint32_t q = _ring.front();
+	flow_queue& fq = _queues[q];
+	if (!fq.head) {
+	    // flushed since it joined the ring
+	    fq.in_ring = false;
+	    _ring.pop_front();
+	    continue;
+	}
+	PullPkt* packet = fq.head;
+	fq.head = (PullPkt*)packet->next_pull();
+	this->_pull_count--;
+	if (!fq.head) {
+	    fq.in_ring = false;
+	    _ring.pop_front();
+	} else if (--fq.deficit == 0) {
+	    fq.deficit = fq.weight;
+	    _ring.pop_front();
+	    _ring.push_back(q);
 	}
-	// there are packets queued, so we'll eventually find a queue
-	// that lets this terminate
+	return packet;
     }
 }
 
 template<class PullPkt>
 void
 FairPullQueue<PullPkt>::flush_flow(int32_t flow_id) {
-    typename map <int32_t, list<PullPkt*>*>::iterator i;
-    i = _queue_map.find(flow_id);
-    if (i == _queue_map.end())
+    uint32_t q = find_queue(flow_id);
+    if (q == NO_QUEUE)
 	return;
-    list<PullPkt*>* pull_queue = i->second;
-    while (!pull_queue->empty()) {
-	    PullPkt* packet = pull_queue->back();
-	    pull_queue->pop_back();
-	    packet->free();
-	    this->_pull_count--;
+    flow_queue& fq = _queues[q];
+    while (fq.head) {
+	PullPkt* packet = fq.head;
+	fq.head = (PullPkt*)packet->next_pull();
+	packet->free();
+	this->_pull_count--;
     }
-    if (_current_queue == i)
-	_current_queue++;
-    _queue_map.erase(i);
+    remove_queue(q);
 }
 
 template<class PullPkt>
-bool 
-FairPullQueue<PullPkt>::queue_exists(const PullPkt& pkt) {
-    typename map <int32_t, list<PullPkt*>*>::iterator i;
-    i = _queue_map.find(pkt.flow_id());
-    if (i == _queue_map.end())
-	return false;
-    return true;
+void
+FairPullQueue<PullPkt>::set_flow_weight(int32_t flow_id, uint32_t weight) {
+    assert(weight > 0);
+    uint32_t q = find_queue(flow_id);
+    if (q == NO_QUEUE)
+	q = create_queue(flow_id);
+    _queues[q].weight = weight;
 }
 
 template<class PullPkt>
-list<PullPkt*>* 
-FairPullQueue<PullPkt>::find_queue(const PullPkt& pkt) {
-    typename map <int32_t, list<PullPkt*>*>::iterator i;
-    i = _queue_map.find(pkt.flow_id());
-    if (i == _queue_map.end())
-	return 0;
-    return i->second;
+uint32_t
+FairPullQueue<PullPkt>::find_queue(int32_t flow_id) {
+    size_t mask = _index.size() - 1;
+    for (size_t i = home(flow_id); ; i = (i + 1) & mask) {
+	if (_index[i].first == flow_id)
+	    return _index[i].second;
+	if (_index[i].first == NO_FLOW)
+	    return NO_QUEUE;
+    }
 }
 
 template<class PullPkt>
-list<PullPkt*>* 
-FairPullQueue<PullPkt>::create_queue(const PullPkt& pkt) {
-    list<PullPkt*>* new_queue = new(list<PullPkt*>);
-    _queue_map.insert(pair<int32_t, list<PullPkt*>*>(pkt.flow_id(), new_queue));
-    return new_queue;
+uint32_t
+FairPullQueue<PullPkt>::create_queue(int32_t flow_id) {
+    assert(flow_id != NO_FLOW);
+    uint32_t q;
+    if (_free_queues.empty()) {
+	q = _queues.size();
+	_queues.push_back(flow_queue());
+	_queues[q].in_ring = false;
+    } else {
+	q = _free_queues.back();
+	_free_queues.pop_back();
+	// may still be in the ring, if it was flushed
+    }
+    flow_queue& fq = _queues[q];
+    fq.flow_id = flow_id;
+    fq.head = fq.tail = NULL;
+    fq.weight = fq.deficit = 1;
+
+    if (2 * (_indexed + 1) > _index.size()) {
+	vector<pair<int32_t, uint32_t> > old(2 * _index.size(), pair<int32_t, uint32_t>(NO_FLOW, NO_QUEUE));
+	old.swap(_index);
+	size_t mask = _index.size() - 1;
+	for (size_t j = 0; j < old.size(); j++) {
+	    if (old[j].first == NO_FLOW)
+		continue;
+	    size_t i = home(old[j].first);
+	    while (_index[i].first != NO_FLOW)
+		i = (i + 1) & mask;
+	    _index[i] = old[j];
+	}
+    }
+    size_t mask = _index.size() - 1;
+    size_t i = home(flow_id);
+    while (_index[i].first != NO_FLOW)
+	i = (i + 1) & mask;
+    _index[i] = pair<int32_t, uint32_t>(flow_id, q);
+    _indexed++;
+    return q;
+}
+
+template<class PullPkt>
+void
+FairPullQueue<PullPkt>::remove_queue(uint32_t q) {
+    size_t mask = _index.size() - 1;
+    size_t i = home(_queues[q].flow_id);
+    while (_index[i].first != _queues[q].flow_id)
+	i = (i + 1) & mask;
+    // close the gap, moving back any entry that probed past it
+    size_t j = i;
+    while (1) {
+	j = (j + 1) & mask;
+	if (_index[j].first == NO_FLOW)
+	    break;
+	size_t k = home(_index[j].first);
+	if (((j - k) & mask) >= ((j - i) & mask)) {
+	    _index[i] = _index[j];
+	    i = j;
+	}
+    }
+    _index[i] = pair<int32_t, uint32_t>(NO_FLOW, NO_QUEUE);
+    _indexed--;
+    _queues[q].flow_id = NO_FLOW;
+    _free_queues.push_back(q);
 }
 
 template class FifoPullQueue<NdpPull>;
@@ -3,13 +3,22 @@
 #define FAIRQUEUE_H
 
 /*
- * A fair queue for pull packets
+ * Queues for pull packets.  FifoPullQueue serves pulls in the order
+ * they arrive.  FairPullQueue serves the flows with pulls waiting in
+ * turn, deficit round robin style: a flow of weight w sends up to w
+ * pulls on each turn (weights default to 1).  Each flow's pulls are
+ * linked through the pulls themselves (next_pull()), the flows
+ * waiting are kept in a ring in the order they'll be served, and
+ * flows are found by id in a small open-addressed table, so
+ * enqueue, dequeue and flush_flow are all O(1).
  */
 
 #include <list>
+#include <vector>
 #include "config.h"
 #include "eventlist.h"
 #include "network.h"
+#include "circular_buffer.h"
 //#include "ndplitepacket.h"
 
 
@@ -24,6 +33,9 @@ class BasePullQueue {
     virtual void set_preferred_flow(int32_t preferred_flow) {
 	_preferred_flow = preferred_flow;
     }
+    // how many pulls the flow sends per turn, for queues that share
+    // out turns
+    virtual void set_flow_weight(int32_t flow_id, uint32_t weight) {}
     inline int32_t pull_count() const {return _pull_count;}
     inline bool empty() const {return _pull_count == 0;}
  protected:
@@ -49,12 +61,35 @@ class FairPullQueue : public BasePullQueue<PullPkt>{
     virtual void enqueue(PullPkt& pkt);
     virtual PullPkt* dequeue();
     virtual void flush_flow(int32_t flow_id);
+    virtual void set_flow_weight(int32_t flow_id, uint32_t weight);
  protected:
-    map<int32_t, list<PullPkt*>*> _queue_map;  // map flow id to pull queue
-    bool queue_exists(const PullPkt& pkt);
-    list<PullPkt*>* find_queue(const PullPkt& pkt);
-    list<PullPkt*>* create_queue(const PullPkt& pkt);
-    typename map<int32_t, list<PullPkt*>*>::iterator _current_queue;
+    struct flow_queue {
+	int32_t flow_id; // NO_FLOW if the entry is free
+	PullPkt* head;   // oldest first
+	PullPkt* tail;
+	uint32_t weight;
+	uint32_t deficit; // pulls it may still send on this turn
+	bool in_ring;
+    };
+    static const int32_t NO_FLOW = -1;
+    static const uint32_t NO_QUEUE = ~(uint32_t)0;
+
+    uint32_t find_queue(int32_t flow_id);  // NO_QUEUE if there's none
+    uint32_t create_queue(int32_t flow_id);
+    void remove_queue(uint32_t queue);
+    size_t home(int32_t flow_id) const {
+	return ((uint32_t)flow_id * 2654435761u) & (_index.size() - 1);
+    }
+
+    vector<flow_queue> _queues;
+    vector<uint32_t> _free_queues;
+    // queues with pulls waiting, in the order they'll be served.  A
+    // flushed queue stays here until its turn comes round.
+    CircularBuffer<uint32_t> _ring;
+    // flow id to queue, open addressed with linear probing; a power
+    // of two of them, never more than half full
+    vector<pair<int32_t, uint32_t> > _index;
+    uint32_t _indexed;
 };
 
 #endif
@@ -1,6 +1,7 @@
 // -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-        
 #define _CRT_SECURE_NO_DEPRECATE  // For Visual Studio: this allows the unsafe operation fopen() without issuing a warning
 #include "logfile.h"
+#include "simcontext.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
@@ -33,6 +34,33 @@ Logfile::Logfile(const string& filename, EventList& eventlist)
     }
 }
 
+void
+Logfile::reopen(const string& filename) {
+    string oldname = _logfilename;
+    if (_logfile != NULL)
+	fclose(_logfile);
+    _logfilename = filename;
+    _logfile = fopen(_logfilename.c_str(), "wbS");
+    if (_logfile==NULL) {
+	cerr << "Failed to open logfile " << _logfilename << endl;
+	exit(1);
+    }
+    if (_numRecords == 0)
+	return;
+
+    // copy the records so far; the preamble is still in memory
+    FILE* old = fopen(oldname.c_str(), "rbS");
+    if (old==NULL) {
+	cerr << "Failed to open logfile " << oldname << endl;
+	exit(1);
+    }
+    char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), old)) > 0)
+	fwrite(buf, 1, n, _logfile);
+    fclose(old);
+}
+
 Logfile::~Logfile() {
     if (_logfile != NULL) {
 	fclose(_logfile);
@@ -49,14 +77,28 @@ Logfile::addLogger(Logger& logger) {
 
 void 
 Logfile::write(const string& msg) {
+    flushNames();
     _preamble << msg << endl;
 }
 
 void
 Logfile::writeName(Logged& logged) {
+    if (logged.nameKey().format) {
+	pending_name n = {logged.nameKey(), logged.id};
+	_names.push_back(n);
+	return;
+    }
+    flushNames();
     _preamble << ": " << logged.str() << "=" << logged.id << endl;
 }
 
+void
+Logfile::flushNames() {
+    for (size_t i = 0; i < _names.size(); i++)
+	_preamble << ": " << _names[i].key.str() << "=" << _names[i].id << "\n";
+    _names.clear();
+}
+
 void
 Logfile::setStartTime(simtime_picosec starttime) {
     _starttime=starttime;
@@ -65,7 +107,17 @@ Logfile::setStartTime(simtime_picosec starttime) {
 void
 Logfile::writeRecord(uint32_t type, uint32_t id, uint32_t ev, 
 		     double val1, double val2, double val3) {
-    uint64_t time = _eventlist.now();
+    LogBuffer* buffer = SimContext::current().log_buffer();
+    if (buffer) {
+	buffer->add(*this, type, id, ev, val1, val2, val3);
+	return;
+    }
+    writeRecordAt(_eventlist.now(), type, id, ev, val1, val2, val3);
+}
+
+void
+Logfile::writeRecordAt(simtime_picosec time, uint32_t type, uint32_t id, uint32_t ev,
+		       double val1, double val2, double val3) {
     if (time<_starttime) return;
     double time_sec = timeAsSec(time);
     fwrite(&time_sec, sizeof(double), 1, _logfile);
@@ -78,6 +130,35 @@ Logfile::writeRecord(uint32_t type, uint32_t id, uint32_t ev,
     _numRecords++;
 }
 
+void
+LogBuffer::add(Logfile& logfile, uint32_t type, uint32_t id, uint32_t ev,
+	       double val1, double val2, double val3) {
+    record r = {&logfile, _eventlist.now(), type, id, ev, val1, val2, val3};
+    _records.push_back(r);
+}
+
+void
+LogBuffer::flush(vector<LogBuffer*>& buffers) {
+    // each buffer is already in time order, so merge them
+    while (true) {
+	LogBuffer* first = NULL;
+	for (size_t i = 0; i < buffers.size(); i++) {
+	    LogBuffer* b = buffers[i];
+	    if (b->_head < b->_records.size()
+		&& (!first || b->_records[b->_head].time < first->_records[first->_head].time))
+		first = b;
+	}
+	if (!first)
+	    break;
+	record& r = first->_records[first->_head++];
+	r.logfile->writeRecordAt(r.time, r.type, r.id, r.ev, r.val1, r.val2, r.val3);
+    }
+    for (size_t i = 0; i < buffers.size(); i++) {
+	buffers[i]->_records.clear();
+	buffers[i]->_head = 0;
+    }
+}
+
 void
 Logfile::transposeLog() {
     double* timeRec = new double[_numRecords];
@@ -115,6 +196,7 @@ Logfile::transposeLog() {
     }
     fclose(logfile);
     assert(numread==_numRecords);
+    flushNames();
     _preamble << "# numrecords=" << numread << endl;
     logfile = fopen(_logfilename.c_str(),"wbS");
     if (logfile==0) {
@@ -34,10 +34,40 @@ class RawLogEvent {
     double _val3;
 };
 
+// Records written by one partition of a parallel run (see pdes.h).
+// Partitions run side by side, so rather than write to the logfile
+// they leave their records here, stamped with the partition's own
+// time, and the engine writes them all out in time order whenever
+// the partitions stop.
+class LogBuffer {
+ public:
+    LogBuffer(EventList& eventlist) : _eventlist(eventlist), _head(0) {}
+    void add(Logfile& logfile, uint32_t type, uint32_t id, uint32_t ev,
+	     double val1, double val2, double val3);
+    // write out everything the buffers hold, earliest first; records
+    // with the same time go in buffer order
+    static void flush(vector<LogBuffer*>& buffers);
+ private:
+    struct record {
+	Logfile* logfile;
+	simtime_picosec time;
+	uint32_t type, id, ev;
+	double val1, val2, val3;
+    };
+    EventList& _eventlist;
+    vector<record> _records;
+    size_t _head; // the first record not yet written
+};
+
 class Logfile {
+    friend class LogBuffer;
  public:
     Logfile(const string& filename, EventList& eventlist);
     ~Logfile();
+    // carry on in a new file, which starts with everything written
+    // so far.  The old file is left as it is, so a forked copy of the
+    // simulation can continue on its own log.
+    void reopen(const string& filename);
     void setStartTime(simtime_picosec starttime);
     void write(const string& msg);
     void writeName(Logged& logged);
@@ -46,10 +76,21 @@ class Logfile {
     void addLogger(Logger& logger);
     simtime_picosec _starttime;
  private:
+    void writeRecordAt(simtime_picosec time, uint32_t type, uint32_t id, uint32_t ev,
+		       double val1, double val2, double val3);
     EventList& _eventlist;
     vector<Logger*> _loggers;
     // managing the files for writing
     void transposeLog();
+    // lazily named objects (see Logged::setName) written since the
+    // last plain line, put into the preamble by flushNames() when
+    // something follows them or the log is finished
+    struct pending_name {
+	name_key key;
+	Logged::id_t id;
+    };
+    vector<pending_name> _names;
+    void flushNames();
     stringstream _preamble;
     string _logfilename;
     FILE* _logfile;
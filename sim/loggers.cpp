@@ -37,6 +37,9 @@ string QueueLoggerSimple::event_to_str(RawLogEvent& event) {
     case QueueLogger::PKT_BOUNCE:
 	ss << " Ev BOUNCE";
 	break;
+    case QueueLogger::PKT_MARK:
+	ss << " Ev MARK";
+	break;
     }
     ss << " Qsize " << (uint64_t)event._val1 
        << " FlowID " << (uint64_t)event._val2 
@@ -48,7 +51,8 @@ QueueLoggerSampling::QueueLoggerSampling(simtime_picosec period,
 					 EventList &eventlist)
   : EventSource(eventlist,"QueuelogSampling"),
     _queue(NULL), _lastlook(0), _period(period), _lastq(0), 
-    _seenQueueInD(false), _cumidle(0), _cumarr(0), _cumdrop(0)
+    _seenQueueInD(false), _cumidle(0), _cumarr(0), _cumdrop(0),
+    _cummarks(0), _numMarksInD(0)
 {	
     eventlist.sourceIsPendingRel(*this,0);
 }
@@ -82,12 +86,22 @@ QueueLoggerSampling::doNextEvent()
 	_cumidle += timeAsSec(dt_ps); 
     _logfile->writeRecord(QUEUE_RECORD, _queue->id, CUM_TRAFFIC, _cumarr,
 			  _cumidle, _cumdrop);
+    if (_cummarks > 0)
+	_logfile->writeRecord(QUEUE_RECORD, _queue->id, CUM_MARKS,
+			      (double)_cummarks, (double)_numMarksInD, 0);
+    _numMarksInD = 0;
 }
 
 void
 QueueLoggerSampling::logQueue(Queue& queue, QueueEvent ev, Packet &pkt) {
     if (_queue==NULL) _queue=&queue;
     assert(&queue==_queue);
+    if (ev == PKT_MARK) {
+	// the packet stays where it was; only count it
+	_cummarks++;
+	_numMarksInD++;
+	return;
+    }
     _lastq = queue.queuesize();
     if (!_seenQueueInD) {
 	_seenQueueInD=true;
@@ -137,6 +151,8 @@ QueueLoggerSampling::logQueue(Queue& queue, QueueEvent ev, Packet &pkt) {
     case PKT_BOUNCE:
 	/* we don't currently do anything with this */
 	break;
+    case PKT_MARK:
+	break;
     }
 }
 
@@ -163,9 +179,18 @@ string QueueLoggerSampling::event_to_str(RawLogEvent& event) {
     case Logger::QUEUE_RECORD:
 	ss << " Type QUEUE_APPROX";
 	ss << " ID " << event._id;
-	assert(event._ev == QueueLogger::CUM_TRAFFIC);
-	ss << " Ev CUM_TRAFFIC CumArr " << (int)event._val1
-	   << " CumIdle " << (int)event._val2 << " CumDrop " << (int)event._val3;
+	switch(event._ev) {
+	case QueueLogger::CUM_TRAFFIC:
+	    ss << " Ev CUM_TRAFFIC CumArr " << (int)event._val1
+	       << " CumIdle " << (int)event._val2 << " CumDrop " << (int)event._val3;
+	    break;
+	case QueueLogger::CUM_MARKS:
+	    ss << " Ev CUM_MARKS CumMarks " << (uint64_t)event._val1
+	       << " Marks " << (uint64_t)event._val2;
+	    break;
+	default:
+	    ss << " Unknown Event " << event._ev;
+	}
 	break;
     default:
 	ss << "Unknown record type: " << event._type;
@@ -537,7 +562,7 @@ void MemoryLoggerSampling::doNextEvent(){
     for (i=0; i<_tcp_sinks.size(); i++) {
 	_logfile->writeRecord(Logger::TCP_MEMORY, _tcp_sinks[i]->get_id(),
 			      TcpLogger::MEMORY, 0, 0,
-			      _tcp_sinks[i]->_received.size()*1000);
+			      _tcp_sinks[i]->_received.bytes());
     }
 
     for (i=0; i<_tcp_sources.size(); i++) {
@@ -550,7 +575,7 @@ void MemoryLoggerSampling::doNextEvent(){
     for (i=0; i<_mtcp_sinks.size(); i++) {
 	_logfile->writeRecord(Logger::MTCP, _mtcp_sinks[i]->get_id(),
 			      MultipathTcpLogger::MEMORY, 0, 0,
-			      _mtcp_sinks[i]->_received.size()*1000);
+			      _mtcp_sinks[i]->_received.bytes());
     }
 
     for (i=0; i<_mtcp_sources.size(); i++) {
@@ -562,6 +587,56 @@ void MemoryLoggerSampling::doNextEvent(){
 #endif
 }
 
+SwitchBufferLoggerSampling::SwitchBufferLoggerSampling(simtime_picosec period, 
+						       EventList& eventlist):
+    EventSource(eventlist,"SwitchBufferSampling"), _period(period)
+{
+    eventlist.sourceIsPendingRel(*this,0);
+}
+
+void SwitchBufferLoggerSampling::monitorBuffer(SwitchBuffer* buffer){
+    _buffers.push_back(buffer);
+}
+
+void SwitchBufferLoggerSampling::doNextEvent(){
+    eventlist().sourceIsPendingRel(*this,_period);
+    for (size_t i=0; i<_buffers.size(); i++) {
+	SwitchBuffer* b = _buffers[i];
+	_logfile->writeRecord(Logger::SHARED_BUFFER, b->id, BUFFER_USED,
+			      (double)b->used(), (double)b->peak(), (double)b->pool());
+	_logfile->writeRecord(Logger::SHARED_BUFFER, b->id, BUFFER_HEADROOM,
+			      (double)b->headroomUsed(), 0, (double)b->headroom());
+	_logfile->writeRecord(Logger::SHARED_BUFFER, b->id, BUFFER_LOSS,
+			      (double)b->drops(), (double)b->overflows(), 0);
+    }
+}
+
+string SwitchBufferLoggerSampling::event_to_str(RawLogEvent& event) {
+    stringstream ss;
+    ss << fixed << setprecision(9) << event._time;
+    assert(event._type == Logger::SHARED_BUFFER);
+    ss << " Type SHARED_BUFFER ID " << event._id;
+    switch(event._ev) {
+    case BUFFER_USED:
+	ss << " Ev USED Bytes " << (uint64_t)event._val1
+	   << " Peak " << (uint64_t)event._val2
+	   << " Pool " << (uint64_t)event._val3;
+	break;
+    case BUFFER_HEADROOM:
+	ss << " Ev HEADROOM Bytes " << (uint64_t)event._val1
+	   << " Reserved " << (uint64_t)event._val3;
+	break;
+    case BUFFER_LOSS:
+	ss << " Ev LOSS Drops " << (uint64_t)event._val1
+	   << " Overflows " << (uint64_t)event._val2;
+	break;
+    default:
+	ss << " Unknown event sub type " << event._ev;
+	break;
+    }
+    return ss.str();
+}
+
 string MemoryLoggerSampling::event_to_str(RawLogEvent& event) {
     stringstream ss;
     ss << fixed << setprecision(9) << event._time;
@@ -71,6 +71,8 @@ class QueueLoggerSampling : public QueueLogger, public EventSource {
     double _cumidle;
     double _cumarr;
     double _cumdrop;
+    uint64_t _cummarks;    // ECN marks; recorded once there are some
+    uint64_t _numMarksInD;
 };
 
 class SinkLoggerSampling : public Logger, public EventSource {
@@ -136,6 +138,19 @@ class MemoryLoggerSampling : public Logger, public EventSource {
     simtime_picosec _period;
 };
 
+// Samples how full shared switch buffers are
+class SwitchBufferLoggerSampling : public Logger, public EventSource {
+ public:
+    enum SwitchBufferEvent { BUFFER_USED=0, BUFFER_HEADROOM=1, BUFFER_LOSS=2 };
+    SwitchBufferLoggerSampling(simtime_picosec period, EventList& eventlist);
+    void doNextEvent();
+    void monitorBuffer(SwitchBuffer* buffer);
+    static string event_to_str(RawLogEvent& event);
+ private:
+    vector<SwitchBuffer*> _buffers;
+    simtime_picosec _period;
+};
+
 
 class AggregateTcpLogger : public Logger, public EventSource {
  public:
@@ -13,17 +13,62 @@ class MultipathTcpSrc;
 class Logfile;
 class RawLogEvent;
 
+// A name yet to be formatted: a printf format and up to three ints
+struct name_key {
+    const char* format; // NULL if there's nothing to format
+    int32_t args[3];
+    string str() const;
+};
+
+// Something with an id and a name for the logs.  A name is kept either
+// as a string or, until str() needs a string, as a name_key, so that
+// most objects, which are only ever named by literals and formats,
+// never hold a string at all.
 class Logged {
  public:
     typedef uint32_t id_t;
-    Logged(const string& name) {_name=name; id=LASTIDNUM; Logged::LASTIDNUM++; }
-    virtual ~Logged() {}
-    virtual void setName(const string& name) { _name=name; }
-    virtual const string& str() { return _name; };
+    // ids come from the current SimContext
+    Logged(const string& name);
+    // the name is kept, not copied: pass a literal, without any %
+    Logged(const char* name);
+    Logged(const Logged& o);
+    Logged& operator=(const Logged& o);
+    virtual ~Logged() { delete _name; }
+    virtual void setName(const string& name) {
+	setString(name);
+	_name_key.format = NULL;
+    }
+    // Name us with a printf format and up to three ints, as in
+    // setName("ndp_%d_%d(%d)", src, dst, n).  Nothing is formatted
+    // until str() asks, so building a million flows needn't build a
+    // million strings.  The format is kept, not copied: pass a literal.
+    void setName(const char* format, int a, int b = 0, int c = 0) {
+	delete _name;
+	_name = NULL;
+	_literal_name = false;
+	_name_key.format = format;
+	_name_key.args[0] = a; _name_key.args[1] = b; _name_key.args[2] = c;
+    }
+    virtual const string& str() { if (!_name) formatName(); return *_name; };
+    // the name still to be formatted, if any
+    const name_key& nameKey() const { return _name_key; }
+    // give us o's name, formatted or not
+    void copyName(const Logged& o);
     id_t id;
-    string _name;
  private:
-    static id_t LASTIDNUM;
+    void setString(const string& name) {
+	if (_name)
+	    *_name = name;
+	else
+	    _name = new string(name);
+    }
+    // sets the string through setName, so subclasses see it as if set
+    // directly; the name we were built with is just copied
+    void formatName();
+
+    bool _literal_name; // _name_key is the name we were built with
+    string* _name;      // NULL until the name is a string
+    name_key _name_key;
 };
 
 class Logger {
@@ -35,7 +80,7 @@ class Logger {
 		     TCP_TRAFFIC=9, NDP_TRAFFIC=10, 
 		     TCP_SINK = 11, MTCP = 12, ENERGY = 13, 
 		     TCP_MEMORY = 14, NDP_EVENT=15, NDP_STATE=16, NDP_RECORD=17, 
-		     NDP_SINK = 18, NDP_MEMORY = 19};
+		     NDP_SINK = 18, NDP_MEMORY = 19, SHARED_BUFFER = 20};
     static string event_to_str(RawLogEvent& event);
     Logger() {};
     virtual ~Logger(){};
@@ -53,8 +98,8 @@ class TrafficLogger : public Logger {
 
 class QueueLogger : public Logger  {
  public:
-    enum QueueEvent { PKT_ENQUEUE=0, PKT_DROP=1, PKT_SERVICE=2, PKT_TRIM=3, PKT_BOUNCE=4 };
-    enum QueueRecord { CUM_TRAFFIC=0 };
+    enum QueueEvent { PKT_ENQUEUE=0, PKT_DROP=1, PKT_SERVICE=2, PKT_TRIM=3, PKT_BOUNCE=4, PKT_MARK=5 };
+    enum QueueRecord { CUM_TRAFFIC=0, CUM_MARKS=1 };
     enum QueueApprox { QUEUE_RANGE=0, QUEUE_OVERFLOW=1 };
     virtual void logQueue(Queue& queue, QueueEvent ev, Packet& pkt) = 0;
     virtual ~QueueLogger(){};
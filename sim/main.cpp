@@ -184,7 +184,7 @@ int main(int argc, char **argv) {
 	
 	pqueue = new Queue(SERVICE1*2, memFromPkt(FEEDER_BUFFER), 
 			   eventlist,NULL); 
-	pqueue->setName("PQueue1_"+ntoa(i)); 
+	pqueue->setName("PQueue1_%d", i); 
 	logfile.writeName(*pqueue);
 
 	// tell it the route
@@ -221,7 +221,7 @@ int main(int argc, char **argv) {
 	
 	pqueue = new Queue(SERVICE2*2, memFromPkt(FEEDER_BUFFER), 
 			   eventlist, NULL); 
-	pqueue->setName("PQueue2_"+ntoa(i)); logfile.writeName(*pqueue);
+	pqueue->setName("PQueue2_%d", i); logfile.writeName(*pqueue);
 
 	// tell it the route
 	routeout = new route_t(); 
@@ -12,6 +12,7 @@ MultipathTcpSrc::MultipathTcpSrc(char cc_type,EventList& ev,MultipathTcpLogger*
   EventSource(ev,"MTCP"),_alfa(1),_logger(logger), _e(1)
 {
 	_cc_type = cc_type;
+	_rng = SimContext::current().rng(id);
 	a = A_SCALE;
 	_sink = NULL;
 
@@ -204,7 +205,7 @@ MultipathTcpSrc::inflate_window(uint32_t cwnd, int newly_acked,uint32_t mss) {
       tmp = 0;
     }
 
-    if (rand() % A_SCALE < tmp2 % A_SCALE){
+    if (_rng.below(A_SCALE) < tmp2 % A_SCALE){
       tmp++;
       tmp_float++;
     }
@@ -252,7 +253,7 @@ MultipathTcpSrc::inflate_window(uint32_t cwnd, int newly_acked,uint32_t mss) {
     tmp_float = ((double)newly_acked * mss * _alfa * pow(_alfa*cwnd,1-_e))/pow(total_cwnd,2-_e);
 
     tmp = (int)floor(tmp_float);
-    if (drand()< tmp_float-tmp)
+    if (_rng.uniform()< tmp_float-tmp)
       tmp++;
 
     if (tmp>tcp_inc)//capping
@@ -637,29 +638,11 @@ MultipathTcpSink::receivePacket(Packet& pkt) {
   if (seqno == _cumulative_ack+1) { // it's the next expected seq no
     _cumulative_ack = seqno + size - 1;
     // are there any additional received packets we can now ack?
-    while (!_received.empty() && (_received.front() == _cumulative_ack+1) ) {
-      _received.pop_front();
-      _cumulative_ack+= size;
-    }
+    _cumulative_ack += _received.fill(seqno) * size;
   } 
   else if (seqno < _cumulative_ack+1) {} //must have been a bad retransmit
   else { // it's not the next expected sequence number
-    if (_received.empty()) {
-      _received.push_front(seqno);
-    } 
-    else if (seqno > _received.back()) { // likely case
-      _received.push_back(seqno);
-    } 
-    else { // uncommon case - it fills a hole
-      list<uint64_t>::iterator i;
-      for (i = _received.begin(); i != _received.end(); i++) {
-	if (seqno == *i) break; // it's a bad retransmit
-	if (seqno < (*i)) {
-	  _received.insert(i, seqno);
-	  break;
-	}
-      }
-    }
+    _received.add(seqno, size); // false if it's a bad retransmit
   }
 #endif
 }	
@@ -84,6 +84,7 @@ public:
 	MultipathTcpSink* _sink;
 private:
 	MultipathTcpLogger* _logger;
+	Rng _rng; // for rounding the window increase
 
 	char _cc_type;
 
@@ -101,14 +102,14 @@ public:
 	uint64_t data_ack(){
 	  return _cumulative_ack;
 	};
-	uint64_t cumulative_ack(){ return _cumulative_ack + _received.size()*1000;}
+	uint64_t cumulative_ack(){ return _cumulative_ack + _received.bytes();}
 
 	uint32_t drops(){ return 0;}
 	uint32_t get_id(){ return id;}
 
 	void doNextEvent();
     virtual const string& nodename() { return _nodename; }
-	list<TcpAck::seq_t> _received; // list of packets above a hole, that we've received
+	ReceiveBitmap _received; // packets above a hole, that we've received
 private:
 
 	// Connectivity
@@ -5,6 +5,119 @@
 #include "queue.h"
 #include <stdio.h>
 
+////////////////////////////////////////////////////////////////
+//  NDP SENT TIMES
+////////////////////////////////////////////////////////////////
+
+const simtime_picosec NdpSentTimes::NONE;
+
+NdpSentTimes::NdpSentTimes()
+    : _slots(16, NONE), _lo(0), _hi(0), _count(0), _mss(1)
+{
+}
+
+void
+NdpSentTimes::set(NdpPacket::seq_t seqno, simtime_picosec when) {
+    assert(seqno > 0 && (seqno - 1) % _mss == 0);
+    uint64_t i = (seqno - 1) / _mss;
+    if (_count == 0) {
+	_lo = i;
+	_hi = i + 1;
+    } else if (i < _lo || i >= _hi) {
+	uint64_t lo = i < _lo ? i : _lo;
+	uint64_t hi = i >= _hi ? i + 1 : _hi;
+	if (hi - lo > _slots.size())
+	    grow(lo, hi);
+	_lo = lo;
+	_hi = hi;
+    }
+    simtime_picosec& s = slot(i);
+    if (s == NONE)
+	_count++;
+    s = when;
+    _by_time.push(entry_t(when, i));
+    // stale entries later than every live one never reach the top
+    if (_by_time.size() > 2 * (size_t)_count + 64)
+	compact();
+}
+
+simtime_picosec
+NdpSentTimes::take(NdpPacket::seq_t seqno) {
+    if (_count == 0)
+	return 0;
+    assert(seqno > 0 && (seqno - 1) % _mss == 0);
+    uint64_t i = (seqno - 1) / _mss;
+    if (i < _lo || i >= _hi || slot(i) == NONE)
+	return 0;
+    simtime_picosec when = slot(i);
+    clear(i);
+    return when;
+}
+
+void
+NdpSentTimes::erase_upto(NdpPacket::seq_t seqno) {
+    // _lo is always in use while there's anything in the window
+    while (_count > 0 && _lo * _mss + 1 <= seqno)
+	clear(_lo);
+}
+
+void
+NdpSentTimes::take_due(simtime_picosec now, simtime_picosec rto,
+		       list<NdpPacket::seq_t>& seqnos) {
+    for (uint64_t i = _lo; _count > 0 && i < _hi; i++) {
+	simtime_picosec sent = slot(i);
+	if (sent != NONE && sent + rto <= now) {
+	    seqnos.push_back(i * _mss + 1);
+	    clear(i);
+	}
+    }
+}
+
+simtime_picosec
+NdpSentTimes::earliest() {
+    assert(_count > 0);
+    while (stale(_by_time.top()))
+	_by_time.pop();
+    return _by_time.top().first;
+}
+
+// rebuild the heap from the packets in the window
+void
+NdpSentTimes::compact() {
+    vector<entry_t> live;
+    live.reserve(_count);
+    for (uint64_t i = _lo; i < _hi; i++)
+	if (slot(i) != NONE)
+	    live.push_back(entry_t(slot(i), i));
+    priority_queue<entry_t, vector<entry_t>, greater<entry_t> > by_time(greater<entry_t>(), live);
+    _by_time.swap(by_time);
+}
+
+void
+NdpSentTimes::clear(uint64_t i) {
+    slot(i) = NONE;
+    if (--_count == 0) {
+	_lo = _hi = 0;
+	return;
+    }
+    while (slot(_lo) == NONE)
+	_lo++;
+    while (slot(_hi - 1) == NONE)
+	_hi--;
+}
+
+// make room for packets lo up to hi, keeping those in the window now
+void
+NdpSentTimes::grow(uint64_t lo, uint64_t hi) {
+    size_t size = _slots.size();
+    while (size < hi - lo)
+	size *= 2;
+    vector<simtime_picosec> slots(size, NONE);
+    for (uint64_t i = _lo; i < _hi; i++)
+	slots[i & (size - 1)] = slot(i);
+    _slots.swap(slots);
+}
+
 ////////////////////////////////////////////////////////////////
 //  NDP SOURCE
 ////////////////////////////////////////////////////////////////
@@ -23,18 +136,6 @@
 //#define RCV_CWND 15
 #define RCV_CWND 0
 
-int NdpSrc::_global_node_count = 0;
-/* _rtt_hist is used to build a histogram of RTTs.  The index is in
-   units of microseconds, and RTT is from when a packet is first sent
-   til when it is ACKed, including any retransmissions.  You can read
-   this out after the sim has finished if you care about this. */
-int NdpSrc::_rtt_hist[10000000] = {0};
-
-/* keep track of RTOs.  Generally, we shouldn't see RTOs if
-   return-to-sender is enabled.  Otherwise we'll see them with very
-   large incasts. */
-uint32_t NdpSrc::_global_rto_count = 0;
-
 /* _min_rto can be tuned using SetMinRTO. Don't change it here.  */
 simtime_picosec NdpSrc::_min_rto = timeFromUs((uint32_t)DEFAULT_RTO_MIN);
 
@@ -44,9 +145,14 @@ RouteStrategy NdpSrc::_route_strategy = NOT_SET;
 RouteStrategy NdpSink::_route_strategy = NOT_SET;
 
 NdpSrc::NdpSrc(NdpLogger* logger, TrafficLogger* pktlogger, EventList &eventlist)
-    : EventSource(eventlist,"ndp"),  _logger(logger), _flow(pktlogger)
+    : EventSource(eventlist,"ndp"),  _logger(logger), _flow(pktlogger),
+      _rtt_hist(NULL)
 {
     _mss = Packet::data_packet_size();
+    _sent_times.set_mss(_mss);
+    _first_sent_times.set_mss(_mss);
+
+    _rng = SimContext::current().rng(id);
 
     _base_rtt = timeInf;
     _acked_packets = 0;
@@ -82,8 +188,8 @@ NdpSrc::NdpSrc(NdpLogger* logger, TrafficLogger* pktlogger, EventList &eventlist
 	_feedback_history[i] = UNKNOWN;
 
     _rtx_timeout_pending = false;
-    _rtx_timeout = timeInf;
-    _node_num = _global_node_count++;
+    set_rtx_timeout(timeInf);
+    _node_num = SimContext::current().next_ndp_node();
     _nodename = "ndpsrc" + to_string(_node_num);
 
     // debugging hack
@@ -126,7 +232,7 @@ void NdpSrc::set_paths(vector<const Route*>* rt_list){
 	_path_counts_rto.resize(no_of_paths);
 
 	for (unsigned int i=0; i < no_of_paths; i++){
-	    Route* tmp = new Route(*(rt_list->at(i)));
+	    Route* tmp = rt_list->at(i)->extend();
 	    tmp->add_endpoints(this, _sink);
 	    tmp->set_path_id(i, rt_list->size());
 	    _paths[i] = tmp;
@@ -147,6 +253,13 @@ void NdpSrc::set_paths(vector<const Route*>* rt_list){
     }
 }
 
+void NdpSrc::clear_paths() {
+    for (unsigned int i = 0; i < _original_paths.size(); i++)
+	delete _original_paths[i];
+    _paths.clear();
+    _original_paths.clear();
+}
+
 void NdpSrc::startflow(){
     _highest_sent = 0;
     _last_acked = 0;
@@ -154,7 +267,7 @@ void NdpSrc::startflow(){
     _acked_packets = 0;
     _packets_sent = 0;
     _rtx_timeout_pending = false;
-    _rtx_timeout = timeInf;
+    set_rtx_timeout(timeInf);
     _pull_window = 0;
     
     _flight_size = 0;
@@ -173,7 +286,7 @@ void NdpSrc::connect(Route& routeout, Route& routeback, NdpSink& sink, simtime_p
     
     _sink = &sink;
     _flow.id = id; // identify the packet flow with the NDP source that generated it
-    _flow._name = _name;
+    _flow.copyName(*this);
     _starttime = starttime; // record start time
     
     _sink->connect(*this, routeback);
@@ -287,7 +400,7 @@ void NdpSrc::processRTS(NdpPacket& pkt){
     _sent_times.erase(pkt.seqno());
     //resend from front of RTX
     //queue on any other path than the one we tried last time
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_CREATE);
+    pkt.logTraffic(*this,TrafficLogger::PKT_CREATE);
     _rtx_queue.push_front(&pkt); 
 
     count_bounce(pkt.route()->path_id());
@@ -347,7 +460,7 @@ void NdpSrc::processNack(const NdpNack& nack){
 			  _paths.size()>0?_paths.size():1, last_packet);
     
     // need to add packet to rtx queue
-    p->flow().logTraffic(*p,*this,TrafficLogger::PKT_CREATE);
+    p->logTraffic(*this,TrafficLogger::PKT_CREATE);
     _rtx_queue.push_back(p);
     if (nack.pull()) {
 	_implicit_pulls++;
@@ -377,8 +490,7 @@ void NdpSrc::processAck(const NdpAck& ack) {
       else
       printf("Receive ACK (----): %s\n", ack.pull_bitmap().to_string().c_str());
     */
-    log_rtt(_first_sent_times[ackno]);
-    _first_sent_times.erase(ackno);
+    log_rtt(_first_sent_times.take(ackno));
     _sent_times.erase(ackno);
 
     count_ack(path_id);
@@ -409,14 +521,14 @@ void NdpSrc::processAck(const NdpAck& ack) {
     }
 
     if (_rto < _min_rto)
-	_rto = _min_rto * ((drand() * 0.5) + 0.75);
+	_rto = _min_rto * ((_rng.uniform() * 0.5) + 0.75);
 
     if (cum_ackno > _last_acked) { // a brand new ack    
 	// we should probably cancel the rtx timer for any acked by
 	// the cumulative ack, but we'll get an ACK or NACK anyway in
 	// due course.
 	_last_acked = cum_ackno;
-
+	process_cumulative_ack(cum_ackno);
     }
     if (_logger) _logger->logNdp(*this, NdpLogger::NDP_RCV);
 
@@ -441,7 +553,7 @@ void NdpSrc::processAck(const NdpAck& ack) {
 
 void NdpSrc::receivePacket(Packet& pkt) 
 {
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+    pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
 
     switch (pkt.type()) {
     case NDP:
@@ -479,7 +591,7 @@ void NdpSrc::receivePacket(Packet& pkt)
 		// the cumulative ack, but we'll get an ACK or NACK anyway in
 		// due course.
 		_last_acked = cum_ackno;
-	  
+		process_cumulative_ack(cum_ackno);
 	    }
 	    //printf("Receive PULL: %s\n", p->pull_bitmap().to_string().c_str());
 	    pull_packets(p->pullno(), p->pacerno());
@@ -544,7 +656,7 @@ const Route* NdpSrc::choose_route() {
     case SCATTER_RANDOM:
 	//ECMP
 	assert(_paths.size() > 0);
-	_crt_path = random()%_paths.size();
+	_crt_path = _rng.below(_paths.size());
 	break;
     case SCATTER_PERMUTE:
 	//Cycle through a permutation.  Generally gets better load balancing than SCATTER_RANDOM.
@@ -585,7 +697,7 @@ void NdpSrc::send_packet(NdpPull::seq_t pacer_no, bool first_rtt) {
 
         p = _rtx_queue.front();
         _rtx_queue.pop_front();
-        p->flow().logTraffic(*p,*this,TrafficLogger::PKT_SEND);
+        p->logTraffic(*this,TrafficLogger::PKT_SEND);
         p->set_ts(eventlist().now());
         p->set_pacerno(pacer_no);
 
@@ -608,13 +720,13 @@ void NdpSrc::send_packet(NdpPull::seq_t pacer_no, bool first_rtt) {
 	    //feeder queue isn't a FIFO but that would be hard to
 	    //implement in a real system, so this is a rough proxy.
         uint32_t service_time = q->serviceTime(*p);  
-        _sent_times[p->seqno()] = eventlist().now() + service_time;
+        _sent_times.set(p->seqno(), eventlist().now() + service_time);
         _packets_sent ++;
         _rtx_packets_sent++;
         update_rtx_time();
 	
         if (_rtx_timeout == timeInf) {
-	       _rtx_timeout = eventlist().now() + _rto;
+	       set_rtx_timeout(eventlist().now() + _rto);
         }
 
     } else {
@@ -658,7 +770,7 @@ void NdpSrc::send_packet(NdpPull::seq_t pacer_no, bool first_rtt) {
                 abort();
         }
         
-        p->flow().logTraffic(*p,*this,TrafficLogger::PKT_CREATESEND);
+        p->logTraffic(*this,TrafficLogger::PKT_CREATESEND);
         p->set_ts(eventlist().now());
     
         _flight_size += _mss;
@@ -682,11 +794,11 @@ void NdpSrc::send_packet(NdpPull::seq_t pacer_no, bool first_rtt) {
         uint32_t service_time = q->serviceTime(*p);  
 	
         //cout << "service_time2: " << service_time << endl;
-	    _sent_times[p->seqno()] = eventlist().now() + service_time;
-	    _first_sent_times[p->seqno()] = eventlist().now();
+	    _sent_times.set(p->seqno(), eventlist().now() + service_time);
+	    _first_sent_times.set(p->seqno(), eventlist().now());
 
         if (_rtx_timeout == timeInf) {
-            _rtx_timeout = eventlist().now() + _rto;
+            set_rtx_timeout(eventlist().now() + _rto);
         }
     }
 
@@ -701,7 +813,7 @@ void NdpSrc::send_packet(NdpPull::seq_t pacer_no, bool first_rtt) {
 void NdpSrc::permute_paths() {
     int len = _paths.size();
     for (int i = 0; i < len; i++) {
-	int ix = random() % (len - i);
+	int ix = _rng.below(len - i);
 	const Route* tmppath = _paths[ix];
 	_paths[ix] = _paths[len-1-i];
 	_paths[len-1-i] = tmppath;
@@ -712,61 +824,29 @@ void
 NdpSrc::update_rtx_time() {
     //simtime_picosec now = eventlist().now();
     if (_sent_times.empty()) {
-	_rtx_timeout = timeInf;
+	set_rtx_timeout(timeInf);
 	return;
     }
-    map<NdpPacket::seq_t, simtime_picosec>::iterator i;
-    simtime_picosec first_senttime = timeInf;
-    int c = 0;
-    for (i = _sent_times.begin(); i != _sent_times.end(); i++) {
-	simtime_picosec sent = i->second;
-	if (sent < first_senttime || first_senttime == timeInf) {
-	    first_senttime = sent;
-	}
-	c++;
-    }
-    _rtx_timeout = first_senttime + _rto;
+    set_rtx_timeout(_sent_times.earliest() + _rto);
 }
  
 void 
 NdpSrc::process_cumulative_ack(NdpPacket::seq_t cum_ackno) {
-    map<NdpPacket::seq_t, simtime_picosec>::iterator i, i_next;
-    i = _sent_times.begin();
-    while (i != _sent_times.end()) {
-	if (i->first <= cum_ackno) {
-	    i_next = i; //juggling to keep i valid
-	    i_next++;
-	    _sent_times.erase(i);
-	    i = i_next;
-	} else {
-	    return;
-	}
-    }
-    //need to call update_rtx_time right after this!
+    // the ACK for a packet the cumulative ack covers may have been
+    // lost, and then we'd never time its RTT; stop waiting, or the low
+    // end of _first_sent_times stays put and the ring grows for the
+    // rest of the flow.  Retransmit timers are left alone: those
+    // packets will get an ACK or NACK anyway.
+    _first_sent_times.erase_upto(cum_ackno);
 }
 
 void 
 NdpSrc::retransmit_packet() {
     //cout << "starting retransmit_packet\n";
     NdpPacket* p;
-    map<NdpPacket::seq_t, simtime_picosec>::iterator i, i_next;
-    i = _sent_times.begin();
     list <NdpPacket::seq_t> rtx_list;
-    // we build a list first because otherwise we're adding to and
-    // removing from _sent_times and the iterator gets confused
-    while (i != _sent_times.end()) {
-	if (i->second + _rto <= eventlist().now()) {
-	    //cout << "_sent_time: " << timeAsUs(i->second) << "us rto " << timeAsUs(_rto) << "us now " << timeAsUs(eventlist().now()) << "us\n";
-	    //this one is due for retransmission
-	    rtx_list.push_back(i->first);
-	    i_next = i; //we're about to invalidate i when we call erase
-	    i_next++;
-	    _sent_times.erase(i);
-	    i = i_next;
-	} else {
-	    i++;
-	}
-    }
+    // we build a list first because retransmitting adds to _sent_times
+    _sent_times.take_due(eventlist().now(), _rto, rtx_list);
     list <NdpPacket::seq_t>::iterator j;
     for (j = rtx_list.begin(); j != rtx_list.end(); j++) {
 	NdpPacket::seq_t seqno = *j;
@@ -781,7 +861,7 @@ NdpSrc::retransmit_packet() {
 	    p = NdpPacket::newpkt(_flow, *rt, seqno, 0, _mss, true,
 				  _paths.size(), last_packet);
 	    if (_route_strategy == SCATTER_RANDOM) {
-		_crt_path = random() % _paths.size();
+		_crt_path = _rng.below(_paths.size());
 	    } else {
 		_crt_path++;
 		if (_crt_path==_paths.size()){ 
@@ -799,14 +879,16 @@ NdpSrc::retransmit_packet() {
 	    abort();
 	}
 	
-	p->flow().logTraffic(*p,*this,TrafficLogger::PKT_CREATESEND);
+	p->logTraffic(*this,TrafficLogger::PKT_CREATESEND);
 	p->set_ts(eventlist().now());
 	//_sent_times[seqno] = eventlist().now();
 	// 	if (_log_me) {
 	//cout << "Sent " << seqno << " RTx" << " flow id " << p->flow().id << endl;
 	// 	}
-	_global_rto_count++;
-	cout << "Total RTOs: " << _global_rto_count << endl;
+	/* keep track of RTOs.  Generally, we shouldn't see RTOs if
+	   return-to-sender is enabled.  Otherwise we'll see them with very
+	   large incasts. */
+	cout << "Total RTOs: " << SimContext::current().count_ndp_rto() << endl;
 	_path_counts_rto[p->path_id()]++;
 	p->sendOn();
 	_packets_sent++;
@@ -815,7 +897,7 @@ NdpSrc::retransmit_packet() {
     update_rtx_time();
 }
 
-void NdpSrc::rtx_timer_hook(simtime_picosec now, simtime_picosec period) {
+void NdpSrc::rtx_timer_hook(simtime_picosec now) {
 #ifndef RESEND_ON_TIMEOUT
     return;  // if we're using RTS, we shouldn't need to also use
 	     // timeouts, at least in simulation where we don't see
@@ -823,7 +905,7 @@ void NdpSrc::rtx_timer_hook(simtime_picosec now, simtime_picosec period) {
 #endif
 
     if (_highest_sent == 0) return;
-    if (_rtx_timeout==timeInf || now + period < _rtx_timeout) return;
+    if (_rtx_timeout==timeInf || now < _rtx_timeout) return;
 
     cout <<"At " << timeAsUs(now) << "us RTO " << timeAsUs(_rto) << "us MDEV " << timeAsUs(_mdev) << "us RTT "<< timeAsUs(_rtt) << "us SEQ " << _last_acked / _mss << " CWND "<< _cwnd/_mss << " Flow ID " << str()  << endl;
     /*
@@ -832,26 +914,23 @@ void NdpSrc::rtx_timer_hook(simtime_picosec now, simtime_picosec period) {
     }
     */
 
-    // here we can run into phase effects because the timer is checked
-    // only periodically for ALL flows but if we keep the difference
-    // between scanning time and real timeout time when restarting the
-    // flows we should minimize them !
+    // the timer fires when it's due, so we can retransmit straight away
     if(!_rtx_timeout_pending) {
 	_rtx_timeout_pending = true;
-
-	
-	// check the timer difference between the event and the real value
-	simtime_picosec too_early = _rtx_timeout - now;
-	if (now > _rtx_timeout) {
-	    // this shouldn't happen
-	    cout << "late_rtx_timeout: " << _rtx_timeout << " now: " << now << " now+rto: " << now + _rto << " rto: " << _rto << endl;
-	    too_early = 0;
-	}
-	eventlist().sourceIsPendingRel(*this, too_early);
+	eventlist().sourceIsPendingRel(*this, 0);
     }
 }
 
 void NdpSrc::log_rtt(simtime_picosec sent_time) {
+    /* _rtt_hist is used to build a histogram of RTTs.  The index is in
+       units of microseconds, and RTT is from when a packet is first sent
+       til when it is ACKed, including any retransmissions.  You can read
+       this out of the SimContext after the sim has finished if you care
+       about this.  We take it from the context we run in rather than
+       the one we were built in, as a partition of a parallel run
+       counts in its own. */
+    if (!_rtt_hist)
+	_rtt_hist = SimContext::current().ndp_rtt_hist();
     int64_t rtt = eventlist().now() - sent_time;
     if (rtt >= 0) 
 	_rtt_hist[(int)timeAsUs(rtt)]++;
@@ -894,6 +973,7 @@ NdpSink::NdpSink(EventList& event, double pull_rate_modifier)
     : Logged("ndp_sink"),_cumulative_ack(0) , _total_received(0) 
 {
     _src = 0;
+    _rng = SimContext::current().rng(id);
     _pacer = new NdpPullPacer(event, pull_rate_modifier);
     //_pacer = new NdpPullPacer(event, "/Users/localadmin/poli/new-datacenter-protocol/data/1500.recv.cdf.pretty");
     
@@ -920,6 +1000,7 @@ NdpSink::NdpSink(EventList& event, double pull_rate_modifier)
 NdpSink::NdpSink(NdpPullPacer* pacer) : Logged("ndp_sink"),_cumulative_ack(0) , _total_received(0) 
 {
     _src = 0;
+    _rng = SimContext::current().rng(id);
     _pacer = pacer;
     _nodename = "ndpsink";
     _pull_no = 0;
@@ -987,7 +1068,7 @@ void NdpSink::set_paths(vector<const Route*>* rt_list){
 	assert(_paths.size() == 0);
 	_paths.resize(rt_list->size());
 	for (unsigned int i=0;i<rt_list->size();i++){
-	    Route* t = new Route(*(rt_list->at(i)));
+	    Route* t = rt_list->at(i)->extend();
 	    t->add_endpoints(this, _src);
 	    _paths[i]=t;
 	}
@@ -1000,6 +1081,15 @@ void NdpSink::set_paths(vector<const Route*>* rt_list){
     }
 }
 
+void NdpSink::clear_paths() {
+    for (unsigned int i = 0; i < _paths.size(); i++)
+	delete _paths[i];
+    _paths.clear();
+    // and the history of them
+    _path_hist_index = -1;
+    _path_hist_first = -1;
+}
+
 // Receive a packet.
 // Note: _cumulative_ack is the last byte we've ACKed.
 // seqno is the first byte of the new packet.
@@ -1036,7 +1126,7 @@ void NdpSink::receivePacket(Packet& pkt) {
     update_path_history(*p);
     if (pkt.header_only()){
 	send_nack(ts,((NdpPacket*)&pkt)->seqno(), pacer_no);	  
-	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+	pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
 #ifdef RECORD_PATH_LENS
 	_trimmed_path_lens[pkt.path_len()]++;
 #endif
@@ -1056,7 +1146,7 @@ void NdpSink::receivePacket(Packet& pkt) {
 	_last_packet_seqno = p->seqno() + size - 1;
     }
 
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+    pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
     p->free();
   
     _total_received+=size;
@@ -1064,30 +1154,16 @@ void NdpSink::receivePacket(Packet& pkt) {
     if (seqno == _cumulative_ack+1) { // it's the next expected seq no
 	_cumulative_ack = seqno + size - 1;
 	// are there any additional received packets we can now ack?
-	while (!_received.empty() && (_received.front() == _cumulative_ack+1) ) {
-	    _received.pop_front();
-	    _cumulative_ack+= size;
-	}
+	_cumulative_ack += _received.fill(seqno) * size;
     } else if (seqno < _cumulative_ack+1) {
 	//must have been a bad retransmit
     } else { // it's not the next expected sequence number
 	if (_received.empty()) {
-	    _received.push_front(seqno);
 	    //it's a drop in this simulator there are no reorderings.
 	    _drops += (size + seqno-_cumulative_ack-1)/size;
-	} else if (seqno > _received.back()) { // likely case
-	    _received.push_back(seqno);
-	} 
-	else { // uncommon case - it fills a hole
-	    list<uint64_t>::iterator i;
-	    for (i = _received.begin(); i != _received.end(); i++) {
-		if (seqno == *i) break; // it's a bad retransmit
-		if (seqno < (*i)) {
-		    _received.insert(i, seqno);
-		    break;
-		}
-	    }
 	}
+	// a packet already held is a bad retransmit
+	_received.add(seqno, size);
     }
     send_ack(ts, seqno, pacer_no);
     // have we seen everything yet?
@@ -1132,7 +1208,7 @@ void NdpSink::send_ack(simtime_picosec ts, NdpPacket::seq_t ackno, NdpPacket::se
 			     _cumulative_ack, _pull_no, 
 			     _path_history[_path_hist_index].path_id());
 	if (_route_strategy == SCATTER_RANDOM) {
-	    _crt_path = random()%_paths.size();
+	    _crt_path = _rng.below(_paths.size());
 	} else {
 	    _crt_path++;
 	    if (_crt_path == _paths.size()) {
@@ -1149,7 +1225,7 @@ void NdpSink::send_ack(simtime_picosec ts, NdpPacket::seq_t ackno, NdpPacket::se
 	abort();
     }
 
-    ack->flow().logTraffic(*ack,*this,TrafficLogger::PKT_CREATE);
+    ack->logTraffic(*this,TrafficLogger::PKT_CREATE);
     ack->set_ts(ts);
 
     _pacer->sendPacket(ack, pacer_no, this);
@@ -1167,7 +1243,7 @@ void NdpSink::send_nack(simtime_picosec ts, NdpPacket::seq_t ackno, NdpPacket::s
 			       _cumulative_ack, _pull_no,
 			       _path_history[_path_hist_index].path_id());
 	if (_route_strategy == SCATTER_RANDOM) {
-	    _crt_path = random()%_paths.size();
+	    _crt_path = _rng.below(_paths.size());
 	} else {
 	    _crt_path++;
 	    if (_crt_path == _paths.size()) {
@@ -1183,7 +1259,7 @@ void NdpSink::send_nack(simtime_picosec ts, NdpPacket::seq_t ackno, NdpPacket::s
     case NOT_SET:
 	abort();
     }
-    nack->flow().logTraffic(*nack,*this,TrafficLogger::PKT_CREATE);
+    nack->logTraffic(*this,TrafficLogger::PKT_CREATE);
     nack->set_ts(ts);
     _pacer->sendPacket(nack, pacer_no, this);
 }
@@ -1192,7 +1268,7 @@ void NdpSink::send_nack(simtime_picosec ts, NdpPacket::seq_t ackno, NdpPacket::s
 void NdpSink::permute_paths() {
     int len = _paths.size();
     for (int i = 0; i < len; i++) {
-	int ix = random() % (len - i);
+	int ix = _rng.below(len - i);
 	const Route* tmppath = _paths[ix];
 	_paths[ix] = _paths[len-1-i];
 	_paths[len-1-i] = tmppath;
@@ -1210,6 +1286,7 @@ int NdpPullPacer::_pull_spacing_cdf_count = 0;
 NdpPullPacer::NdpPullPacer(EventList& event, double rate_mbps)  : 
     EventSource(event, "ndp_pacer"), _last_pull(0)
 {
+    _rng = SimContext::current().rng(id);
     _packet_drain_time = (simtime_picosec)(Packet::data_packet_size() * (pow(10.0,12.0) * 8) / speedFromMbps((uint64_t)rate_mbps));
     _log_me = false;
     _pacer_no = 0;
@@ -1218,6 +1295,7 @@ NdpPullPacer::NdpPullPacer(EventList& event, double rate_mbps)  :
 NdpPullPacer::NdpPullPacer(EventList& event, char* filename)  : 
     EventSource(event, "ndp_pacer"), _last_pull(0)
 {
+    _rng = SimContext::current().rng(id);
     int t;
     _packet_drain_time = 0;
 
@@ -1279,7 +1357,7 @@ void NdpPullPacer::sendPacket(Packet* ack, NdpPacket::seq_t rcvd_pacer_no, NdpSi
     if (_packet_drain_time>0)
 	drain_time = _packet_drain_time;
     else {
-	int t = (int)(drand()*_pull_spacing_cdf_count);
+	int t = (int)(_rng.uniform()*_pull_spacing_cdf_count);
 	drain_time = 10*timeFromNs(_pull_spacing_cdf[t])/20;
 	//cout << "Drain time is " << timeAsUs(drain_time);
     }
@@ -1290,7 +1368,7 @@ void NdpPullPacer::sendPacket(Packet* ack, NdpPacket::seq_t rcvd_pacer_no, NdpSi
     
 	if (delta >= drain_time){
 	    //send out as long as last NACK/ACK was sent more than packetDrain time ago.
-	    ack->flow().logTraffic(*ack,*this,TrafficLogger::PKT_SEND);
+	    ack->logTraffic(*this,TrafficLogger::PKT_SEND);
 	    if (_log_me) {
 		double excess = (delta - drain_time)/(double)drain_time;
 		_total_excess += excess;
@@ -1335,11 +1413,11 @@ void NdpPullPacer::sendPacket(Packet* ack, NdpPacket::seq_t rcvd_pacer_no, NdpSi
 	pull_pkt = NdpPull::newpkt((NdpNack*)ack);
 	((NdpNack*)ack)->dont_pull();
     }
-    pull_pkt->flow().logTraffic(*pull_pkt,*this,TrafficLogger::PKT_CREATE);
+    pull_pkt->logTraffic(*this,TrafficLogger::PKT_CREATE);
 
     _pull_queue.enqueue(*pull_pkt);
 
-    ack->flow().logTraffic(*ack,*this,TrafficLogger::PKT_SEND);
+    ack->logTraffic(*this,TrafficLogger::PKT_SEND);
     ack->sendOn();
     
     //   if (_log_me) {
@@ -1382,7 +1460,7 @@ void NdpPullPacer::doNextEvent(){
     Packet *pkt = _pull_queue.dequeue();
 
     //   cout << "Sending NACK for packet " << nack->ackno() << endl;
-    pkt->flow().logTraffic(*pkt,*this,TrafficLogger::PKT_SEND);
+    pkt->logTraffic(*this,TrafficLogger::PKT_SEND);
     if (pkt->flow().log_me()) {
 	if (pkt->type() == NDPACK) {
 	    abort(); //we now only pace pulls
@@ -1404,7 +1482,7 @@ void NdpPullPacer::doNextEvent(){
     if (_packet_drain_time>0)
 	drain_time = _packet_drain_time;
     else {
-	int t = (int)(drand()*_pull_spacing_cdf_count);
+	int t = (int)(_rng.uniform()*_pull_spacing_cdf_count);
 	drain_time = 10*timeFromNs(_pull_spacing_cdf[t])/20;
 	//cout << "Drain time is " << timeAsUs(drain_time);
     }
@@ -1423,25 +1501,14 @@ void NdpPullPacer::doNextEvent(){
 ////////////////////////////////////////////////////////////////
 
 NdpRtxTimerScanner::NdpRtxTimerScanner(simtime_picosec scanPeriod, EventList& eventlist)
-  : EventSource(eventlist,"RtxScanner"), 
-    _scanPeriod(scanPeriod)
+  : RtxTimerWheel(eventlist, scanPeriod, "RtxScanner")
 {
-    eventlist.sourceIsPendingRel(*this, 0);
 }
 
 void 
 NdpRtxTimerScanner::registerNdp(NdpSrc &tcpsrc)
 {
-    _tcps.push_back(&tcpsrc);
-}
-
-void
-NdpRtxTimerScanner::doNextEvent() 
-{
-    simtime_picosec now = eventlist().now();
-    tcps_t::iterator i;
-    for (i = _tcps.begin(); i!=_tcps.end(); i++) {
-	(*i)->rtx_timer_hook(now,_scanPeriod);
-    }
-    eventlist().sourceIsPendingRel(*this, _scanPeriod);
+#ifdef RESEND_ON_TIMEOUT
+    tcpsrc.rtx_timer_join(*this);
+#endif
 }
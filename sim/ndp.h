@@ -10,11 +10,15 @@
 
 #include <list>
 #include <map>
+#include <queue>
 #include "config.h"
 #include "network.h"
 #include "ndppacket.h"
 #include "fairpullqueue.h"
 #include "eventlist.h"
+#include "simcontext.h"
+#include "receive_bitmap.h"
+#include "rtx_timer.h"
 
 #define timeInf 0
 #define NDP_PACKET_SCATTER
@@ -42,7 +46,50 @@ class ReceiptEvent {
     bool _is_header;
 };
 
-class NdpSrc : public PacketSink, public EventSource {
+// When each of a source's in-flight packets was sent, by sequence
+// number.  NDP numbers packets 1, 1+mss, 1+2*mss..., so rather than a
+// map this is a window of slots, one per packet, from the oldest
+// in-flight packet to the newest, in a ring that grows as needed.
+// The earliest time comes from a heap of every time set.  Entries for
+// packets since removed or set again are left there, and dropped only
+// when they reach the top, so finding the earliest is O(log n) however
+// packets leave the window.
+class NdpSentTimes {
+ public:
+    NdpSentTimes();
+    void set_mss(uint16_t mss) {assert(empty()); _mss = mss;}
+    bool empty() const {return _count == 0;}
+    void set(NdpPacket::seq_t seqno, simtime_picosec when);
+    // removes seqno's time and returns it, or 0 if it has none
+    simtime_picosec take(NdpPacket::seq_t seqno);
+    void erase(NdpPacket::seq_t seqno) {take(seqno);}
+    // removes every packet up to and including seqno
+    void erase_upto(NdpPacket::seq_t seqno);
+    // removes every packet sent at least rto before now, and adds their
+    // sequence numbers to seqnos, in order
+    void take_due(simtime_picosec now, simtime_picosec rto, list<NdpPacket::seq_t>& seqnos);
+    // the earliest time of any packet; the window mustn't be empty
+    simtime_picosec earliest();
+ private:
+    static const simtime_picosec NONE = ~(simtime_picosec)0;
+    simtime_picosec& slot(uint64_t i) {return _slots[i & (_slots.size() - 1)];}
+    void clear(uint64_t i);
+    void grow(uint64_t lo, uint64_t hi);
+
+    typedef pair<simtime_picosec, uint64_t> entry_t; // time, packet
+    bool stale(const entry_t& e) {
+	return e.second < _lo || e.second >= _hi || slot(e.second) != e.first;
+    }
+    void compact();
+
+    vector<simtime_picosec> _slots; // a power of two of them, NONE if free
+    uint64_t _lo, _hi;  // the window: packets _lo up to but not _hi
+    uint32_t _count;
+    uint16_t _mss;
+    priority_queue<entry_t, vector<entry_t>, greater<entry_t> > _by_time;
+};
+
+class NdpSrc : public PacketSink, public EventSource, public RtxTimerClient {
     friend class NdpSink;
  public:
     NdpSrc(NdpLogger* logger, TrafficLogger* pktlogger, EventList &eventlist);
@@ -67,8 +114,10 @@ class NdpSrc : public PacketSink, public EventSource {
 
     void replace_route(Route* newroute);
 
-    virtual void rtx_timer_hook(simtime_picosec now,simtime_picosec period);
+    virtual void rtx_timer_hook(simtime_picosec now);
     void set_paths(vector<const Route*>* rt);
+    // frees the routes set_paths made, so it can be called again
+    void clear_paths();
 
     // should really be private, but loggers want to see:
     uint64_t _highest_sent;  //seqno is in bytes
@@ -102,8 +151,8 @@ class NdpSrc : public PacketSink, public EventSource {
     vector <int32_t> _avoid_ratio; //keeps path scores
     vector <int32_t> _avoid_score; //keeps path scores
 
-    map<NdpPacket::seq_t, simtime_picosec> _sent_times;
-    map<NdpPacket::seq_t, simtime_picosec> _first_sent_times;
+    NdpSentTimes _sent_times;
+    NdpSentTimes _first_sent_times;
 
     void print_stats();
 
@@ -127,6 +176,10 @@ class NdpSrc : public PacketSink, public EventSource {
     NdpSink* _sink;
  
     simtime_picosec _rtx_timeout;
+    void set_rtx_timeout(simtime_picosec when) {
+	_rtx_timeout = when;
+	rtx_timer_arm(when);
+    }
     bool _rtx_timeout_pending;
     const Route* _route;
 
@@ -142,11 +195,8 @@ class NdpSrc : public PacketSink, public EventSource {
     void log_me();
     bool _log_me;
 
-    static uint32_t _global_rto_count;  // keep track of the total number of timeouts across all srcs
     static simtime_picosec _min_rto;
     static RouteStrategy _route_strategy;
-    static int _global_node_count;
-    static int _rtt_hist[10000000];
     int _node_num;
 
  private:
@@ -155,6 +205,8 @@ class NdpSrc : public PacketSink, public EventSource {
     TrafficLogger* _pktlogger;
     // Connectivity
     PacketFlow _flow;
+    int* _rtt_hist; // the running SimContext's, once we've an RTT for it
+    Rng _rng; // for path choices and RTO jitter
     string _nodename;
 
     enum  FeedbackType {ACK, NACK, BOUNCE, UNKNOWN};
@@ -192,14 +244,14 @@ class NdpSink : public PacketSink, public DataReceiver, public Logged {
     void receivePacket(Packet& pkt);
     NdpAck::seq_t _cumulative_ack; // the packet we have cumulatively acked
     uint32_t _drops;
-    uint64_t cumulative_ack() { return _cumulative_ack + _received.size()*9000;}
+    uint64_t cumulative_ack() { return _cumulative_ack + _received.bytes();}
     uint64_t total_received() const { return _total_received;}
     uint32_t drops(){ return _src->_drops;}
     virtual const string& nodename() { return _nodename; }
     void increase_window() {_pull_no++;} 
     static void setRouteStrategy(RouteStrategy strat) {_route_strategy = strat;}
 
-    list<NdpAck::seq_t> _received; // list of packets above a hole, that we've received
+    ReceiveBitmap _received; // packets above a hole, that we've received
  
     NdpSrc* _src;
 
@@ -208,6 +260,10 @@ class NdpSink : public PacketSink, public DataReceiver, public Logged {
     bool _log_me;
 
     void set_paths(vector<const Route*>* rt);
+    // frees the routes set_paths made, so it can be called again
+    void clear_paths();
+    // for a sink moved to another host
+    void set_pacer(NdpPullPacer* pacer) {_pacer = pacer;}
 
 #ifdef RECORD_PATH_LENS
 #define MAX_PATH_LEN 20
@@ -258,6 +314,7 @@ class NdpSink : public PacketSink, public DataReceiver, public Logged {
     int _path_hist_index; //index of last entry to be added to _path_history
     int _path_hist_first; //index of oldest entry added to _path_history
     int _no_of_paths;
+    Rng _rng; // for path choices
 };
 
 class NdpPullPacer : public EventSource {
@@ -278,6 +335,8 @@ class NdpPullPacer : public EventSource {
     bool _log_me;
 
     void set_preferred_flow(int id) { _preferred_flow = id;cout << "Preferring flow "<< id << endl;};
+    // the flow gets weight pulls for every one another flow gets
+    void set_flow_weight(int flow_id, uint32_t weight) {_pull_queue.set_flow_weight(flow_id, weight);}
 
  private:
     void set_pacerno(Packet *pkt, NdpPull::seq_t pacer_no);
@@ -294,6 +353,7 @@ class NdpPullPacer : public EventSource {
     //pull distribution from real life
     static int _pull_spacing_cdf_count;
     static double* _pull_spacing_cdf;
+    Rng _rng; // for sampling _pull_spacing_cdf
 
     //debugging
     double _total_excess;
@@ -302,15 +362,14 @@ class NdpPullPacer : public EventSource {
 };
 
 
-class NdpRtxTimerScanner : public EventSource {
+// Keeps the retransmission timers of the sources registered with it.
+// Timers fire when due; a source not ready for its timeout yet is
+// asked again each scanPeriod.  Without RESEND_ON_TIMEOUT sources
+// never act on a timeout, so they aren't registered at all.
+class NdpRtxTimerScanner : public RtxTimerWheel {
  public:
     NdpRtxTimerScanner(simtime_picosec scanPeriod, EventList& eventlist);
-    void doNextEvent();
     void registerNdp(NdpSrc &tcpsrc);
- private:
-    simtime_picosec _scanPeriod;
-    typedef list<NdpSrc*> tcps_t;
-    tcps_t _tcps;
 };
 
 #endif
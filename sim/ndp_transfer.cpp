@@ -10,9 +10,11 @@
 int CDF_WEB [] = {250,500,1000,1500,2000,3000,4000,10000,100000,1000000};
 
 
-NdpSrcTransfer::NdpSrcTransfer(NdpLogger* logger, TrafficLogger* pktLogger, EventList &eventlist) : NdpSrc(logger,pktLogger,eventlist)
+NdpSrcTransfer::NdpSrcTransfer(NdpLogger* logger, TrafficLogger* pktLogger, EventList &eventlist,
+			       FlowStopped* stopped) : NdpSrc(logger,pktLogger,eventlist)
 {
   _is_active = false;
+  _flow_stopped = stopped;
 
   _bytes_to_send = generateFlowSize();
 
@@ -21,6 +23,9 @@ NdpSrcTransfer::NdpSrcTransfer(NdpLogger* logger, TrafficLogger* pktLogger, Even
 
 void NdpSrcTransfer::reset(uint64_t bb, int shouldRestart){
   //reset here!
+  // packets the last transfer never heard back about aren't ours now
+  _sent_times.erase_upto(_highest_sent);
+  _first_sent_times.erase_upto(_highest_sent);
   _bytes_to_send = bb;
   set_flowsize(_bytes_to_send);
 
@@ -66,27 +71,30 @@ NdpSrcTransfer::receivePacket(Packet& pkt){
 
 	cout << endl << "Flow " << str() << " " <<  _bytes_to_send << " finished after " << timeAsMs(eventlist().now()-_started) << endl;
 
-	reset(generateFlowSize(),1);
+	if (_flow_stopped)
+	  _flow_stopped->flowStopped();
+	else
+	  reset(generateFlowSize(),1);
       }
     }
   }
   else {
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+    pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
     pkt.free();
   }
 }
 
-void NdpSrcTransfer::rtx_timer_hook(simtime_picosec now, simtime_picosec period) {
+void NdpSrcTransfer::rtx_timer_hook(simtime_picosec now) {
   if (!_is_active) return;
 
   // FIXME
-  if (now <= _rtx_timeout || _rtx_timeout==timeInf) return;
+  if (now < _rtx_timeout || _rtx_timeout==timeInf) return;
 
   if (_highest_sent == 0) return;
 
   cout << "Transfer timeout: active " << _is_active << " bytes to send " << _bytes_to_send << " sent " << _last_acked << endl;
   
-  NdpSrc::rtx_timer_hook(now,period);
+  NdpSrc::rtx_timer_hook(now);
 }
 
 ////////////////////////////////////////////////////////////////
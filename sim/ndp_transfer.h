@@ -20,10 +20,11 @@ class NdpSinkTransfer;
 
 class NdpSrcTransfer: public NdpSrc {
 public:
-	NdpSrcTransfer(NdpLogger* logger, TrafficLogger* pktLogger, EventList &eventlist);
+	NdpSrcTransfer(NdpLogger* logger, TrafficLogger* pktLogger, EventList &eventlist,
+		       FlowStopped* stopped = NULL);
 	void connect(route_t& routeout, route_t& routeback, NdpSink& sink, simtime_picosec starttime);
 
-	virtual void rtx_timer_hook(simtime_picosec now,simtime_picosec period);
+	virtual void rtx_timer_hook(simtime_picosec now);
 	virtual void receivePacket(Packet& pkt);
 	void reset(uint64_t bb, int rs);
 	virtual void doNextEvent();
@@ -36,7 +37,7 @@ public:
 	bool _is_active;
 	simtime_picosec _started;
 	vector<route_t*>* _paths;
-	EventSource* _flow_stopped;
+	FlowStopped* _flow_stopped;
 };
 
 class NdpSinkTransfer : public NdpSink {
@@ -75,12 +75,12 @@ class NdpPacket : public Packet {
     seq_t _seqno;
     seq_t _pacerno;  // the pacer sequence number from the pull, seq space is common to all flows on that pacer
     simtime_picosec _ts;
-    bool _retransmitted;
     int32_t _no_of_paths;  // how many paths are in the sender's
 			    // list.  A real implementation would not
 			    // send this in every packet, but this is
 			    // simulation, and this is easiest to
 			    // implement
+    bool _retransmitted;
     bool _last_packet;  // set to true in the last packet in a flow.
     static PacketDB<NdpPacket> _packetdb;
 };
@@ -126,9 +126,9 @@ class NdpAck : public Packet {
     seq_t _ackno;
     seq_t _cumulative_ack;
     simtime_picosec _ts;
-    bool _pull;
     seq_t _pullno;
     int32_t _path_id; //see comment in NdpPull
+    bool _pull;
     static PacketDB<NdpAck> _packetdb;
 };
 
@@ -175,9 +175,9 @@ class NdpNack : public Packet {
     seq_t _ackno;
     seq_t _cumulative_ack;
     simtime_picosec _ts;
-    bool _pull;
     seq_t _pullno;
     int32_t _path_id;
+    bool _pull;
     static PacketDB<NdpNack> _packetdb;
 };
 
@@ -224,6 +224,9 @@ class NdpPull : public Packet {
     inline seq_t cumulative_ack() const {return _cumulative_ack;}
     inline seq_t pullno() const {return _pullno;}
     int32_t path_id() const {return _path_id;}
+    // pulls waiting at a pacer are linked per flow (see fairpullqueue.h)
+    inline NdpPull* next_pull() const {return _next_pull;}
+    inline void set_next_pull(NdpPull* next) {_next_pull = next;}
   
     virtual ~NdpPull(){}
 
@@ -233,6 +236,7 @@ class NdpPull : public Packet {
     seq_t _cumulative_ack;
     seq_t _pullno;
     int32_t _path_id; // indicates ??
+    NdpPull* _next_pull;
     static PacketDB<NdpPull> _packetdb;
 };
 
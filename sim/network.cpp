@@ -1,15 +1,13 @@
 // -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-    
 #include "network.h"
-
-#define DEFAULTDATASIZE 1500
-int Packet::_data_packet_size = DEFAULTDATASIZE;
-bool Packet::_packet_size_fixed = false;
+#include <cstdio>
 
 // use set_attrs only when we want to do a late binding of the route -
 // otherwise use set_route or set_rg
 void 
 Packet::set_attrs(PacketFlow& flow, int pkt_size, packetid_t id){
     _flow = &flow;
+    _flow_id = flow.flow_id();
     _size = pkt_size;
     _id = id;
     _nexthop = 0;
@@ -22,6 +20,7 @@ void
 Packet::set_route(PacketFlow& flow, const Route &route, int pkt_size, 
 	    packetid_t id){
     _flow = &flow;
+    _flow_id = flow.flow_id();
     _size = pkt_size;
     _id = id;
     _nexthop = 0;
@@ -42,9 +41,9 @@ Packet::sendOn() {
 	if (_bounced) {
 	    assert(_nexthop > 0);
 	    assert(_nexthop < _route->size());
-	    assert(_nexthop < _route->reverse()->size());
+	    assert(_nexthop < _route->reverse_size());
 	    //assert(_route->size() == _route->reverse()->size());
-	    nextsink = _route->reverse()->at(_nexthop);
+	    nextsink = _route->reverse_at(_nexthop);
 	    _nexthop++;
 	} else {
 	    assert(_nexthop<_route->size());
@@ -65,9 +64,9 @@ Packet::sendOn2(VirtualQueue* crtSink) {
 	if (_bounced) {
 	    assert(_nexthop > 0);
 	    assert(_nexthop < _route->size());
-	    assert(_nexthop < _route->reverse()->size());
+	    assert(_nexthop < _route->reverse_size());
 	    //assert(_route->size() == _route->reverse()->size());
-	    nextsink = _route->reverse()->at(_nexthop);
+	    nextsink = _route->reverse_at(_nexthop);
 	    _nexthop++;
 	} else {
 	    assert(_nexthop<_route->size());
@@ -162,13 +161,11 @@ Packet::str() const {
     return s;
 }
 
-uint32_t PacketFlow::_max_flow_id = 0;
-
 PacketFlow::PacketFlow(TrafficLogger* logger)
     : Logged("PacketFlow"),
       _logger(logger)
 {
-    _flow_id = _max_flow_id++;
+    _flow_id = SimContext::current().next_flow_id();
 }
 
 void PacketFlow::set_logger(TrafficLogger *logger) {
@@ -191,4 +188,59 @@ void print_route(const Route& route) {
     cout << endl;
 }
 
-Logged::id_t Logged::LASTIDNUM = 1;
+Logged::Logged(const string& name)
+    : _literal_name(false), _name(new string(name))
+{
+    _name_key.format = NULL;
+    id = SimContext::current().next_logged_id();
+}
+
+Logged::Logged(const char* name)
+    : _literal_name(true), _name(NULL)
+{
+    _name_key.format = name;
+    id = SimContext::current().next_logged_id();
+}
+
+Logged::Logged(const Logged& o)
+    : id(o.id), _literal_name(o._literal_name),
+      _name(o._name ? new string(*o._name) : NULL), _name_key(o._name_key)
+{
+}
+
+Logged&
+Logged::operator=(const Logged& o) {
+    if (this != &o) {
+	id = o.id;
+	copyName(o);
+    }
+    return *this;
+}
+
+void
+Logged::copyName(const Logged& o) {
+    if (o._name)
+	setString(*o._name);
+    else {
+	delete _name;
+	_name = NULL;
+    }
+    _literal_name = o._literal_name;
+    _name_key = o._name_key;
+}
+
+void
+Logged::formatName() {
+    if (_literal_name) {
+	_name = new string(_name_key.format);
+	return;
+    }
+    setName(_name_key.str());
+}
+
+string
+name_key::str() const {
+    char buf[256];
+    snprintf(buf, sizeof(buf), format, args[0], args[1], args[2]);
+    return buf;
+}
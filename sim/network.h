@@ -7,6 +7,8 @@
 #include "config.h"
 #include "loggertypes.h"
 #include "route.h"
+#include "simcontext.h"
+#include "packetdb.h"
 
 class Packet;
 class PacketFlow;
@@ -33,7 +35,6 @@ class PacketFlow : public Logged {
     inline uint32_t flow_id() const {return _flow_id;}
     bool log_me() const {return _logger != NULL;}
  protected:
-    static uint32_t _max_flow_id;
     uint32_t _flow_id;
     TrafficLogger* _logger;
 };
@@ -67,14 +68,12 @@ class Packet {
 	// before the value has been used to initialize anything else.
 	// If someone has already read the value of packet size, no
 	// longer allow it to be changed, or all hell will break
-	// loose.
-	assert(_packet_size_fixed == false);
-	_data_packet_size = packet_size;
+	// loose.  It's kept per simulation, in the current SimContext.
+	SimContext::current().set_packet_size(packet_size);
     }
 
     static int data_packet_size() {
-	_packet_size_fixed = true;
-	return _data_packet_size;
+	return SimContext::current().data_packet_size();
     }
 
     virtual PacketSink* sendOn(); // "go on to the next hop along your route"
@@ -88,9 +87,15 @@ class Packet {
     bool header_only() const {return _is_header;}
     bool bounced() const {return _bounced;}
     PacketFlow& flow() const {return *_flow;}
+    // Log ev at location if this packet's flow is being logged
+    inline void logTraffic(Logged& location, TrafficLogger::TrafficEvent ev) {
+	_flow->logTraffic(*this, location, ev);
+    }
     virtual ~Packet() {};
     inline const packetid_t id() const {return _id;}
-    inline uint32_t flow_id() const {return _flow->flow_id();}
+    // a copy of flow().flow_id(), so queues that sort packets by flow
+    // needn't touch the flow, which lives with its sender
+    inline uint32_t flow_id() const {return _flow_id;}
     const Route* route() const {return _route;}
     const Route* reverse_route() const {return _route->reverse();}
 
@@ -114,26 +119,24 @@ class Packet {
 	     int pkt_size, packetid_t id);
     void set_attrs(PacketFlow& flow, int pkt_size, packetid_t id);
 
-    static int _data_packet_size; // default size of a TCP or NDP data packet,
-				  // measured in bytes
-    static bool _packet_size_fixed; //prevent foot-shooting
-    
-    packet_type _type;
-    
-    uint16_t _size;
-    bool _is_header;
-    bool _bounced; // packet has hit a full queue, and is being bounced back to the sender
-    uint32_t _flags; // used for ECN & friends
+    // Laid out largest first, so there's no padding: with the
+    // vtable pointer this is 48 bytes, and subclasses should keep
+    // their own fields packed the same way.
 
     // A packet can contain a route or a routegraph, but not both.
     // Eventually switch over entirely to RouteGraph?
     const Route* _route;
-    uint32_t _nexthop;
-
-    packetid_t _id;
     PacketFlow* _flow;
-    uint32_t _path_len; // length of the path in hops - used in BCube priority routing with NDP
+    uint32_t _flow_id;
+    packetid_t _id;
+    uint32_t _flags; // used for ECN & friends
 
+    uint16_t _nexthop;
+    uint16_t _path_len; // length of the path in hops - used in BCube priority routing with NDP
+    uint16_t _size;
+    uint8_t _type; // a packet_type
+    bool _is_header;
+    bool _bounced; // packet has hit a full queue, and is being bounced back to the sender
     bool _first_rtt;    // used with Aeolus 
 };
 
@@ -148,31 +151,13 @@ class PacketSink {
     virtual const string& nodename()=0;
 };
 
-
-// For speed, it may be useful to keep a database of all packets that
-// have been allocated -- that way we don't need a malloc for every
-// new packet, we can just reuse old packets. Care, though -- the set()
-// method will need to be invoked properly for each new/reused packet
-
-template<class P>
-class PacketDB {
+// Told by a source that runs one transfer after another, such as
+// TcpSrcTransfer, each time a transfer finishes, instead of the source
+// starting the next itself.
+class FlowStopped {
  public:
-    P* allocPacket() {
-	if (_freelist.empty()) {
-	    return new P();
-	} else {
-	    P* p = _freelist.back();
-	    _freelist.pop_back();
-	    return p;
-	}
-    };
-    void freePacket(P* pkt) {
-	_freelist.push_back(pkt);
-    };
-
- protected:
-    vector<P*> _freelist; // Irek says it's faster with vector than with list
+    virtual ~FlowStopped() {}
+    virtual void flowStopped() = 0;
 };
 
-
 #endif
@@ -0,0 +1,68 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "packetdb.h"
+#include <iomanip>
+#include <cxxabi.h>
+
+static size_t high_water = 0;
+
+// made on first use, as the pools register themselves during static
+// initialisation
+static vector<PacketPools::Pool*>&
+pools()
+{
+    static vector<PacketPools::Pool*> _pools;
+    return _pools;
+}
+
+PacketPools::Pool::Pool()
+{
+    pools().push_back(this);
+}
+
+double
+PacketPools::Pool::now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void
+PacketPools::setHighWater(size_t packets)
+{
+    // applies to threads that haven't used a pool yet, so set it
+    // before the simulation starts
+    high_water = packets;
+}
+
+size_t
+PacketPools::highWater()
+{
+    return high_water;
+}
+
+void
+PacketPools::report(ostream& out)
+{
+    out << left << setw(16) << "# packet pool" << right
+	<< setw(7) << "bytes" << setw(12) << "allocs" << setw(10) << "live"
+	<< setw(10) << "peak" << setw(8) << "slabs" << setw(8) << "peak"
+	<< setw(9) << "trimmed" << setw(10) << "MB" << setw(14) << "allocs/s" << endl;
+    for (size_t i = 0; i < pools().size(); i++) {
+	packet_pool_stats s = pools()[i]->stats();
+	if (s.allocs == 0)
+	    continue;
+	int status;
+	char* name = abi::__cxa_demangle(s.type.c_str(), NULL, NULL, &status);
+	if (status == 0) {
+	    s.type = name;
+	    free(name);
+	}
+	out << left << setw(16) << s.type << right
+	    << setw(7) << s.packet_bytes << setw(12) << s.allocs << setw(10) << s.live
+	    << setw(10) << s.peak_live << setw(8) << s.slabs << setw(8) << s.peak_slabs
+	    << setw(9) << s.trimmed
+	    << setw(10) << fixed << setprecision(2) << s.slabs * PACKET_SLAB_SIZE * s.packet_bytes / 1e6
+	    << setw(14) << setprecision(0) << (s.seconds > 0 ? s.allocs / s.seconds : 0) << endl;
+    }
+}
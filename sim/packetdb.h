@@ -0,0 +1,226 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef PACKETDB_H
+#define PACKETDB_H
+
+/*
+ * Packet pools.  Each packet class keeps a PacketDB, and never news or
+ * deletes packets itself: allocPacket() hands out a packet that may
+ * have been used before, so the class's newpkt() must set every field,
+ * and free() gives it back with freePacket().
+ *
+ * Packets are made PACKET_SLAB_SIZE at a time in contiguous slabs.
+ * Each thread keeps its own cache of free packets, so the partitions
+ * of a parallel run (see pdes.h) allocate and free without locking,
+ * and a thread's slabs are first touched, and so placed in memory, by
+ * the thread that uses them.  A packet freed by a different thread
+ * than allocated it simply joins the freeing thread's cache.
+ *
+ * Left alone, a pool keeps every packet it has ever made, as peak
+ * demand is likely to come round again.  With a high-water mark set
+ * (PacketPools::setHighWater), a thread whose cache grows well past
+ * the mark gives back any slab all of whose packets are in its cache.
+ *
+ * PacketPools::report prints how many packets of each type are live,
+ * the peak, the slabs held and the allocation rate.
+ */
+
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <iostream>
+#include <typeinfo>
+#include <time.h>
+#include "config.h"
+
+#define PACKET_SLAB_SIZE 256 // packets made at a time
+
+struct packet_pool_stats {
+    string type;
+    size_t packet_bytes;
+    uint64_t allocs;     // allocPacket calls
+    uint64_t live;       // allocated and not yet freed
+    uint64_t peak_live;  // exact with one thread; with several, the
+			 // sum of each thread's peak
+    uint64_t slabs;      // held now
+    uint64_t peak_slabs;
+    uint64_t trimmed;    // slabs given back
+    double seconds;      // since the pool first made a packet
+};
+
+class PacketPools {
+ public:
+    // free packets a thread may cache per type before it tries to
+    // give slabs back; 0 (the default) never gives anything back
+    static void setHighWater(size_t packets);
+    static size_t highWater();
+    static void report(ostream& out);
+
+    // what the pools have in common
+    class Pool {
+    public:
+	Pool();
+	virtual ~Pool() {}
+	virtual packet_pool_stats stats() = 0;
+    protected:
+	static double now();
+    };
+};
+
+template<class P>
+class PacketDB : public PacketPools::Pool {
+ public:
+    PacketDB() : _peak_slabs(0), _trimmed(0), _start(0),
+		 _retired_allocs(0), _retired_frees(0), _retired_peak(0) {}
+
+    P* allocPacket() {
+	cache_t& c = cache();
+	if (c.free.empty())
+	    refill(c);
+	P* p = c.free.back();
+	c.free.pop_back();
+	c.allocs++;
+	if (c.allocs - c.frees > c.peak_live)
+	    c.peak_live = c.allocs - c.frees;
+	return p;
+    }
+
+    void freePacket(P* pkt) {
+	cache_t& c = cache();
+	c.free.push_back(pkt);
+	c.frees++;
+	if (c.trim_at && c.free.size() > c.trim_at)
+	    trim(c);
+    }
+
+    // exact only while no other thread is using the pool
+    packet_pool_stats stats() {
+	std::lock_guard<std::mutex> guard(_lock);
+	packet_pool_stats s;
+	s.type = typeid(P).name();
+	s.packet_bytes = sizeof(P);
+	uint64_t frees = _retired_frees;
+	s.allocs = _retired_allocs;
+	s.peak_live = _retired_peak;
+	for (size_t i = 0; i < _caches.size(); i++) {
+	    s.allocs += _caches[i]->allocs;
+	    frees += _caches[i]->frees;
+	    s.peak_live += _caches[i]->peak_live;
+	}
+	// counts are per thread, so with packets freed by another
+	// thread than allocated them, live can only be had in total
+	s.live = s.allocs - frees;
+	s.slabs = _slabs.size();
+	s.peak_slabs = _peak_slabs;
+	s.trimmed = _trimmed;
+	s.seconds = _start ? now() - _start : 0;
+	return s;
+    }
+
+ private:
+    struct cache_t {
+	cache_t() : allocs(0), frees(0), peak_live(0), trim_at(0) {}
+	vector<P*> free;
+	uint64_t allocs;
+	uint64_t frees;
+	uint64_t peak_live;
+	size_t trim_at;  // try to give slabs back above this; 0 never
+    };
+
+    // Hands a thread's cache back when the thread exits: its free
+    // packets go to the pool's spare list and its counts into the
+    // totals.
+    struct cache_holder {
+	cache_holder(PacketDB* db) : _db(db), _cache(db->attach()) {}
+	~cache_holder() {_db->retire(_cache);}
+	PacketDB* _db;
+	cache_t* _cache;
+    };
+
+    cache_t& cache() {
+	static thread_local cache_holder holder(this);
+	assert(holder._db == this); // one PacketDB per packet class
+	return *holder._cache;
+    }
+
+    cache_t* attach() {
+	std::lock_guard<std::mutex> guard(_lock);
+	cache_t* c = new cache_t();
+	size_t high = PacketPools::highWater();
+	c->trim_at = high ? 2 * high : 0;
+	_caches.push_back(c);
+	return c;
+    }
+
+    void retire(cache_t* c) {
+	std::lock_guard<std::mutex> guard(_lock);
+	_spare.insert(_spare.end(), c->free.begin(), c->free.end());
+	_retired_allocs += c->allocs;
+	_retired_frees += c->frees;
+	_retired_peak += c->peak_live;
+	_caches.erase(find(_caches.begin(), _caches.end(), c));
+	delete c;
+    }
+
+    // the cache is empty: take what other threads left behind, or
+    // make a new slab
+    void refill(cache_t& c) {
+	std::lock_guard<std::mutex> guard(_lock);
+	if (!_spare.empty()) {
+	    c.free.swap(_spare);
+	    return;
+	}
+	if (!_start)
+	    _start = now();
+	P* slab = new P[PACKET_SLAB_SIZE];
+	_slabs.insert(upper_bound(_slabs.begin(), _slabs.end(), slab), slab);
+	if (_slabs.size() > _peak_slabs)
+	    _peak_slabs = _slabs.size();
+	// handed out lowest address first
+	for (int i = PACKET_SLAB_SIZE - 1; i >= 0; i--)
+	    c.free.push_back(&slab[i]);
+    }
+
+    // Give back every slab whose packets are all in this cache.
+    // Sorting by address puts each slab's free packets together.
+    void trim(cache_t& c) {
+	std::lock_guard<std::mutex> guard(_lock);
+	sort(c.free.begin(), c.free.end());
+	vector<P*> kept;
+	size_t i = 0;
+	while (i < c.free.size()) {
+	    // the slab this packet is in: the last one starting at or
+	    // before it
+	    P* slab = *(upper_bound(_slabs.begin(), _slabs.end(), c.free[i]) - 1);
+	    size_t j = i;
+	    while (j < c.free.size() && c.free[j] < slab + PACKET_SLAB_SIZE)
+		j++;
+	    if (j - i == PACKET_SLAB_SIZE) {
+		_slabs.erase(lower_bound(_slabs.begin(), _slabs.end(), slab));
+		delete[] slab;
+		_trimmed++;
+	    } else {
+		kept.insert(kept.end(), c.free.begin() + i, c.free.begin() + j);
+	    }
+	    i = j;
+	}
+	// reuse the lowest addresses first, keeping the packets in use
+	// packed into as few slabs as we can
+	reverse(kept.begin(), kept.end());
+	c.free.swap(kept);
+	// don't sort again until there's much more to gain
+	c.trim_at = max(2 * PacketPools::highWater(), 2 * c.free.size());
+    }
+
+    std::mutex _lock;       // for everything below
+    vector<P*> _slabs;      // sorted by address
+    uint64_t _peak_slabs;
+    uint64_t _trimmed;
+    double _start;
+    vector<cache_t*> _caches;
+    vector<P*> _spare;      // left by threads that have exited
+    uint64_t _retired_allocs;
+    uint64_t _retired_frees;
+    uint64_t _retired_peak;
+};
+
+#endif
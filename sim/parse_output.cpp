@@ -233,6 +233,9 @@ int main(int argc, char** argv){
 	    case Logger::NDP_SINK: //18
 		cout << NdpSinkLoggerSampling::event_to_str(event) << endl;
 		break;
+	    case Logger::SHARED_BUFFER: //20
+		cout << SwitchBufferLoggerSampling::event_to_str(event) << endl;
+		break;
 	    }
 	} else {
 	    if ((typeRec[i]==(uint32_t)TYPE || TYPE==-1) 
@@ -0,0 +1,197 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "pdes.h"
+#include <thread>
+
+#define NO_EVENT ((simtime_picosec)-1)
+
+CrossPipe::CrossPipe(simtime_picosec delay, ParallelEngine& engine, int from, int to)
+    : Pipe(delay, engine.partition(to)),
+      _engine(engine), _upstream(engine.partition(from)), _from(from), _to(to)
+{
+    // a shared delay line runs on the downstream clock, which we
+    // can't read from the upstream partition
+    _line = NULL;
+}
+
+void
+CrossPipe::receivePacket(Packet& pkt)
+{
+    pkt.logTraffic(*this,TrafficLogger::PKT_ARRIVE);
+    ParallelEngine::crossing_t c = {_upstream.now() + delay(), this, &pkt};
+    _engine.send(_from, _to, c);
+}
+
+ParallelEngine::ParallelEngine(EventList& global, int partitions)
+    : _global(global), _context(SimContext::current()), _lookahead(NO_EVENT),
+      _window_end(0), _done(false), _barrier_count(0), _barrier_generation(0)
+{
+    assert(partitions > 0);
+    for (int p = 0; p < partitions; p++) {
+	_partitions.push_back(new EventList(global.scheduler()));
+	_partitions[p]->setEndtime(global.endtime());
+    }
+    for (int i = 0; i < partitions * partitions; i++)
+	_channels.push_back(new SpscQueue<crossing_t>());
+    _random_state.resize(partitions);
+    seedRandom(1);
+}
+
+ParallelEngine::~ParallelEngine()
+{
+    for (size_t i = 0; i < _channels.size(); i++)
+	delete _channels[i];
+    for (size_t p = 0; p < _partitions.size(); p++)
+	delete _partitions[p];
+}
+
+void
+ParallelEngine::setEndtime(simtime_picosec endtime)
+{
+    for (size_t p = 0; p < _partitions.size(); p++)
+	_partitions[p]->setEndtime(endtime);
+    _global.setEndtime(endtime);
+}
+
+void
+ParallelEngine::seedRandom(unsigned int seed)
+{
+    for (size_t p = 0; p < _partitions.size(); p++)
+	_random_state[p] = seed + 0x9e3779b9u * (unsigned int)(p + 1);
+    _global_random_state = seed;
+}
+
+Pipe*
+ParallelEngine::makePipe(simtime_picosec delay, int from, int to)
+{
+    if (from == to)
+	return new Pipe(delay, partition(to));
+
+    // a zero-delay cut would leave us no lookahead at all
+    assert(delay > 0);
+    if (delay < _lookahead)
+	_lookahead = delay;
+    return new CrossPipe(delay, *this, from, to);
+}
+
+// Hand partition p everything sent to it during the last window.
+// Everything sent in a window leaves its pipe at or after the end of
+// that window, so it's never in p's past.
+void
+ParallelEngine::deliver(int p)
+{
+    crossing_t c;
+    for (size_t from = 0; from < _partitions.size(); from++) {
+	SpscQueue<crossing_t>& q = channel(from, p);
+	while (q.pop(c))
+	    c.pipe->schedule(c.departure, c.pkt);
+    }
+}
+
+// Run any observer events due before the partitions' next event, then
+// pick the end of the next window.  Returns false when there's
+// nothing left to run.
+bool
+ParallelEngine::next_window()
+{
+    LogBuffer::flush(_log_buffers);
+    setThreadRandomState(&_global_random_state);
+    while (true) {
+	simtime_picosec next = NO_EVENT;
+	for (size_t p = 0; p < _partitions.size(); p++)
+	    if (!_partitions[p]->empty() && _partitions[p]->nextEventTime() < next)
+		next = _partitions[p]->nextEventTime();
+	simtime_picosec global_next = _global.empty() ? NO_EVENT : _global.nextEventTime();
+
+	if (global_next != NO_EVENT && global_next <= next) {
+	    // every partition has finished everything before
+	    // global_next, so the observers see a consistent state
+	    while (!_global.empty() && _global.nextEventTime() == global_next)
+		_global.doNextEvent();
+	    continue;
+	}
+	if (next == NO_EVENT)
+	    return false;
+
+	_window_end = next + _lookahead;
+	if (_window_end < next) // no cut links at all
+	    _window_end = NO_EVENT;
+	if (global_next < _window_end)
+	    _window_end = global_next;
+	return true;
+    }
+}
+
+void
+ParallelEngine::barrier(int threads)
+{
+    if (threads == 1)
+	return;
+    int generation = _barrier_generation.load(std::memory_order_acquire);
+    if (_barrier_count.fetch_add(1, std::memory_order_acq_rel) == threads - 1) {
+	_barrier_count.store(0, std::memory_order_relaxed);
+	_barrier_generation.fetch_add(1, std::memory_order_release);
+    } else {
+	while (_barrier_generation.load(std::memory_order_acquire) == generation)
+	    std::this_thread::yield();
+    }
+}
+
+// Thread 'id' owns partitions id, id+threads, id+2*threads...
+void
+ParallelEngine::worker(int id, int threads)
+{
+    SimContext::Use use(_context);
+    int n = _partitions.size();
+    while (true) {
+	if (id == 0)
+	    _done = !next_window();
+	barrier(threads);
+	if (_done)
+	    break;
+
+	for (int p = id; p < n; p += threads) {
+	    SimContext::Use partition_context(*_contexts[p]);
+	    setThreadRandomState(&_random_state[p]);
+	    _partitions[p]->runUntil(_window_end);
+	}
+	barrier(threads);
+
+	for (int p = id; p < n; p += threads)
+	    deliver(p);
+	barrier(threads);
+    }
+    setThreadRandomState(NULL);
+}
+
+void
+ParallelEngine::run(int threads)
+{
+    if (threads < 1)
+	threads = 1;
+    if (threads > (int)_partitions.size())
+	threads = _partitions.size();
+
+    int n = _partitions.size();
+    for (int p = 0; p < n; p++) {
+	_contexts.push_back(new SimContext(_context, p, n));
+	_log_buffers.push_back(new LogBuffer(*_partitions[p]));
+	_contexts[p]->set_log_buffer(_log_buffers[p]);
+    }
+
+    vector<std::thread> pool;
+    for (int t = 1; t < threads; t++)
+	pool.push_back(std::thread(&ParallelEngine::worker, this, t, threads));
+    worker(0, threads);
+    for (size_t t = 0; t < pool.size(); t++)
+	pool[t].join();
+
+    // the last window's records were written when worker 0 found
+    // there was nothing left to run
+    for (int p = 0; p < n; p++) {
+	_context.merge(*_contexts[p]);
+	delete _contexts[p];
+	delete _log_buffers[p];
+    }
+    _contexts.clear();
+    _log_buffers.clear();
+}
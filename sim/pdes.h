@@ -0,0 +1,117 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef PDES_H
+#define PDES_H
+
+/*
+ * A conservative parallel engine.  The network is split into
+ * partitions (typically one per pod), each with its own EventList,
+ * and the only links between partitions are CrossPipes.  A packet
+ * entering a CrossPipe at time t can't affect the far side before
+ * t + delay, so with the smallest CrossPipe delay as the lookahead L,
+ * every partition can safely run all its events in [T, T+L) at the
+ * same time as the others, where T is the earliest pending event
+ * anywhere (YAWNS-style synchronous windows).  Packets crossing
+ * partitions are handed over through lock-free single-producer
+ * single-consumer queues, and delivered at the end of each window.
+ *
+ * The outcome depends only on the partitioning, never on the number
+ * of threads: windows are computed from the partitions' own event
+ * times, crossings are delivered in (source partition, send order),
+ * and components draw from their own random streams (see Rng).  Code
+ * still using simrandom()/drand() gets a stream per partition.
+ *
+ * Each partition also runs in a SimContext of its own, a child of the
+ * one the engine was built in, so partitions never share its state:
+ * objects made while running take ids from disjoint sequences, each
+ * partition counts its own statistics, and the records it logs wait
+ * in its own buffer.  When the partitions stop at the end of each
+ * window the buffers are written to the logfiles in time order, and
+ * when the run ends the statistics are added to the parent context.
+ *
+ * Event sources that only observe the model (loggers, Clock) stay on
+ * the global eventlist the engine is built around.  Its events run
+ * while every partition is stopped at exactly that simulated time, so
+ * they see a consistent snapshot; they must not send packets.
+ */
+
+#include <vector>
+#include <atomic>
+#include "config.h"
+#include "eventlist.h"
+#include "pipe.h"
+#include "spscqueue.h"
+#include "simcontext.h"
+#include "logfile.h"
+
+class ParallelEngine;
+
+// The pipe on a link whose ends are in different partitions.  It's
+// fed by the upstream partition and drains into the downstream one.
+class CrossPipe : public Pipe {
+    friend class ParallelEngine;
+ public:
+    void receivePacket(Packet& pkt); // inherited from PacketSink
+ private:
+    CrossPipe(simtime_picosec delay, ParallelEngine& engine, int from, int to);
+
+    ParallelEngine& _engine;
+    EventList& _upstream;
+    int _from, _to;
+};
+
+class ParallelEngine {
+    friend class CrossPipe;
+ public:
+    // the partitions inherit global's scheduler and end time, and
+    // the workers run in the SimContext current when it's built
+    ParallelEngine(EventList& global, int partitions);
+    ~ParallelEngine();
+
+    int partitions() const {return _partitions.size();}
+    EventList& partition(int p) {return *_partitions[p];}
+    EventList& global() {return _global;}
+
+    void setEndtime(simtime_picosec endtime);
+    // give each partition its own random stream derived from seed
+    void seedRandom(unsigned int seed);
+
+    // the pipe for a link from partition 'from' to partition 'to'
+    Pipe* makePipe(simtime_picosec delay, int from, int to);
+    simtime_picosec lookahead() const {return _lookahead;}
+
+    // run the simulation to completion on the given number of threads
+    void run(int threads);
+
+ private:
+    struct crossing_t {
+	simtime_picosec departure;
+	CrossPipe* pipe;
+	Packet* pkt;
+    };
+    inline SpscQueue<crossing_t>& channel(int from, int to) {
+	return *_channels[from * _partitions.size() + to];
+    }
+    void send(int from, int to, const crossing_t& c) {channel(from, to).push(c);}
+    void deliver(int p);
+    bool next_window();
+    void worker(int id, int threads);
+    void barrier(int threads);
+
+    vector<EventList*> _partitions;
+    vector<SpscQueue<crossing_t>*> _channels;
+    vector<unsigned int> _random_state;
+    vector<SimContext*> _contexts; // one per partition, during run()
+    vector<LogBuffer*> _log_buffers;
+    unsigned int _global_random_state;
+    EventList& _global;
+    SimContext& _context;
+    simtime_picosec _lookahead;
+
+    // shared between workers; only written by worker 0 between barriers
+    simtime_picosec _window_end;
+    bool _done;
+    std::atomic<int> _barrier_count;
+    std::atomic<int> _barrier_generation;
+};
+
+#endif
@@ -0,0 +1,170 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "pfc.h"
+
+uint8_t PfcClass::_class[ETH_PAUSE + 1]; // all class 0
+uint8_t PfcClass::_header_class = 0;
+
+simtime_picosec PfcSender::_watchdog = timeFromMs(10);
+
+void PfcClass::set(packet_type type, int cls) {
+    assert(cls >= 0 && cls < PFC_CLASSES);
+    _class[type] = cls;
+}
+
+void PfcClass::setControl(int cls) {
+    set(TCPACK, cls);
+    set(TCPNACK, cls);
+    set(NDPACK, cls);
+    set(NDPNACK, cls);
+    set(NDPPULL, cls);
+    set(NDPLITEACK, cls);
+    set(NDPLITEPULL, cls);
+    set(NDPLITERTS, cls);
+    _header_class = cls;
+}
+
+mem_b pfcHeadroom(linkspeed_bps rate, simtime_picosec cable_delay) {
+    mem_b cable = (mem_b)(timeAsSec(cable_delay) * rate / 8);
+    return 2*cable + 2*Packet::data_packet_size() + PAUSESIZE;
+}
+
+simtime_picosec pfcQuantaTime(linkspeed_bps rate, unsigned int quanta) {
+    // a quantum is 512 bit times
+    return (simtime_picosec)(quanta * 512 * 1e12 / rate);
+}
+
+PfcSender::PfcSender(EventList& eventlist, PfcPausable& owner, linkspeed_bps rate)
+    : EventSource(eventlist, "pfc_sender"), _owner(owner), _rate(rate),
+      _paused(0), _backlogged(0)
+{
+    for (int c = 0; c < PFC_CLASSES; c++) {
+	_until[c] = 0;
+	_blocked_since[c] = 0;
+	_blocked_time[c] = 0;
+	_watchdog_fired[c] = false;
+	_pauses[c] = 0;
+	_hol_blocked[c] = 0;
+	_deadlocks[c] = 0;
+    }
+}
+
+void PfcSender::receivePause(const EthPausePacket& pkt) {
+    simtime_picosec now = eventlist().now();
+    for (int c = 0; c < PFC_CLASSES; c++) {
+	if (!pkt.names(c))
+	    continue;
+	if (pkt.sleepTime() == 0) {
+	    if (paused(c))
+		resume(c);
+	    continue;
+	}
+	_until[c] = now + pfcQuantaTime(_rate, pkt.sleepTime());
+	if (!paused(c)) {
+	    _paused |= 1 << c;
+	    _pauses[c]++;
+	    if (_backlogged & (1 << c))
+		startBlocked(c);
+	} else if ((_backlogged & (1 << c)) && !_watchdog_fired[c]
+		   && now - _blocked_since[c] > _watchdog) {
+	    // refreshed for longer than any transient congestion lasts
+	    _watchdog_fired[c] = true;
+	    _deadlocks[c]++;
+	}
+    }
+    schedule();
+}
+
+void PfcSender::setBacklogged(int cls, bool backlogged) {
+    uint8_t bit = 1 << cls;
+    if (backlogged == ((_backlogged & bit) != 0))
+	return;
+    if (backlogged)
+	_backlogged |= bit;
+    else
+	_backlogged &= ~bit;
+    if (!paused(cls))
+	return;
+    if (backlogged)
+	startBlocked(cls);
+    else
+	stopBlocked(cls);
+}
+
+simtime_picosec PfcSender::blockedTime(int cls) const {
+    if (paused(cls) && (_backlogged & (1 << cls)))
+	return _blocked_time[cls] + eventlist().now() - _blocked_since[cls];
+    return _blocked_time[cls];
+}
+
+void PfcSender::startBlocked(int cls) {
+    _blocked_since[cls] = eventlist().now();
+    _watchdog_fired[cls] = false;
+    _hol_blocked[cls]++;
+}
+
+void PfcSender::stopBlocked(int cls) {
+    _blocked_time[cls] += eventlist().now() - _blocked_since[cls];
+}
+
+void PfcSender::resume(int cls) {
+    if (_backlogged & (1 << cls))
+	stopBlocked(cls);
+    _paused &= ~(1 << cls);
+    _owner.pfcResumed(cls);
+}
+
+void PfcSender::schedule() {
+    simtime_picosec next = 0;
+    for (int c = 0; c < PFC_CLASSES; c++)
+	if (paused(c) && (next == 0 || _until[c] < next))
+	    next = _until[c];
+    if (next == 0) {
+	if (isPending())
+	    eventlist().cancelPendingSource(*this);
+    } else if (isPending()) {
+	eventlist().reschedulePendingSource(*this, next);
+    } else {
+	eventlist().sourceIsPending(*this, next);
+    }
+}
+
+void PfcSender::doNextEvent() {
+    // pauses that weren't refreshed have run out
+    simtime_picosec now = eventlist().now();
+    for (int c = 0; c < PFC_CLASSES; c++)
+	if (paused(c) && _until[c] <= now)
+	    resume(c);
+    schedule();
+}
+
+PfcReceiver::PfcReceiver(EventList& eventlist, PfcPausing& owner, linkspeed_bps rate)
+    : EventSource(eventlist, "pfc_receiver"), _owner(owner), _off(0)
+{
+    _refresh = pfcQuantaTime(rate, PFC_MAX_QUANTA) / 2;
+}
+
+void PfcReceiver::xoff(int cls) {
+    if (off(cls))
+	return;
+    _off |= 1 << cls;
+    _owner.sendPfc(cls, PFC_MAX_QUANTA);
+    if (!isPending())
+	eventlist().sourceIsPendingRel(*this, _refresh);
+}
+
+void PfcReceiver::xon(int cls) {
+    if (!off(cls))
+	return;
+    _off &= ~(1 << cls);
+    _owner.sendPfc(cls, 0);
+}
+
+void PfcReceiver::doNextEvent() {
+    // every class still off is refreshed at least every half pause
+    if (!_off)
+	return;
+    for (int c = 0; c < PFC_CLASSES; c++)
+	if (off(c))
+	    _owner.sendPfc(c, PFC_MAX_QUANTA);
+    eventlist().sourceIsPendingRel(*this, _refresh);
+}
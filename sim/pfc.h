@@ -0,0 +1,127 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef PFC_H
+#define PFC_H
+
+/*
+ * Priority flow control (802.1Qbb), shared by the lossless queues.
+ *
+ * Packets travel in one of PFC_CLASSES classes, chosen by packet type
+ * (PfcClass::set); by default everything is in class 0, which is
+ * plain single-class PAUSE.  A receiver pauses a class by sending a
+ * pause time in quanta of 512 bit times, and resumes it with a pause
+ * of 0.  A pause it doesn't refresh lapses.
+ *
+ * PfcReceiver is the receiving end: it remembers which classes it has
+ * turned off (XOFF) and refreshes their pauses before they lapse.
+ * PfcSender is the transmitting end: it tracks which of its classes
+ * are paused, lets them go when told or when the pause runs out, and
+ * counts, per class, pauses, pauses that caught packets waiting (the
+ * head-of-line blocking PFC imposes on every flow in a class), the time
+ * those packets spent waiting, and pauses that outlast a watchdog
+ * interval, as a buffer-dependency deadlock would.  Queues make their
+ * PfcSender on the first pause they get and their PfcReceiver on their
+ * first XOFF, so whatever a run sets up before it starts keeps the
+ * Logged ids, and so the names and random streams, it had without PFC.
+ *
+ * pfcHeadroom() is what a receiver must keep free above a class's XOFF
+ * threshold for what's still arriving once it sends the pause: a round
+ * trip of the cable at the link rate, an MTU the sender may just have
+ * started, an MTU of ours that may delay the pause, and the pause
+ * frame itself.
+ */
+
+#include "config.h"
+#include "eventlist.h"
+#include "network.h"
+#include "eth_pause_packet.h"
+
+#define PFC_CLASSES 8
+#define PFC_MAX_QUANTA 0xffff
+
+class PfcClass {
+ public:
+    static int of(const Packet& pkt) {
+	return pkt.header_only() ? _header_class : _class[pkt.type()];
+    }
+    static void set(packet_type type, int cls);
+    // acks, nacks, pulls, RTSs and trimmed headers
+    static void setControl(int cls);
+ private:
+    static uint8_t _class[ETH_PAUSE + 1];
+    static uint8_t _header_class;
+};
+
+mem_b pfcHeadroom(linkspeed_bps rate, simtime_picosec cable_delay);
+// how long quanta of pause last on a link of rate bps
+simtime_picosec pfcQuantaTime(linkspeed_bps rate, unsigned int quanta);
+
+// what a PfcSender's owner is told when a class may send again
+class PfcPausable {
+ public:
+    virtual ~PfcPausable() {}
+    virtual void pfcResumed(int cls) = 0;
+};
+
+// how a PfcReceiver's owner sends a pause frame upstream
+class PfcPausing {
+ public:
+    virtual ~PfcPausing() {}
+    virtual void sendPfc(int cls, unsigned int quanta) = 0;
+};
+
+class PfcSender : public EventSource {
+ public:
+    PfcSender(EventList& eventlist, PfcPausable& owner, linkspeed_bps rate);
+
+    // apply a pause frame; resumed classes are reported to the owner
+    void receivePause(const EthPausePacket& pkt);
+    bool paused(int cls) const {return _paused & (1 << cls);}
+    // the owner has packets of class cls waiting, or now hasn't
+    void setBacklogged(int cls, bool backlogged);
+    void doNextEvent();
+
+    uint32_t pauses(int cls) const {return _pauses[cls];}
+    uint32_t holBlocked(int cls) const {return _hol_blocked[cls];}
+    simtime_picosec blockedTime(int cls) const;
+    uint32_t deadlocks(int cls) const {return _deadlocks[cls];}
+
+    // pauses lasting longer than this are counted as deadlocks
+    static void setWatchdog(simtime_picosec t) {_watchdog = t;}
+
+ private:
+    void resume(int cls);
+    void startBlocked(int cls);
+    void stopBlocked(int cls);
+    void schedule();
+
+    PfcPausable& _owner;
+    linkspeed_bps _rate;
+    uint8_t _paused;
+    uint8_t _backlogged;
+    simtime_picosec _until[PFC_CLASSES];
+    simtime_picosec _blocked_since[PFC_CLASSES]; // while paused and backlogged
+    simtime_picosec _blocked_time[PFC_CLASSES];
+    bool _watchdog_fired[PFC_CLASSES];
+    uint32_t _pauses[PFC_CLASSES];
+    uint32_t _hol_blocked[PFC_CLASSES];
+    uint32_t _deadlocks[PFC_CLASSES];
+
+    static simtime_picosec _watchdog;
+};
+
+class PfcReceiver : public EventSource {
+ public:
+    PfcReceiver(EventList& eventlist, PfcPausing& owner, linkspeed_bps rate);
+
+    void xoff(int cls);
+    void xon(int cls);
+    bool off(int cls) const {return _off & (1 << cls);}
+    void doNextEvent();
+
+ private:
+    PfcPausing& _owner;
+    simtime_picosec _refresh; // half the longest pause
+    uint8_t _off;
+};
+
+#endif
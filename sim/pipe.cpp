@@ -2,25 +2,38 @@
 #include "pipe.h"
 #include <iostream>
 #include <sstream>
+#include "simcontext.h"
 
 Pipe::Pipe(simtime_picosec delay, EventList& eventlist)
-: EventSource(eventlist,"pipe"), _delay(delay)
+: EventSource(eventlist,"pipe"), _line(NULL), _delay(delay)
 {
     stringstream ss;
     ss << "pipe(" << delay/1000000 << "us)";
     _nodename= ss.str();
+    if (SimContext::current().shared_delay_lines())
+	_line = DelayLine::get(eventlist, delay);
 }
 
 void
 Pipe::receivePacket(Packet& pkt)
 {
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_ARRIVE);
+    pkt.logTraffic(*this,TrafficLogger::PKT_ARRIVE);
+    if (_line) {
+	_line->enqueue(this, &pkt);
+	return;
+    }
+    schedule(eventlist().now() + _delay, &pkt);
+}
+
+void
+Pipe::schedule(simtime_picosec departure, Packet* pkt)
+{
     if (_inflight.empty()){
 	/* no packets currently inflight; need to notify the eventlist
 	   we've an event pending */
-	eventlist().sourceIsPendingRel(*this,_delay);
+	eventlist().sourceIsPending(*this,departure);
     }
-    _inflight.push_front(make_pair(eventlist().now() + _delay, &pkt));
+    _inflight.push_front(make_pair(departure, pkt));
 }
 
 void
@@ -30,10 +43,7 @@ Pipe::doNextEvent() {
 
     Packet *pkt = _inflight.back().second;
     _inflight.pop_back();
-    pkt->flow().logTraffic(*pkt, *this,TrafficLogger::PKT_DEPART);
-
-    // tell the packet to move itself on to the next hop
-    pkt->sendOn();
+    depart(pkt);
 
     if (!_inflight.empty()) {
 	// notify the eventlist we've another event pending
@@ -41,3 +51,54 @@ Pipe::doNextEvent() {
 	_eventlist.sourceIsPending(*this, nexteventtime);
     }
 }
+
+void
+Pipe::depart(Packet* pkt) {
+    pkt->logTraffic(*this,TrafficLogger::PKT_DEPART);
+
+    // tell the packet to move itself on to the next hop
+    pkt->sendOn();
+}
+
+void
+Pipe::setSharedDelayLines(bool shared) {
+    SimContext::current().set_shared_delay_lines(shared);
+}
+
+DelayLine*
+DelayLine::get(EventList& eventlist, simtime_picosec delay) {
+    EventSource*& line = eventlist.delayLine(delay);
+    if (!line)
+	line = new DelayLine(delay, eventlist);
+    return static_cast<DelayLine*>(line);
+}
+
+DelayLine::DelayLine(simtime_picosec delay, EventList& eventlist)
+: EventSource(eventlist,"delayline"), _delay(delay)
+{
+}
+
+void
+DelayLine::enqueue(Pipe* pipe, Packet* pkt) {
+    inflight_t rec = {eventlist().now() + _delay, pipe, pkt};
+    _inflight.push_back(rec);
+    // if we're idle, this packet is the head of the line.  Otherwise
+    // either we're already scheduled for the head, or we're in
+    // doNextEvent and will schedule it when we're done.
+    if (!isPending())
+	eventlist().sourceIsPending(*this, rec.departure);
+}
+
+void
+DelayLine::doNextEvent() {
+    // send on everything that's due now; packets arriving at other
+    // pipes while we do this join the back of their own line
+    while (!_inflight.empty() && _inflight.front().departure <= eventlist().now()) {
+	inflight_t rec = _inflight.front();
+	_inflight.pop_front();
+	rec.pipe->depart(rec.pkt);
+    }
+
+    if (!_inflight.empty() && !isPending())
+	eventlist().sourceIsPending(*this, _inflight.front().departure);
+}
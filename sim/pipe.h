@@ -6,27 +6,68 @@
  * A pipe is a dumb device which simply delays all incoming packets
  */
 
-#include <list>
 #include <utility>
 #include "config.h"
+#include "circular_buffer.h"
 #include "eventlist.h"
 #include "network.h"
 #include "loggertypes.h"
 
 
+class DelayLine;
+
 class Pipe : public EventSource, public PacketSink {
+    friend class DelayLine;
  public:
     Pipe(simtime_picosec delay, EventList& eventlist);
     void receivePacket(Packet& pkt); // inherited from PacketSink
     void doNextEvent(); // inherited from EventSource
     simtime_picosec delay() { return _delay; }
     const string& nodename() { return _nodename; }
+
+    // When set, pipes created afterwards in the current SimContext
+    // hand their packets to a DelayLine shared by all pipes on their
+    // eventlist with the same delay, rather than each scheduling its
+    // own events.  Off by default: it changes the order in which
+    // simultaneous events are run.
+    static void setSharedDelayLines(bool shared);
+ protected:
+    // queue pkt to leave the pipe at departure
+    void schedule(simtime_picosec departure, Packet* pkt);
+    void depart(Packet* pkt);
+
+    DelayLine* _line; // NULL unless we use a shared delay line
  private:
     simtime_picosec _delay;
     typedef pair<simtime_picosec,Packet*> pktrecord_t;
-    list<pktrecord_t> _inflight; // the packets in flight (or being serialized)
+    CircularBuffer<pktrecord_t> _inflight; // the packets in flight (or being serialized)
     string _nodename;
 };
 
+/*
+ * All the pipes in a topology with the same delay can share one FIFO:
+ * a packet entering any of them at time t leaves at t+delay, and
+ * packets enter in time order, so the FIFO stays sorted by departure
+ * time.  The line keeps a single event in the EventList for its head
+ * and, when it fires, sends on every packet due at that instant.
+ */
+class DelayLine : public EventSource {
+ public:
+    static DelayLine* get(EventList& eventlist, simtime_picosec delay);
+
+    void enqueue(Pipe* pipe, Packet* pkt);
+    void doNextEvent(); // inherited from EventSource
+    simtime_picosec delay() { return _delay; }
+ private:
+    DelayLine(simtime_picosec delay, EventList& eventlist);
+
+    struct inflight_t {
+	simtime_picosec departure;
+	Pipe* pipe;
+	Packet* pkt;
+    };
+    simtime_picosec _delay;
+    CircularBuffer<inflight_t> _inflight;
+};
 
 #endif
@@ -58,7 +58,7 @@ void QcnReactor::receivePacket(Packet& pkt) { // i.e. react to feedback
 void QcnEndpoint::receivePacket(Packet& pkt)
 	{ 
 	QcnPacket *p = (QcnPacket*)(&pkt);
-	//pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+	//pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
 	p->free();
 	};
 
@@ -3,18 +3,19 @@
 #include <math.h>
 #include "queue.h"
 #include "ndppacket.h"
-#include "queue_lossless.h"
 
 Queue::Queue(linkspeed_bps bitrate, mem_b maxsize, EventList& eventlist, 
 	     QueueLogger* logger)
   : EventSource(eventlist,"queue"), 
-    _maxsize(maxsize), _logger(logger), _bitrate(bitrate), _num_drops(0)
+    _maxsize(maxsize), _logger(logger), _bitrate(bitrate), _num_drops(0),
+    _buffer(NULL), _buffer_port(0)
 {
     _queuesize = 0;
     _ps_per_byte = (simtime_picosec)((pow(10.0, 12.0) * 8) / _bitrate);
     stringstream ss;
     ss << "queue(" << bitrate/1000000 << "Mb/s," << maxsize << "bytes)";
     _nodename = ss.str();
+    _rng = SimContext::current().rng(id);
 }
 
 
@@ -34,7 +35,8 @@ Queue::completeService()
     Packet* pkt = _enqueued.back();
     _enqueued.pop_back();
     _queuesize -= pkt->size();
-    pkt->flow().logTraffic(*pkt, *this, TrafficLogger::PKT_DEPART);
+    bufferGive(pkt->size());
+    pkt->logTraffic(*this, TrafficLogger::PKT_DEPART);
     if (_logger) _logger->logQueue(*this, QueueLogger::PKT_SERVICE, *pkt);
 
     /* tell the packet to move on to the next pipe */
@@ -56,21 +58,23 @@ Queue::doNextEvent()
 void
 Queue::receivePacket(Packet& pkt) 
 {
-    if (_queuesize+pkt.size() > _maxsize) {
+    if (!bufferFits(_queuesize, pkt.size())) {
 	/* if the packet doesn't fit in the queue, drop it */
 	if (_logger) 
 	    _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
-	pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_DROP);
+	pkt.logTraffic(*this, TrafficLogger::PKT_DROP);
 	pkt.free();
 	_num_drops++;
+	bufferDropped();
 	return;
     }
-    pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_ARRIVE);
+    pkt.logTraffic(*this, TrafficLogger::PKT_ARRIVE);
 
     /* enqueue the packet */
     bool queueWasEmpty = _enqueued.empty();
     _enqueued.push_front(&pkt);
     _queuesize += pkt.size();
+    bufferTake(pkt.size());
     if (_logger) _logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
 
     if (queueWasEmpty) {
@@ -85,6 +89,12 @@ Queue::queuesize() {
     return _queuesize;
 }
 
+void
+Queue::setMaxsize(mem_b maxsize) {
+    assert(queuesize() == 0);
+    _maxsize = maxsize;
+}
+
 simtime_picosec
 Queue::serviceTime() {
     return _queuesize * _ps_per_byte;
@@ -99,7 +109,9 @@ PriorityQueue::PriorityQueue(linkspeed_bps bitrate, mem_b maxsize,
     _queuesize[Q_MID] = 0;
     _queuesize[Q_HI] = 0;
     _servicing = Q_NONE;
-    _state_send = LosslessQueue::READY;
+    _pfc = NULL;
+    for (int c = 0; c < PFC_CLASSES; c++)
+	_pfc_queued[c] = 0;
 }
 
 PriorityQueue::queue_priority_t 
@@ -161,66 +173,61 @@ PriorityQueue::receivePacket(Packet& pkt)
 {
     //is this a PAUSE packet?
     if (pkt.type()==ETH_PAUSE){
-	EthPausePacket* p = (EthPausePacket*)&pkt;
-
-	if (p->sleepTime()>0){
-	    //remote end is telling us to shut up.
-	    //assert(_state_send == LosslessQueue::READY);
-	    if (queuesize()>0)
-		//we have a packet in flight
-		_state_send = LosslessQueue::PAUSE_RECEIVED;
-	    else
-		_state_send = LosslessQueue::PAUSED;
-	    
-	    //cout << timeAsMs(eventlist().now()) << " " << _name << " PAUSED "<<endl;
+	//remote end is telling us to shut up, or that we may go again.
+	//A packet already on the wire carries on regardless.
+	if (!_pfc) {
+	    _pfc = new PfcSender(eventlist(), *this, _bitrate);
+	    for (int c = 0; c < PFC_CLASSES; c++)
+		if (_pfc_queued[c])
+		    _pfc->setBacklogged(c, true);
 	}
-	else {
-	    //we are allowed to send!
-	    _state_send = LosslessQueue::READY;
-	    //cout << timeAsMs(eventlist().now()) << " " << _name << " GO "<<endl;
-
-	    //start transmission if we have packets to send!
-	    if(queuesize()>0)
-		beginService();
-	}
-	
+	_pfc->receivePause(*(EthPausePacket*)&pkt);
 	pkt.free();
 	return;
     }
 
     queue_priority_t prio = getPriority(pkt);
-    pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_ARRIVE);
+    pkt.logTraffic(*this, TrafficLogger::PKT_ARRIVE);
 
     /* enqueue the packet */
-    bool queueWasEmpty = false;
-    if (queuesize() == 0)
-	queueWasEmpty = true;
-
     _queuesize[prio] += pkt.size();
     _queue[prio].push_front(&pkt);
+    int cls = PfcClass::of(pkt);
+    if (_pfc_queued[cls]++ == 0 && _pfc)
+	_pfc->setBacklogged(cls, true);
 
     if (_logger) _logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
 
-    if (queueWasEmpty && _state_send==LosslessQueue::READY) {
+    if (_servicing == Q_NONE) {
 	/* schedule the dequeue event */
-	assert(_queue[Q_LO].size() + _queue[Q_MID].size() + _queue[Q_HI].size() == 1);
 	beginService();
     }
 }
 
+void
+PriorityQueue::pfcResumed(int cls)
+{
+    //start transmission if we have packets to send!
+    if (_servicing == Q_NONE && queuesize() > 0)
+	beginService();
+}
+
 void
 PriorityQueue::beginService()
 {
-    assert(_state_send == LosslessQueue::READY);
+    assert(_servicing == Q_NONE);
 
     /* schedule the next dequeue event */
     for (int prio = Q_HI; prio >= Q_LO; --prio) {
 	if (_queuesize[prio] > 0) {
+	    if (_pfc && _pfc->paused(PfcClass::of(*_queue[prio].back())))
+		continue;
 	    eventlist().sourceIsPendingRel(*this, drainTime(_queue[prio].back()));
 	    _servicing = (queue_priority_t)prio;
 	    return;
 	}
     }
+    //nothing, or only paused packets, to send
 }
 
 void
@@ -232,29 +239,20 @@ PriorityQueue::completeService()
     Packet* pkt = _queue[_servicing].back();
     _queue[_servicing].pop_back();
     _queuesize[_servicing] -= pkt->size();
-    pkt->flow().logTraffic(*pkt, *this, TrafficLogger::PKT_DEPART);
+    int cls = PfcClass::of(*pkt);
+    if (--_pfc_queued[cls] == 0 && _pfc)
+	_pfc->setBacklogged(cls, false);
+    pkt->logTraffic(*this, TrafficLogger::PKT_DEPART);
     if (_logger) _logger->logQueue(*this, QueueLogger::PKT_SERVICE, *pkt);
 
     /* tell the packet to move on to the next pipe */
     pkt->sendOn();
 
-    if (_state_send==LosslessQueue::PAUSE_RECEIVED)
-	_state_send = LosslessQueue::PAUSED;
-
-    //if (_state_send!=LosslessQueue::READY){
-    //cout << eventlist().now() << " queue " << _name << " not ready but sending " << endl;
-    //}
-
-    if (queuesize() > 0) {
-	if (_state_send==LosslessQueue::READY)
-	    /* schedule the next dequeue event */
-	    beginService();
-	else {
-	    //we've received pause or are already paused and will do nothing until the other end unblocks us
-	}
-    } else {
-	_servicing = Q_NONE;
-    }
+    _servicing = Q_NONE;
+    if (queuesize() > 0)
+	/* schedule the next dequeue event; if everything waiting is
+	   paused we'll be started again by pfcResumed() */
+	beginService();
 }
 
 mem_b
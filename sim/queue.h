@@ -6,11 +6,13 @@
  * A simple FIFO queue
  */
 
-#include <list>
 #include "config.h"
+#include "circular_buffer.h"
 #include "eventlist.h"
 #include "network.h"
 #include "loggertypes.h"
+#include "switch_buffer.h"
+#include "pfc.h"
 
 class Queue : public EventSource, public PacketSink {
  public:
@@ -28,6 +30,9 @@ class Queue : public EventSource, public PacketSink {
 	return (mem_b)(timeAsSec(t) * (double)_bitrate); 
     }
     virtual mem_b queuesize();
+    linkspeed_bps bitrate() const {return _bitrate;}
+    // change the buffer size; only safe while the queue is empty
+    virtual void setMaxsize(mem_b maxsize);
     simtime_picosec serviceTime();
     int num_drops() const {return _num_drops;}
     void reset_drops() {_num_drops = 0;}
@@ -36,6 +41,18 @@ class Queue : public EventSource, public PacketSink {
     virtual void setRemoteEndpoint2(Queue* q) {_remoteEndpoint = q;q->setRemoteEndpoint(this);};
     Queue* getRemoteEndpoint() {return _remoteEndpoint;}
 
+    // Draw on a switch's shared buffer, as the given port of it, in
+    // place of our own _maxsize.  Only Queue, RandomQueue, ECNQueue,
+    // LosslessQueue and CompositeQueue know how; see switch_buffer.h.
+    void setSwitchBuffer(SwitchBuffer* buffer, int port) {
+	assert(queuesize() == 0);
+	_buffer = buffer;
+	_buffer_port = port;
+    }
+    SwitchBuffer* switchBuffer() const {return _buffer;}
+    int switchBufferPort() const {return _buffer_port;}
+
+    using Logged::setName;
     virtual void setName(const string& name) {
 	Logged::setName(name); 
 	_nodename += name;
@@ -43,7 +60,8 @@ class Queue : public EventSource, public PacketSink {
     virtual void setLogger(QueueLogger* logger) {
 	_logger = logger;
     }
-    virtual const string& nodename() { return _nodename; }
+    // str() formats a lazily set name, adding it to ours
+    virtual const string& nodename() { str(); return _nodename; }
 
  protected:
     // Housekeeping
@@ -61,13 +79,36 @@ class Queue : public EventSource, public PacketSink {
     linkspeed_bps _bitrate; 
     simtime_picosec _ps_per_byte;  // service time, in picoseconds per byte
     mem_b _queuesize;
-    list<Packet*> _enqueued;
+    CircularBuffer<Packet*> _enqueued;
     int _num_drops;
     string _nodename;
+    Rng _rng; // for queues that make random decisions
+
+    // the shared buffer we draw on, if any, and our port in it
+    SwitchBuffer* _buffer;
+    int _buffer_port;
+    // Would size more bytes of class cls fit, with queued bytes of it
+    // here already?  Without a shared buffer that's up to _maxsize.
+    bool bufferFits(mem_b queued, mem_b size, int cls = 0) const {
+	if (!_buffer)
+	    return queued + size <= _maxsize;
+	return _buffer->fits(_buffer_port, cls, size);
+    }
+    void bufferTake(mem_b size, int cls = 0) {
+	if (_buffer) _buffer->take(_buffer_port, cls, size);
+    }
+    void bufferGive(mem_b size, int cls = 0) {
+	if (_buffer) _buffer->give(_buffer_port, cls, size);
+    }
+    void bufferDropped() {
+	if (_buffer) _buffer->dropped();
+    }
 };
 
 /* implement a 3-level priority queue */
-class PriorityQueue : public Queue {
+/* Pause frames stop the PFC classes they name; a level whose head
+   packet is in a paused class waits, and lower levels may go ahead. */
+class PriorityQueue : public Queue, public PfcPausable {
  public:
     typedef enum {Q_LO=0, Q_MID=1, Q_HI=2, Q_NONE=3} queue_priority_t;
     PriorityQueue(linkspeed_bps bitrate, mem_b maxsize, EventList &eventlist, 
@@ -75,6 +116,9 @@ class PriorityQueue : public Queue {
     virtual void receivePacket(Packet& pkt);
     virtual mem_b queuesize();
     simtime_picosec serviceTime(Packet& pkt);
+    void pfcResumed(int cls);
+    // NULL until we're first paused
+    PfcSender* pfc() {return _pfc;}
 
  protected:
     //this is needed for lossless operation!
@@ -86,10 +130,11 @@ class PriorityQueue : public Queue {
     // wrap up serving the item at the head of the queue
     virtual void completeService(); 
     PriorityQueue::queue_priority_t getPriority(Packet& pkt);
-    list <Packet*> _queue[Q_NONE];
+    CircularBuffer<Packet*> _queue[Q_NONE];
     mem_b _queuesize[Q_NONE];
     queue_priority_t _servicing;
-    int _state_send;
+    PfcSender* _pfc;
+    int _pfc_queued[PFC_CLASSES]; // packets of each class queued
 };
 
 #endif
@@ -7,9 +7,7 @@
 LosslessQueue::LosslessQueue(linkspeed_bps bitrate, mem_b maxsize, 
 			 EventList& eventlist, QueueLogger* logger, Switch* sw)
     : Queue(bitrate,maxsize,eventlist,logger), 
-      _switch(sw),
-      _state_send(READY),
-      _state_recv(READY)
+      _switch(sw)
 {
     //assume worst case: PAUSE frame waits for one MSS packet to be sent to other switch, and there is 
     //an MSS just beginning to be sent when PAUSE frame arrives; this means 2 packets per incoming
@@ -19,14 +17,31 @@ LosslessQueue::LosslessQueue(linkspeed_bps bitrate, mem_b maxsize,
 	sw->addPort(this);
 
     _sending = 0;
+    _mtu = Packet::data_packet_size();
     _high_threshold = maxsize;
     _low_threshold = 0;
+
+    _pfc = NULL;
+    _pfc_rx = NULL;
+    for (int c = 0; c < PFC_CLASSES; c++)
+	_queued_cls[c] = 0;
 }
 
 
 void
-LosslessQueue::initThresholds(){
-    _high_threshold = _maxsize - (_switch->portCount())*Packet::data_packet_size()*2;
+LosslessQueue::initThresholds(simtime_picosec cable_delay){
+    mem_b headroom = _switch->portCount() * pfcHeadroom(_bitrate, cable_delay);
+    if (_buffer) {
+	// the same allowance for packets in flight, but as headroom
+	// outside the shared pool
+	_buffer->setHeadroom(_buffer_port, 0, headroom);
+	return;
+    }
+    // as LosslessInputQueue::configurePfc, grow the buffer if the
+    // headroom leaves too little below XOFF
+    if (_maxsize - headroom < Packet::data_packet_size()*4)
+	_maxsize = Packet::data_packet_size()*4 + headroom;
+    _high_threshold = _maxsize - headroom;
 
     assert(_high_threshold>0);
 
@@ -40,65 +55,80 @@ LosslessQueue::receivePacket(Packet& pkt)
 {
     //is this a PAUSE frame? 
     if (pkt.type()==ETH_PAUSE){
-	EthPausePacket* p = (EthPausePacket*)&pkt;
-
-	if (p->sleepTime()>0){
-	    //remote end is telling us to shut up.
-	    //assert(_state_send == READY);
-	    if (_sending)
-		//we have a packet in flight
-		_state_send = PAUSE_RECEIVED;
-	    else
-		_state_send = PAUSED;
-
-	    //cout << timeAsMs(eventlist().now()) << " " << _name << " PAUSED "<<endl;	    
+	//remote end is telling us to shut up, or that we may go again.
+	//A packet already on the wire carries on regardless.
+	if (!_pfc) {
+	    _pfc = new PfcSender(eventlist(), *this, _bitrate);
+	    for (int c = 0; c < PFC_CLASSES; c++)
+		if (_queued_cls[c])
+		    _pfc->setBacklogged(c, true);
 	}
-	else {
-	    //we are allowed to send!
-	    _state_send = READY;
-	    //cout << timeAsMs(eventlist().now()) << " " << _name << " GO "<<endl;
-
-	    //start transmission if we have packets to send!
-	    if(_enqueued.size()>0&&!_sending)
-		beginService();
-	}
-	
+	_pfc->receivePause(*(EthPausePacket*)&pkt);
 	pkt.free();
 	return;
     }
 
     /* normal packet, enqueue it */
 
-    pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_ARRIVE);
-    bool queueWasEmpty = _enqueued.empty();
+    pkt.logTraffic(*this, TrafficLogger::PKT_ARRIVE);
+    int cls = PfcClass::of(pkt);
     _enqueued.push_front(&pkt);
     _queuesize += pkt.size();
+    bool overflow = _buffer ? !_buffer->take(_buffer_port, 0, pkt.size()) : _queuesize > _maxsize;
 
     //send PAUSE notifications if that is the case!
-    if (_queuesize > _high_threshold && _state_recv!=PAUSED){
-	_state_recv = PAUSED;
-	_switch->sendPause(this,1000);
+    if (overHigh()) {
+	if (!_pfc_rx)
+	    _pfc_rx = new PfcReceiver(eventlist(), *this, _bitrate);
+	_pfc_rx->xoff(cls);
     }
 
-    //if (_state_recv==PAUSED)
+    //if (_pfc_rx->off(cls))
     //cout << timeAsMs(eventlist().now()) << " queue " << _name << " switch (" << _switch->_name << ") "<< " recv when paused pkt " << pkt.type() << " sz " << _queuesize << endl;	
 
-    if (_queuesize > _maxsize){
-	cout << " Queue " << _name << " switch (" << _switch->_name << ") "<< " LOSSLESS not working! I should have dropped this packet" << endl;
+    if (overflow){
+	cout << " Queue " << str() << " switch (" << _switch->_name << ") "<< " LOSSLESS not working! I should have dropped this packet" << endl;
     }
 
     if (_logger) 
 	_logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
 
-    if (queueWasEmpty && _state_send == READY) {
+    if (_queued_cls[cls]++ == 0 && _pfc)
+	_pfc->setBacklogged(cls, true);
+    if (!_sending && !headPaused()) {
 	/* schedule the dequeue event */
-	assert(_enqueued.size()==1);
 	beginService();
     }
 }
 
+void LosslessQueue::pfcResumed(int cls){
+    //start transmission if we have packets to send!
+    if (!_enqueued.empty() && !_sending && !headPaused())
+	beginService();
+}
+
+void LosslessQueue::sendPfc(int cls, unsigned int quanta){
+    _switch->sendPause(this, cls, quanta);
+}
+
+// With a shared buffer we pause our senders once another packet
+// wouldn't fit under our threshold, and let them go again when two
+// would and the headroom's empty.
+bool LosslessQueue::overHigh(){
+    if (!_buffer)
+	return _queuesize > _high_threshold;
+    return !_buffer->fits(_buffer_port, 0, _mtu);
+}
+
+bool LosslessQueue::underLow(){
+    if (!_buffer)
+	return _queuesize < _low_threshold;
+    return _buffer->headroomUsed(_buffer_port, 0) == 0
+	&& _buffer->fits(_buffer_port, 0, 2*_mtu);
+}
+
 void LosslessQueue::beginService(){
-    assert(_state_send==READY&&!_sending);
+    assert(!_sending && !headPaused());
     Queue::beginService();
     _sending = 1;
 }
@@ -109,7 +139,11 @@ void LosslessQueue::completeService(){
     Packet* pkt = _enqueued.back();
     _enqueued.pop_back();
     _queuesize -= pkt->size();
-    pkt->flow().logTraffic(*pkt, *this, TrafficLogger::PKT_DEPART);
+    bufferGive(pkt->size());
+    int cls = PfcClass::of(*pkt);
+    if (--_queued_cls[cls] == 0 && _pfc)
+	_pfc->setBacklogged(cls, false);
+    pkt->logTraffic(*this, TrafficLogger::PKT_DEPART);
      if (_logger) _logger->logQueue(*this, QueueLogger::PKT_SERVICE, *pkt);
 
     /* tell the packet to move on to the next pipe */
@@ -117,24 +151,14 @@ void LosslessQueue::completeService(){
 
     _sending = 0;
 
-    //if (_state_send!=READY){
-    //cout << timeAsMs(eventlist().now()) << " queue " << _name << " not ready but sending pkt " << pkt->type() << endl;
-    //}
-
-    if (_state_send == PAUSE_RECEIVED)
-	_state_send = PAUSED;
-
     //unblock if that is the case
-    if (_queuesize < _low_threshold && _state_recv == PAUSED) {
-	_switch->sendPause(this,0);
-	_state_recv = READY;
-    }
+    if (underLow() && _pfc_rx)
+	for (int c = 0; c < PFC_CLASSES; c++)
+	    _pfc_rx->xon(c);
 
-    if (!_enqueued.empty()) {
-	if (_state_send == READY)
-	    /* start packet transmission, schedule the next dequeue event */
-	    beginService();
-    }
+    if (!_enqueued.empty() && !headPaused())
+	/* start packet transmission, schedule the next dequeue event */
+	beginService();
 }
 
 /*void LosslessQueue::enqueuePauseFrame(EthPausePacket* p){
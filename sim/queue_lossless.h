@@ -4,6 +4,12 @@
 #include "queue.h"
 /*
  * A FIFO queue that supports PAUSE frames and lossless operation
+ *
+ * Pauses are per PFC class (see pfc.h).  Once the queue passes its high
+ * threshold, the class of each packet that arrives is paused at every
+ * other port of the switch; all are let go again below the low
+ * threshold.  Being a single FIFO, a paused class at the head holds up
+ * the classes behind it.
  */
 
 #include <list>
@@ -12,10 +18,11 @@
 #include "network.h"
 #include "loggertypes.h"
 #include "eth_pause_packet.h"
+#include "pfc.h"
 
 class Switch;
 
-class LosslessQueue : public Queue {
+class LosslessQueue : public Queue, public PfcPausable, public PfcPausing {
  public:
     LosslessQueue(linkspeed_bps bitrate, mem_b maxsize, EventList &eventlist, QueueLogger* logger, 
 		  Switch* sw);
@@ -23,7 +30,14 @@ class LosslessQueue : public Queue {
     void receivePacket(Packet& pkt);
     void beginService();
     void completeService();
-    void initThresholds();
+    // leave headroom above XOFF for what each other port may still
+    // send, on cables of this delay, once we pause it
+    void initThresholds(simtime_picosec cable_delay);
+
+    void pfcResumed(int cls);
+    void sendPfc(int cls, unsigned int quanta);
+    // NULL until we've been paused
+    PfcSender* pfc() {return _pfc;}
 
     void setSwitch(Switch *s) {_switch = s;};
     Switch* getSwitch() {return _switch;};
@@ -34,13 +48,18 @@ class LosslessQueue : public Queue {
 
  private:
     Switch* _switch;
-    int _state_send;
-    int _state_recv;
+    PfcSender* _pfc;      // pauses from downstream; made on the first
+    PfcReceiver* _pfc_rx; // pauses we send upstream; made on the first
+    int _queued_cls[PFC_CLASSES]; // packets of each class queued
 
     int _sending;
+    mem_b _mtu; // Packet::data_packet_size(), which we check against per packet
 
     int _low_threshold;
     int _high_threshold;
+    bool overHigh();
+    bool underLow();
+    bool headPaused() const {return _pfc && _pfc->paused(PfcClass::of(*_enqueued.back()));}
 };
 
 #endif
@@ -5,23 +5,10 @@
 #include <sstream>
 #include "switch.h"
 
-LosslessInputQueue::LosslessInputQueue(EventList& eventlist)
-    : Queue(0,Packet::data_packet_size()*20,eventlist,NULL),
-      VirtualQueue(),
-      _state_recv(READY)
-{
-    _high_threshold = Packet::data_packet_size()*15;
-    _low_threshold = Packet::data_packet_size()*12;
-
-    assert(_high_threshold>0);
-    assert(_high_threshold > _low_threshold);
-
-}
-
 LosslessInputQueue::LosslessInputQueue(EventList& eventlist,Queue* peer)
     : Queue(0,Packet::data_packet_size()*20,eventlist,NULL),
       VirtualQueue(),
-      _state_recv(READY)
+      _pfc(NULL)
 {
     _high_threshold = Packet::data_packet_size()*15;
     _low_threshold = Packet::data_packet_size()*12;
@@ -29,31 +16,53 @@ LosslessInputQueue::LosslessInputQueue(EventList& eventlist,Queue* peer)
     assert(_high_threshold>0);
     assert(_high_threshold > _low_threshold);
 
+    for (int c = 0; c < PFC_CLASSES; c++)
+	_queuesize_cls[c] = 0;
+
     stringstream ss;
-    ss << "VirtualQueue("<< peer->_name<< ")";
+    ss << "VirtualQueue("<< peer->str()<< ")";
     _nodename = ss.str();
     _remoteEndpoint = peer;
 
     peer->setRemoteEndpoint(this);
 }
 
+void
+LosslessInputQueue::configurePfc(simtime_picosec cable_delay){
+    // each class may hold up to _maxsize; XON stays three packets below
+    // XOFF, as with the fixed thresholds.  With small packets on a long
+    // or fast link the headroom may not leave room for that, so the
+    // buffer grows to fit it.
+    mem_b headroom = pfcHeadroom(_remoteEndpoint->bitrate(), cable_delay);
+    if (_maxsize - headroom < Packet::data_packet_size()*4)
+	_maxsize = Packet::data_packet_size()*4 + headroom;
+    _high_threshold = _maxsize - headroom;
+    _low_threshold = _high_threshold - Packet::data_packet_size()*3;
+
+    assert(_low_threshold>0);
+    assert(_high_threshold > _low_threshold);
+}
+
 void
 LosslessInputQueue::receivePacket(Packet& pkt) 
 {
     /* normal packet, enqueue it */
+    int cls = PfcClass::of(pkt);
     _queuesize += pkt.size();
+    _queuesize_cls[cls] += pkt.size();
 
     //send PAUSE notifications if that is the case!
-    if (_queuesize > _high_threshold && _state_recv!=PAUSED){
-	_state_recv = PAUSED;
-	sendPause(1000);
+    if (_queuesize_cls[cls] > _high_threshold) {
+	if (!_pfc)
+	    _pfc = new PfcReceiver(eventlist(), *this, _remoteEndpoint->bitrate());
+	_pfc->xoff(cls);
     }
 
-    //if (_state_recv==PAUSED)
+    //if (_pfc->off(cls))
     //cout << timeAsMs(eventlist().now()) << " queue " << _name << " switch (" << _switch->_name << ") "<< " recv when paused pkt " << pkt.type() << " sz " << _queuesize << endl;	
 
-    if (_queuesize > _maxsize){
-	cout << " Queue " << _name << " LOSSLESS not working! I should have dropped this packet" << endl;
+    if (_queuesize_cls[cls] > _maxsize){
+	cout << " Queue " << str() << " LOSSLESS not working! I should have dropped this packet" << endl;
     }
 
     //tell the output queue we're here!
@@ -61,19 +70,18 @@ LosslessInputQueue::receivePacket(Packet& pkt)
 }
 
 void LosslessInputQueue::completedService(Packet& pkt){
+    int cls = PfcClass::of(pkt);
     _queuesize -= pkt.size();
+    _queuesize_cls[cls] -= pkt.size();
 
     //unblock if that is the case
-    if (_queuesize < _low_threshold && _state_recv == PAUSED) {
-	sendPause(0);
-	_state_recv = READY;
-    }
+    if (_queuesize_cls[cls] < _low_threshold && _pfc)
+	_pfc->xon(cls);
 }
 
-void LosslessInputQueue::sendPause(unsigned int wait){
-    cout << "Ingress link " << getRemoteEndpoint()->_name << " PAUSE " << wait << endl;
-    //cout << "Informing " << getRemoteEndpoint()->_name << endl;
-    EthPausePacket* pkt = EthPausePacket::newpkt(wait);
+void LosslessInputQueue::sendPfc(int cls, unsigned int quanta){
+    cout << "Ingress link " << getRemoteEndpoint()->str() << " PAUSE class " << cls << " " << quanta << endl;
+    EthPausePacket* pkt = EthPausePacket::newpkt(cls, quanta);
     getRemoteEndpoint()->receivePacket(*pkt);
 };
 
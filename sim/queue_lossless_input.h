@@ -4,6 +4,10 @@
 #include "queue.h"
 /*
  * A FIFO queue that supports PAUSE frames and lossless operation
+ *
+ * Accounts for what has arrived on a switch port and not yet left by
+ * some output, per PFC class, and pauses that class at the sender
+ * (our peer) when it passes its XOFF threshold, resuming at XON.
  */
 
 #include <list>
@@ -12,29 +16,28 @@
 #include "network.h"
 #include "loggertypes.h"
 #include "eth_pause_packet.h"
+#include "pfc.h"
 
 class Switch;
 
-class LosslessInputQueue : public Queue, public VirtualQueue {
+class LosslessInputQueue : public Queue, public VirtualQueue, public PfcPausing {
  public:
-    LosslessInputQueue(EventList &eventlist);
     LosslessInputQueue(EventList &eventlist,Queue* peer);
 
     void receivePacket(Packet& pkt);
 
-    void sendPause(unsigned int wait);
+    void sendPfc(int cls, unsigned int quanta);
     void completedService(Packet& pkt);
 
-    virtual void setName(const string& name) {
-	Logged::setName(name); 
-	_nodename += name;
-    }
-    virtual string& nodename() { return _nodename; }
+    // set XOFF to leave room above it for the packets still in flight
+    // on a cable of this delay once we pause; see pfcHeadroom()
+    void configurePfc(simtime_picosec cable_delay);
 
     enum {PAUSED,READY,PAUSE_RECEIVED};
 
  private:
-    int _state_recv;
+    PfcReceiver* _pfc; // made on the first XOFF
+    mem_b _queuesize_cls[PFC_CLASSES];
 
     int _low_threshold;
     int _high_threshold;
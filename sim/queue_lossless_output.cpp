@@ -7,17 +7,18 @@
 
 LosslessOutputQueue::LosslessOutputQueue(linkspeed_bps bitrate, mem_b maxsize, 
 					 EventList& eventlist, QueueLogger* logger, int ECN, int K)
-    : Queue(bitrate,maxsize,eventlist,logger), 
-      _state_send(READY)
+    : Queue(bitrate,maxsize,eventlist,logger),
+      _marker(K)
 {
     //assume worst case: PAUSE frame waits for one MSS packet to be sent to other switch, and there is 
     //an MSS just beginning to be sent when PAUSE frame arrives; this means 2 packets per incoming
     //port, and we must have buffering for all ports except this one (assuming no one hop cycles!)
 
-    _sending = 0;
+    _sending = -1;
+    _pfc = NULL;
 
     _ecn_enabled = ECN;
-    _K = K;
+    _marker.setRate(bitrate);
 
     stringstream ss;
     ss << "queue lossless output(" << bitrate/1000000 << "Mb/s," << maxsize << "bytes)";
@@ -25,6 +26,19 @@ LosslessOutputQueue::LosslessOutputQueue(linkspeed_bps bitrate, mem_b maxsize,
 }
 
 
+void
+LosslessOutputQueue::setMarker(const EcnMarker& marker){
+    assert(_ecn_enabled);
+    _marker = marker;
+    _marker.setRate(_bitrate);
+}
+
+void
+LosslessOutputQueue::markPacket(Packet& pkt){
+    pkt.set_flags(pkt.flags() | ECN_CE);
+    if (_logger) _logger->logQueue(*this, QueueLogger::PKT_MARK, pkt);
+}
+
 void
 LosslessOutputQueue::receivePacket(Packet& pkt){
     receivePacket(pkt,NULL);
@@ -35,29 +49,15 @@ LosslessOutputQueue::receivePacket(Packet& pkt,VirtualQueue* prev)
 {
     //is this a PAUSE frame? 
     if (pkt.type()==ETH_PAUSE){
-	EthPausePacket* p = (EthPausePacket*)&pkt;
-
-	if (p->sleepTime()>0){
-	    //remote end is telling us to shut up.
-	    //assert(_state_send == READY);
-	    if (_sending)
-		//we have a packet in flight
-		_state_send = PAUSE_RECEIVED;
-	    else
-		_state_send = PAUSED;
-
-	    //cout << timeAsMs(eventlist().now()) << " " << _name << " PAUSED "<<endl;	    
-	}
-	else {
-	    //we are allowed to send!
-	    _state_send = READY;
-	    //cout << timeAsMs(eventlist().now()) << " " << _name << " GO "<<endl;
-
-	    //start transmission if we have packets to send!
-	    if(_enqueued.size()>0&&!_sending)
-		beginService();
+	//the pause doesn't stop a packet already on the wire; classes
+	//it lets go again are started in pfcResumed
+	if (!_pfc) {
+	    _pfc = new PfcSender(eventlist(), *this, _bitrate);
+	    for (int c = 0; c < PFC_CLASSES; c++)
+		if (!_enqueued_cls[c].empty())
+		    _pfc->setBacklogged(c, true);
 	}
-	
+	_pfc->receivePause(*(EthPausePacket*)&pkt);
 	pkt.free();
 	return;
     }
@@ -67,52 +67,86 @@ LosslessOutputQueue::receivePacket(Packet& pkt,VirtualQueue* prev)
     //remember the virtual queue that has sent us this packet; will notify the vq once the packet has left our buffer.
     assert(prev!=NULL);
 
-    pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_ARRIVE);
+    pkt.logTraffic(*this, TrafficLogger::PKT_ARRIVE);
 
-    bool queueWasEmpty = _enqueued.empty();
+    int cls = PfcClass::of(pkt);
+    simtime_picosec now = eventlist().now();
 
-    _vq.push_front(prev);
-    _enqueued.push_front(&pkt);
+    //mark on enqueue
+    if (_ecn_enabled && _marker.markPoint() == EcnMarker::MARK_ON_ENQUEUE) {
+	simtime_picosec sojourn = _enqueued_cls[cls].empty() ? 0 : now - _enqueue_times[cls].back();
+	if (_marker.mark(_queuesize, sojourn, now, _rng))
+	    markPacket(pkt);
+    }
 
+    _vq[cls].push_front(prev);
+    _enqueued_cls[cls].push_front(&pkt);
+    _enqueue_times[cls].push_front(now);
+    if (_enqueued_cls[cls].size() == 1 && _pfc)
+	_pfc->setBacklogged(cls, true);
 
     _queuesize += pkt.size();
+    if (_ecn_enabled)
+	_marker.sample(_queuesize, now);
 
     if (_queuesize > _maxsize){
-	cout << " Queue " << _name << " LOSSLESS not working! I should have dropped this packet" << endl;
+	cout << " Queue " << str() << " LOSSLESS not working! I should have dropped this packet" << endl;
     }
 
     if (_logger) 
 	_logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
 
-    if (queueWasEmpty && _state_send == READY) {
+    if (_sending < 0 && nextClass() >= 0) {
 	/* schedule the dequeue event */
-	assert(_enqueued.size()==1);
 	beginService();
     }
 }
 
+void LosslessOutputQueue::pfcResumed(int cls){
+    //start transmission if we have packets to send!
+    if (_sending < 0 && !_enqueued_cls[cls].empty())
+	beginService();
+}
+
+int LosslessOutputQueue::nextClass(){
+    for (int c = PFC_CLASSES - 1; c >= 0; c--)
+	if (!_enqueued_cls[c].empty() && !(_pfc && _pfc->paused(c)))
+	    return c;
+    return -1;
+}
+
 void LosslessOutputQueue::beginService(){
-    assert(_state_send==READY&&!_sending);
-    Queue::beginService();
-    _sending = 1;
+    assert(_sending < 0);
+    _sending = nextClass();
+    assert(_sending >= 0);
+    eventlist().sourceIsPendingRel(*this, drainTime(_enqueued_cls[_sending].back()));
 }
 
 void LosslessOutputQueue::completeService(){
     /* dequeue the packet */
-    assert(!_enqueued.empty());
-    Packet* pkt = _enqueued.back();
-    VirtualQueue* q = _vq.back();
-
-    _enqueued.pop_back();
-    _vq.pop_back();
+    int cls = _sending;
+    assert(cls >= 0 && !_enqueued_cls[cls].empty());
+    Packet* pkt = _enqueued_cls[cls].back();
+    VirtualQueue* q = _vq[cls].back();
+    simtime_picosec now = eventlist().now();
+    simtime_picosec sojourn = now - _enqueue_times[cls].back();
+
+    _enqueued_cls[cls].pop_back();
+    _vq[cls].pop_back();
+    _enqueue_times[cls].pop_back();
+    if (_enqueued_cls[cls].empty() && _pfc)
+	_pfc->setBacklogged(cls, false);
 
     //mark on deque
-    if (_ecn_enabled && _queuesize > _K)
-	  pkt->set_flags(pkt->flags() | ECN_CE);    
+    if (_ecn_enabled && _marker.markPoint() == EcnMarker::MARK_ON_DEQUEUE
+	&& _marker.mark(_queuesize, sojourn, now, _rng))
+	markPacket(*pkt);
 
     _queuesize -= pkt->size();
+    if (_ecn_enabled)
+	_marker.sample(_queuesize, now);
 
-    pkt->flow().logTraffic(*pkt, *this, TrafficLogger::PKT_DEPART);
+    pkt->logTraffic(*this, TrafficLogger::PKT_DEPART);
     if (_logger) _logger->logQueue(*this, QueueLogger::PKT_SERVICE, *pkt);
 
     //tell the virtual input queue this packet is done!
@@ -121,18 +155,13 @@ void LosslessOutputQueue::completeService(){
     /* tell the packet to move on to the next pipe */
     pkt->sendOn();
 
-    _sending = 0;
+    _sending = -1;
 
-    //if (_state_send!=READY){
+    //if (_pfc->paused(cls)){
     //cout << timeAsMs(eventlist().now()) << " queue " << _name << " not ready but sending pkt " << pkt->type() << endl;
     //}
 
-    if (_state_send == PAUSE_RECEIVED)
-	_state_send = PAUSED;
-
-    if (!_enqueued.empty()) {
-	if (_state_send == READY)
-	    /* start packet transmission, schedule the next dequeue event */
-	    beginService();
-    }
+    if (nextClass() >= 0)
+	/* start packet transmission, schedule the next dequeue event */
+	beginService();
 }
@@ -3,18 +3,24 @@
 #define _LOSSLESS_OUTPUT_QUEUE_H
 /*
  * A FIFO queue that supports PAUSE frames and lossless operation
+ *
+ * One FIFO per PFC class, each paused separately by the next hop;
+ * the highest class that has packets and isn't paused goes first.
+ * With ECN on, an EcnMarker picks the packets to mark, by default those
+ * leaving while the queue holds more than K.
  */
 
-#include <list>
 #include "queue.h"
 #include "config.h"
 #include "eventlist.h"
 #include "network.h"
 #include "loggertypes.h"
 #include "eth_pause_packet.h"
+#include "pfc.h"
 #include "ecn.h"
+#include "ecn_marker.h"
 
-class LosslessOutputQueue : public Queue {
+class LosslessOutputQueue : public Queue, public PfcPausable {
  public:
     LosslessOutputQueue(linkspeed_bps bitrate, mem_b maxsize, EventList &eventlist, QueueLogger* logger, int ECN=0, int K=0);
 
@@ -23,17 +29,30 @@ class LosslessOutputQueue : public Queue {
 
     void beginService();
     void completeService();
+    void pfcResumed(int cls);
+    // NULL until we've been paused
+    PfcSender* pfc() {return _pfc;}
+
+    // with ECN on, mark as marker does, from a fresh start; see ecn_marker.h
+    void setMarker(const EcnMarker& marker);
+    uint64_t num_marked() const {return _marker.marks();}
 
     enum {PAUSED,READY,PAUSE_RECEIVED};
 
  private:
-    list<VirtualQueue*> _vq;
+    // the highest class with packets waiting that isn't paused, or -1
+    int nextClass();
+    void markPacket(Packet& pkt);
+
+    CircularBuffer<Packet*> _enqueued_cls[PFC_CLASSES];
+    CircularBuffer<VirtualQueue*> _vq[PFC_CLASSES];
+    CircularBuffer<simtime_picosec> _enqueue_times[PFC_CLASSES]; // as _enqueued_cls
+    PfcSender* _pfc; // made on the first pause
 
-    int _state_send;
-    int _sending;
+    int _sending; // the class on the wire, or -1
 
     int _ecn_enabled;
-    int _K;
+    EcnMarker _marker;
 };
 
 #endif
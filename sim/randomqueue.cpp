@@ -23,9 +23,9 @@ RandomQueue::receivePacket(Packet& pkt)
     double drop_prob = 0;
     int crt = _queuesize + pkt.size();
 
-    if (_plr > 0.0 && drand() < _plr){
+    if (_plr > 0.0 && _rng.uniform() < _plr){
 	//if (_logger) _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
-	//pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_DROP);
+	//pkt.logTraffic(*this,TrafficLogger::PKT_DROP);
 	pkt.free();
 	return;
     }
@@ -35,12 +35,14 @@ RandomQueue::receivePacket(Packet& pkt)
   
     //  cout << "Drop Prob "<<drop_prob<< " queue size "<< _queuesize/1000 << " queue id " << id << endl;
 
-    if (crt > _maxsize || drand() < drop_prob) {
+    bool full = !bufferFits(_queuesize, pkt.size());
+    if (full || _rng.uniform() < drop_prob) {
 	/* drop the packet */
 	if (_logger) _logger->logQueue(*this, QueueLogger::PKT_DROP, pkt);
-	pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_DROP);
-	if (crt > _maxsize){
+	pkt.logTraffic(*this, TrafficLogger::PKT_DROP);
+	if (full){
 	    _buffer_drops ++;
+	    bufferDropped();
 	}
 	pkt.free();
 
@@ -50,10 +52,11 @@ RandomQueue::receivePacket(Packet& pkt)
     }
 
     /* enqueue the packet */
-    pkt.flow().logTraffic(pkt, *this, TrafficLogger::PKT_ARRIVE);
+    pkt.logTraffic(*this, TrafficLogger::PKT_ARRIVE);
     bool queueWasEmpty = _enqueued.empty();
     _enqueued.push_front(&pkt);
     _queuesize += pkt.size();
+    bufferTake(pkt.size());
 
     if (_logger) 
 	_logger->logQueue(*this, QueueLogger::PKT_ENQUEUE, pkt);
@@ -43,7 +43,7 @@ TcpSrc::receivePacket(Packet& pkt)
 	{
 	TcpAck *p = (TcpAck*)(&pkt);
 	TcpAck::seq_t seqno = p->ackno();
-	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+	pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
 	p->free();
 	assert(seqno >= _last_acked);  // no dups or reordering allowed in this simple simulator
 	if (seqno > _last_acked) { // a brand new ack
@@ -148,7 +148,7 @@ void
 TcpSrc::send_packets() {
 	while ( _last_acked + _cwnd >= _highest_sent + _mss) {
 		TcpPacket* p = TcpPacket::newpkt(_flow, *_route, _highest_sent+1, _mss);
-		p->flow().logTraffic(*p,*this,TrafficLogger::PKT_CREATESEND);
+		p->logTraffic(*this,TrafficLogger::PKT_CREATESEND);
 		_highest_sent += _mss;  //XX beware wrapping
 		_last_sent_time = eventlist().now();
 		p->sendOn();
@@ -158,7 +158,7 @@ TcpSrc::send_packets() {
 void 
 TcpSrc::retransmit_packet() {
 	TcpPacket* p = TcpPacket::newpkt(_flow, *_route, _last_acked+1, _mss);
-		p->flow().logTraffic(*p,*this,TrafficLogger::PKT_CREATESEND);
+		p->logTraffic(*this,TrafficLogger::PKT_CREATESEND);
 	_last_sent_time = eventlist().now();
 	p->sendOn();
 	}
@@ -207,7 +207,7 @@ TcpSink::receivePacket(Packet& pkt) {
 	TcpPacket *p = (TcpPacket*)(&pkt);
 	TcpPacket::seq_t seqno = p->seqno();
 	int size = p->size(); // TODO: the following code assumes all packets are the same size
-	pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+	pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
 	p->free();
 
 	if (seqno == _cumulative_ack+1) { // it's the next expected seq no
@@ -243,7 +243,7 @@ TcpSink::receivePacket(Packet& pkt) {
 void 
 TcpSink::send_ack() {
 	TcpAck *ack = TcpAck::newpkt(_src->_flow, *_route, 0, _cumulative_ack);
-	ack->flow().logTraffic(*ack,*this,TrafficLogger::PKT_CREATESEND);
+	ack->logTraffic(*this,TrafficLogger::PKT_CREATESEND);
 	ack->sendOn();
 	}
 
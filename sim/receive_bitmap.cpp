@@ -0,0 +1,84 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include <algorithm>
+#include "receive_bitmap.h"
+
+ReceiveBitmap::ReceiveBitmap()
+    : _words(1, 0), _lo(0), _hi(0), _count(0), _size(0), _phase(0)
+{
+}
+
+bool
+ReceiveBitmap::add(uint64_t seqno, uint32_t size) {
+    assert(seqno > 0 && size > 0);
+    if (_count == 0) {
+	_size = size;
+	_phase = seqno % size;
+    }
+    assert(size == _size && seqno % _size == _phase);
+    uint64_t packet = seqno / _size;
+    if (_count == 0) {
+	_lo = packet;
+	_hi = packet + 1;
+    } else if (packet < _lo || packet >= _hi) {
+	uint64_t lo = packet < _lo ? packet : _lo;
+	uint64_t hi = packet >= _hi ? packet + 1 : _hi;
+	if (((hi - 1) >> 6) - (lo >> 6) >= _words.size())
+	    grow(lo, hi);
+	_lo = lo;
+	_hi = hi;
+    }
+    uint64_t& w = word(packet);
+    uint64_t bit = (uint64_t)1 << (packet & 63);
+    if (w & bit)
+	return false;
+    w |= bit;
+    _count++;
+    return true;
+}
+
+uint64_t
+ReceiveBitmap::fill(uint64_t seqno) {
+    if (_count == 0 || seqno % _size != _phase)
+	return 0;
+    uint64_t packet = seqno / _size + 1;
+    if (packet < _lo || packet >= _hi)
+	return 0;
+    uint64_t released = 0;
+    while (_count > 0) {
+	uint64_t& w = word(packet);
+	int shift = packet & 63;
+	// bits above the word's top shift in as zeros, so the run of
+	// ones stops at the end of the word if not before
+	uint64_t run = ~(w >> shift);
+	int ones = run ? __builtin_ctzll(run) : 64;
+	if (ones == 0)
+	    break;
+	w &= ones == 64 ? 0 : ~((((uint64_t)1 << ones) - 1) << shift);
+	released += ones;
+	packet += ones;
+	_count -= ones;
+	if (packet & 63)
+	    break; // the run ended inside this word
+    }
+    _lo = packet;
+    return released;
+}
+
+void
+ReceiveBitmap::clear() {
+    fill_n(_words.begin(), _words.size(), 0);
+    _lo = _hi = 0;
+    _count = 0;
+}
+
+// make room for packets lo up to hi, keeping those held now
+void
+ReceiveBitmap::grow(uint64_t lo, uint64_t hi) {
+    size_t size = _words.size();
+    while (((hi - 1) >> 6) - (lo >> 6) >= size)
+	size *= 2;
+    vector<uint64_t> words(size, 0);
+    for (uint64_t i = _lo >> 6; i <= (_hi - 1) >> 6; i++)
+	words[i & (size - 1)] = _words[i & (_words.size() - 1)];
+    _words.swap(words);
+}
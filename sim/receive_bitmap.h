@@ -0,0 +1,47 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef RECEIVE_BITMAP_H
+#define RECEIVE_BITMAP_H
+
+/*
+ * The packets a sink has received above a hole, which it can't yet
+ * acknowledge cumulatively.  Sinks assume packets are all the same
+ * size, so their sequence numbers step by that size, and rather than
+ * a sorted list this keeps a bit per packet in a ring of 64-bit words,
+ * sliding forward as the hole is filled and doubling when a packet
+ * lands beyond its end.  Filling the hole releases the run of packets
+ * after it a word at a time, by counting trailing ones.
+ */
+
+#include <vector>
+#include "config.h"
+
+class ReceiveBitmap {
+ public:
+    ReceiveBitmap();
+
+    bool empty() const {return _count == 0;}
+    // how many packets are held, and how many bytes they carry
+    uint64_t size() const {return _count;}
+    uint64_t bytes() const {return _count * _size;}
+
+    // holds the packet of size bytes at seqno, which is above the
+    // hole; returns false if it was already held
+    bool add(uint64_t seqno, uint32_t size);
+    // the packet at seqno has just filled the hole: releases the held
+    // packets that follow it without a gap, and returns how many
+    uint64_t fill(uint64_t seqno);
+    // forgets every packet held, keeping the space for reuse
+    void clear();
+
+ private:
+    uint64_t& word(uint64_t packet) {return _words[(packet >> 6) & (_words.size() - 1)];}
+    void grow(uint64_t lo, uint64_t hi);
+
+    vector<uint64_t> _words; // a power of two of them
+    uint64_t _lo, _hi;  // none held below packet _lo or from packet _hi
+    uint64_t _count;
+    uint32_t _size;
+    uint32_t _phase;  // packet n starts at n*_size + _phase
+};
+
+#endif
@@ -0,0 +1,66 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef RNG_H
+#define RNG_H
+
+/*
+ * A small, fast random number generator (xoshiro256**), meant to be
+ * embedded in each component that makes random decisions.  A
+ * generator is seeded from the simulation's master seed and a stream
+ * number, normally the component's id (see SimContext::rng), so each
+ * component draws from its own stream: its decisions don't depend on
+ * what any other component drew, or in which order things were set up
+ * or run, and there's no shared state to lock.
+ */
+
+#include "config.h"
+
+class Rng {
+ public:
+    Rng() {seed(0, 0);}
+    Rng(uint64_t master, uint64_t stream) {seed(master, stream);}
+
+    void seed(uint64_t master, uint64_t stream) {
+	// splitmix64 spreads the seed over the whole state, so nearby
+	// stream numbers give unrelated sequences
+	uint64_t x = master ^ (stream * 0xd1342543de82ef95ULL);
+	for (int i = 0; i < 4; i++)
+	    _s[i] = splitmix64(x);
+    }
+
+    inline uint64_t next() {
+	uint64_t result = rotl(_s[1] * 5, 7) * 9;
+	uint64_t t = _s[1] << 17;
+	_s[2] ^= _s[0];
+	_s[3] ^= _s[1];
+	_s[1] ^= _s[2];
+	_s[0] ^= _s[3];
+	_s[2] ^= t;
+	_s[3] = rotl(_s[3], 45);
+	return result;
+    }
+
+    // uniform in [0,1)
+    inline double uniform() {
+	return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // uniform in [0,n)
+    inline uint32_t below(uint32_t n) {
+	return (uint32_t)(((next() >> 32) * n) >> 32);
+    }
+
+ private:
+    static inline uint64_t rotl(uint64_t x, int k) {
+	return (x << k) | (x >> (64 - k));
+    }
+    static inline uint64_t splitmix64(uint64_t& x) {
+	uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+    }
+
+    uint64_t _s[4];
+};
+
+#endif
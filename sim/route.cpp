@@ -7,12 +7,88 @@
 
 #define MAXQUEUES 10
 
+Route*
+Route::extend() const {
+    if (_hops)
+	return new Route(*this);
+    Route* rt = new Route();
+    rt->_base = this;
+    rt->_hops = _sinklist.size();
+    rt->_reverse = _reverse;
+    rt->_reverse_endpoint = _reverse_endpoint;
+    rt->_path_id = _path_id;
+    rt->_no_of_paths = _no_of_paths;
+    return rt;
+}
+
 void
 Route::add_endpoints(PacketSink *src, PacketSink* dst) {
     _sinklist.push_back(dst);
-    if (_reverse) {
-	_reverse->push_back(src);
+    if (_reverse)
+	_reverse_endpoint = src;
+}
+
+uint64_t
+RouteTable::hash(const Route* rt) {
+    // FNV-1a over the sinks' addresses
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < rt->size(); i++) {
+	h ^= (uint64_t)rt->at(i);
+	h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+Route*
+RouteTable::find(const Route* rt) const {
+    pair<multimap<uint64_t, Route*>::const_iterator,
+	 multimap<uint64_t, Route*>::const_iterator> range = _routes.equal_range(hash(rt));
+    for (multimap<uint64_t, Route*>::const_iterator i = range.first; i != range.second; i++) {
+	Route* other = i->second;
+	if (other == rt)
+	    return other;
+	if (other->size() != rt->size())
+	    continue;
+	size_t n = 0;
+	while (n < rt->size() && other->at(n) == rt->at(n))
+	    n++;
+	if (n == rt->size())
+	    return other;
     }
+    return NULL;
+}
+
+const Route*
+RouteTable::intern(Route* rt) {
+    Route* same = find(rt);
+    if (same) {
+	if (same != rt) {
+	    if (rt->_reverse && find(rt->_reverse) != rt->_reverse)
+		delete rt->_reverse;
+	    delete rt;
+	}
+	return same;
+    }
+    _routes.insert(make_pair(hash(rt), rt));
+    if (rt->_reverse) {
+	Route* reverse = find(rt->_reverse);
+	if (!reverse) {
+	    reverse = rt->_reverse;
+	    _routes.insert(make_pair(hash(reverse), reverse));
+	} else if (reverse != rt->_reverse) {
+	    delete rt->_reverse;
+	    rt->_reverse = reverse;
+	}
+	if (!reverse->_reverse)
+	    reverse->_reverse = rt;
+    }
+    return rt;
+}
+
+void
+RouteTable::intern(vector<const Route*>& paths) {
+    for (size_t i = 0; i < paths.size(); i++)
+	paths[i] = intern(const_cast<Route*>(paths[i]));
 }
 
 
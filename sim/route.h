@@ -4,27 +4,86 @@
 
 /*
  * A Route, carried by packets, to allow routing
+ *
+ * A route is usually a list of the sinks a packet passes through.  On
+ * a regular topology it can instead name path n from src to dst and
+ * leave the hops to a PathAlgorithm, which works out each one as it's
+ * needed; sinks pushed onto such a route (the endpoints) come after
+ * the computed hops.  Either way at() and size() see the whole route.
+ *
+ * Many connections follow the same paths, each with its own
+ * endpoints.  extend() makes a route that shares another's hops and
+ * has only the endpoints of its own, and a RouteTable keeps one copy
+ * of each distinct path however many times a topology hands it out.
  */
 
 #include "config.h"
 #include <list>
 #include <vector>
+#include <map>
 
 class PacketSink;
+
+class PathAlgorithm {
+ public:
+    virtual ~PathAlgorithm() {}
+    // the number of hops on path n from src to dst, and hop i of it
+    virtual size_t path_hops(int src, int dst, int path) const = 0;
+    virtual PacketSink* path_hop(int src, int dst, int path, size_t i) const = 0;
+};
+
 class Route {
   public:
-    Route() : _reverse(NULL) {};
-    inline PacketSink* at(size_t n) const {return _sinklist.at(n);}
+    Route() : _reverse(NULL), _reverse_endpoint(NULL), _base(NULL), _algo(NULL), _hops(0),
+	      _path_id(0), _no_of_paths(1) {};
+    Route(const PathAlgorithm* algo, int src, int dst, int path)
+	: _reverse(NULL), _reverse_endpoint(NULL), _base(NULL), _algo(algo),
+	  _src(src), _dst(dst), _path(path), _hops(algo->path_hops(src, dst, path)),
+	  _path_id(0), _no_of_paths(1) {}
+    // A new route with this one's hops, for endpoints to be pushed
+    // onto.  Stored hops are shared, not copied, so this route must
+    // outlive it and not change.
+    Route* extend() const;
+    inline PacketSink* at(size_t n) const {
+	if (n < _hops)
+	    return _base ? _base->_sinklist[n] : _algo->path_hop(_src, _dst, _path, n);
+	return _sinklist.at(n - _hops);
+    }
     void push_back(PacketSink* sink) {_sinklist.push_back(sink);}
-    void push_front(PacketSink* sink) {_sinklist.insert(_sinklist.begin(), sink);}
+    void push_front(PacketSink* sink) {
+	assert(!_hops);
+	_sinklist.insert(_sinklist.begin(), sink);
+    }
+    // Push dst onto this route, and have packets bounced back along
+    // its reverse end up at src.  The reverse itself is left alone, as
+    // other routes may share it.
     void add_endpoints(PacketSink *src, PacketSink* dst);
-    inline size_t size() const {return _sinklist.size();}
-    typedef vector<PacketSink*>::const_iterator const_iterator;
-    //typedef vector<PacketSink*>::iterator iterator;
-    inline const_iterator begin() const {return _sinklist.begin();}
-    inline const_iterator end() const {return _sinklist.end();}
+    inline size_t size() const {return _hops + _sinklist.size();}
+    // walks the whole route, as at() sees it
+    class const_iterator {
+    public:
+	const_iterator(const Route* route, size_t n) : _route(route), _n(n) {}
+	PacketSink* operator*() const {return _route->at(_n);}
+	const_iterator& operator++() {_n++; return *this;}
+	const_iterator operator++(int) {const_iterator i = *this; _n++; return i;}
+	bool operator==(const const_iterator& o) const {return _n == o._n && _route == o._route;}
+	bool operator!=(const const_iterator& o) const {return !(*this == o);}
+    private:
+	const Route* _route;
+	size_t _n;
+    };
+    inline const_iterator begin() const {return const_iterator(this, 0);}
+    inline const_iterator end() const {return const_iterator(this, size());}
     void set_reverse(Route* reverse) {_reverse = reverse;}
     inline const Route* reverse() const {return _reverse;}
+    // the way back: reverse(), then the source endpoint if there is one
+    inline size_t reverse_size() const {return _reverse->size() + (_reverse_endpoint ? 1 : 0);}
+    inline PacketSink* reverse_at(size_t n) const {
+	if (n < _reverse->size())
+	    return _reverse->at(n);
+	assert(_reverse_endpoint && n == _reverse->size());
+	return _reverse_endpoint;
+    }
     void set_path_id(int path_id, int no_of_paths) {
 	_path_id = path_id;
 	_no_of_paths = no_of_paths;
@@ -32,11 +91,34 @@ class Route {
     inline int path_id() const {return _path_id;}
     inline int no_of_paths() const {return _no_of_paths;}
  private:
+    friend class RouteTable;
     vector<PacketSink*> _sinklist;
     Route* _reverse;
+    PacketSink* _reverse_endpoint;
+    const Route* _base;         // whose _sinklist we share, if extended
+    const PathAlgorithm* _algo; // NULL unless the hops are computed
+    int _src, _dst, _path;
+    uint32_t _hops;             // shared or computed hops, before _sinklist
     int _path_id; //path identifier for this path
     int _no_of_paths; //total number of paths sender is using
 };
+
+// One route for each distinct sequence of hops.
+class RouteTable {
+ public:
+    // The route with rt's hops: rt itself if it's the first, with its
+    // reverse interned likewise.  Duplicates, rt and its reverse, are
+    // deleted, so they mustn't be in use yet.
+    const Route* intern(Route* rt);
+    // interns each route in paths in place
+    void intern(vector<const Route*>& paths);
+    size_t size() const {return _routes.size();}
+ private:
+    Route* find(const Route* rt) const;
+    static uint64_t hash(const Route* rt);
+    multimap<uint64_t, Route*> _routes;
+};
+
 //typedef vector<PacketSink*> route_t;
 typedef Route route_t;
 typedef vector<route_t*> routes_t;
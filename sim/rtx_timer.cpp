@@ -1,114 +1,175 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include <string.h>
 #include "rtx_timer.h"
 
-RtxTimer::RtxTimer(EventList& list):
-  _eventList(list)
+RtxTimerClient::RtxTimerClient()
+    : _rtx_wheel(NULL), _rtx_when(0), _rtx_next(NULL), _rtx_prev(NULL), _rtx_slot(0)
 {
-  TimerBucket* bucket;
-  simtime_picosec now;
-  now = _eventList().now();
-
-  for (int i=50;i<=400;i*=2){
-    bucket = new TimerBucket();
-    bucket->base = timeFromMs(i);
-    bucket->expire  = now + bucket->base;
-  }
 }
 
-//time is absolute!
-void RtxTimer::schedule_timer(TcpSrc* who,simtime_picosec when){
-  timer_entry * t;
-
-  if (active_timers.find(who)!=active_timers.end()){
-    t = remove_timer(who);
-  }
-  else {
-    t = new timer_entry();
-    active_timers.insert(who);
-  }
-  t->who = who;
-  t->when = when;
-  
-  simtime_picosec now = _eventList().now(), delta = when-now;
+RtxTimerClient::~RtxTimerClient() {
+    if (_rtx_prev)
+	_rtx_wheel->remove(this);
+}
 
-  vector<TimerBucket*>::iterator it;
-  TimerBucket* crt = NULL;
-  int j = -1;
+void
+RtxTimerClient::rtx_timer_join(RtxTimerWheel& wheel) {
+    assert(!_rtx_wheel);
+    _rtx_wheel = &wheel;
+    if (_rtx_when)
+	_rtx_wheel->add(this);
+}
 
-  for (int i = 0;i<_buckets.size();i++){
-    crt = _buckets[i];
-    
-    if (crt->base>delta){
-      j = i-1;
-      break;
-    }
-    else j = i;
-  }
+void
+RtxTimerClient::rtx_timer_arm(simtime_picosec when) {
+    if (when == _rtx_when && (_rtx_prev || !_rtx_wheel))
+	return;
+    if (_rtx_prev)
+	_rtx_wheel->remove(this);
+    _rtx_when = when;
+    if (_rtx_wheel && _rtx_when)
+	_rtx_wheel->add(this);
+}
 
-  if (j<0){
-    _soon[t->when] = t;
-  }
-  else{
-    //insert in that timerbucket;
-    _buckets[j]->timers[who] = t;
-    _timer_to_bucket[who] = _buckets[j];
-  }
+RtxTimerWheel::RtxTimerWheel(EventList& eventlist, simtime_picosec scan_period,
+			     const string& name)
+    : EventSource(eventlist, name), _tick_time(timeFromUs((uint32_t)1)),
+      _scan_period(scan_period), _tick(eventlist.now() / _tick_time),
+      _count(0), _wake(0)
+{
+    assert(scan_period > 0);
+    memset(_occupied, 0, sizeof(_occupied));
+    memset(_slots, 0, sizeof(_slots));
 }
 
-void RtxTimer::reschedule_timer(TcpSrc* who,simtime_picosec when){
-  //fast case only!
-  if (_active_timers.find(who)==_active_timers.end()){
-    return schedule_timer(who,when);
-  }  
-  bool ok = false;
-  
-  if (_timer_to_bucket.find(who)!=_timer_to_bucket.end()){
-    TimerBucket* bucket = _timer_to_bucket[who];
-    simtime_picosec now = _eventList().now(), delta = when-now;
-    if (delta>bucket->base) //ok to reschedule here!
-      if (bucket->timers.find(who)!=bucket->timers.end()){
-	t = bucket->timers[who];
-	t->when = when;
-	ok = true;
-      }
-  }
+void
+RtxTimerWheel::add(RtxTimerClient* c) {
+    insert(c);
+    if (!_wake || c->_rtx_when < _wake)
+	wake_at(c->_rtx_when);
+}
 
-  if (!ok) 
-    schedule_timer(who,when);
+// A deadline goes in the lowest level where its tick shares the wheel's
+// slot on every level above, so each level's deadlines are all ahead of
+// the wheel's slot on that level.  Deadlines already past go in the
+// current slot.
+void
+RtxTimerWheel::insert(RtxTimerClient* c) {
+    uint64_t tick = c->_rtx_when / _tick_time;
+    if (tick < _tick)
+	tick = _tick;
+    uint64_t diff = tick ^ _tick;
+    int level = diff ? (63 - __builtin_clzll(diff)) / SLOT_BITS : 0;
+    uint64_t slot = (tick >> (level * SLOT_BITS)) & (SLOTS - 1);
+    RtxTimerClient*& head = _slots[level][slot];
+    c->_rtx_next = head;
+    if (head)
+	head->_rtx_prev = &c->_rtx_next;
+    head = c;
+    c->_rtx_prev = &head;
+    c->_rtx_slot = level * SLOTS + slot;
+    _occupied[level] |= (uint64_t)1 << slot;
+    _count++;
 }
 
-void RtxTimer::remove_timer(TcpSrc* who){
-  timer_entry * t = NULL;
+void
+RtxTimerWheel::remove(RtxTimerClient* c) {
+    *c->_rtx_prev = c->_rtx_next;
+    if (c->_rtx_next)
+	c->_rtx_next->_rtx_prev = c->_rtx_prev;
+    c->_rtx_prev = NULL;
+    int level = c->_rtx_slot / SLOTS, slot = c->_rtx_slot % SLOTS;
+    if (!_slots[level][slot])
+	_occupied[level] &= ~((uint64_t)1 << slot);
+    _count--;
+}
 
-  if (_active_timers.find(who)==_active_timers.end()){
-    return NULL;
-  }  
+// the first tick of a slot ahead of the wheel
+uint64_t
+RtxTimerWheel::slot_start(int level, uint64_t slot) const {
+    int shift = level * SLOT_BITS;
+    uint64_t above = shift + SLOT_BITS < 64 ? _tick >> (shift + SLOT_BITS) << (shift + SLOT_BITS) : 0;
+    return above | (slot << shift);
+}
 
-  _active_timers.erase(who);
+// Moves the wheel on to the earliest slot with deadlines in, as far as
+// time now allows, spreading each higher level slot it reaches over the
+// levels below.
+void
+RtxTimerWheel::advance(simtime_picosec now) {
+    while (_count > 0 && !_slots[0][_tick & (SLOTS - 1)]) {
+	int level = 0;
+	while (!_occupied[level])
+	    level++;
+	uint64_t slot = __builtin_ctzll(_occupied[level]);
+	uint64_t tick = slot_start(level, slot);
+	if (level > 0 && tick * _tick_time > now)
+	    return; // not time to spread this slot yet
+	_tick = tick;
+	if (level == 0)
+	    continue;
+	RtxTimerClient* c = _slots[level][slot];
+	_slots[level][slot] = NULL;
+	_occupied[level] &= ~((uint64_t)1 << slot);
+	while (c) {
+	    RtxTimerClient* next = c->_rtx_next;
+	    _count--;
+	    insert(c);
+	    c = next;
+	}
+    }
+}
 
-  if (_timer_to_bucket.find(who)!=_timer_to_bucket.end()){
-    TimerBucket* bucket = _timer_to_bucket[who];
-    if (bucket->timers.find(who)!=bucket->timers.end()){
-      t = bucket->timers[who];
-      bucket->timers.erase(who);
+// the earliest deadline in the current slot, or failing that when the
+// next slot has to be spread out; 0 if there are no deadlines
+simtime_picosec
+RtxTimerWheel::next_wake() const {
+    if (_count == 0)
+	return 0;
+    const RtxTimerClient* c = _slots[0][_tick & (SLOTS - 1)];
+    if (c) {
+	simtime_picosec earliest = c->_rtx_when;
+	for (c = c->_rtx_next; c; c = c->_rtx_next)
+	    if (c->_rtx_when < earliest)
+		earliest = c->_rtx_when;
+	return earliest;
     }
+    int level = 0;
+    while (!_occupied[level])
+	level++;
+    return slot_start(level, __builtin_ctzll(_occupied[level])) * _tick_time;
+}
 
-    _timer_to_bucket.erase(_timer_to_bucket.find(who).second);
-  }
-  else {
-    list<timer_entry*>::iterator it;
-    bool found = false;
+void
+RtxTimerWheel::wake_at(simtime_picosec when) {
+    if (when < eventlist().now())
+	when = eventlist().now();
+    eventlist().reschedulePendingSource(*this, when);
+    _wake = when;
+}
 
-    for (it = _soon.begin();it!=_soon.end();it++){
-      t = _soon[*it];
-      if (t->who==who){
-	found = true;
-	_soon.erase(it);
-	break;
-      }
+void
+RtxTimerWheel::doNextEvent() {
+    simtime_picosec now = eventlist().now();
+    _wake = 0;
+    while (1) {
+	advance(now);
+	RtxTimerClient* c = _slots[0][_tick & (SLOTS - 1)];
+	while (c && c->_rtx_when > now)
+	    c = c->_rtx_next;
+	if (!c)
+	    break;
+	// the hook may well set a new deadline or clear it; if it
+	// does neither, the source wasn't ready, so ask again later
+	remove(c);
+	simtime_picosec due = c->_rtx_when;
+	c->rtx_timer_hook(now);
+	if (!c->_rtx_prev && c->_rtx_when == due) {
+	    c->_rtx_when = now + _scan_period;
+	    insert(c);
+	}
     }
-    if (!found)
-      t = NULL;
-  }
-
-  return t;
+    simtime_picosec when = next_wake();
+    if (when)
+	wake_at(when);
 }
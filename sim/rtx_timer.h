@@ -1,78 +1,77 @@
-#ifndef __RTX_TIMER
-#define __RTX_TIMER
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef RTX_TIMER_H
+#define RTX_TIMER_H
+
+/*
+ * Retransmission timers.  A source keeps its RTO deadline in an
+ * RtxTimerWheel, a hierarchical timing wheel: SLOTS slots per level,
+ * each level's slots SLOTS times as wide as the level below's, the
+ * finest a microsecond wide.  Setting, moving or clearing a deadline
+ * is O(1), and the wheel only wakes when some deadline is due or a
+ * slot of deadlines has to be spread out over the level below, so
+ * sources with nothing outstanding cost nothing.  Deadlines fire at
+ * exactly the time they were set for.
+ *
+ * A deadline the hook leaves as it was, because the source isn't ready
+ * to act on it yet, is tried again every scan period until the source
+ * moves or clears it, as the scanners that came before the wheel did.
+ */
 
-#include <list>
-#include <hash_map>
-#include <map>
 #include "config.h"
-#include "network.h"
-#include "tcppacket.h"
 #include "eventlist.h"
 
+class RtxTimerWheel;
 
-class RtxTimer {
+// anything with a retransmission deadline
+class RtxTimerClient {
  public:
-  RtxTimer(EventList & list);
-
-  void schedule_timer(TcpSrc* who,simtime_picosec when);
-  void reschedule_timer(TcpSrc* who,simtime_picosec when);
-  void remove_timer(TcpSrc* who);
-
-  void check_lists(); 
-
-  struct timer_entry {
-    TcpSrc* who;
-    simtime_picosec when;
-  };
-
-  EventList& _eventList;
-
-  struct eqint
-  {
-    bool operator()(const int i1, const int i2) const
-    {
-      return i1==i2;
-    }
-  };
-
-  struct ltint
-  {
-    bool operator()(const int i1, const int i2) const
-    {
-      return i1<i2;
-    }
-  };
-
-  struct lttime
-  {
-    bool operator()(const simtime_picosec i1, const simtime_picosec i2) const
-    {
-      return i1<i2;
-    }
-  };
-
-
-  struct eqtcp
-  {
-    bool operator()(const TcpSrc* src1, const TcpSrc* src2) const
-    {
-      return src1==src2;
-    }
-  };
-
-  typedef hash_map<const TcpSrc*, timer_entry*, hash<int>,eqtcp> Timers;
-
-  struct TimerBucket {
-    Timers timers;
-    simtime_picosec base;
-    simtime_picosec expire;
-  }
-
-  map<simtime_picosec,timer_entry*,lttime> _soon;
-  vector<TimerBucket*> _buckets;
+    RtxTimerClient();
+    virtual ~RtxTimerClient();
+    // called when the deadline last set falls due; if the hook doesn't
+    // set another or clear it, it's called again a scan period later
+    virtual void rtx_timer_hook(simtime_picosec now) = 0;
+    // keeps this client's deadline, now and from now on, in wheel
+    void rtx_timer_join(RtxTimerWheel& wheel);
+ protected:
+    // sets the deadline to when, replacing any set before; 0 (the
+    // sources' timeInf) clears it
+    void rtx_timer_arm(simtime_picosec when);
+ private:
+    friend class RtxTimerWheel;
+    RtxTimerWheel* _rtx_wheel;
+    simtime_picosec _rtx_when;  // 0 if there's no deadline
+    // the wheel slot's list; _rtx_prev is NULL when not in one
+    RtxTimerClient* _rtx_next;
+    RtxTimerClient** _rtx_prev;
+    uint16_t _rtx_slot;  // level * SLOTS + slot
+};
 
-  hash_set<const TcpSrc*, hash<int>, eqint> _active_timers;
-  hash_map<const TcpSrc*, TimerBucket*,hash<int>,eqint> _timer_to_bucket;
+class RtxTimerWheel : public EventSource {
+ public:
+    RtxTimerWheel(EventList& eventlist, simtime_picosec scan_period,
+		  const string& name = "RtxTimers");
+    void doNextEvent();
+    uint64_t armed() const {return _count;}
+ private:
+    friend class RtxTimerClient;
+    // ticks are 64 bits, so enough levels of 6 bits to cover them
+    enum {SLOT_BITS = 6, SLOTS = 1 << SLOT_BITS, LEVELS = 11};
+
+    void add(RtxTimerClient* c);
+    void insert(RtxTimerClient* c);
+    void remove(RtxTimerClient* c);
+    void advance(simtime_picosec now);
+    uint64_t slot_start(int level, uint64_t slot) const;
+    simtime_picosec next_wake() const;
+    void wake_at(simtime_picosec when);
+
+    simtime_picosec _tick_time;
+    simtime_picosec _scan_period;
+    uint64_t _tick;  // where the wheel is: level 0's current slot
+    uint64_t _count;
+    simtime_picosec _wake; // when the wheel next looks, 0 if never
+    uint64_t _occupied[LEVELS]; // a bit for each slot with deadlines
+    RtxTimerClient* _slots[LEVELS][SLOTS];
 };
 
 #endif
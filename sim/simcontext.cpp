@@ -0,0 +1,127 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "simcontext.h"
+#include "eventlist.h"
+
+#define DEFAULTDATASIZE 1500
+#define DEFAULTSEED 1
+
+static __thread SimContext* current_context = NULL;
+
+SimContext::SimContext()
+    : _eventlist(NULL), _seed(DEFAULTSEED), _id_stride(1), _next_logged_id(1), _next_flow_id(0),
+      _data_packet_size(DEFAULTDATASIZE), _packet_size_fixed(false),
+      _shared_delay_lines(false), _random_seeded(false), _random_state(0),
+      _ndp_node_count(0), _ndp_rto_count(0), _ndp_rtt_hist(NULL),
+      _log_buffer(NULL)
+{
+}
+
+SimContext::SimContext(SimContext& parent, int p, int n)
+    : _eventlist(NULL), _seed(parent._seed), _id_stride(parent._id_stride * n),
+      _next_logged_id(parent._next_logged_id + p * parent._id_stride),
+      _next_flow_id(parent._next_flow_id + p * parent._id_stride),
+      _data_packet_size(parent.data_packet_size()), _packet_size_fixed(true),
+      _shared_delay_lines(parent._shared_delay_lines),
+      _random_seeded(false), _random_state(0),
+      _ndp_node_count(parent._ndp_node_count + p * parent._id_stride),
+      _ndp_rto_count(0), _ndp_rtt_hist(NULL), _log_buffer(NULL)
+{
+    assert(p >= 0 && p < n);
+}
+
+SimContext::~SimContext()
+{
+    assert(current_context != this);
+    delete _eventlist;
+    free(_ndp_rtt_hist);
+}
+
+SimContext&
+SimContext::current()
+{
+    if (current_context)
+	return *current_context;
+    // built on first use, as objects made during static
+    // initialisation need it too
+    static SimContext default_context;
+    return default_context;
+}
+
+SimContext::Use::Use(SimContext& context)
+    : _previous(current_context)
+{
+    current_context = &context;
+}
+
+SimContext::Use::~Use()
+{
+    current_context = _previous;
+}
+
+EventList&
+SimContext::eventlist()
+{
+    if (!_eventlist)
+	_eventlist = new EventList();
+    return *_eventlist;
+}
+
+void
+SimContext::set_packet_size(int packet_size)
+{
+    // Once someone has read the packet size, it's been used to
+    // initialize something, and changing it would leave the two
+    // inconsistent.
+    assert(_packet_size_fixed == false);
+    _data_packet_size = packet_size;
+}
+
+void
+SimContext::seedRandom(unsigned int seed)
+{
+    _random_seeded = true;
+    _random_state = seed;
+}
+
+long
+SimContext::random()
+{
+    if (_random_seeded)
+	return rand_r(&_random_state);
+    return ::random();
+}
+
+int
+SimContext::rand()
+{
+    if (_random_seeded)
+	return rand_r(&_random_state);
+    return ::rand();
+}
+
+int*
+SimContext::ndp_rtt_hist()
+{
+    // calloc rather than new, so pages nobody counts in are never
+    // touched
+    if (!_ndp_rtt_hist)
+	_ndp_rtt_hist = (int*)calloc(NDP_RTT_HIST_LEN, sizeof(int));
+    return _ndp_rtt_hist;
+}
+
+void
+SimContext::merge(SimContext& partition)
+{
+    if (partition._next_logged_id > _next_logged_id)
+	_next_logged_id = partition._next_logged_id;
+    if (partition._next_flow_id > _next_flow_id)
+	_next_flow_id = partition._next_flow_id;
+    if (partition._ndp_node_count > _ndp_node_count)
+	_ndp_node_count = partition._ndp_node_count;
+    _ndp_rto_count += partition._ndp_rto_count;
+    if (partition._ndp_rtt_hist) {
+	int* hist = ndp_rtt_hist();
+	for (int i = 0; i < NDP_RTT_HIST_LEN; i++)
+	    hist[i] += partition._ndp_rtt_hist[i];
+    }
+}
@@ -0,0 +1,128 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef SIMCONTEXT_H
+#define SIMCONTEXT_H
+
+/*
+ * The state that belongs to one simulation rather than to the
+ * process: id counters, the default data packet size, the random
+ * stream and the global statistics kept by the transports.
+ *
+ * Every thread has a current context, which is where objects find
+ * this state when they're built.  Until told otherwise that is a
+ * default context shared by the whole process, so a program that
+ * runs one simulation never needs to know contexts exist.  To run
+ * several simulations in one process, give each its own SimContext
+ * and make it current (SimContext::Use) on whichever thread builds
+ * and runs that simulation; they then share nothing but read-only
+ * configuration (route strategy, minimum RTO and the like).
+ *
+ * Packet pools cache free packets per thread (see packetdb.h) rather
+ * than per context: a freed packet carries nothing from the
+ * simulation that used it, so simulations on one thread may as well
+ * share them.
+ */
+
+#include "config.h"
+#include "loggertypes.h"
+#include "rng.h"
+
+class EventList;
+class LogBuffer;
+
+class SimContext {
+ public:
+    SimContext();
+    // A context for partition p of n in a parallel run (see pdes.h),
+    // made from the one the model was built in, which is its parent.
+    // It has parent's seed and packet size, counts its own
+    // statistics, and hands out only every n'th id from parent's
+    // next, starting p along, so no two partitions share an id.
+    SimContext(SimContext& parent, int p, int n);
+    ~SimContext();
+
+    // the context in use on this thread
+    static SimContext& current();
+
+    // makes a context current on this thread for as long as it lives
+    class Use {
+    public:
+	Use(SimContext& context);
+	~Use();
+    private:
+	SimContext* _previous;
+    };
+
+    // an eventlist for the simulation, made on first use.  Programs
+    // that keep their own eventlist don't need this one.
+    EventList& eventlist();
+
+    Logged::id_t next_logged_id() {Logged::id_t id = _next_logged_id; _next_logged_id += _id_stride; return id;}
+    uint32_t next_flow_id() {uint32_t id = _next_flow_id; _next_flow_id += _id_stride; return id;}
+
+    // the default size of a TCP or NDP data packet, in bytes; see
+    // Packet::set_packet_size
+    void set_packet_size(int packet_size);
+    int data_packet_size() {_packet_size_fixed = true; return _data_packet_size;}
+
+    // whether pipes built from now on share delay lines; see pipe.h
+    void set_shared_delay_lines(bool shared) {_shared_delay_lines = shared;}
+    bool shared_delay_lines() const {return _shared_delay_lines;}
+
+    // Components that make random decisions each keep an Rng on
+    // their own stream, derived from the master seed and a stream
+    // number: their id, or one of the RNG_STREAM_ constants for
+    // things that aren't Logged.  Set the seed before building
+    // anything.
+    void setSeed(uint64_t seed) {_seed = seed;}
+    uint64_t seed() const {return _seed;}
+    Rng rng(uint64_t stream) const {return Rng(_seed, stream);}
+
+    // drand() and simrandom() are for code without a stream of its
+    // own.  Until seeded, every context draws them from the C
+    // library's shared generator, as the simulator always has.
+    // Seeding gives this simulation a sequence of its own.
+    void seedRandom(unsigned int seed);
+    long random();
+    int rand();
+
+    // NDP's statistics across all its sources
+    uint32_t next_ndp_node() {uint32_t n = _ndp_node_count; _ndp_node_count += _id_stride; return n;}
+    uint32_t count_ndp_rto() {return ++_ndp_rto_count;}
+    // histogram of RTTs in microseconds, NDP_RTT_HIST_LEN entries
+    int* ndp_rtt_hist();
+
+    // where Logfiles put records written in this context, or NULL to
+    // write them straight out; partitions buffer theirs (see pdes.h)
+    LogBuffer* log_buffer() const {return _log_buffer;}
+    void set_log_buffer(LogBuffer* buffer) {_log_buffer = buffer;}
+
+    // add a partition's statistics to ours, and move our id counters
+    // past any id it handed out
+    void merge(SimContext& partition);
+
+ private:
+    SimContext(const SimContext&);
+    SimContext& operator=(const SimContext&);
+
+    EventList* _eventlist;
+    uint64_t _seed;
+    uint32_t _id_stride;
+    Logged::id_t _next_logged_id;
+    uint32_t _next_flow_id;
+    int _data_packet_size;
+    bool _packet_size_fixed; //prevent foot-shooting
+    bool _shared_delay_lines;
+    bool _random_seeded;
+    unsigned int _random_state;
+    uint32_t _ndp_node_count;
+    uint32_t _ndp_rto_count;
+    int* _ndp_rtt_hist;
+    LogBuffer* _log_buffer;
+};
+
+#define NDP_RTT_HIST_LEN 10000000
+
+// streams for components that aren't Logged, clear of any Logged id
+#define RNG_STREAM_CONNECTIONS ((uint64_t)1 << 32)
+
+#endif
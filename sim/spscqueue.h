@@ -0,0 +1,82 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+/*
+ * An unbounded lock-free queue for exactly one producer thread and one
+ * consumer thread.  Items are stored in fixed-size blocks chained
+ * together; the producer only ever writes to the last block and the
+ * consumer only ever reads (and frees) blocks at the front, so the
+ * two sides share nothing but each block's fill count and next
+ * pointer.  The producer never waits for the consumer.
+ */
+
+#include <atomic>
+#include "config.h"
+
+#define SPSC_BLOCK_SIZE 256
+
+template<class T>
+class SpscQueue {
+ public:
+    SpscQueue() {
+	_head = _tail = new Block();
+    }
+    ~SpscQueue() {
+	while (_head) {
+	    Block* next = _head->next.load(std::memory_order_relaxed);
+	    delete _head;
+	    _head = next;
+	}
+    }
+
+    // producer side
+    void push(const T& v) {
+	size_t n = _tail->count.load(std::memory_order_relaxed);
+	if (n == SPSC_BLOCK_SIZE) {
+	    Block* b = new Block();
+	    _tail->next.store(b, std::memory_order_release);
+	    _tail = b;
+	    n = 0;
+	}
+	_tail->items[n] = v;
+	_tail->count.store(n + 1, std::memory_order_release);
+    }
+
+    // consumer side: returns false if nothing is available
+    bool pop(T& v) {
+	while (true) {
+	    size_t n = _head->count.load(std::memory_order_acquire);
+	    if (_head->read < n) {
+		v = _head->items[_head->read++];
+		return true;
+	    }
+	    if (n < SPSC_BLOCK_SIZE)
+		return false;
+	    // this block is used up; move on if the producer has
+	    // started another one
+	    Block* next = _head->next.load(std::memory_order_acquire);
+	    if (!next)
+		return false;
+	    delete _head;
+	    _head = next;
+	}
+    }
+
+ private:
+    SpscQueue(const SpscQueue&);
+    SpscQueue& operator=(const SpscQueue&);
+
+    struct Block {
+	Block() : count(0), next(NULL), read(0) {}
+	T items[SPSC_BLOCK_SIZE];
+	std::atomic<size_t> count;  // written by the producer
+	std::atomic<Block*> next;   // written by the producer
+	size_t read;                // consumer only
+    };
+
+    Block* _head; // consumer only
+    Block* _tail; // producer only
+};
+
+#endif
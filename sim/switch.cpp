@@ -5,8 +5,8 @@
 #include "queue_lossless.h"
 #include "queue_lossless_input.h"
 
-void Switch::sendPause(LosslessQueue* problem, unsigned int wait){
-    cout << "Switch " << _name << " link " << problem->_name << " pause " << wait << endl;
+void Switch::sendPause(LosslessQueue* problem, int cls, unsigned int quanta){
+    cout << "Switch " << _name << " link " << problem->str() << " pause class " << cls << " " << quanta << endl;
 
     for (list<Queue*>::iterator it=_ports.begin(); it != _ports.end(); ++it){
 	LosslessQueue* q = (LosslessQueue*)*it;
@@ -14,17 +14,24 @@ void Switch::sendPause(LosslessQueue* problem, unsigned int wait){
 	if (q==problem)
 	    continue;
 
-	cout << "Informing " << q->_name << endl;
-	EthPausePacket* pkt = EthPausePacket::newpkt(wait);
+	cout << "Informing " << q->str() << endl;
+	EthPausePacket* pkt = EthPausePacket::newpkt(cls, quanta);
 	q->getRemoteEndpoint()->receivePacket(*pkt);
     }
 };
 
-void Switch::configureLossless(){
+void Switch::setBuffer(SwitchBuffer* buffer){
+    assert(!_buffer);
+    _buffer = buffer;
+    for (list<Queue*>::iterator it=_ports.begin(); it != _ports.end(); ++it)
+	(*it)->setSwitchBuffer(_buffer, _buffer->addPort());
+}
+
+void Switch::configureLossless(simtime_picosec cable_delay){
     for (list<Queue*>::iterator it=_ports.begin(); it != _ports.end(); ++it){
 	LosslessQueue* q = (LosslessQueue*)*it;
 	q->setSwitch(this);
-	q->initThresholds();
+	q->initThresholds(cable_delay);
     }
 };
 /*Switch::configureLosslessInput(){
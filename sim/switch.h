@@ -4,7 +4,8 @@
 #define _SWITCH_H
 #include "queue.h"
 /*
- * A switch to group together multiple ports (currently used in the PAUSE implementation)
+ * A switch to group together multiple ports (used in the PAUSE
+ * implementation, and to share a buffer between them)
  */
 
 #include <list>
@@ -18,23 +19,32 @@ class LosslessInputQueue;
 
 class Switch {
  public:
-    Switch(){ _name = "none";};
-    Switch(string s) { _name= s;}
+    Switch(){ _name = "none"; _buffer = NULL;};
+    Switch(string s) { _name= s; _buffer = NULL;}
 
     void addPort(Queue* q){
 	_ports.push_back(q);
+	if (_buffer)
+	    q->setSwitchBuffer(_buffer, _buffer->addPort());
     }
 
+    // have our ports, now and to come, share one buffer rather than
+    // each having their own; see switch_buffer.h
+    void setBuffer(SwitchBuffer* buffer);
+    SwitchBuffer* buffer() {return _buffer;}
+
     unsigned int portCount(){ return _ports.size();}
 
-    void sendPause(LosslessQueue* problem, unsigned int wait);
+    // pause (or with quanta 0 resume) class cls at every port but problem
+    void sendPause(LosslessQueue* problem, int cls, unsigned int quanta);
     void sendPause(LosslessInputQueue* problem, unsigned int wait);
 
-    void configureLossless();
+    void configureLossless(simtime_picosec cable_delay);
     void configureLosslessInput();
 
     string _name;
  private:
     list<Queue*> _ports;
+    SwitchBuffer* _buffer;
 };
 #endif
@@ -0,0 +1,69 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#include "switch_buffer.h"
+
+SwitchBuffer::SwitchBuffer(mem_b pool, double alpha)
+    : Logged("SwitchBuffer"), _pool(pool), _used(0), _peak(0),
+      _headroom(0), _headroom_used(0), _alpha(alpha), _drops(0), _overflows(0)
+{
+    assert(pool > 0 && alpha > 0);
+}
+
+int
+SwitchBuffer::addPort() {
+    port_state p;
+    for (int c = 0; c < SWITCH_BUFFER_CLASSES; c++) {
+	p.alpha[c] = _alpha;
+	p.used[c] = 0;
+	p.headroom[c] = 0;
+	p.headroom_used[c] = 0;
+    }
+    _ports.push_back(p);
+    return _ports.size() - 1;
+}
+
+void
+SwitchBuffer::setAlpha(int port, int cls, double alpha) {
+    assert(alpha > 0 && cls < SWITCH_BUFFER_CLASSES);
+    _ports[port].alpha[cls] = alpha;
+}
+
+void
+SwitchBuffer::setHeadroom(int port, int cls, mem_b headroom) {
+    assert(cls < SWITCH_BUFFER_CLASSES);
+    port_state& p = _ports[port];
+    assert(p.headroom_used[cls] == 0);
+    _headroom += headroom - p.headroom[cls];
+    p.headroom[cls] = headroom;
+}
+
+bool
+SwitchBuffer::take(int port, int cls, mem_b size) {
+    port_state& p = _ports[port];
+    bool ok = true;
+    if (!fits(port, cls, size)) {
+	if (p.headroom_used[cls] + size <= p.headroom[cls]) {
+	    p.headroom_used[cls] += size;
+	    _headroom_used += size;
+	    return true;
+	}
+	_overflows++;
+	ok = false;
+    }
+    p.used[cls] += size;
+    _used += size;
+    if (_used > _peak)
+	_peak = _used;
+    return ok;
+}
+
+void
+SwitchBuffer::give(int port, int cls, mem_b size) {
+    port_state& p = _ports[port];
+    mem_b from_headroom = min(size, p.headroom_used[cls]);
+    p.headroom_used[cls] -= from_headroom;
+    _headroom_used -= from_headroom;
+    size -= from_headroom;
+    assert(p.used[cls] >= size);
+    p.used[cls] -= size;
+    _used -= size;
+}
@@ -0,0 +1,92 @@
+// -*- c-basic-offset: 4; tab-width: 8; indent-tabs-mode: t -*-
+#ifndef SWITCH_BUFFER_H
+#define SWITCH_BUFFER_H
+
+/*
+ * A switch's packet memory, shared by the queues on its output ports.
+ *
+ * A queue given a SwitchBuffer (Switch::setBuffer) no longer has a
+ * _maxsize of its own: it asks the buffer whether each packet fits.
+ * Admission uses dynamic thresholds (Choudhury and Hahne): a port's
+ * traffic class may hold up to alpha times what's still free in the
+ * shared pool.  A lone busy port can take most of an idle switch's
+ * memory, busy ports share it out between them, and a little is always
+ * left for a port that's just become busy.  Each (port, class) has its
+ * own alpha.  Queue, RandomQueue, ECNQueue and LosslessQueue use class
+ * 0; CompositeQueue puts full packets in class 0 and headers in 1.
+ *
+ * Lossless classes can also be given PFC headroom: bytes set aside
+ * per (port, class), outside the shared pool, for what's still in
+ * flight after a PAUSE.  A packet over its threshold goes in headroom
+ * if there's room, and is counted as an overflow if not.
+ *
+ * Occupancy and its peak, headroom in use, drops and overflows are
+ * sampled by SwitchBufferLoggerSampling (loggers.h).
+ */
+
+#include <vector>
+#include "config.h"
+#include "loggertypes.h"
+
+#define SWITCH_BUFFER_CLASSES 8
+
+class SwitchBuffer : public Logged {
+ public:
+    // pool: the shared memory in bytes; alpha: the default threshold
+    // for every port and class
+    SwitchBuffer(mem_b pool, double alpha);
+
+    // a new port; its queue passes the number back in the calls below
+    int addPort();
+    int ports() const {return _ports.size();}
+
+    void setAlpha(int port, int cls, double alpha);
+    void setHeadroom(int port, int cls, mem_b headroom);
+
+    // what (port, cls) may hold of the shared pool right now
+    mem_b threshold(int port, int cls) const {
+	mem_b free = _used < _pool ? _pool - _used : 0;
+	return (mem_b)(_ports[port].alpha[cls] * free);
+    }
+    // would size more bytes stay under the threshold?
+    bool fits(int port, int cls, mem_b size) const {
+	return _ports[port].used[cls] + size <= threshold(port, cls);
+    }
+    // A packet of size bytes has been queued: from the shared pool if
+    // it fits, else from headroom.  False if it fit in neither, in
+    // which case it's charged to the pool anyway, as an overflow.
+    bool take(int port, int cls, mem_b size);
+    // a packet has left; headroom is given back first
+    void give(int port, int cls, mem_b size);
+    // a packet the queue turned away for want of space
+    void dropped() {_drops++;}
+
+    // bytes (port, cls) holds, from the pool and from headroom
+    mem_b occupancy(int port, int cls) const {
+	return _ports[port].used[cls] + _ports[port].headroom_used[cls];
+    }
+    mem_b headroomUsed(int port, int cls) const {return _ports[port].headroom_used[cls];}
+
+    mem_b pool() const {return _pool;}
+    mem_b used() const {return _used;}
+    mem_b peak() const {return _peak;}
+    mem_b headroom() const {return _headroom;}
+    mem_b headroomUsed() const {return _headroom_used;}
+    uint64_t drops() const {return _drops;}
+    uint64_t overflows() const {return _overflows;}
+
+ private:
+    struct port_state {
+	double alpha[SWITCH_BUFFER_CLASSES];
+	mem_b used[SWITCH_BUFFER_CLASSES];          // of the shared pool
+	mem_b headroom[SWITCH_BUFFER_CLASSES];
+	mem_b headroom_used[SWITCH_BUFFER_CLASSES];
+    };
+    vector<port_state> _ports;
+    mem_b _pool, _used, _peak;
+    mem_b _headroom, _headroom_used; // over all ports
+    double _alpha;
+    uint64_t _drops, _overflows;
+};
+
+#endif
@@ -14,6 +14,7 @@ TcpSrc::TcpSrc(TcpLogger* logger, TrafficLogger* pktlogger,
     : EventSource(eventlist,"tcp"),  _logger(logger), _flow(pktlogger)
 {
     _mss = Packet::data_packet_size();
+    _rng = SimContext::current().rng(id);
     _maxcwnd = 0xffffffff;//MAX_SENT*_mss;
     _sawtooth = 0;
     _subflow_id = -1;
@@ -57,7 +58,7 @@ TcpSrc::TcpSrc(TcpLogger* logger, TrafficLogger* pktlogger,
     _last_packet_with_old_route = 0;
 
     _rtx_timeout_pending = false;
-    _RFC2988_RTO_timeout = timeInf;
+    set_rto_timeout(timeInf);
 
     _nodename = "tcpsrc";
 }
@@ -136,7 +137,7 @@ TcpSrc::receivePacket(Packet& pkt)
 	_mSrc->receivePacket(pkt);
 #endif
 
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+    pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
   
     ts = p->ts();
     p->free();
@@ -195,12 +196,12 @@ TcpSrc::receivePacket(Packet& pkt)
 		//printf("Deleted old route\n");
 	    }
 	}
-	_RFC2988_RTO_timeout = eventlist().now() + _rto;// RFC 2988 5.3
+	set_rto_timeout(eventlist().now() + _rto);// RFC 2988 5.3
 	_last_ping = eventlist().now();
     
 	if (seqno >= _highest_sent) {
 	    _highest_sent = seqno;
-	    _RFC2988_RTO_timeout = timeInf;// RFC 2988 5.2
+	    set_rto_timeout(timeInf);// RFC 2988 5.2
 	    _last_ping = timeInf;
 	}
 
@@ -391,7 +392,7 @@ TcpSrc::send_packets() {
 	p->sendOn();
 
 	if(_RFC2988_RTO_timeout == timeInf) {// RFC2988 5.1
-	    _RFC2988_RTO_timeout = eventlist().now() + _rto;
+	    set_rto_timeout(eventlist().now() + _rto);
 	}	
 	//cout << "Sending SYN, waiting for SYN/ACK" << endl;
 	return;
@@ -447,7 +448,7 @@ TcpSrc::send_packets() {
 	if (_paths){
 
 #ifdef RANDOM_PATH
-	    _crt_path = random()%_paths->size();
+	    _crt_path = _rng.below(_paths->size());
 #endif
 
 	    p = TcpPacket::newpkt(_flow, *(_paths->at(_crt_path)), _highest_sent+1, 
@@ -459,7 +460,7 @@ TcpSrc::send_packets() {
 #else
 	TcpPacket* p = TcpPacket::newpkt(_flow, *_route, _highest_sent+1, data_seq, _mss);
 #endif
-	p->flow().logTraffic(*p,*this,TrafficLogger::PKT_CREATESEND);
+	p->logTraffic(*this,TrafficLogger::PKT_CREATESEND);
 	p->set_ts(eventlist().now());
     
 	_highest_sent += _mss;  //XX beware wrapping
@@ -468,7 +469,7 @@ TcpSrc::send_packets() {
 	p->sendOn();
 
 	if(_RFC2988_RTO_timeout == timeInf) {// RFC2988 5.1
-	    _RFC2988_RTO_timeout = eventlist().now() + _rto;
+	    set_rto_timeout(eventlist().now() + _rto);
 	}
     }
 }
@@ -502,7 +503,7 @@ TcpSrc::retransmit_packet() {
     if (_paths) {
 
 #ifdef RANDOM_PATH
-	_crt_path = random()%_paths->size();
+	_crt_path = _rng.below(_paths->size());
 #endif
 
 	p = TcpPacket::newpkt(_flow, *(_paths->at(_crt_path)), _last_acked+1, data_seq, _mss);
@@ -514,19 +515,19 @@ TcpSrc::retransmit_packet() {
     TcpPacket* p = TcpPacket::newpkt(_flow, *_route, _last_acked+1, data_seq, _mss);
 #endif
 
-    p->flow().logTraffic(*p,*this,TrafficLogger::PKT_CREATESEND);
+    p->logTraffic(*this,TrafficLogger::PKT_CREATESEND);
     p->set_ts(eventlist().now());
     p->sendOn();
 
     _packets_sent += _mss;
 
     if(_RFC2988_RTO_timeout == timeInf) {// RFC2988 5.1
-	_RFC2988_RTO_timeout = eventlist().now() + _rto;
+	set_rto_timeout(eventlist().now() + _rto);
     }
 }
 
-void TcpSrc::rtx_timer_hook(simtime_picosec now, simtime_picosec period) {
-    if (now <= _RFC2988_RTO_timeout || _RFC2988_RTO_timeout==timeInf) 
+void TcpSrc::rtx_timer_hook(simtime_picosec now) {
+    if (now < _RFC2988_RTO_timeout || _RFC2988_RTO_timeout==timeInf) 
 	return;
 
     if (_highest_sent == 0) 
@@ -537,31 +538,17 @@ void TcpSrc::rtx_timer_hook(simtime_picosec now, simtime_picosec period) {
 	 << " CWND "<< _cwnd/_mss << " FAST RECOVERY? " << 	_in_fast_recovery << " Flow ID " 
 	 << str()  << endl;
 
-    // here we can run into phase effects because the timer is checked
-    // only periodically for ALL flows but if we keep the difference
-    // between scanning time and real timeout time when restarting the
-    // flows we should minimize them !
+    // the timer fires when it's due, so we can retransmit straight away
     if(!_rtx_timeout_pending) {
 	_rtx_timeout_pending = true;
-
-	// check the timer difference between the event and the real value
-	simtime_picosec too_late = now - (_RFC2988_RTO_timeout);
- 
-	// careful: we might calculate a negative value if _rto suddenly drops very much
-	// to prevent overflow but keep randomness we just divide until we are within the limit
-	while(too_late > period) too_late >>= 1;
-
-	// carry over the difference for restarting
-	simtime_picosec rtx_off = (period - too_late)/200;
- 
-	eventlist().sourceIsPendingRel(*this, rtx_off);
+	eventlist().sourceIsPendingRel(*this, 0);
 
 	//reset our rtx timerRFC 2988 5.5 & 5.6
 
 	_rto *= 2;
 	//if (_rto > timeFromMs(1000))
 	//  _rto = timeFromMs(1000);
-	_RFC2988_RTO_timeout = now + _rto;
+	set_rto_timeout(now + _rto);
     }
 }
 
@@ -616,6 +603,7 @@ void TcpSrc::doNextEvent() {
 TcpSink::TcpSink() 
     : Logged("sink"), _cumulative_ack(0) , _packets(0), _mSink(0), _crt_path(0)
 {
+    _rng = SimContext::current().rng(id);
     _nodename = "tcpsink";
 }
 
@@ -642,7 +630,7 @@ TcpSink::receivePacket(Packet& pkt) {
     }
 
     int size = p->size(); // TODO: the following code assumes all packets are the same size
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+    pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
     p->free();
 
     _packets+= p->size();
@@ -653,28 +641,15 @@ TcpSink::receivePacket(Packet& pkt) {
 	_cumulative_ack = seqno + size - 1;
 	//cout << "New cumulative ack is " << _cumulative_ack << endl;
 	// are there any additional received packets we can now ack?
-	while (!_received.empty() && (_received.front() == _cumulative_ack+1) ) {
-	    _received.pop_front();
-	    _cumulative_ack+= size;
-	}
+	_cumulative_ack += _received.fill(seqno) * size;
     } else if (seqno < _cumulative_ack+1) {
     } else { // it's not the next expected sequence number
 	if (_received.empty()) {
-	    _received.push_front(seqno);
 	    //it's a drop in this simulator there are no reorderings.
 	    _drops += (1000 + seqno-_cumulative_ack-1)/1000;
-	} else if (seqno > _received.back()) { // likely case
-	    _received.push_back(seqno);
-	} else { // uncommon case - it fills a hole
-	    list<uint64_t>::iterator i;
-	    for (i = _received.begin(); i != _received.end(); i++) {
-		if (seqno == *i) break; // it's a bad retransmit
-		if (seqno < (*i)) {
-		    _received.insert(i, seqno);
-		    break;
-		}
-	    }
 	}
+	// a packet already held is a bad retransmit
+	_received.add(seqno, size);
     }
     send_ack(ts,marked);
 }
@@ -686,7 +661,7 @@ TcpSink::send_ack(simtime_picosec ts,bool marked) {
 #ifdef PACKET_SCATTER
     if (_paths){
 #ifdef RANDOM_PATH
-	_crt_path = random()%_paths->size();
+	_crt_path = _rng.below(_paths->size());
 #endif
 	
 	rt = _paths->at(_crt_path);
@@ -697,7 +672,7 @@ TcpSink::send_ack(simtime_picosec ts,bool marked) {
     TcpAck *ack = TcpAck::newpkt(_src->_flow, *rt, 0, _cumulative_ack, 
 				 _mSink!=NULL?_mSink->data_ack():0);
 
-    ack->flow().logTraffic(*ack,*this,TrafficLogger::PKT_CREATESEND);
+    ack->logTraffic(*this,TrafficLogger::PKT_CREATESEND);
     ack->set_ts(ts);
     if (marked) 
 	ack->set_flags(ECN_ECHO);
@@ -725,20 +700,10 @@ void TcpSink::set_paths(vector<const Route*>* rt) {
 ////////////////////////////////////////////////////////////////
 
 TcpRtxTimerScanner::TcpRtxTimerScanner(simtime_picosec scanPeriod, EventList& eventlist)
-    : EventSource(eventlist,"RtxScanner"), _scanPeriod(scanPeriod) {
-    eventlist.sourceIsPendingRel(*this, _scanPeriod);
+    : RtxTimerWheel(eventlist, scanPeriod, "RtxScanner") {
 }
 
 void 
 TcpRtxTimerScanner::registerTcp(TcpSrc &tcpsrc) {
-    _tcps.push_back(&tcpsrc);
-}
-
-void TcpRtxTimerScanner::doNextEvent() {
-    simtime_picosec now = eventlist().now();
-    tcps_t::iterator i;
-    for (i = _tcps.begin(); i!=_tcps.end(); i++) {
-	(*i)->rtx_timer_hook(now,_scanPeriod);
-    }
-    eventlist().sourceIsPendingRel(*this, _scanPeriod);
+    tcpsrc.rtx_timer_join(*this);
 }
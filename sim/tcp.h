@@ -12,6 +12,8 @@
 #include "tcppacket.h"
 #include "eventlist.h"
 #include "sent_packets.h"
+#include "receive_bitmap.h"
+#include "rtx_timer.h"
 
 //#define MODEL_RECEIVE_WINDOW 1
 
@@ -26,7 +28,7 @@ class TcpSink;
 class MultipathTcpSrc;
 class MultipathTcpSink;
 
-class TcpSrc : public PacketSink, public EventSource {
+class TcpSrc : public PacketSink, public EventSource, public RtxTimerClient {
     friend class TcpSink;
  public:
     TcpSrc(TcpLogger* logger, TrafficLogger* pktlogger, EventList &eventlist);
@@ -51,7 +53,7 @@ class TcpSrc : public PacketSink, public EventSource {
     void set_ssthresh(uint64_t s){_ssthresh = s;}
 
     uint32_t effective_window();
-    virtual void rtx_timer_hook(simtime_picosec now,simtime_picosec period);
+    virtual void rtx_timer_hook(simtime_picosec now);
     virtual const string& nodename() { return _nodename; }
 
     // should really be private, but loggers want to see:
@@ -90,6 +92,10 @@ class TcpSrc : public PacketSink, public EventSource {
     TcpSink* _sink;
     MultipathTcpSrc* _mSrc;
     simtime_picosec _RFC2988_RTO_timeout;
+    void set_rto_timeout(simtime_picosec when) {
+	_RFC2988_RTO_timeout = when;
+	rtx_timer_arm(when);
+    }
     bool _rtx_timeout_pending;
 
     void set_app_limit(int pktps);
@@ -109,6 +115,7 @@ class TcpSrc : public PacketSink, public EventSource {
     uint64_t _highest_data_seq;
 #endif
     int _subflow_id;
+    Rng _rng; // for path choices
 
     virtual void inflate_window();
     virtual void deflate_window();
@@ -148,14 +155,13 @@ class TcpSink : public PacketSink, public DataReceiver, public Logged {
     TcpAck::seq_t _cumulative_ack; // the packet we have cumulatively acked
     uint64_t _packets;
     uint32_t _drops;
-    uint64_t cumulative_ack(){ return _cumulative_ack + _received.size()*1000;}
+    uint64_t cumulative_ack(){ return _cumulative_ack + _received.bytes();}
     uint32_t drops(){ return _src->_drops;}
     uint32_t get_id(){ return id;}
     virtual const string& nodename() { return _nodename; }
 
     MultipathTcpSink* _mSink;
-    list<TcpAck::seq_t> _received; /* list of packets above a hole, that 
-				      we've received */
+    ReceiveBitmap _received; // packets above a hole, that we've received
 
 #ifdef PACKET_SCATTER
     vector<const Route*>* _paths;
@@ -167,6 +173,7 @@ class TcpSink : public PacketSink, public DataReceiver, public Logged {
  private:
     // Connectivity
     uint16_t _crt_path;
+    Rng _rng; // for path choices
 
     void connect(TcpSrc& src, const Route& route);
     const Route* _route;
@@ -177,15 +184,13 @@ class TcpSink : public PacketSink, public DataReceiver, public Logged {
     string _nodename;
 };
 
-class TcpRtxTimerScanner : public EventSource {
+// Keeps the retransmission timers of the sources registered with it.
+// Timers fire when due; a source not ready for its timeout yet is
+// asked again each scanPeriod.
+class TcpRtxTimerScanner : public RtxTimerWheel {
  public:
     TcpRtxTimerScanner(simtime_picosec scanPeriod, EventList& eventlist);
-    void doNextEvent();
     void registerTcp(TcpSrc &tcpsrc);
- private:
-    simtime_picosec _scanPeriod;
-    typedef list<TcpSrc*> tcps_t;
-    tcps_t _tcps;
 };
 
 #endif
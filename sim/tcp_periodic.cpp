@@ -34,7 +34,7 @@ void TcpSrcPeriodic::reset(){
   _mSrc = NULL;
 
   _rtx_timeout_pending = false;
-  _RFC2988_RTO_timeout = timeInf;
+  set_rto_timeout(timeInf);
 }
 
 void 
@@ -85,7 +85,7 @@ TcpSrcPeriodic::receivePacket(Packet& pkt){
   if (_is_active)
     TcpSrc::receivePacket(pkt);
   else {
-    pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+    pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
     pkt.free();
   }
 }
@@ -18,7 +18,7 @@ uint64_t generateFlowSize(){
 
 TcpSrcTransfer::TcpSrcTransfer(TcpLogger* logger, TrafficLogger* pktLogger, EventList &eventlist,
 			       uint64_t bytes_to_send, vector<const Route*>* p, 
-			       EventSource* stopped) : TcpSrc(logger,pktLogger,eventlist)
+			       FlowStopped* stopped) : TcpSrc(logger,pktLogger,eventlist)
 {
   _is_active = false;  
   _ssthresh = 0xffffffff;
@@ -50,7 +50,7 @@ void TcpSrcTransfer::reset(uint64_t bb, int shouldRestart){
   _established = false;
   
   _rtx_timeout_pending = false;
-  _RFC2988_RTO_timeout = timeInf;
+  set_rto_timeout(timeInf);
   
   //_bytes_to_send = bb;
 
@@ -59,6 +59,25 @@ void TcpSrcTransfer::reset(uint64_t bb, int shouldRestart){
 }
 
 
+void
+TcpSrcTransfer::change_paths(vector<const Route*>* p) {
+  for (size_t i = 0; i < _path_routes.size(); i++)
+      delete _path_routes[i];
+  _path_routes.clear();
+  _paths = p;
+}
+
+const Route*
+TcpSrcTransfer::path_route(size_t i) {
+  if (_path_routes.size() != _paths->size())
+      _path_routes.resize(_paths->size(), NULL);
+  if (!_path_routes[i]) {
+      _path_routes[i] = _paths->at(i)->extend();
+      _path_routes[i]->push_back(_sink);
+  }
+  return _path_routes[i];
+}
+
 void 
 TcpSrcTransfer::connect(const Route& routeout, const Route& routeback, TcpSink& sink, simtime_picosec starttime)
 {
@@ -72,12 +91,8 @@ TcpSrcTransfer::doNextEvent() {
   if (!_is_active){
     _is_active = true;
 
-    //delete _route;
-    if (_paths!=NULL){
-	Route* rt = new Route(*(_paths->at(rand()%_paths->size())));
-	rt->push_back(_sink);
-	_route = rt;
-    }
+    if (_paths!=NULL)
+	_route = path_route(_rng.below(_paths->size()));
 
     //should reset route here!
     //how?
@@ -101,7 +116,7 @@ TcpSrcTransfer::receivePacket(Packet& pkt){
 	      cout << endl << "Flow " << _bytes_to_send << " finished after " << timeAsMs(eventlist().now()-_started) << endl;
 	      
 	      if (_flow_stopped){
-		  _flow_stopped->doNextEvent();
+		  _flow_stopped->flowStopped();
 	      }
 	      else 
 		  reset(_bytes_to_send,1);
@@ -131,20 +146,20 @@ TcpSrcTransfer::receivePacket(Packet& pkt){
       }
   }
   else {
-      pkt.flow().logTraffic(pkt,*this,TrafficLogger::PKT_RCVDESTROY);
+      pkt.logTraffic(*this,TrafficLogger::PKT_RCVDESTROY);
       pkt.free();
   }
 }
 
-void TcpSrcTransfer::rtx_timer_hook(simtime_picosec now, simtime_picosec period) {
+void TcpSrcTransfer::rtx_timer_hook(simtime_picosec now) {
   if (!_is_active) return;
 
-  if (now <= _RFC2988_RTO_timeout || _RFC2988_RTO_timeout==timeInf) return;
+  if (now < _RFC2988_RTO_timeout || _RFC2988_RTO_timeout==timeInf) return;
   if (_highest_sent == 0) return;
 
   cout << "Transfer timeout: active " << _is_active << " bytes to send " << _bytes_to_send << " sent " << _last_acked << " established? " << _established << " HSENT " << _highest_sent << endl;
   
-  TcpSrc::rtx_timer_hook(now,period);
+  TcpSrc::rtx_timer_hook(now);
 }
 
 ////////////////////////////////////////////////////////////////
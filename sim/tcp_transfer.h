@@ -22,12 +22,15 @@ uint64_t generateFlowSize();
 class TcpSrcTransfer: public TcpSrc {
 public:
   TcpSrcTransfer(TcpLogger* logger, TrafficLogger* pktLogger, EventList &eventlist,
-		 uint64_t b, vector<const Route*>* p, EventSource* stopped = NULL);
+		 uint64_t b, vector<const Route*>* p, FlowStopped* stopped = NULL);
   void connect(const Route& routeout, const Route& routeback, TcpSink& sink, simtime_picosec starttime);
 
-  virtual void rtx_timer_hook(simtime_picosec now,simtime_picosec period);
+  virtual void rtx_timer_hook(simtime_picosec now);
   virtual void receivePacket(Packet& pkt);
   void reset(uint64_t bb, int rs);
+  // sends later transfers over p, freeing the routes made for the old
+  // paths; only once no packet of ours is left on them
+  void change_paths(vector<const Route*>* p);
   virtual void doNextEvent();
  
 // should really be private, but loggers want to see:
@@ -36,7 +39,12 @@ public:
   bool _is_active;
   simtime_picosec _started;
   vector<const Route*>* _paths;
-  EventSource* _flow_stopped;
+  FlowStopped* _flow_stopped;
+ private:
+  // route i is _paths[i] on to our sink, made when first chosen and
+  // kept for every later transfer that picks it
+  vector<Route*> _path_routes;
+  const Route* path_route(size_t i);
 };
 
 class TcpSinkTransfer : public TcpSink {